@@ -0,0 +1,172 @@
+// bench/benchmark.cpp
+#include "benchmark.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <map>
+#include <thread>
+#include <ctime>
+#include <sys/utsname.h>
+#include <openssl/opensslv.h>
+#include <sqlite3.h>
+
+namespace nexus::bench {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double measure_ns(const Body& body, const Setup& setup, uint64_t iterations) {
+    if (setup) setup(iterations);
+    auto started = Clock::now();
+    body(iterations);
+    return std::chrono::duration<double, std::nano>(Clock::now() - started).count();
+}
+
+std::string cpu_model() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            auto colon = line.find(':');
+            if (colon != std::string::npos) return line.substr(line.find_first_not_of(' ', colon + 1));
+        }
+    }
+    return "unknown";
+}
+
+uint64_t total_memory_kb() {
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    uint64_t value = 0;
+    while (meminfo >> key >> value) {
+        if (key == "MemTotal:") return value;
+        meminfo.ignore(256, '\n');
+    }
+    return 0;
+}
+
+} // namespace
+
+nlohmann::json Result::to_json() const {
+    return {
+        {"name", name},
+        {"iterations", iterations},
+        {"ns_per_op", ns_per_op_median},
+        {"ns_per_op_min", ns_per_op_min},
+        {"ns_per_op_max", ns_per_op_max},
+        {"ops_per_sec", ns_per_op_median > 0 ? 1e9 / ns_per_op_median : 0},
+        {"params", params}
+    };
+}
+
+bool Runner::selected(const std::string& name) const {
+    return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+}
+
+bool Runner::group_selected(const std::string& prefix) const {
+    return selected(prefix) || options_.filter.rfind(prefix, 0) == 0;
+}
+
+void Runner::run(const std::string& name, const Body& body, nlohmann::json params, const Setup& setup) {
+    if (!selected(name)) return;
+
+    // Разогрев и калибровка: удваиваем итерации, пока замер короче 1/10 целевого
+    uint64_t iterations = 1;
+    double target_ns = options_.min_time_s * 1e9;
+    for (;;) {
+        double elapsed = measure_ns(body, setup, iterations);
+        if (elapsed >= target_ns / 10 || iterations >= (1ULL << 40)) {
+            double per_op = elapsed / static_cast<double>(iterations);
+            iterations = std::max<uint64_t>(1, static_cast<uint64_t>(target_ns / std::max(per_op, 1.0)));
+            break;
+        }
+        iterations *= 2;
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < std::max(1, options_.repetitions); ++i) {
+        samples.push_back(measure_ns(body, setup, iterations) / static_cast<double>(iterations));
+    }
+    std::sort(samples.begin(), samples.end());
+
+    Result result;
+    result.name = name;
+    result.iterations = iterations;
+    result.ns_per_op_median = samples[samples.size() / 2];
+    result.ns_per_op_min = samples.front();
+    result.ns_per_op_max = samples.back();
+    result.params = std::move(params);
+
+    std::cerr << std::left << std::setw(40) << name << std::right << std::setw(14) << std::fixed
+              << std::setprecision(1) << result.ns_per_op_median << " ns/op"
+              << std::setw(12) << iterations << " iters" << std::endl;
+    results_.push_back(std::move(result));
+}
+
+nlohmann::json Runner::report() const {
+    nlohmann::json results = nlohmann::json::array();
+    for (const auto& result : results_) results.push_back(result.to_json());
+    return {
+        {"timestamp", static_cast<int64_t>(time(nullptr))},
+        {"hardware", hardware_info()},
+        {"options", {
+            {"filter", options_.filter},
+            {"min_time_s", options_.min_time_s},
+            {"repetitions", options_.repetitions},
+            {"history_blocks", options_.history_blocks},
+            {"txs_per_block", options_.txs_per_block}
+        }},
+        {"results", results}
+    };
+}
+
+nlohmann::json hardware_info() {
+    struct utsname uts{};
+    uname(&uts);
+    return {
+        {"cpu", cpu_model()},
+        {"cores", std::thread::hardware_concurrency()},
+        {"memory_kb", total_memory_kb()},
+        {"os", std::string(uts.sysname) + " " + uts.release},
+        {"arch", uts.machine},
+#if defined(__clang__)
+        {"compiler", "clang " __clang_version__},
+#elif defined(__GNUC__)
+        {"compiler", "gcc " __VERSION__},
+#else
+        {"compiler", "unknown"},
+#endif
+#ifdef NDEBUG
+        {"build", "release"},
+#else
+        {"build", "debug"},
+#endif
+        {"openssl", OPENSSL_VERSION_TEXT},
+        {"sqlite", sqlite3_libversion()}
+    };
+}
+
+int compare_with_baseline(const nlohmann::json& current, const nlohmann::json& baseline, double threshold_percent) {
+    std::map<std::string, double> before;
+    for (const auto& result : baseline.value("results", nlohmann::json::array())) {
+        before[result.value("name", "")] = result.value("ns_per_op", 0.0);
+    }
+
+    int regressions = 0;
+    for (const auto& result : current["results"]) {
+        std::string name = result["name"];
+        auto it = before.find(name);
+        if (it == before.end() || it->second <= 0) continue;
+        double change = (result["ns_per_op"].get<double>() - it->second) / it->second * 100.0;
+        bool regressed = change > threshold_percent;
+        if (regressed) regressions++;
+        std::cerr << std::left << std::setw(40) << name << std::right << std::showpos << std::fixed
+                  << std::setprecision(1) << std::setw(9) << change << "%" << std::noshowpos
+                  << (regressed ? "  REGRESSION" : "") << std::endl;
+    }
+    return regressions;
+}
+
+} // namespace nexus::bench
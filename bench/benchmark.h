@@ -0,0 +1,75 @@
+// bench/benchmark.h
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <nlohmann/json.hpp>
+
+namespace nexus::bench {
+
+// Не даёт компилятору выбросить вычисление, результат которого не используется
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+struct Options {
+    std::string filter;            // Подстрока имени; пусто — все бенчмарки
+    double min_time_s = 0.5;       // Минимальное время одного замера
+    int repetitions = 5;           // Замеры на бенчмарк, в отчёт идут медиана и минимум
+    int history_blocks = 1000;     // Размер истории в тестовой БД хранилища
+    int txs_per_block = 10;
+};
+
+struct Result {
+    std::string name;
+    uint64_t iterations{0};        // Итераций в одном замере
+    double ns_per_op_median{0};
+    double ns_per_op_min{0};
+    double ns_per_op_max{0};
+    nlohmann::json params;         // Параметры (размер истории, число транзакций...)
+
+    nlohmann::json to_json() const;
+};
+
+// Тело бенчмарка выполняет операцию iterations раз. Подготовка, которую
+// не нужно мерить, делается до вызова run() или в setup — он вызывается
+// перед каждым замером с тем же числом итераций и в замер не входит.
+using Body = std::function<void(uint64_t iterations)>;
+using Setup = std::function<void(uint64_t iterations)>;
+
+class Runner {
+public:
+    explicit Runner(Options options) : options_(std::move(options)) {}
+
+    const Options& options() const { return options_; }
+    bool selected(const std::string& name) const;
+    // Может ли фильтр выбрать хоть один бенчмарк группы — чтобы не готовить
+    // дорогие данные (БД с историей) зря
+    bool group_selected(const std::string& prefix) const;
+
+    // Подбирает число итераций так, чтобы замер длился не меньше min_time_s,
+    // затем делает repetitions замеров. Пропускает бенчмарки вне фильтра.
+    void run(const std::string& name, const Body& body,
+             nlohmann::json params = nlohmann::json::object(), const Setup& setup = {});
+
+    const std::vector<Result>& results() const { return results_; }
+
+    // Отчёт: окружение, параметры запуска и результаты
+    nlohmann::json report() const;
+
+private:
+    Options options_;
+    std::vector<Result> results_;
+};
+
+// Описание машины и сборки, чтобы результаты разных хостов не смешивались
+nlohmann::json hardware_info();
+
+// Сравнение с прошлым отчётом: печатает изменения медиан и возвращает
+// число бенчмарков, замедлившихся больше чем на threshold_percent
+int compare_with_baseline(const nlohmann::json& current, const nlohmann::json& baseline, double threshold_percent);
+
+} // namespace nexus::bench
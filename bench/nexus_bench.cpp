@@ -0,0 +1,476 @@
+// bench/nexus_bench.cpp
+// Микробенчмарки криптографии, подписей, блоков, сообщений, хранилища и mempool.
+// Запускать из каталога сборки (рядом должен лежать schema.sql):
+//   ./nexus-bench --history 5000 --out results.json
+//   ./nexus-bench --baseline previous.json --threshold 10
+#include "benchmark.h"
+#include "blockchain/blockchain.h"
+#include "core/thread_pool.h"
+#include "core/signature_queue.h"
+#include "network/message.h"
+#include "storage/lsm_ledger.h"
+#include "logging/logger.h"
+#include <boost/asio.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <unistd.h>
+
+using nexus::bench::Runner;
+using nexus::bench::do_not_optimize;
+
+namespace {
+
+const int ADDRESS_POOL = 100;
+
+std::string address(int i) {
+    return "bench_addr_" + std::to_string(i);
+}
+
+Transaction make_tx(int from, int to, long timestamp, const std::string& status = "pending") {
+    Transaction tx;
+    tx.fromAddress = address(from);
+    tx.toAddress = address(to);
+    tx.amount = (1 + timestamp % 97) * COIN;
+    tx.fee = COIN / 1000;
+    tx.timestamp = timestamp;
+    tx.signature = "bench_signature";
+    tx.status = status;
+    tx.txHash = tx.calculateHash();
+    return tx;
+}
+
+Block make_block(int height, int tx_count, long timestamp_base) {
+    Block block;
+    block.height = height;
+    block.prevHash = std::string(64, '0');
+    block.minedBy = "bench_miner";
+    for (int i = 0; i < tx_count; ++i) {
+        block.transactions.push_back(make_tx(i % ADDRESS_POOL, (i * 7 + 1) % ADDRESS_POOL,
+                                             timestamp_base + i, "confirmed"));
+    }
+    block.merkleRoot = block.calculateMerkleRoot();
+    block.hash = block.calculateHash();
+    return block;
+}
+
+void bench_crypto(Runner& runner) {
+    for (size_t size : {64, 1024, 16384}) {
+        std::string input(size, 'x');
+        runner.run("crypto/sha256/" + std::to_string(size), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) do_not_optimize(Crypto::sha256(input));
+        }, {{"bytes", size}});
+    }
+
+    auto keys = Crypto::generateKeyPair();
+    std::string message = Crypto::sha256("bench");
+    std::string signature = Crypto::sign(keys.privateKey, message);
+    runner.run("crypto/ed25519_sign", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) do_not_optimize(Crypto::sign(keys.privateKey, message));
+    });
+    runner.run("crypto/ed25519_verify", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) do_not_optimize(Crypto::verify(keys.publicKey, message, signature));
+    });
+}
+
+// Подписанные транзакции: проверка пачки через очередь (пул или сразу) и
+// повторная проверка, отвечающая из кэша
+void bench_signatures(Runner& runner) {
+    if (!runner.group_selected("signature/")) return;
+    const size_t batch_size = 1024;
+    std::vector<Transaction> txs;
+    for (size_t i = 0; i < batch_size; ++i) {
+        auto keys = Crypto::generateKeyPair();
+        Transaction tx = make_tx(0, 1, 1700000000 + static_cast<long>(i));
+        tx.fromAddress = Crypto::addressFromPublicKey(keys.publicKey);
+        tx.sign(keys.privateKey);
+        txs.push_back(std::move(tx));
+    }
+
+    std::vector<unsigned> thread_counts = {0, 1};
+    if (std::thread::hardware_concurrency() > 1) thread_counts.push_back(std::thread::hardware_concurrency());
+    for (unsigned threads : thread_counts) {
+        std::unique_ptr<nexus::ThreadPool> pool;
+        if (threads > 0) pool = std::make_unique<nexus::ThreadPool>(threads);
+        std::string name = "signature/queue/" + std::to_string(batch_size) +
+                           (threads > 0 ? "/threads_" + std::to_string(threads) : "/inline");
+        runner.run(name, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                // Новый верификатор — пустой кэш: проверяется вся пачка
+                SignatureVerifier verifier;
+                // Итоги возвращаются в этот поток, как в io-поток узла
+                boost::asio::io_context io;
+                auto work = boost::asio::make_work_guard(io);
+                size_t remaining = txs.size();
+                nexus::SignatureQueue queue(verifier, pool.get(), [&io](std::function<void()> task) {
+                    boost::asio::post(io, std::move(task));
+                });
+                for (const auto& tx : txs) {
+                    queue.submit(tx, [&](const Transaction&, const std::string& error) {
+                        do_not_optimize(error.size());
+                        if (--remaining == 0) work.reset();
+                    });
+                }
+                io.run();
+            }
+        }, {{"txs", batch_size}, {"threads", threads}});
+    }
+
+    SignatureVerifier verifier;
+    for (const auto& tx : txs) verifier.check(tx);
+    runner.run("signature/check/cached", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) do_not_optimize(verifier.check(txs[i % txs.size()]).size());
+    });
+}
+
+void bench_block(Runner& runner) {
+    Block header = make_block(1, 0, 1700000000);
+    runner.run("block/calculate_hash", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) {
+            header.nonce = static_cast<int>(i);
+            do_not_optimize(header.calculateHash());
+        }
+    });
+
+    for (int tx_count : {1, 10, 100, 1000}) {
+        Block block = make_block(1, tx_count, 1700000000);
+        runner.run("block/merkle_root/" + std::to_string(tx_count), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) do_not_optimize(block.calculateMerkleRoot());
+        }, {{"txs", tx_count}});
+    }
+
+    for (int tx_count : {10, 100}) {
+        Block block = make_block(1, tx_count, 1700000000);
+        runner.run("block/to_json/" + std::to_string(tx_count), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) do_not_optimize(block.toJson());
+        }, {{"txs", tx_count}});
+
+        nlohmann::json json = block.toJson();
+        runner.run("block/from_json/" + std::to_string(tx_count), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                Block parsed;
+                parsed.fromJson(json);
+                do_not_optimize(parsed.height);
+            }
+        }, {{"txs", tx_count}});
+    }
+
+    // Конкурент вершины: вставка в индекс и выбор лучшей вершины не
+    // должны зависеть от длины цепочки (индекс длинной цепочки строится долго)
+    if (!runner.group_selected("block/index_competing_tip/")) return;
+    for (int chain_length : {1000, 100000}) {
+        BlockIndex index;
+        Block parent = make_block(0, 0, 1700000000);
+        index.appendConnected(parent);
+        for (int h = 1; h < chain_length; ++h) {
+            Block next = make_block(h, 0, 1700000000);
+            next.prevHash = parent.hash;
+            next.hash = next.calculateHash();
+            index.appendConnected(next);
+            parent = std::move(next);
+        }
+        std::vector<Block> rivals;
+        runner.run("block/index_competing_tip/" + std::to_string(chain_length), [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                do_not_optimize(index.insert(rivals[i]));
+                do_not_optimize(index.bestTip());
+            }
+        }, {{"chain_length", chain_length}}, [&](uint64_t n) {
+            rivals.clear();
+            Block rival = make_block(chain_length - 1, 0, 1700000000);
+            rival.prevHash = index.activeHash(chain_length - 2);
+            for (uint64_t i = 0; i < n; ++i) {
+                rival.nonce = static_cast<int>(rivals.size() + index.size());
+                rival.hash = rival.calculateHash();
+                rivals.push_back(rival);
+            }
+        });
+    }
+}
+
+// Пачка BLOCKS_RESPONSE через BlockPipeline: разбор, хэши транзакций,
+// правила и корень Меркла. threads = 0 — в вызывающем потоке
+void bench_validation(Runner& runner) {
+    if (!runner.group_selected("validation/")) return;
+    const int blocks = 16;
+    const int tx_count = 500;
+    nlohmann::json batch = nlohmann::json::array();
+    for (int h = 1; h <= blocks; ++h) batch.push_back(make_block(h, tx_count, 1700000000 + h * tx_count).toJson());
+
+    std::vector<unsigned> thread_counts = {0, 1};
+    if (std::thread::hardware_concurrency() > 1) thread_counts.push_back(std::thread::hardware_concurrency());
+    for (unsigned threads : thread_counts) {
+        std::unique_ptr<nexus::ThreadPool> pool;
+        if (threads > 0) pool = std::make_unique<nexus::ThreadPool>(threads);
+        BlockPipeline pipeline(pool.get());
+        pipeline.setProofOfWorkCheck(false);
+        std::string name = "validation/blocks_response/" + std::to_string(blocks) + "x" + std::to_string(tx_count) +
+                           (threads > 0 ? "/threads_" + std::to_string(threads) : "/inline");
+        runner.run(name, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) {
+                for (auto& verdict : pipeline.submit(batch)) do_not_optimize(verdict.get().error.size());
+            }
+        }, {{"blocks", blocks}, {"txs", tx_count}, {"threads", threads}});
+    }
+}
+
+void bench_message(Runner& runner) {
+    nlohmann::json tx_json = make_tx(1, 2, 1700000000).toJsonObject();
+    nexus::Message tx_msg = nexus::Message::create_new_transaction("bench_node", tx_json);
+
+    nexus::Message blocks_msg(nexus::MessageType::BLOCKS_RESPONSE);
+    blocks_msg.sender_id = "bench_node";
+    blocks_msg.payload = nlohmann::json::array();
+    for (int h = 0; h < 10; ++h) blocks_msg.payload.push_back(make_block(h, 10, 1700000000 + h * 100).toJson());
+
+    for (const auto& [name, msg] : {std::pair{"new_transaction", &tx_msg}, std::pair{"blocks_response", &blocks_msg}}) {
+        std::string wire = msg->serialize();
+        runner.run(std::string("message/serialize/") + name, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) do_not_optimize(msg->serialize());
+        }, {{"bytes", wire.size()}});
+        runner.run(std::string("message/deserialize/") + name, [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) do_not_optimize(nexus::Message::deserialize(wire).type);
+        }, {{"bytes", wire.size()}});
+    }
+}
+
+// Байты, записанные процессом через write(2), из /proc/self/io
+uint64_t process_write_bytes() {
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value = 0;
+    while (io >> key >> value) {
+        if (key == "wchar:") return value;
+    }
+    return 0;
+}
+
+// Хранилище меряется на файловой БД с заранее записанной историей, чтобы
+// учитывались индексы, размер страниц и fsync, как на работающем узле.
+// Бэкенды с телами блоков в файлах и с LSM-состоянием — отдельные группы
+// storage/blockfile/ и storage/lsm/. Запись истории заодно даёт
+// write_bytes_per_tx: сколько байт ушло на диск на одну транзакцию
+void bench_storage_backend(Runner& runner, const std::string& prefix, StorageBackend backend) {
+    const auto& options = runner.options();
+    auto path = std::filesystem::temp_directory_path() / ("nexus-bench-" + std::to_string(getpid()) + ".db");
+    std::filesystem::path blocks_dir = path.string() + ".blocks";
+    std::filesystem::path state_dir = path.string() + ".state";
+    std::filesystem::remove(path);
+    std::filesystem::remove_all(blocks_dir);
+    std::filesystem::remove_all(state_dir);
+
+    {
+        auto db = openLedgerStorage(path.string(), backend);
+        std::cerr << "Populating " << options.history_blocks << " blocks x "
+                  << options.txs_per_block << " txs..." << std::endl;
+        uint64_t written_before = process_write_bytes();
+        for (int i = 0; i < ADDRESS_POOL; ++i) db->ensureWalletExists(address(i));
+        db->beginTransaction();
+        for (int h = 1; h <= options.history_blocks; ++h) {
+            db->addBlock(make_block(h, options.txs_per_block, 1700000000L + h * 1000L));
+        }
+        db->commitTransaction();
+        auto* lsm = dynamic_cast<LsmLedger*>(db.get());
+        // Фоновые сброс и слияние — тоже часть записи
+        if (lsm) lsm->flushState();
+        double txs_written = std::max(1, options.history_blocks * options.txs_per_block);
+        double write_bytes_per_tx = static_cast<double>(process_write_bytes() - written_before) / txs_written;
+
+        nlohmann::json params = {{"history_blocks", options.history_blocks}, {"txs_per_block", options.txs_per_block},
+                                 {"write_bytes_per_tx", write_bytes_per_tx}};
+        if (lsm) params["lsm_write_amplification"] = lsm->stateStats().writeAmplification();
+        std::mt19937 rng(42);
+
+        runner.run(prefix + "get_block_by_height", [&](uint64_t n) {
+            std::uniform_int_distribution<int> height(0, options.history_blocks);
+            for (uint64_t i = 0; i < n; ++i) do_not_optimize(db->getBlockByHeight(height(rng)).has_value());
+        }, params);
+
+        // В blockfile балансы считает тот же SQLite, что и в storage/
+        if (backend != StorageBackend::BLOCK_FILES) {
+            runner.run(prefix + "get_balance", [&](uint64_t n) {
+                std::uniform_int_distribution<int> addr(0, ADDRESS_POOL - 1);
+                for (uint64_t i = 0; i < n; ++i) do_not_optimize(db->getBalance(address(addr(rng))));
+            }, params);
+        }
+
+        // Страница истории с курсора на случайной высоте: цена не должна
+        // зависеть от глубины страницы
+        runner.run(prefix + "address_history_page", [&](uint64_t n) {
+            std::uniform_int_distribution<int> addr(0, ADDRESS_POOL - 1);
+            std::uniform_int_distribution<int> height(1, options.history_blocks);
+            AddressHistoryPage page;
+            for (uint64_t i = 0; i < n; ++i) {
+                db->getAddressHistory(address(addr(rng)), encodeHistoryCursor(height(rng), 0), 50, page);
+                do_not_optimize(page.entries.size());
+            }
+        }, params);
+
+        // Поток pending-транзакций со случайными хэшами: запись в случайное
+        // место индекса транзакций
+        long tx_timestamp = 5000000000L;
+        std::vector<Transaction> incoming;
+        runner.run(prefix + "add_tx", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) do_not_optimize(db->addTransaction(incoming[i], -1));
+        }, params, [&](uint64_t n) {
+            incoming.clear();
+            std::uniform_int_distribution<int> addr(0, ADDRESS_POOL - 1);
+            for (uint64_t i = 0; i < n; ++i) incoming.push_back(make_tx(addr(rng), addr(rng), tx_timestamp++));
+        });
+
+        // Каждая итерация дописывает новый блок поверх истории
+        int next_height = options.history_blocks + 1;
+        std::vector<Block> pending;
+        runner.run(prefix + "add_block", [&](uint64_t n) {
+            for (uint64_t i = 0; i < n; ++i) do_not_optimize(db->addBlock(pending[i]));
+        }, params, [&](uint64_t n) {
+            pending.clear();
+            for (uint64_t i = 0; i < n; ++i, ++next_height) {
+                pending.push_back(make_block(next_height, options.txs_per_block, 4000000000L + next_height * 1000L));
+            }
+        });
+
+        // С пулом изменения балансов блока суммируются параллельно (BlockExecutor)
+        if (std::thread::hardware_concurrency() > 1) {
+            nexus::ThreadPool pool;
+            db->setExecutionPool(&pool);
+            runner.run(prefix + "add_block/threads_" + std::to_string(pool.size()), [&](uint64_t n) {
+                for (uint64_t i = 0; i < n; ++i) do_not_optimize(db->addBlock(pending[i]));
+            }, params, [&](uint64_t n) {
+                pending.clear();
+                for (uint64_t i = 0; i < n; ++i, ++next_height) {
+                    pending.push_back(make_block(next_height, options.txs_per_block, 4000000000L + next_height * 1000L));
+                }
+            });
+            db->setExecutionPool(nullptr);
+        }
+    }
+    std::filesystem::remove(path);
+    std::filesystem::remove_all(blocks_dir);
+    std::filesystem::remove_all(state_dir);
+}
+
+void bench_storage(Runner& runner) {
+    if (runner.group_selected("storage/")) {
+        bench_storage_backend(runner, "storage/", StorageBackend::SQLITE);
+    }
+    if (runner.group_selected("storage/blockfile/")) {
+        bench_storage_backend(runner, "storage/blockfile/", StorageBackend::BLOCK_FILES);
+    }
+    if (runner.group_selected("storage/lsm/")) {
+        bench_storage_backend(runner, "storage/lsm/", StorageBackend::LSM);
+    }
+}
+
+// Mempool — на БД в памяти: меряется приём транзакции узлом, а не диск
+void bench_mempool(Runner& runner) {
+    if (!runner.group_selected("mempool/")) return;
+    const size_t MEMPOOL_LIMIT = 10000;  // Совпадает с ограничением в Blockchain::addTransaction
+
+    std::unique_ptr<Blockchain> chain;
+    std::vector<Transaction> txs;
+    long timestamp = 1700000000;
+    auto make_txs = [&](uint64_t n, Amount fee) {
+        txs.clear();
+        for (uint64_t i = 0; i < n; ++i) {
+            Transaction tx = make_tx(0, 1, timestamp++);
+            tx.fromAddress = "genesis_miner";
+            tx.amount = COIN / 100;
+            tx.fee = fee;
+            tx.txHash = tx.calculateHash();
+            txs.push_back(std::move(tx));
+        }
+    };
+
+    runner.run("mempool/insert", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) do_not_optimize(chain->addTransaction(txs[i]));
+    }, nlohmann::json::object(), [&](uint64_t n) {
+        chain = std::make_unique<Blockchain>(":memory:");
+        make_txs(n, COIN / 1000);
+    });
+
+    // Вставка в заполненный mempool: каждая транзакция вытесняет самую дешёвую
+    runner.run("mempool/insert_evict", [&](uint64_t n) {
+        for (uint64_t i = 0; i < n; ++i) do_not_optimize(chain->addTransaction(txs[i]));
+    }, {{"mempool_size", MEMPOOL_LIMIT}}, [&](uint64_t n) {
+        chain = std::make_unique<Blockchain>(":memory:");
+        make_txs(MEMPOOL_LIMIT, COIN / 10000);
+        for (const auto& tx : txs) chain->addTransaction(tx);
+        make_txs(n, COIN / 100);
+    });
+    chain.reset();
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]" << std::endl
+              << "  --filter <substr>     Run only benchmarks whose name contains substr" << std::endl
+              << "  --min-time <seconds>  Minimum duration of one measurement (default 0.5)" << std::endl
+              << "  --repetitions <n>     Measurements per benchmark (default 5)" << std::endl
+              << "  --history <blocks>    Blocks in the storage benchmark DB (default 1000)" << std::endl
+              << "  --txs-per-block <n>   Transactions per history block (default 10)" << std::endl
+              << "  --out <file>          Write JSON report to file instead of stdout" << std::endl
+              << "  --baseline <file>     Compare with a previous report" << std::endl
+              << "  --threshold <pct>     Slowdown treated as regression (default 10)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    nexus::bench::Options options;
+    std::string out_path;
+    std::string baseline_path;
+    double threshold = 10.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--filter" && has_value) options.filter = argv[++i];
+        else if (arg == "--min-time" && has_value) options.min_time_s = std::stod(argv[++i]);
+        else if (arg == "--repetitions" && has_value) options.repetitions = std::stoi(argv[++i]);
+        else if (arg == "--history" && has_value) options.history_blocks = std::stoi(argv[++i]);
+        else if (arg == "--txs-per-block" && has_value) options.txs_per_block = std::stoi(argv[++i]);
+        else if (arg == "--out" && has_value) out_path = argv[++i];
+        else if (arg == "--baseline" && has_value) baseline_path = argv[++i];
+        else if (arg == "--threshold" && has_value) threshold = std::stod(argv[++i]);
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    nexus::Logger::instance().setLevel(nexus::LogLevel::WARN);
+
+    Runner runner(options);
+    bench_crypto(runner);
+    bench_signatures(runner);
+    bench_block(runner);
+    bench_validation(runner);
+    bench_message(runner);
+    bench_storage(runner);
+    bench_mempool(runner);
+
+    nlohmann::json report = runner.report();
+    if (out_path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(out_path);
+        out << report.dump(2) << std::endl;
+    }
+
+    if (!baseline_path.empty()) {
+        std::ifstream in(baseline_path);
+        if (!in) {
+            std::cerr << "Can't open baseline " << baseline_path << std::endl;
+            return 1;
+        }
+        int regressions = nexus::bench::compare_with_baseline(report, nlohmann::json::parse(in), threshold);
+        if (regressions > 0) {
+            std::cerr << regressions << " benchmark(s) slower than baseline by more than "
+                      << threshold << "%" << std::endl;
+            return 2;
+        }
+    }
+    return 0;
+}
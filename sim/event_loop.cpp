@@ -0,0 +1,28 @@
+// sim/event_loop.cpp
+#include "event_loop.h"
+
+namespace nexus::sim {
+
+void EventLoop::schedule_at(Micros at, Task task) {
+    // Событие в прошлом выполняется "сейчас", часы назад не идут
+    queue_.push({at < now_ ? now_ : at, next_seq_++, std::move(task)});
+}
+
+bool EventLoop::run_next() {
+    if (queue_.empty()) return false;
+    // top() константен, но элемент сразу удаляется — забираем задачу без копии
+    Event event = std::move(const_cast<Event&>(queue_.top()));
+    queue_.pop();
+    now_ = event.at;
+    event.task();
+    return true;
+}
+
+void EventLoop::run_until(Micros deadline) {
+    while (!queue_.empty() && queue_.top().at <= deadline) {
+        run_next();
+    }
+    if (now_ < deadline) now_ = deadline;
+}
+
+} // namespace nexus::sim
@@ -0,0 +1,52 @@
+// sim/event_loop.h
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace nexus::sim {
+
+// Виртуальное время симуляции в микросекундах
+using Micros = int64_t;
+
+constexpr Micros MICROS_PER_MS = 1000;
+constexpr Micros MICROS_PER_SECOND = 1000000;
+
+// Однопоточный цикл событий с виртуальными часами. Время сдвигается
+// скачком к следующему событию, поэтому часы симуляции не связаны с
+// реальными. События одного момента выполняются в порядке постановки —
+// при одинаковом seed прогон полностью воспроизводим.
+class EventLoop {
+public:
+    using Task = std::function<void()>;
+
+    Micros now() const { return now_; }
+    size_t pending() const { return queue_.size(); }
+
+    void schedule_at(Micros at, Task task);
+    void schedule_after(Micros delay, Task task) { schedule_at(now_ + delay, std::move(task)); }
+
+    // Выполнить ближайшее событие; false — очередь пуста
+    bool run_next();
+    // Выполнять события не позже deadline; часы останавливаются на deadline
+    void run_until(Micros deadline);
+
+private:
+    struct Event {
+        Micros at;
+        uint64_t seq;
+        Task task;
+    };
+    struct Later {
+        bool operator()(const Event& a, const Event& b) const {
+            return a.at != b.at ? a.at > b.at : a.seq > b.seq;
+        }
+    };
+
+    std::priority_queue<Event, std::vector<Event>, Later> queue_;
+    Micros now_{0};
+    uint64_t next_seq_{0};
+};
+
+} // namespace nexus::sim
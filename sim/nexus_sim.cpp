@@ -0,0 +1,369 @@
+// sim/nexus_sim.cpp
+// Детерминированная симуляция сети узлов в одном процессе. Запускать из
+// каталога сборки (рядом должен лежать schema.sql):
+//   ./nexus-sim --nodes 200 --blocks 50 --latency-ms 80 --out sim.json
+//   ./nexus-sim --nodes 100 --partition 600:900:0.3 --late-joiners 5
+#include "event_loop.h"
+#include "sim_network.h"
+#include "sim_node.h"
+#include "logging/logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+using namespace nexus::sim;
+
+namespace {
+
+const int64_t TIMESTAMP_BASE = 1700000000;  // Виртуальный ноль в метках времени блоков
+
+struct Options {
+    int nodes = 100;
+    size_t peers = 8;                    // Исходящих соединений узла, как MAX_OUTBOUND
+    int blocks = 50;
+    double block_interval_s = 60;        // Среднее время между блоками по всей сети
+    int filler_txs = 0;
+    LinkParams link;
+    NodeParams node;
+    double partition_start_s = -1;       // < 0 — без разбиения
+    double partition_duration_s = 0;
+    double partition_fraction = 0;
+    int late_joiners = 0;
+    double join_at_s = -1;               // < 0 — после последнего блока
+    double drain_s = 120;                // Сколько ждать схождения после последнего блока
+    uint64_t seed = 1;
+};
+
+double to_ms(Micros us) { return static_cast<double>(us) / MICROS_PER_MS; }
+
+nlohmann::json distribution(std::vector<double> values) {
+    if (values.empty()) return {{"count", 0}};
+    std::sort(values.begin(), values.end());
+    auto at = [&](double q) {
+        size_t index = static_cast<size_t>(std::ceil(q * values.size()));
+        return values[std::min(values.size() - 1, index > 0 ? index - 1 : 0)];
+    };
+    double sum = 0;
+    for (double v : values) sum += v;
+    return {
+        {"count", values.size()},
+        {"mean", sum / values.size()},
+        {"p50", at(0.50)},
+        {"p90", at(0.90)},
+        {"p99", at(0.99)},
+        {"max", values.back()}
+    };
+}
+
+// Что и когда произошло с каждым блоком
+class Recorder {
+public:
+    explicit Recorder(size_t node_count) : node_count_(node_count) {}
+
+    void block_accepted(int node, const Block& block, bool replaced, Micros now) {
+        if (replaced) replacements_++;
+        auto [it, inserted] = traces_.try_emplace(block.hash);
+        BlockTrace& trace = it->second;
+        if (inserted) {
+            trace.height = block.height;
+            trace.mined_at = now;
+            trace.seen.assign(node_count_, false);
+            order_.push_back(block.hash);
+        }
+        if (trace.seen[node]) return;
+        trace.seen[node] = true;
+        trace.delays.push_back(now - trace.mined_at);
+    }
+
+    uint64_t replacements() const { return replacements_; }
+    size_t mined() const { return traces_.size(); }
+    const std::vector<std::string>& order() const { return order_; }
+
+    // Задержки по каждому (блок, узел) и время охвата долей сети по блокам
+    nlohmann::json propagation(size_t network_size) const {
+        std::vector<double> arrivals;
+        std::vector<double> reach50, reach90, reach100;
+        for (const auto& hash : order_) {
+            const BlockTrace& trace = traces_.at(hash);
+            std::vector<Micros> delays = trace.delays;
+            std::sort(delays.begin(), delays.end());
+            for (size_t i = 1; i < delays.size(); ++i) arrivals.push_back(to_ms(delays[i]));  // [0] — сам майнер
+            auto reach = [&](double fraction, std::vector<double>& out) {
+                size_t needed = static_cast<size_t>(std::ceil(fraction * network_size));
+                if (needed > 0 && delays.size() >= needed) out.push_back(to_ms(delays[needed - 1]));
+            };
+            reach(0.5, reach50);
+            reach(0.9, reach90);
+            reach(1.0, reach100);
+        }
+        return {
+            {"arrival_ms", distribution(arrivals)},
+            {"reach_50pct_ms", distribution(reach50)},
+            {"reach_90pct_ms", distribution(reach90)},
+            {"reach_100pct_ms", distribution(reach100)}
+        };
+    }
+
+private:
+    struct BlockTrace {
+        int height = 0;
+        Micros mined_at = 0;
+        std::vector<bool> seen;
+        std::vector<Micros> delays;
+    };
+
+    size_t node_count_;
+    std::unordered_map<std::string, BlockTrace> traces_;
+    std::vector<std::string> order_;
+    uint64_t replacements_ = 0;
+};
+
+bool parse_partition(const std::string& spec, Options& options) {
+    std::stringstream ss(spec);
+    char sep1 = 0, sep2 = 0;
+    ss >> options.partition_start_s >> sep1 >> options.partition_duration_s >> sep2 >> options.partition_fraction;
+    return ss && sep1 == ':' && sep2 == ':' && options.partition_fraction > 0 && options.partition_fraction < 1;
+}
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]" << std::endl
+              << "  --nodes <n>               Nodes in the network (default 100)" << std::endl
+              << "  --peers <n>               Outbound connections per node (default 8)" << std::endl
+              << "  --blocks <n>              Blocks to mine (default 50)" << std::endl
+              << "  --block-interval <s>      Mean network-wide block interval (default 60)" << std::endl
+              << "  --filler-txs <n>          Extra transactions per block (default 0)" << std::endl
+              << "  --latency-ms <ms>         One-way link latency (default 50)" << std::endl
+              << "  --jitter-ms <ms>          Uniform extra latency (default 10)" << std::endl
+              << "  --bandwidth-mbps <mbps>   Link bandwidth, 0 = unlimited (default 10)" << std::endl
+              << "  --loss <p>                Segment loss probability (default 0)" << std::endl
+              << "  --validation-ms <ms>      Per-block processing time (default 10)" << std::endl
+              << "  --partition <s:dur:frac>  Split off a fraction of nodes for a time window" << std::endl
+              << "  --late-joiners <n>        Empty nodes that join and sync (default 0)" << std::endl
+              << "  --join-at <s>             When late joiners connect (default: after last block)" << std::endl
+              << "  --drain <s>               Time to converge after the last block (default 120)" << std::endl
+              << "  --seed <n>                Random seed (default 1)" << std::endl
+              << "  --out <file>              Write JSON report to file instead of stdout" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    std::string out_path;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--nodes" && has_value) options.nodes = std::stoi(argv[++i]);
+        else if (arg == "--peers" && has_value) options.peers = std::stoul(argv[++i]);
+        else if (arg == "--blocks" && has_value) options.blocks = std::stoi(argv[++i]);
+        else if (arg == "--block-interval" && has_value) options.block_interval_s = std::stod(argv[++i]);
+        else if (arg == "--filler-txs" && has_value) options.filler_txs = std::stoi(argv[++i]);
+        else if (arg == "--latency-ms" && has_value) options.link.latency = static_cast<Micros>(std::stod(argv[++i]) * MICROS_PER_MS);
+        else if (arg == "--jitter-ms" && has_value) options.link.jitter = static_cast<Micros>(std::stod(argv[++i]) * MICROS_PER_MS);
+        else if (arg == "--bandwidth-mbps" && has_value) options.link.bandwidth = std::stod(argv[++i]) * 1e6 / 8;
+        else if (arg == "--loss" && has_value) options.link.loss = std::stod(argv[++i]);
+        else if (arg == "--validation-ms" && has_value) options.node.block_validation = static_cast<Micros>(std::stod(argv[++i]) * MICROS_PER_MS);
+        else if (arg == "--partition" && has_value) {
+            if (!parse_partition(argv[++i], options)) {
+                std::cerr << "Invalid --partition, expected start:duration:fraction" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--late-joiners" && has_value) options.late_joiners = std::stoi(argv[++i]);
+        else if (arg == "--join-at" && has_value) options.join_at_s = std::stod(argv[++i]);
+        else if (arg == "--drain" && has_value) options.drain_s = std::stod(argv[++i]);
+        else if (arg == "--seed" && has_value) options.seed = std::stoull(argv[++i]);
+        else if (arg == "--out" && has_value) out_path = argv[++i];
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.nodes < 2 || options.blocks < 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // Сотни узлов пишут в лог о каждом блоке, а ожидаемые при форках
+    // предупреждения ("Invalid prevHash") отчёт и так считает — по умолчанию только ошибки
+    nexus::Logger::instance().setLevel(nexus::LogLevel::ERROR);
+    if (const char* spec = std::getenv("NEXUS_LOG")) nexus::Logger::instance().configure(spec);
+
+    auto wall_started = std::chrono::steady_clock::now();
+    EventLoop loop;
+    SimNetwork network(loop, options.link, options.seed);
+    std::mt19937_64 rng(options.seed);
+
+    int total = options.nodes + options.late_joiners;
+    Recorder recorder(options.nodes);
+    std::vector<std::unique_ptr<SimNode>> nodes;
+    std::cerr << "Creating " << total << " nodes..." << std::endl;
+    for (int i = 0; i < total; ++i) {
+        auto node = std::make_unique<SimNode>(i, loop, network, options.node, rng());
+        SimNode* raw = node.get();
+        network.add_endpoint([raw](int from, const std::string& wire) { raw->receive(from, wire); });
+        nodes.push_back(std::move(node));
+    }
+    for (int i = 0; i < options.nodes; ++i) {
+        network.connect_random(i, options.peers, options.nodes);
+    }
+    for (int i = 0; i < options.nodes; ++i) {
+        nodes[i]->start_periodic_sync();
+    }
+
+    // Синхронизация поздних узлов: цель — лучшая высота сети в момент входа
+    std::vector<int> sync_target(total, -1);
+    std::vector<Micros> joined_at(total, 0);
+    std::vector<double> sync_times_s;
+
+    for (auto& node : nodes) {
+        node->set_block_handler([&](int id, const Block& block, bool replaced) {
+            // Поздние узлы получают старые блоки синхронизацией, в распространение не входят
+            if (id < options.nodes) recorder.block_accepted(id, block, replaced, loop.now());
+            if (sync_target[id] >= 0 && block.height >= sync_target[id]) {
+                sync_times_s.push_back(static_cast<double>(loop.now() - joined_at[id]) / MICROS_PER_SECOND);
+                sync_target[id] = -1;
+            }
+        });
+    }
+
+    // Блоки находятся пуассоновским процессом; майнер выбирается равновероятно
+    // (одинаковый хэшрейт), время блока берётся из виртуальных часов
+    std::exponential_distribution<double> interval(1.0 / (options.block_interval_s * MICROS_PER_SECOND));
+    std::uniform_int_distribution<int> pick_miner(0, options.nodes - 1);
+    Micros at = 0;
+    for (int b = 0; b < options.blocks; ++b) {
+        at += static_cast<Micros>(interval(rng));
+        int miner = pick_miner(rng);
+        loop.schedule_at(at, [&, miner]() {
+            nodes[miner]->mine(TIMESTAMP_BASE + loop.now() / MICROS_PER_SECOND, options.filler_txs);
+        });
+    }
+    Micros last_block_at = at;
+
+    if (options.partition_start_s >= 0) {
+        Micros start = static_cast<Micros>(options.partition_start_s * MICROS_PER_SECOND);
+        Micros end = start + static_cast<Micros>(options.partition_duration_s * MICROS_PER_SECOND);
+        int split = static_cast<int>(options.nodes * options.partition_fraction);
+        loop.schedule_at(start, [&, split]() {
+            for (int i = 0; i < split; ++i) network.set_group(i, 1);
+        });
+        loop.schedule_at(end, [&]() { network.heal(); });
+    }
+
+    if (options.late_joiners > 0) {
+        Micros join_at = options.join_at_s >= 0
+            ? static_cast<Micros>(options.join_at_s * MICROS_PER_SECOND)
+            : last_block_at + MICROS_PER_SECOND;
+        loop.schedule_at(join_at, [&]() {
+            int best = 0;
+            for (int i = 0; i < options.nodes; ++i) best = std::max(best, nodes[i]->height());
+            for (int j = options.nodes; j < total; ++j) {
+                joined_at[j] = loop.now();
+                if (best <= nodes[j]->height()) {
+                    sync_times_s.push_back(0);
+                    continue;
+                }
+                sync_target[j] = best;
+                network.connect_random(j, options.peers, options.nodes);
+                // Как после подключения: запрос недостающих блоков у каждого пира
+                for (int peer : network.neighbours(j)) nodes[j]->sync_with(peer);
+                nodes[j]->start_periodic_sync();
+            }
+        });
+        last_block_at = std::max(last_block_at, join_at);
+    }
+
+    std::cerr << "Simulating " << options.blocks << " blocks over "
+              << static_cast<double>(last_block_at) / MICROS_PER_SECOND << "s of virtual time..." << std::endl;
+    loop.run_until(last_block_at + static_cast<Micros>(options.drain_s * MICROS_PER_SECOND));
+
+    // Итоговая цепочка — вершина большинства узлов
+    std::unordered_map<std::string, int> tips;
+    for (int i = 0; i < options.nodes; ++i) tips[nodes[i]->tip_hash()]++;
+    auto consensus = std::max_element(tips.begin(), tips.end(),
+        [](const auto& a, const auto& b) { return a.second < b.second; });
+    SimNode* reference = nullptr;
+    for (int i = 0; i < options.nodes && !reference; ++i) {
+        if (nodes[i]->tip_hash() == consensus->first) reference = nodes[i].get();
+    }
+    std::unordered_map<std::string, bool> in_chain;
+    for (int h = 1; h <= reference->height(); ++h) {
+        auto block = reference->chain().getBlock(h);
+        if (block) in_chain[block->hash] = true;
+    }
+    size_t stale = 0;
+    for (const auto& hash : recorder.order()) {
+        if (!in_chain.count(hash)) stale++;
+    }
+    uint64_t unconnectable = 0;
+    uint64_t duplicates = 0;
+    for (const auto& node : nodes) {
+        unconnectable += node->unconnectable_blocks();
+        duplicates += node->duplicate_blocks();
+    }
+
+    const auto& net = network.stats();
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_started).count();
+    nlohmann::json report = {
+        {"options", {
+            {"nodes", options.nodes},
+            {"peers", options.peers},
+            {"blocks", options.blocks},
+            {"block_interval_s", options.block_interval_s},
+            {"filler_txs", options.filler_txs},
+            {"latency_ms", to_ms(options.link.latency)},
+            {"jitter_ms", to_ms(options.link.jitter)},
+            {"bandwidth_mbps", options.link.bandwidth * 8 / 1e6},
+            {"loss", options.link.loss},
+            {"validation_ms", to_ms(options.node.block_validation)},
+            {"partition", options.partition_start_s >= 0
+                ? nlohmann::json{{"start_s", options.partition_start_s},
+                                 {"duration_s", options.partition_duration_s},
+                                 {"fraction", options.partition_fraction}}
+                : nlohmann::json(nullptr)},
+            {"late_joiners", options.late_joiners},
+            {"seed", options.seed}
+        }},
+        {"propagation", recorder.propagation(options.nodes)},
+        {"forks", {
+            {"blocks_mined", recorder.mined()},
+            {"stale_blocks", stale},
+            {"stale_rate", recorder.mined() > 0 ? static_cast<double>(stale) / recorder.mined() : 0.0},
+            {"tip_replacements", recorder.replacements()},
+            {"unconnectable_blocks", unconnectable},
+            {"duplicate_blocks", duplicates}
+        }},
+        {"convergence", {
+            {"height", reference->height()},
+            {"nodes_at_consensus_tip", consensus->second},
+            {"distinct_tips", tips.size()}
+        }},
+        {"sync_time_s", distribution(sync_times_s)},
+        {"sync_incomplete", std::count_if(sync_target.begin(), sync_target.end(), [](int t) { return t >= 0; })},
+        {"network", {
+            {"messages_sent", net.messages_sent},
+            {"bytes_sent", net.bytes_sent},
+            {"messages_delivered", net.messages_delivered},
+            {"retransmits", net.retransmits},
+            {"dropped_by_partition", net.dropped_by_partition}
+        }},
+        {"virtual_time_s", static_cast<double>(loop.now()) / MICROS_PER_SECOND},
+        {"wall_time_s", wall_s}
+    };
+
+    if (out_path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(out_path);
+        out << report.dump(2) << std::endl;
+    }
+    nexus::Logger::instance().flush();
+    return 0;
+}
@@ -0,0 +1,91 @@
+// sim/sim_network.cpp
+#include "sim_network.h"
+#include <algorithm>
+
+namespace nexus::sim {
+
+SimNetwork::SimNetwork(EventLoop& loop, LinkParams defaults, uint64_t seed)
+    : loop_(loop), defaults_(defaults), rng_(seed) {
+}
+
+int SimNetwork::add_endpoint(Receiver receiver) {
+    endpoints_.push_back({std::move(receiver), {}, 0});
+    return static_cast<int>(endpoints_.size()) - 1;
+}
+
+bool SimNetwork::connect(int a, int b) {
+    return connect(a, b, defaults_);
+}
+
+bool SimNetwork::connect(int a, int b, const LinkParams& params) {
+    if (a == b || connected(a, b)) return false;
+    links_[{a, b}] = Link{params};
+    links_[{b, a}] = Link{params};
+    endpoints_[a].neighbours.push_back(b);
+    endpoints_[b].neighbours.push_back(a);
+    return true;
+}
+
+void SimNetwork::connect_random(int node, size_t outbound, int limit) {
+    if (limit <= 1) return;
+    std::uniform_int_distribution<int> pick(0, limit - 1);
+    // Попыток с запасом: часть выборов попадёт в себя или в уже связанных
+    size_t opened = 0;
+    for (size_t attempt = 0; opened < outbound && attempt < outbound * 8; ++attempt) {
+        if (connect(node, pick(rng_))) opened++;
+    }
+}
+
+void SimNetwork::send(int from, int to, std::string wire) {
+    auto it = links_.find({from, to});
+    if (it == links_.end()) return;
+    Link& link = it->second;
+    const LinkParams& p = link.params;
+
+    stats_.messages_sent++;
+    stats_.bytes_sent += wire.size();
+
+    if (endpoints_[from].group != endpoints_[to].group) {
+        stats_.dropped_by_partition++;
+        return;
+    }
+
+    Micros now = loop_.now();
+    Micros transmit = p.bandwidth > 0
+        ? static_cast<Micros>(static_cast<double>(wire.size()) / p.bandwidth * MICROS_PER_SECOND)
+        : 0;
+    Micros departed = std::max(now, link.busy_until) + transmit;
+    link.busy_until = departed;
+
+    Micros arrival = departed + p.latency;
+    if (p.jitter > 0) {
+        arrival += std::uniform_int_distribution<Micros>(0, p.jitter)(rng_);
+    }
+    if (p.loss > 0) {
+        std::bernoulli_distribution lost(p.loss);
+        Micros rto = p.retransmit_timeout;
+        while (lost(rng_)) {
+            arrival += rto;
+            rto *= 2;
+            stats_.retransmits++;
+        }
+    }
+    arrival = std::max(arrival, link.last_arrival);
+    link.last_arrival = arrival;
+
+    loop_.schedule_at(arrival, [this, from, to, wire = std::move(wire)]() {
+        // Разбиение могло начаться, пока сообщение было в пути
+        if (endpoints_[from].group != endpoints_[to].group) {
+            stats_.dropped_by_partition++;
+            return;
+        }
+        stats_.messages_delivered++;
+        endpoints_[to].receiver(from, wire);
+    });
+}
+
+void SimNetwork::heal() {
+    for (auto& endpoint : endpoints_) endpoint.group = 0;
+}
+
+} // namespace nexus::sim
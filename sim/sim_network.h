@@ -0,0 +1,83 @@
+// sim/sim_network.h
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <functional>
+#include "event_loop.h"
+
+namespace nexus::sim {
+
+// Параметры направленного канала между двумя узлами
+struct LinkParams {
+    Micros latency = 50 * MICROS_PER_MS;   // Задержка распространения в одну сторону
+    Micros jitter = 10 * MICROS_PER_MS;    // Добавка, равномерная в [0, jitter]
+    double bandwidth = 1250000;            // Байт в секунду (10 Мбит/с); 0 — без ограничения
+    double loss = 0;                       // Вероятность потери сегмента
+    Micros retransmit_timeout = 200 * MICROS_PER_MS;
+};
+
+// Модель сети поверх EventLoop. Узлы связаны TCP-подобными каналами:
+// сообщения одного направления приходят по порядку, передача занимает
+// size / bandwidth и ждёт освобождения канала, потерянный сегмент
+// доставляется после таймаута повторной передачи (RTO удваивается
+// при каждой следующей потере). Сообщения между разными разбиениями
+// пропадают, как в "чёрную дыру".
+class SimNetwork {
+public:
+    using Receiver = std::function<void(int from, const std::string& wire)>;
+
+    struct Stats {
+        uint64_t messages_sent = 0;
+        uint64_t bytes_sent = 0;
+        uint64_t messages_delivered = 0;
+        uint64_t retransmits = 0;
+        uint64_t dropped_by_partition = 0;
+    };
+
+    SimNetwork(EventLoop& loop, LinkParams defaults, uint64_t seed);
+
+    // Возвращает идентификатор конечной точки (индекс узла)
+    int add_endpoint(Receiver receiver);
+    size_t size() const { return endpoints_.size(); }
+
+    // Двунаправленное соединение; повторное соединение игнорируется
+    bool connect(int a, int b);
+    bool connect(int a, int b, const LinkParams& params);
+    bool connected(int a, int b) const { return links_.count({a, b}) > 0; }
+    const std::vector<int>& neighbours(int id) const { return endpoints_[id].neighbours; }
+
+    // Случайная топология: каждый узел открывает outbound соединений
+    // к случайным узлам из [0, limit)
+    void connect_random(int node, size_t outbound, int limit);
+
+    void send(int from, int to, std::string wire);
+
+    // Разбиения: узлы с разными группами не получают сообщений друг друга
+    void set_group(int id, int group) { endpoints_[id].group = group; }
+    void heal();
+
+    const Stats& stats() const { return stats_; }
+
+private:
+    struct Endpoint {
+        Receiver receiver;
+        std::vector<int> neighbours;
+        int group = 0;
+    };
+    struct Link {
+        LinkParams params;
+        Micros busy_until = 0;     // Когда канал закончит передавать очередь
+        Micros last_arrival = 0;   // Сохраняем порядок доставки внутри канала
+    };
+
+    EventLoop& loop_;
+    LinkParams defaults_;
+    std::mt19937_64 rng_;
+    std::vector<Endpoint> endpoints_;
+    std::map<std::pair<int, int>, Link> links_;  // (от кого, кому)
+    Stats stats_;
+};
+
+} // namespace nexus::sim
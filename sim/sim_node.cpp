@@ -0,0 +1,251 @@
+// sim/sim_node.cpp
+#include "sim_node.h"
+#include "logging/logger.h"
+#include <algorithm>
+
+namespace nexus::sim {
+
+namespace {
+
+// Как Node::BLOCK_REQUEST_TIMEOUT
+const Micros BLOCK_REQUEST_TIMEOUT = 10 * MICROS_PER_SECOND;
+
+} // namespace
+
+SimNode::SimNode(int id, EventLoop& loop, SimNetwork& network, NodeParams params, uint64_t seed)
+    : id_(id),
+      name_("sim_node_" + std::to_string(id)),
+      loop_(loop),
+      network_(network),
+      params_(params),
+      rng_(seed),
+      chain_(std::make_unique<Blockchain>(":memory:")) {
+    // Блоки симуляции не майнятся: nonce случайный, PoW не выполнен
+    chain_->setProofOfWorkCheck(false);
+}
+
+std::string SimNode::tip_hash() {
+    auto tip = chain_->getBlock(chain_->getHeight());
+    return tip ? tip->hash : std::string();
+}
+
+void SimNode::receive(int from, const std::string& wire) {
+    Message msg;
+    try {
+        msg = Message::deserialize(wire);
+    } catch (const std::exception& e) {
+        LOG_WARN(NET, "Malformed simulated message").kv("node", id_).kv("error", e.what());
+        return;
+    }
+    // Очередь обработки одна на узел: следующее сообщение ждёт предыдущее
+    Micros start = std::max(loop_.now(), busy_until_);
+    busy_until_ = start + processing_cost(msg);
+    loop_.schedule_at(busy_until_, [this, from, msg = std::move(msg)]() { handle(from, msg); });
+}
+
+Micros SimNode::processing_cost(const Message& msg) const {
+    switch (msg.type) {
+        case MessageType::NEW_BLOCK:
+            // Заголовок только запускает запрос тела
+            return msg.payload.contains("transactions") ? params_.block_validation : 0;
+        case MessageType::BLOCKS_RESPONSE:
+            return params_.block_validation * static_cast<Micros>(msg.payload.is_array() ? msg.payload.size() : 0);
+        default:
+            return 0;
+    }
+}
+
+void SimNode::handle(int from, const Message& msg) {
+    switch (msg.type) {
+        case MessageType::NEW_BLOCK:
+            handle_new_block(from, msg);
+            break;
+        case MessageType::GET_BLOCKS:
+            handle_get_blocks(from, msg);
+            break;
+        case MessageType::BLOCKS_RESPONSE:
+            handle_blocks_response(from, msg);
+            break;
+        default:
+            break;
+    }
+}
+
+void SimNode::handle_new_block(int from, const Message& msg) {
+    Block block;
+    block.fromJson(msg.payload);
+    known_blocks_[from].insert(block.hash);
+    if (chain_->knowsBlock(block.hash)) return;
+    if (msg.payload.contains("transactions")) {
+        in_flight_.erase(block.hash);
+        handle_accepted(from, chain_->acceptBlocks({block}));
+    } else {
+        request_block(from, block);
+    }
+}
+
+bool SimNode::in_flight(const std::string& hash) const {
+    auto it = in_flight_.find(hash);
+    return it != in_flight_.end() && loop_.now() - it->second < BLOCK_REQUEST_TIMEOUT;
+}
+
+// Как Node::requestBlock
+void SimNode::request_block(int from, const Block& header) {
+    if (in_flight(header.hash)) return;
+    in_flight_[header.hash] = loop_.now();
+    if (!chain_->knowsBlock(header.prevHash) && !in_flight(header.prevHash)) {
+        sync_with(from, header.height);
+        return;
+    }
+    Message req(MessageType::GET_BLOCKS);
+    req.sender_id = name_;
+    req.payload = {{"from_height", header.height}, {"hashes", {header.hash}}};
+    send(from, req);
+}
+
+// Как GET_BLOCKS в Node::handleMessage: ответ начинается после общего предка
+void SimNode::handle_get_blocks(int from, const Message& msg) {
+    if (msg.payload.contains("hashes") && msg.payload["hashes"].is_array()) {
+        nlohmann::json blocks = nlohmann::json::array();
+        for (const auto& h : msg.payload["hashes"]) {
+            if (!h.is_string()) continue;
+            if (auto block = chain_->getBlockByHash(h.get<std::string>())) blocks.push_back(block->toJson());
+        }
+        if (blocks.empty()) return;
+        Message response(MessageType::BLOCKS_RESPONSE);
+        response.sender_id = name_;
+        response.payload = std::move(blocks);
+        send(from, response);
+        return;
+    }
+
+    int from_height = msg.payload.value("from_height", 0);
+    int current_height = chain_->getHeight();
+    if (msg.payload.contains("locator") && msg.payload["locator"].is_array()) {
+        std::vector<std::string> locator;
+        for (const auto& h : msg.payload["locator"]) {
+            if (h.is_string()) locator.push_back(h.get<std::string>());
+        }
+        int fork = chain_->findLocatorFork(locator);
+        if (fork >= 0) from_height = fork + 1;
+    }
+    int to_height = std::min(current_height, msg.payload.value("to_height", current_height));
+    nlohmann::json blocks = nlohmann::json::array();
+    for (int h = from_height; h <= to_height; ++h) {
+        auto block = chain_->getBlock(h);
+        if (block) blocks.push_back(block->toJson());
+    }
+    if (blocks.empty()) return;
+
+    Message response(MessageType::BLOCKS_RESPONSE);
+    response.sender_id = name_;
+    response.payload = std::move(blocks);
+    send(from, response);
+}
+
+void SimNode::handle_blocks_response(int from, const Message& msg) {
+    if (!msg.payload.is_array()) return;
+    for (const auto& json : msg.payload) {
+        std::string hash = json.is_object() ? json.value("hash", "") : "";
+        known_blocks_[from].insert(hash);
+        in_flight_.erase(hash);
+    }
+    handle_accepted(from, chain_->acceptBlocks(msg.payload));
+}
+
+// Как Node::handleAcceptedBlocks
+void SimNode::handle_accepted(int from, const AcceptResult& result) {
+    duplicate_blocks_ += result.duplicates;
+    unconnectable_blocks_ += result.orphaned;
+    for (const auto& block : result.connected) accepted(block, result.disconnected > 0);
+    if (!result.connected.empty()) broadcast_block(result.connected.back());
+    for (const auto& missing : result.missingParents) {
+        if (!in_flight(missing.first)) sync_with(from, missing.second);
+    }
+}
+
+void SimNode::mine(int64_t timestamp, int filler_txs) {
+    Block block = chain_->createBlock(name_);
+    block.timestamp = timestamp;
+
+    // Метки времени берутся из виртуальных часов, чтобы прогон с тем же
+    // seed давал те же хэши
+    Transaction& coinbase = block.transactions.front();
+    coinbase.timestamp = timestamp;
+    coinbase.txHash = coinbase.calculateHash();
+    for (int i = 0; i < filler_txs; ++i) {
+        Transaction tx;
+        tx.fromAddress = "genesis_miner";
+        tx.toAddress = "sim_sink_" + std::to_string(i % 16);
+        // Разные суммы — разные хэши: data в хэш транзакции не входит
+        tx.amount = COIN / 1000000 * (i + 1);
+        tx.fee = 0;
+        tx.timestamp = timestamp;
+        tx.signature = "sim_signature";
+        tx.data = name_ + "/" + std::to_string(block.height) + "/" + std::to_string(i);
+        tx.status = "confirmed";
+        tx.txHash = tx.calculateHash();
+        block.transactions.push_back(std::move(tx));
+    }
+
+    block.merkleRoot = block.calculateMerkleRoot();
+    block.nonce = static_cast<int>(rng_() & 0x7fffffff);
+    block.hash = block.calculateHash();
+    if (!chain_->addBlock(block)) return;
+    accepted(block, false);
+    broadcast_block(block);
+}
+
+void SimNode::sync_with(int peer, int to_height) {
+    Message req(MessageType::GET_BLOCKS);
+    req.sender_id = name_;
+    req.payload = {{"from_height", chain_->getHeight() + 1}, {"locator", chain_->getLocator()}};
+    if (to_height >= 0) req.payload["to_height"] = to_height;
+    send(peer, req);
+}
+
+void SimNode::start_periodic_sync() {
+    schedule_sync();
+}
+
+void SimNode::schedule_sync() {
+    Micros jitter = std::uniform_int_distribution<Micros>(-params_.sync_jitter, params_.sync_jitter)(rng_);
+    loop_.schedule_after(params_.sync_interval + jitter, [this]() {
+        const auto& peers = network_.neighbours(id_);
+        if (!peers.empty()) {
+            sync_with(peers[std::uniform_int_distribution<size_t>(0, peers.size() - 1)(rng_)]);
+        }
+        schedule_sync();
+    });
+}
+
+void SimNode::accepted(const Block& block, bool replaced) {
+    if (block_handler_) block_handler_(id_, block, replaced);
+}
+
+// Как Node::broadcastBlock: заголовок, соседям, которые блок ещё не знают
+void SimNode::broadcast_block(const Block& block) {
+    Message msg(MessageType::NEW_BLOCK);
+    msg.sender_id = name_;
+    msg.payload = {
+        {"height", block.height},
+        {"hash", block.hash},
+        {"prevHash", block.prevHash},
+        {"merkleRoot", block.merkleRoot},
+        {"timestamp", block.timestamp},
+        {"nonce", block.nonce},
+        {"difficulty", block.difficulty},
+        {"minedBy", block.minedBy}
+    };
+    std::string wire = msg.serialize();
+    for (int peer : network_.neighbours(id_)) {
+        if (!known_blocks_[peer].insert(block.hash).second) continue;
+        network_.send(id_, peer, wire);
+    }
+}
+
+void SimNode::send(int to, const Message& msg) {
+    network_.send(id_, to, msg.serialize());
+}
+
+} // namespace nexus::sim
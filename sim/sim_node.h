@@ -0,0 +1,87 @@
+// sim/sim_node.h
+#pragma once
+#include <string>
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include "event_loop.h"
+#include "sim_network.h"
+#include "blockchain/blockchain.h"
+#include "network/message.h"
+
+namespace nexus::sim {
+
+struct NodeParams {
+    Micros block_validation = 10 * MICROS_PER_MS;    // Время проверки и записи одного блока
+    Micros sync_interval = 30 * MICROS_PER_SECOND;   // Как периодическая задача "sync" узла
+    Micros sync_jitter = 3 * MICROS_PER_SECOND;
+};
+
+// Узел симуляции: настоящий Blockchain на БД в памяти и тот же протокол
+// распространения блоков, что у nexus::Node (NEW_BLOCK, GET_BLOCKS /
+// BLOCKS_RESPONSE, периодическая синхронизация со случайным пиром),
+// но поверх SimNetwork и виртуальных часов вместо сокетов и потоков.
+// Сообщения сериализуются в тот же формат, поэтому их размер настоящий.
+// Входящие сообщения обрабатываются по одному, как в io-потоке узла.
+class SimNode {
+public:
+    // Узел принял блок в свою цепочку (replaced — вместо своего последнего)
+    using BlockHandler = std::function<void(int node, const Block& block, bool replaced)>;
+
+    SimNode(int id, EventLoop& loop, SimNetwork& network, NodeParams params, uint64_t seed);
+
+    int id() const { return id_; }
+    const std::string& name() const { return name_; }
+    Blockchain& chain() { return *chain_; }
+    int height() const { return chain_->getHeight(); }
+    std::string tip_hash();
+    uint64_t unconnectable_blocks() const { return unconnectable_blocks_; }
+    uint64_t duplicate_blocks() const { return duplicate_blocks_; }
+
+    void set_block_handler(BlockHandler handler) { block_handler_ = std::move(handler); }
+
+    // Вход сети: вызывается SimNetwork при доставке сообщения
+    void receive(int from, const std::string& wire);
+
+    // Узел нашёл блок на своей вершине. Шаблон собирается так же, как в
+    // mine_loop; filler_txs добавляют вес блоку для синхронизации
+    void mine(int64_t timestamp, int filler_txs);
+
+    // Запросить недостающие блоки у пира, как после подключения;
+    // to_height >= 0 — только до этой высоты (родители сироты)
+    void sync_with(int peer, int to_height = -1);
+    void start_periodic_sync();
+
+private:
+    void handle(int from, const Message& msg);
+    void handle_new_block(int from, const Message& msg);
+    void request_block(int from, const Block& header);
+    bool in_flight(const std::string& hash) const;
+    void handle_get_blocks(int from, const Message& msg);
+    void handle_blocks_response(int from, const Message& msg);
+    void handle_accepted(int from, const AcceptResult& result);
+    void accepted(const Block& block, bool replaced);
+    void broadcast_block(const Block& block);
+    void send(int to, const Message& msg);
+    Micros processing_cost(const Message& msg) const;
+    void schedule_sync();
+
+    int id_;
+    std::string name_;
+    EventLoop& loop_;
+    SimNetwork& network_;
+    NodeParams params_;
+    std::mt19937_64 rng_;
+    std::unique_ptr<Blockchain> chain_;
+    BlockHandler block_handler_;
+    Micros busy_until_{0};
+    uint64_t unconnectable_blocks_{0};
+    uint64_t duplicate_blocks_{0};
+    // Как Peer::known_blocks: блоки, которые сосед прислал или получил от нас
+    std::unordered_map<int, std::unordered_set<std::string>> known_blocks_;
+    std::unordered_map<std::string, Micros> in_flight_;   // Запрошенные тела блоков
+};
+
+} // namespace nexus::sim
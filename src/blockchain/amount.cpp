@@ -0,0 +1,94 @@
+// src/blockchain/amount.cpp
+#include "amount.h"
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+bool addAmount(Amount a, Amount b, Amount& out) {
+    Amount result;
+    if (__builtin_add_overflow(a, b, &result)) return false;
+    out = result;
+    return true;
+}
+
+bool subAmount(Amount a, Amount b, Amount& out) {
+    Amount result;
+    if (__builtin_sub_overflow(a, b, &result)) return false;
+    out = result;
+    return true;
+}
+
+std::string formatAmount(Amount amount) {
+    // Модуль в беззнаковом: у INT64_MIN нет положительной пары
+    uint64_t magnitude = amount < 0 ? 0 - static_cast<uint64_t>(amount) : static_cast<uint64_t>(amount);
+    std::string out = amount < 0 ? "-" : "";
+    out += std::to_string(magnitude / COIN);
+    uint64_t fraction = magnitude % COIN;
+    if (fraction == 0) return out;
+
+    std::string digits = std::to_string(fraction);
+    digits.insert(0, AMOUNT_DECIMALS - digits.size(), '0');
+    digits.erase(digits.find_last_not_of('0') + 1);
+    return out + "." + digits;
+}
+
+bool parseAmount(const std::string& text, Amount& out) {
+    size_t pos = 0;
+    bool negative = false;
+    if (pos < text.size() && (text[pos] == '-' || text[pos] == '+')) negative = text[pos++] == '-';
+
+    Amount whole = 0;
+    size_t wholeDigits = 0;
+    for (; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos, ++wholeDigits) {
+        if (__builtin_mul_overflow(whole, 10, &whole) || __builtin_add_overflow(whole, text[pos] - '0', &whole)) {
+            return false;
+        }
+    }
+
+    Amount fraction = 0;
+    int fractionDigits = 0;
+    if (pos < text.size() && text[pos] == '.') {
+        for (++pos; pos < text.size() && text[pos] >= '0' && text[pos] <= '9'; ++pos) {
+            if (++fractionDigits > AMOUNT_DECIMALS) return false;
+            fraction = fraction * 10 + (text[pos] - '0');
+        }
+    }
+    if (pos != text.size() || (wholeDigits == 0 && fractionDigits == 0)) return false;
+    for (int i = fractionDigits; i < AMOUNT_DECIMALS; ++i) fraction *= 10;
+
+    Amount value;
+    if (__builtin_mul_overflow(whole, COIN, &value) || __builtin_add_overflow(value, fraction, &value)) return false;
+    out = negative ? -value : value;
+    return true;
+}
+
+double amountToCoins(Amount amount) {
+    // Одно деление: для сумм с не более чем AMOUNT_DECIMALS знаками это
+    // тот же double, что давал литерал или разбор JSON
+    return static_cast<double>(amount) / COIN;
+}
+
+bool amountFromCoins(double coins, Amount& out) {
+    double scaled = std::round(coins * COIN);
+    // 2^63 представимо точно; всё, что не меньше, в int64 не входит
+    constexpr double LIMIT = 9223372036854775808.0;
+    if (!std::isfinite(scaled) || scaled >= LIMIT || scaled < -LIMIT) return false;
+    out = static_cast<Amount>(scaled);
+    return true;
+}
+
+Amount amountFromJson(const nlohmann::json& value) {
+    Amount amount = 0;
+    if (value.is_string()) {
+        if (!parseAmount(value.get<std::string>(), amount)) {
+            throw std::invalid_argument("malformed amount: " + value.get<std::string>());
+        }
+    } else if (value.is_number_integer()) {
+        if (__builtin_mul_overflow(value.get<int64_t>(), COIN, &amount)) {
+            throw std::invalid_argument("amount out of range");
+        }
+    } else if (!value.is_number() || !amountFromCoins(value.get<double>(), amount)) {
+        throw std::invalid_argument("malformed amount");
+    }
+    return amount;
+}
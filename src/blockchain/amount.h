@@ -0,0 +1,37 @@
+// src/blockchain/amount.h
+#pragma once
+#include <cstdint>
+#include <string>
+#include <nlohmann/json.hpp>
+
+// Суммы и балансы — целые минимальные единицы: 1 монета = COIN единиц.
+// Девять знаков после запятой покрывают все суммы, что раньше ходили как
+// double (генератор нагрузки давал шаг 1e-9). Снаружи — в JSON, логах,
+// API — сумма пишется десятичной строкой монет ("12.5"), без двоичного округления.
+using Amount = int64_t;
+
+constexpr int AMOUNT_DECIMALS = 9;
+constexpr Amount COIN = 1000000000;
+// Предел суммы и комиссии транзакции: их сумма заведомо умещается в int64
+constexpr Amount MAX_AMOUNT = 1000000000 * COIN;
+
+// false — переполнение, out не меняется
+bool addAmount(Amount a, Amount b, Amount& out);
+bool subAmount(Amount a, Amount b, Amount& out);
+
+// "-1.25", "100", "0.000012345": без лишних нулей в дробной части
+std::string formatAmount(Amount amount);
+// Строго десятичная запись: знак, цифры, не больше AMOUNT_DECIMALS знаков
+// после точки. Лишние знаки не округляются — запись отклоняется
+bool parseAmount(const std::string& text, Amount& out);
+
+// Монеты как double: для старых записей (REAL в SQLite, f64 в block_codec)
+// и для хэша транзакции версии 1
+double amountToCoins(Amount amount);
+// false — не конечное число или вне предела
+bool amountFromCoins(double coins, Amount& out);
+
+// Сумма в JSON — строка; число (старые клиенты и узлы) округляется до
+// минимальной единицы. Бросает std::invalid_argument
+Amount amountFromJson(const nlohmann::json& value);
+inline nlohmann::json amountToJson(Amount amount) { return formatAmount(amount); }
@@ -75,7 +75,7 @@ nlohmann::json Block::toJson() const {
     
     nlohmann::json txs = nlohmann::json::array();
     for (const auto& tx : transactions) {
-        txs.push_back(tx.toJson());
+        txs.push_back(tx.toJsonObject());
     }
     j["transactions"] = txs;
     
@@ -83,6 +83,17 @@ nlohmann::json Block::toJson() const {
 }
 
 void Block::fromJson(const nlohmann::json& j) {
+    headerFromJson(j);
+    
+    transactions.clear();
+    if (j.contains("transactions") && j["transactions"].is_array()) {
+        for (const auto& txJson : j["transactions"]) {
+            transactions.push_back(transactionFromJson(txJson));
+        }
+    }
+}
+
+void Block::headerFromJson(const nlohmann::json& j) {
     height = j.value("height", 0);
     hash = j.value("hash", "");
     prevHash = j.value("prevHash", "");
@@ -91,22 +102,12 @@ void Block::fromJson(const nlohmann::json& j) {
     nonce = j.value("nonce", 0);
     difficulty = j.value("difficulty", 2.0);
     minedBy = j.value("minedBy", "");
-    
-    transactions.clear();
-    if (j.contains("transactions") && j["transactions"].is_array()) {
-        for (const auto& txJson : j["transactions"]) {
-            Transaction tx;
-            tx.fromAddress = txJson.value("from", "");
-            tx.toAddress = txJson.value("to", "");
-            tx.amount = txJson.value("amount", 0.0);
-            tx.fee = txJson.value("fee", 0.0);
-            tx.signature = txJson.value("signature", "");
-            tx.timestamp = txJson.value("timestamp", 0L);
-            tx.data = txJson.value("data", "");
-            tx.status = txJson.value("status", "pending");
-            tx.nonce = txJson.value("nonce", 0ULL);
-            tx.txHash = tx.calculateHash();
-            transactions.push_back(tx);
-        }
+}
+
+Transaction Block::transactionFromJson(const nlohmann::json& txJson) {
+    // Старые узлы кладут транзакцию строкой JSON
+    if (txJson.is_string()) {
+        return Transaction::fromJson(nlohmann::json::parse(txJson.get<std::string>()));
     }
+    return Transaction::fromJson(txJson);
 }
\ No newline at end of file
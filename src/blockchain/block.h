@@ -26,4 +26,8 @@ struct Block {
 
     nlohmann::json toJson() const;
     void fromJson(const nlohmann::json& j);
+    // Только поля заголовка: транзакции разбирает конвейер проверки
+    void headerFromJson(const nlohmann::json& j);
+    // Транзакция из массива "transactions"; txHash пересчитывается
+    static Transaction transactionFromJson(const nlohmann::json& txJson);
 };
\ No newline at end of file
@@ -0,0 +1,96 @@
+// src/blockchain/block_executor.cpp
+#include "block_executor.h"
+#include "../core/thread_pool.h"
+#include <algorithm>
+#include <future>
+#include <memory>
+
+namespace {
+
+// Изменения балансов от одной части блока
+struct ChunkSum {
+    std::map<std::string, Amount> deltas;
+    size_t applied = 0;
+    bool overflow = false;
+};
+
+void sumChunk(const std::vector<Transaction>& txs, size_t begin, size_t end,
+              const BlockExecutor::TxPreparer& prepare, ChunkSum& sum) {
+    for (size_t i = begin; i < end; ++i) {
+        const Transaction& tx = txs[i];
+        if (!prepare(i, tx)) continue;
+        sum.applied++;
+        Amount spend;
+        Amount& to = sum.deltas[tx.toAddress];
+        if (!addAmount(to, tx.amount, to) || !addAmount(tx.amount, tx.fee, spend)) {
+            sum.overflow = true;
+            continue;
+        }
+        Amount& from = sum.deltas[tx.fromAddress];
+        if (!subAmount(from, spend, from)) sum.overflow = true;
+    }
+}
+
+} // namespace
+
+void BlockExecutor::forEachChunk(size_t count, size_t chunk, const std::function<void(size_t, size_t)>& task) const {
+    if (!pool_ || count < PARALLEL_MIN_TXS) {
+        task(0, count);
+        return;
+    }
+    std::vector<std::future<void>> parts;
+    for (size_t begin = 0; begin < count; begin += chunk) {
+        size_t end = std::min(count, begin + chunk);
+        auto done = std::make_shared<std::promise<void>>();
+        parts.push_back(done->get_future());
+        pool_->submit([&task, begin, end, done]() {
+            try {
+                task(begin, end);
+                done->set_value();
+            } catch (...) {
+                done->set_exception(std::current_exception());
+            }
+        });
+    }
+    // Все части дожидаются до первого get, бросающего исключение:
+    // задачи ссылаются на локальные переменные
+    for (auto& part : parts) part.wait();
+    for (auto& part : parts) part.get();
+}
+
+BlockExecution BlockExecutor::execute(const std::vector<Transaction>& txs, const StateReader& read,
+                                      const TxPreparer& prepare) const {
+    // Без пула forEachChunk отдаёт всё одной частью — в sums[0]
+    std::vector<ChunkSum> sums(std::max<size_t>(1, (txs.size() + TX_CHUNK - 1) / TX_CHUNK));
+    forEachChunk(txs.size(), TX_CHUNK, [&](size_t begin, size_t end) {
+        sumChunk(txs, begin, end, prepare, sums[begin / TX_CHUNK]);
+    });
+
+    BlockExecution result;
+    for (const auto& sum : sums) {
+        result.applied += sum.applied;
+        if (sum.overflow) result.overflow = true;
+        for (const auto& [address, delta] : sum.deltas) {
+            Amount& total = result.balanceDeltas[address];
+            if (!addAmount(total, delta, total)) result.overflow = true;
+        }
+    }
+    if (result.overflow || !read) return result;
+
+    std::vector<std::string> addresses;
+    addresses.reserve(result.balanceDeltas.size());
+    for (const auto& [address, delta] : result.balanceDeltas) addresses.push_back(address);
+    std::vector<AccountState> states(addresses.size());
+    forEachChunk(addresses.size(), TX_CHUNK, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) states[i] = read(addresses[i]);
+    });
+    for (size_t i = 0; i < addresses.size(); ++i) {
+        AccountState& state = states[i];
+        if (!addAmount(state.balance, result.balanceDeltas[addresses[i]], state.balance)) {
+            result.overflow = true;
+            return result;
+        }
+        result.accounts.emplace(addresses[i], state);
+    }
+    return result;
+}
@@ -0,0 +1,61 @@
+// src/blockchain/block_executor.h
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <cstdint>
+#include <functional>
+#include "transaction.h"
+
+namespace nexus { class ThreadPool; }
+
+// Счёт, как его видит исполнение блока. Nonce исполнение не меняет, а
+// переносит из прочитанного, чтобы хранилище записало счёт целиком
+struct AccountState {
+    Amount balance = 0;
+    uint64_t nonce = 0;
+};
+
+// Итог исполнения блока — ровно то, что дал бы последовательный проход
+struct BlockExecution {
+    std::map<std::string, AccountState> accounts;   // Итоговые значения затронутых счетов (если есть StateReader)
+    std::map<std::string, Amount> balanceDeltas;    // Изменения по счетам, как в undo-записи
+    size_t applied = 0;        // Транзакций, изменивших балансы
+    bool overflow = false;     // Баланс или изменение вышли за Amount: блок применять нельзя
+};
+
+// Параллельное суммирование изменений балансов блока. Транзакция блока
+// только прибавляет получателю amount и вычитает у отправителя amount + fee,
+// без проверок, зависящих от баланса, поэтому изменения перестановочны:
+// части блока суммируются в пуле независимо, затем суммы частей
+// складываются по порядку, и итог не зависит от разбиения. Конфликтов
+// между транзакциями здесь нет и перевыполнять нечего. Итоговые значения
+// счетов — прочитанные до блока плюс сумма изменений; переполнение
+// проверяется у сумм и итогов.
+class BlockExecutor {
+public:
+    // Меньше — всё в вызывающем потоке: раздача задач дороже самой работы
+    static constexpr size_t PARALLEL_MIN_TXS = 64;
+    static constexpr size_t TX_CHUNK = 128;
+
+    // Счёт до блока; с пулом вызывается из его потоков одновременно
+    using StateReader = std::function<AccountState(const std::string& address)>;
+    // Своя работа хранилища над транзакцией и ответ, меняет ли она балансы.
+    // Вызывается ровно один раз на индекс, с пулом — из его потоков
+    using TxPreparer = std::function<bool(size_t index, const Transaction& tx)>;
+
+    // pool == nullptr — всё в вызывающем потоке. Вызывающий не должен
+    // сам быть задачей этого пула: execute ждёт его задачи
+    explicit BlockExecutor(nexus::ThreadPool* pool = nullptr) : pool_(pool) {}
+
+    // read пустой — итоговые счета не нужны (хранилище прибавляет изменения
+    // само), accounts остаётся пустым
+    BlockExecution execute(const std::vector<Transaction>& txs, const StateReader& read,
+                           const TxPreparer& prepare) const;
+
+private:
+    // Выполнить task(begin, end) по частям размера chunk: в пуле или здесь же
+    void forEachChunk(size_t count, size_t chunk, const std::function<void(size_t, size_t)>& task) const;
+
+    nexus::ThreadPool* pool_;
+};
@@ -0,0 +1,230 @@
+// src/blockchain/block_index.cpp
+#include "block_index.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const std::string EMPTY_HASH;
+
+} // namespace
+
+double BlockIndex::blockWork(double difficulty) {
+    return std::pow(16.0, std::max(0.0, difficulty));
+}
+
+bool BlockIndex::betterThan(const BlockIndexEntry& a, const BlockIndexEntry& b) {
+    if (a.chainWork != b.chainWork) return a.chainWork > b.chainWork;
+    // Правило одинаково на всех узлах, поэтому равные ветки не перебрасываются
+    return a.hash < b.hash;
+}
+
+const BlockIndexEntry* BlockIndex::find(const std::string& hash) const {
+    auto it = entries_.find(hash);
+    return it == entries_.end() ? nullptr : &it->second;
+}
+
+bool BlockIndex::appendConnected(const Block& header) {
+    double parentWork = 0;
+    if (!active_.empty()) {
+        if (header.height != tipHeight() + 1 || header.prevHash != active_.back()) return false;
+        parentWork = tip()->chainWork;
+    } else if (header.height != 0) {
+        return false;
+    }
+
+    BlockIndexEntry& entry = entries_[header.hash];
+    entry.hash = header.hash;
+    entry.prevHash = header.prevHash;
+    entry.height = header.height;
+    entry.difficulty = header.difficulty;
+    entry.chainWork = parentWork + blockWork(header.difficulty);
+    entry.status = BlockStatus::CONNECTED;
+    entry.body.reset();
+    side_.erase(header.hash);
+    active_.push_back(header.hash);
+    considerBest(entry);
+    return true;
+}
+
+const BlockIndexEntry* BlockIndex::insert(const Block& block) {
+    if (auto* existing = find(block.hash)) return existing;
+    const BlockIndexEntry* parent = find(block.prevHash);
+    if (!parent || block.height != parent->height + 1) return nullptr;
+
+    BlockIndexEntry entry;
+    entry.hash = block.hash;
+    entry.prevHash = block.prevHash;
+    entry.height = block.height;
+    entry.difficulty = block.difficulty;
+    entry.chainWork = parent->chainWork + blockWork(block.difficulty);
+    entry.status = parent->status == BlockStatus::FAILED ? BlockStatus::FAILED : BlockStatus::CONNECTABLE;
+    entry.body = block;
+    auto [it, inserted] = entries_.emplace(block.hash, std::move(entry));
+    side_.insert(block.hash);
+    considerBest(it->second);
+    return &it->second;
+}
+
+const BlockIndexEntry* BlockIndex::tip() const {
+    return active_.empty() ? nullptr : find(active_.back());
+}
+
+const std::string& BlockIndex::activeHash(int height) const {
+    if (height < 0 || height > tipHeight()) return EMPTY_HASH;
+    return active_[height];
+}
+
+bool BlockIndex::isActive(const BlockIndexEntry& entry) const {
+    return entry.height >= 0 && entry.height <= tipHeight() && active_[entry.height] == entry.hash;
+}
+
+std::vector<const BlockIndexEntry*> BlockIndex::branchTo(const std::string& hash) const {
+    std::vector<const BlockIndexEntry*> branch;
+    const BlockIndexEntry* entry = find(hash);
+    while (entry && !isActive(*entry)) {
+        if (entry->status == BlockStatus::FAILED || !entry->body) return {};
+        branch.push_back(entry);
+        entry = find(entry->prevHash);
+    }
+    if (!entry) return {};
+    return {branch.rbegin(), branch.rend()};
+}
+
+void BlockIndex::switchTo(int forkHeight, std::vector<Block> disconnected, const std::vector<Block>& branch) {
+    std::unordered_map<std::string, Block> bodies;
+    for (auto& block : disconnected) {
+        std::string hash = block.hash;
+        bodies.emplace(std::move(hash), std::move(block));
+    }
+    while (tipHeight() > forkHeight) {
+        BlockIndexEntry& entry = entries_.at(active_.back());
+        entry.status = BlockStatus::CONNECTABLE;
+        auto body = bodies.find(entry.hash);
+        if (body != bodies.end()) entry.body = std::move(body->second);
+        side_.insert(entry.hash);
+        active_.pop_back();
+    }
+    for (const auto& block : branch) {
+        if (!insert(block) || !appendConnected(block)) break;
+    }
+}
+
+void BlockIndex::markFailed(const std::string& hash) {
+    auto it = entries_.find(hash);
+    if (it == entries_.end() || isActive(it->second)) return;
+    it->second.status = BlockStatus::FAILED;
+    it->second.body.reset();
+    recomputeBest();
+}
+
+size_t BlockIndex::pruneSideBranches(int belowHeight) {
+    if (side_.empty()) return 0;
+    std::vector<std::string> doomed;
+    for (const auto& hash : side_) {
+        if (entries_.at(hash).height < belowHeight) doomed.push_back(hash);
+    }
+    size_t removed = 0;
+    // Потомки удалённых блоков остались бы без родителя — убираем и их
+    while (!doomed.empty()) {
+        for (const auto& hash : doomed) {
+            entries_.erase(hash);
+            side_.erase(hash);
+            removed++;
+        }
+        doomed.clear();
+        for (const auto& hash : side_) {
+            if (!entries_.count(entries_.at(hash).prevHash)) doomed.push_back(hash);
+        }
+    }
+    if (removed > 0) recomputeBest();
+    return removed;
+}
+
+std::vector<std::string> BlockIndex::locator() const {
+    std::vector<std::string> hashes;
+    int step = 1;
+    for (int h = tipHeight(); h > 0; h -= step) {
+        hashes.push_back(active_[h]);
+        if (hashes.size() >= 10) step *= 2;
+    }
+    if (!active_.empty()) hashes.push_back(active_.front());
+    return hashes;
+}
+
+int BlockIndex::findFork(const std::vector<std::string>& locator) const {
+    for (const auto& hash : locator) {
+        const BlockIndexEntry* entry = find(hash);
+        if (entry && isActive(*entry)) return entry->height;
+    }
+    return -1;
+}
+
+bool BlockIndex::hasFailedAncestor(const BlockIndexEntry& entry) const {
+    const BlockIndexEntry* current = &entry;
+    while (current && !isActive(*current)) {
+        if (current->status == BlockStatus::FAILED) return true;
+        current = find(current->prevHash);
+    }
+    return false;
+}
+
+void BlockIndex::recomputeBest() {
+    // Работа вдоль основной цепочки растёт, из неё достаточно вершины
+    best_ = tip();
+    for (const auto& hash : side_) {
+        const BlockIndexEntry& entry = entries_.at(hash);
+        if (!hasFailedAncestor(entry)) considerBest(entry);
+    }
+}
+
+void BlockIndex::considerBest(const BlockIndexEntry& entry) {
+    if (entry.status == BlockStatus::FAILED) return;
+    if (!best_ || betterThan(entry, *best_)) best_ = &entry;
+}
+
+bool OrphanPool::add(Block block) {
+    if (contains(block.hash)) return false;
+    while (byHash_.size() >= MAX_ORPHANS && !order_.empty()) {
+        std::string oldest = std::move(order_.front());
+        order_.pop_front();
+        erase(oldest);
+    }
+    // Подобранные сироты остаются в order_ до вытеснения: чистим, чтобы не рос
+    if (order_.size() > 2 * MAX_ORPHANS) {
+        std::deque<std::string> alive;
+        for (auto& hash : order_) {
+            if (contains(hash)) alive.push_back(std::move(hash));
+        }
+        order_.swap(alive);
+    }
+    byHash_[block.hash] = block.prevHash;
+    order_.push_back(block.hash);
+    std::string parent = block.prevHash;
+    byParent_.emplace(std::move(parent), std::move(block));
+    return true;
+}
+
+std::vector<Block> OrphanPool::takeChildren(const std::string& parentHash) {
+    std::vector<Block> children;
+    auto [begin, end] = byParent_.equal_range(parentHash);
+    for (auto it = begin; it != end; ++it) {
+        byHash_.erase(it->second.hash);
+        children.push_back(std::move(it->second));
+    }
+    byParent_.erase(begin, end);
+    return children;
+}
+
+void OrphanPool::erase(const std::string& hash) {
+    auto parent = byHash_.find(hash);
+    if (parent == byHash_.end()) return;
+    auto [begin, end] = byParent_.equal_range(parent->second);
+    for (auto it = begin; it != end; ++it) {
+        if (it->second.hash == hash) {
+            byParent_.erase(it);
+            break;
+        }
+    }
+    byHash_.erase(parent);
+}
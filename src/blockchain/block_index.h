@@ -0,0 +1,108 @@
+// src/blockchain/block_index.h
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include "block.h"
+
+enum class BlockStatus {
+    CONNECTABLE,    // Тело есть (в памяти), ветку можно подключить
+    CONNECTED,      // В основной цепочке, тело в хранилище
+    FAILED          // Не подключился: ни он, ни его потомки не выбираются
+};
+
+struct BlockIndexEntry {
+    std::string hash;
+    std::string prevHash;
+    int height = 0;
+    double difficulty = 0;
+    double chainWork = 0;          // Работа от генезиса до блока включительно
+    BlockStatus status = BlockStatus::CONNECTABLE;
+    std::optional<Block> body;     // Только вне основной цепочки
+};
+
+// Все известные узлу блоки в памяти: основная цепочка (заголовки) и
+// боковые ветки (с телами, чтобы переход на них не требовал повторной
+// загрузки). Лучшая вершина — с наибольшей накопленной работой, при
+// равной работе — с меньшим хэшем; она обновляется при каждой вставке
+// сравнением с текущей, без обхода ветвей.
+class BlockIndex {
+public:
+    // Работа блока: difficulty — число ведущих нулевых hex-цифр хэша,
+    // поэтому в среднем на блок уходит 16^difficulty попыток
+    static double blockWork(double difficulty);
+    static bool betterThan(const BlockIndexEntry& a, const BlockIndexEntry& b);
+
+    const BlockIndexEntry* find(const std::string& hash) const;
+    bool contains(const std::string& hash) const { return entries_.count(hash) > 0; }
+    size_t size() const { return entries_.size(); }
+
+    // Блок основной цепочки, прочитанный из хранилища при запуске
+    // или только что записанный на вершину
+    bool appendConnected(const Block& header);
+    // Блок вне основной цепочки; родитель уже должен быть в индексе.
+    // nullptr — родителя нет или высота не следует за ним
+    const BlockIndexEntry* insert(const Block& block);
+
+    const BlockIndexEntry* tip() const;
+    const BlockIndexEntry* bestTip() const { return best_; }
+    int tipHeight() const { return static_cast<int>(active_.size()) - 1; }
+    // Хэш блока основной цепочки на высоте; пусто — выше вершины
+    const std::string& activeHash(int height) const;
+    bool isActive(const BlockIndexEntry& entry) const;
+
+    // Блоки от первого не подключённого предка до hash включительно,
+    // по возрастанию высоты; пусто — ветка упирается в FAILED или разорвана
+    std::vector<const BlockIndexEntry*> branchTo(const std::string& hash) const;
+
+    // Основная цепочка перешла на ветку: блоки выше forkHeight
+    // отключены (их тела — в disconnected), подключены блоки branch
+    void switchTo(int forkHeight, std::vector<Block> disconnected, const std::vector<Block>& branch);
+    // Блок не подключился: он и его потомки исключаются из выбора
+    void markFailed(const std::string& hash);
+    // Удалить боковые ветки, отошедшие от основной ниже belowHeight
+    size_t pruneSideBranches(int belowHeight);
+
+    // Локатор для GET_BLOCKS: хэши основной цепочки от вершины вниз,
+    // первые подряд, затем с удваивающимся шагом, последним — генезис
+    std::vector<std::string> locator() const;
+    // Высота первого хэша локатора, лежащего в нашей основной цепочке; -1 — ни одного
+    int findFork(const std::vector<std::string>& locator) const;
+
+private:
+    bool hasFailedAncestor(const BlockIndexEntry& entry) const;
+    void recomputeBest();
+    void considerBest(const BlockIndexEntry& entry);
+
+    std::unordered_map<std::string, BlockIndexEntry> entries_;
+    std::vector<std::string> active_;       // Хэши основной цепочки по высоте
+    std::unordered_set<std::string> side_;  // Блоки вне основной цепочки
+    const BlockIndexEntry* best_ = nullptr;
+};
+
+// Блоки, пришедшие раньше родителя, ждут его здесь и не загружаются
+// повторно. Ключ — хэш недостающего родителя; при переполнении
+// вытесняются самые старые
+class OrphanPool {
+public:
+    static constexpr size_t MAX_ORPHANS = 512;
+
+    // false — такой блок уже ждёт
+    bool add(Block block);
+    bool contains(const std::string& hash) const { return byHash_.count(hash) > 0; }
+    // Ждёт ли кто-то этого родителя
+    bool awaits(const std::string& parentHash) const { return byParent_.count(parentHash) > 0; }
+    // Забрать блоки, ждавшие parentHash
+    std::vector<Block> takeChildren(const std::string& parentHash);
+    size_t size() const { return byHash_.size(); }
+
+private:
+    void erase(const std::string& hash);
+
+    std::unordered_multimap<std::string, Block> byParent_;
+    std::unordered_map<std::string, std::string> byHash_;    // Хэш -> хэш родителя
+    std::deque<std::string> order_;                          // Порядок поступления для вытеснения
+};
@@ -0,0 +1,224 @@
+// src/blockchain/block_pipeline.cpp
+#include "block_pipeline.h"
+#include "signature_verifier.h"
+#include "../core/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+namespace {
+
+// Уровни дерева Меркла по правилам Block::calculateMerkleRoot: нечётный
+// последний хэш уровня идёт в пару сам с собой. levels < 0 — до корня
+std::string reduceMerkle(std::vector<std::string> hashes, int levels) {
+    for (int level = 0; levels < 0 ? hashes.size() > 1 : level < levels; ++level) {
+        if (hashes.size() % 2 != 0) hashes.push_back(hashes.back());
+        std::vector<std::string> next;
+        next.reserve(hashes.size() / 2);
+        for (size_t i = 0; i < hashes.size(); i += 2) {
+            next.push_back(Crypto::sha256(hashes[i] + hashes[i + 1]));
+        }
+        hashes = std::move(next);
+    }
+    return hashes.front();
+}
+
+// log2(TX_CHUNK): на столько уровней поддерево части поднимается до стыка с соседними
+constexpr int chunkLevels() {
+    int levels = 0;
+    for (size_t n = BlockPipeline::TX_CHUNK; n > 1; n /= 2) levels++;
+    return levels;
+}
+
+static_assert((BlockPipeline::TX_CHUNK & (BlockPipeline::TX_CHUNK - 1)) == 0,
+              "TX_CHUNK must be a power of two");
+
+} // namespace
+
+struct BlockPipeline::Job {
+    nexus::ThreadPool* pool = nullptr;
+    bool checkProofOfWork = true;
+    SignatureVerifier* verifier = nullptr;
+    nexus::ScopedTimer::LabelledObserver observer;
+    std::chrono::steady_clock::time_point started;
+
+    Block block;
+    nlohmann::json json;                 // Блок в JSON; разбирается в задачах
+    bool fromJson = false;
+    size_t txCount = 0;
+    std::vector<std::string> chunkRoots;
+    std::atomic<size_t> pendingChunks{0};
+
+    std::atomic<bool> failed{false};
+    std::mutex errorMutex;
+    std::string error;                   // Первая найденная ошибка
+    std::promise<BlockVerdict> promise;
+
+    void fail(std::string reason) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (error.empty()) error = std::move(reason);
+        failed = true;
+    }
+};
+
+std::shared_ptr<BlockPipeline::Job> BlockPipeline::makeJob() {
+    auto job = std::make_shared<Job>();
+    job->pool = pool_;
+    job->checkProofOfWork = checkProofOfWork_;
+    job->verifier = verifier_;
+    job->observer = observer_;
+    return job;
+}
+
+std::vector<std::future<BlockVerdict>> BlockPipeline::submit(std::vector<Block> blocks) {
+    std::vector<std::future<BlockVerdict>> verdicts;
+    verdicts.reserve(blocks.size());
+    for (auto& block : blocks) {
+        auto job = makeJob();
+        job->block = std::move(block);
+        verdicts.push_back(job->promise.get_future());
+        dispatch(std::move(job));
+    }
+    return verdicts;
+}
+
+std::vector<std::future<BlockVerdict>> BlockPipeline::submit(const nlohmann::json& blocks) {
+    std::vector<std::future<BlockVerdict>> verdicts;
+    if (!blocks.is_array()) return verdicts;
+    verdicts.reserve(blocks.size());
+    for (const auto& json : blocks) {
+        auto job = makeJob();
+        job->json = json;
+        job->fromJson = true;
+        verdicts.push_back(job->promise.get_future());
+        dispatch(std::move(job));
+    }
+    return verdicts;
+}
+
+void BlockPipeline::dispatch(std::shared_ptr<Job> job) {
+    run(pool_, [job]() { start(job); });
+}
+
+void BlockPipeline::run(nexus::ThreadPool* pool, std::function<void()> task) {
+    if (pool) {
+        pool->submit(std::move(task));
+    } else {
+        task();
+    }
+}
+
+std::string BlockPipeline::checkHeader(const Block& block, bool checkProofOfWork) {
+    if (block.hash.empty()) return "missing hash";
+    if (block.height < 0) return "negative height";
+    if (block.hash != block.calculateHash()) return "hash mismatch";
+    if (!checkProofOfWork) return "";
+    // Как при майнинге: difficulty — число ведущих нулевых hex-цифр
+    if (!(block.difficulty >= 0 && block.difficulty <= static_cast<double>(block.hash.size()))) {
+        return "invalid difficulty";
+    }
+    size_t zeros = static_cast<size_t>(block.difficulty);
+    if (block.hash.find_first_not_of('0') < zeros) return "insufficient proof of work";
+    return "";
+}
+
+std::string BlockPipeline::checkTransaction(const Transaction& tx, size_t index) {
+    if (tx.fromAddress == "SYSTEM") {
+        return index == 0 ? "" : "coinbase is not the first transaction";
+    }
+    if (tx.amount <= 0) return "non-positive amount";
+    if (tx.fee < 0) return "negative fee";
+    if (tx.amount > MAX_AMOUNT || tx.fee > MAX_AMOUNT) return "amount out of range";
+    if (tx.signature.empty()) return "missing signature";
+    return "";
+}
+
+void BlockPipeline::start(const std::shared_ptr<Job>& job) {
+    job->started = std::chrono::steady_clock::now();
+    try {
+        if (job->fromJson) {
+            job->block.headerFromJson(job->json);
+            auto txs = job->json.find("transactions");
+            job->txCount = txs != job->json.end() && txs->is_array() ? txs->size() : 0;
+            job->block.transactions.resize(job->txCount);
+        } else {
+            job->txCount = job->block.transactions.size();
+        }
+    } catch (const std::exception& e) {
+        job->fail(std::string("malformed block: ") + e.what());
+        finish(job);
+        return;
+    }
+
+    std::string error = checkHeader(job->block, job->checkProofOfWork);
+    if (!error.empty() || job->txCount == 0) {
+        if (!error.empty()) job->fail(std::move(error));
+        finish(job);
+        return;
+    }
+
+    size_t chunks = (job->txCount + TX_CHUNK - 1) / TX_CHUNK;
+    job->chunkRoots.resize(chunks);
+    job->pendingChunks = chunks;
+    // Первая часть — в этой же задаче, остальные ждут свободных потоков
+    for (size_t chunk = 1; chunk < chunks; ++chunk) {
+        run(job->pool, [job, chunk]() { runChunk(job, chunk); });
+    }
+    runChunk(job, 0);
+}
+
+void BlockPipeline::runChunk(const std::shared_ptr<Job>& job, size_t chunk) {
+    size_t begin = chunk * TX_CHUNK;
+    size_t end = std::min(job->txCount, begin + TX_CHUNK);
+    try {
+        // Только константный доступ: части одного блока читают JSON одновременно
+        const nlohmann::json& json = job->json;
+        const nlohmann::json* txs = job->fromJson ? &json.at("transactions") : nullptr;
+        std::vector<std::string> hashes;
+        hashes.reserve(end - begin);
+        for (size_t i = begin; i < end && !job->failed; ++i) {
+            Transaction& tx = job->block.transactions[i];
+            if (txs) {
+                tx = Block::transactionFromJson((*txs)[i]);
+            } else if (!tx.hasValidHash()) {
+                job->fail("transaction " + std::to_string(i) + ": hash mismatch");
+                break;
+            }
+            // Подпись — после дешёвых правил; транзакции из mempool отвечают из кэша
+            std::string error = checkTransaction(tx, i);
+            if (error.empty() && job->verifier) error = job->verifier->check(tx);
+            if (!error.empty()) {
+                job->fail("transaction " + std::to_string(i) + ": " + error);
+                break;
+            }
+            hashes.push_back(tx.txHash);
+        }
+        // Одна часть — всё дерево; иначе поддерево части до уровня стыка
+        if (!job->failed && job->chunkRoots.size() > 1) {
+            job->chunkRoots[chunk] = reduceMerkle(std::move(hashes), chunkLevels());
+        }
+    } catch (const std::exception& e) {
+        job->fail("transaction " + std::to_string(begin) + "+: " + e.what());
+    }
+    if (job->pendingChunks.fetch_sub(1) == 1) finish(job);
+}
+
+void BlockPipeline::finish(const std::shared_ptr<Job>& job) {
+    if (!job->failed) {
+        std::string root = job->chunkRoots.size() > 1
+            ? reduceMerkle(std::move(job->chunkRoots), -1)
+            : job->block.calculateMerkleRoot();
+        if (root != job->block.merkleRoot) job->fail("merkle root mismatch");
+    }
+    if (job->observer) {
+        job->observer("block_validation",
+                      std::chrono::duration<double>(std::chrono::steady_clock::now() - job->started).count());
+    }
+
+    BlockVerdict verdict;
+    verdict.block = std::move(job->block);
+    verdict.error = std::move(job->error);
+    job->json = nlohmann::json();
+    job->promise.set_value(std::move(verdict));
+}
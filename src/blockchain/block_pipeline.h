@@ -0,0 +1,65 @@
+// src/blockchain/block_pipeline.h
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <future>
+#include "block.h"
+#include "../metrics/scoped_timer.h"
+
+namespace nexus { class ThreadPool; }
+class SignatureVerifier;
+
+// Итог проверки блока, не зависящей от состояния цепочки
+struct BlockVerdict {
+    Block block;
+    std::string error;    // Пусто — блок прошёл все этапы
+};
+
+// Проверка пришедших от пиров блоков до подключения: заголовок и PoW,
+// хэши, правила и подписи отдельных транзакций, корень Меркла. Каждый блок —
+// отдельная задача пула, большой блок делится на части по TX_CHUNK
+// транзакций, так что одновременно проверяются и блоки пачки, и части
+// одного блока. У каждого блока свой future: вызывающий подключает блоки
+// по порядку, пока следующие ещё проверяются. Состояние цепочки (балансы,
+// nonce отправителей) здесь не читается — это дело подключения.
+class BlockPipeline {
+public:
+    // Степень двойки: часть блока — целое поддерево Меркла,
+    // и его корень считается вместе с хэшами транзакций части
+    static constexpr size_t TX_CHUNK = 256;
+
+    // pool == nullptr — все этапы сразу в вызывающем потоке
+    explicit BlockPipeline(nexus::ThreadPool* pool = nullptr) : pool_(pool) {}
+    void setPool(nexus::ThreadPool* pool) { pool_ = pool; }
+    // Симуляция не майнит: nonce у её блоков случайный
+    void setProofOfWorkCheck(bool enabled) { checkProofOfWork_ = enabled; }
+    // Без верификатора у транзакций проверяется только наличие подписи
+    void setSignatureVerifier(SignatureVerifier* verifier) { verifier_ = verifier; }
+    // "block_validation" на каждый блок; вызывается из потоков пула
+    void setStageObserver(nexus::ScopedTimer::LabelledObserver observer) { observer_ = std::move(observer); }
+
+    std::vector<std::future<BlockVerdict>> submit(std::vector<Block> blocks);
+    // Блоки в JSON, как в BLOCKS_RESPONSE: разбор транзакций тоже идёт в пуле
+    std::vector<std::future<BlockVerdict>> submit(const nlohmann::json& blocks);
+
+    // Этапы по отдельности; пустая строка — проверка пройдена
+    static std::string checkHeader(const Block& block, bool checkProofOfWork);
+    static std::string checkTransaction(const Transaction& tx, size_t index);
+
+private:
+    struct Job;
+    std::shared_ptr<Job> makeJob();
+    void dispatch(std::shared_ptr<Job> job);
+
+    // Задачи держат Job, но не сам конвейер
+    static void run(nexus::ThreadPool* pool, std::function<void()> task);
+    static void start(const std::shared_ptr<Job>& job);
+    static void runChunk(const std::shared_ptr<Job>& job, size_t chunk);
+    static void finish(const std::shared_ptr<Job>& job);
+
+    nexus::ThreadPool* pool_;
+    bool checkProofOfWork_ = true;
+    SignatureVerifier* verifier_ = nullptr;
+    nexus::ScopedTimer::LabelledObserver observer_;
+};
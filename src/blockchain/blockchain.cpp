@@ -1,66 +1,134 @@
 // src/blockchain/blockchain.cpp
 #include "blockchain.h"
-#include <iostream>
-#include <iomanip>
+#include "reorg_engine.h"
+#include "../logging/logger.h"
 
-Blockchain::Blockchain(const std::string& dbPath)
-    : db(std::make_unique<LedgerDB>(dbPath)) {
+namespace {
+
+// Хватает ли баланса на сумму с комиссией; переполнение — не хватает
+bool coversSpend(Amount balance, const Transaction& tx) {
+    Amount needs;
+    return addAmount(tx.amount, tx.fee, needs) && balance >= needs;
+}
+
+} // namespace
+
+Blockchain::Blockchain(const std::string& dbPath, StorageBackend backend)
+    : db(openLedgerStorage(dbPath, backend)) {
+    pipeline_.setSignatureVerifier(&verifier_);
+    // Индекс строится по заголовкам основной цепочки; боковые ветки
+    // живут только в памяти и после перезапуска догружаются заново
+    int height = db->getLatestHeight();
+    for (int h = 0; h <= height; ++h) {
+        auto header = db->getBlockHeader(h);
+        if (!header || !index_.appendConnected(*header)) {
+            LOG_ERROR(CHAIN, "Can't index stored block").kv("height", h);
+            break;
+        }
+    }
+    LOG_DEBUG(CHAIN, "Block index loaded").kv("blocks", index_.size());
+
+    snapshotBase_ = db->getSnapshotBase();
+    // Проверка истории не сохраняется между запусками и начинается заново
+    if (snapshotBase_.historyMismatch) {
+        LOG_ERROR(CHAIN, "Snapshot state doesn't match history; transactions and mining are disabled")
+            .kv("height", snapshotBase_.height);
+    } else if (snapshotBase_.height > 0 && !snapshotBase_.verified) {
+        startHistoryCheck();
+    }
 }
 
 bool Blockchain::addBlock(Block& block) {
+    nexus::ScopedTimer validation(stageObserver_, "block_validation");
     int currentHeight = getHeight();
     
-    std::cout << "addBlock: received block #" << block.height 
-              << ", current height=" << currentHeight << std::endl;
+    LOG_DEBUG(CHAIN, "addBlock: received block").kv("height", block.height).kv("current", currentHeight);
     
     if (block.height <= currentHeight) {
-        std::cout << "Block #" << block.height << " already exists" << std::endl;
+        LOG_DEBUG(CHAIN, "Block already exists").kv("height", block.height);
         return false;
     }
     
     if (block.height > 0) {
         auto prev = db->getBlockByHeight(currentHeight);
         if (!prev.has_value()) {
-            std::cerr << "Previous block not found at height " << currentHeight << std::endl;
+            LOG_ERROR(CHAIN, "Previous block not found").kv("height", currentHeight);
             return false;
         }
         if (prev->hash != block.prevHash) {
-            std::cerr << "Invalid prevHash" << std::endl;
+            LOG_WARN(CHAIN, "Invalid prevHash").kv("height", block.height);
+            return false;
+        }
+    }
+    // Свой блок проверяется по тем же правилам транзакций, что и блоки
+    // пиров в BlockPipeline: иначе узел подключил бы блок, который
+    // отвергнут все остальные, и ушёл бы в отдельную ветку
+    for (size_t i = 0; i < block.transactions.size(); ++i) {
+        const Transaction& tx = block.transactions[i];
+        std::string error = BlockPipeline::checkTransaction(tx, i);
+        if (error.empty()) error = verifier_.check(tx);
+        if (!error.empty()) {
+            LOG_WARN(CHAIN, "Rejected block").kv("height", block.height)
+                .kv("reason", "transaction " + std::to_string(i) + ": " + error);
             return false;
         }
     }
     
+    validation.stop();
+
+    nexus::ScopedTimer commit(stageObserver_, "block_commit");
     if (!db->addBlock(block)) {
         return false;
     }
+    commit.stop();
+    if (!index_.appendConnected(block)) {
+        LOG_WARN(CHAIN, "Block index is out of sync with storage").kv("height", block.height);
+    }
     
     // Очищаем mempool от транзакций блока
-    int removed = 0;
-    for (const auto& tx : block.transactions) {
-        if (tx.fromAddress != "SYSTEM") {
-            if (mempool.erase(tx.txHash)) {
-                removed++;
-            }
-        }
-    }
+    int removed = removeBlockFromMempool(block);
 
     // Очищаем mempool от ставших невалидными транзакций
     cleanMempool();
     
-    std::cout << "Added block #" << block.height 
-              << ", removed " << removed << " txs from mempool, mempool size: " << mempool.size() << std::endl;
+    LOG_INFO(CHAIN, "Added block")
+        .kv("height", block.height).kv("removed", removed).kv("mempool", mempool.size());
     
     return true;
 }
 
 bool Blockchain::addTransaction(const Transaction& tx) {
+    nexus::ScopedTimer admission(stageObserver_, "tx_admission");
 
-    if (tx.amount <= 0) {
-        std::cerr << "Invalid amount: " << tx.amount << std::endl;
+    if (tx.amount <= 0 || tx.amount > MAX_AMOUNT) {
+        LOG_DEBUG(CHAIN, "Rejected tx: invalid amount").kv("amount", formatAmount(tx.amount));
+        return false;
+    }
+    if (tx.fee < 0 || tx.fee > MAX_AMOUNT) {
+        LOG_DEBUG(CHAIN, "Rejected tx: invalid fee").kv("fee", formatAmount(tx.fee));
+        return false;
+    }
+    // Coinbase создаёт только майнер, первой транзакцией своего блока.
+    // Подписи у SYSTEM нет: из mempool она попала бы в блок не первой,
+    // и такой блок отвергли бы все пиры
+    if (tx.fromAddress == "SYSTEM") {
+        LOG_DEBUG(CHAIN, "Rejected tx: coinbase outside a block").kv("tx", tx.txHash.substr(0, 8));
+        return false;
+    }
+    if (snapshotBase_.historyMismatch) {
+        LOG_DEBUG(CHAIN, "Rejected tx: state doesn't match history").kv("tx", tx.txHash.substr(0, 8));
+        return false;
+    }
+    // Хэш версии 1 не различает суммы: новые транзакции — только с версией 2
+    if (tx.txHash != tx.calculateHash()) {
+        LOG_DEBUG(CHAIN, "Rejected tx: hash mismatch").kv("tx", tx.txHash.substr(0, 8));
         return false;
     }
-    if (tx.fee < 0) {
-        std::cerr << "Invalid fee: " << tx.fee << std::endl;
+    // Проверенная заранее (очередь проверки, HTTP-поток) отвечает из кэша
+    std::string signatureError = verifier_.check(tx);
+    if (!signatureError.empty()) {
+        LOG_DEBUG(CHAIN, "Rejected tx: bad signature")
+            .kv("tx", tx.txHash.substr(0, 8)).kv("error", signatureError);
         return false;
     }
     if (tx.fromAddress != "SYSTEM") {
@@ -69,11 +137,11 @@ bool Blockchain::addTransaction(const Transaction& tx) {
     db->ensureWalletExists(tx.toAddress);
 
     if (tx.fromAddress != "SYSTEM") {
-        double balance = getBalance(tx.fromAddress);
-        if (balance < tx.amount + tx.fee) {
-            std::cerr << "Insufficient balance for " << tx.fromAddress
-                      << ": has " << std::fixed << std::setprecision(2) << balance
-                      << ", needs " << tx.amount + tx.fee << std::endl;
+        Amount balance = getBalance(tx.fromAddress);
+        if (!coversSpend(balance, tx)) {
+            LOG_DEBUG(CHAIN, "Rejected tx: insufficient balance")
+                .kv("from", tx.fromAddress).kv("balance", formatAmount(balance))
+                .kv("needs", formatAmount(tx.amount + tx.fee));
             return false;
         }
         
@@ -87,29 +155,24 @@ bool Blockchain::addTransaction(const Transaction& tx) {
 
         // Увеличиваем nonce в БД
         if (!db->updateNonce(tx.fromAddress, tx.nonce + 1)) {
-            std::cerr << "Failed to update nonce for " << tx.fromAddress << std::endl;
+            LOG_ERROR(CHAIN, "Failed to update nonce").kv("address", tx.fromAddress);
             return false;
         }
     }
 
-    double fee_per_byte = tx.fee / (tx.toJson().size()); // Комиссия за байт
-
     // Добавляем в mempool
-    mempool[tx.txHash] = tx;
-    mempool_by_priority.insert({fee_per_byte, tx.txHash, time(nullptr)});
-
-    // Ограничение размера mempool
-    while (mempool_by_priority.size() > 10000) {
-        auto lowest = --mempool_by_priority.end();
-        mempool.erase(lowest->tx_hash);
-        mempool_by_priority.erase(lowest);
+    if (mempool.count(tx.txHash) == 0) {
+        mempool[tx.txHash] = tx;
+        mempool_by_priority.insert(priorityOf(tx));
     }
 
+    trimMempool();
+
     // Сохраняем в БД (как неподтверждённую)
     db->addTransaction(tx, -1);
     db->addToMempool(tx);
 
-    std::cout << "Transaction " << tx.txHash.substr(0, 8) << "... added to mempool" << std::endl;
+    LOG_DEBUG(CHAIN, "Transaction added to mempool").kv("tx", tx.txHash.substr(0, 8));
     return true;
 }
 
@@ -147,13 +210,11 @@ Block Blockchain::createBlock(const std::string& miner) {
         if (txCount >= 10) break;
         auto it = mempool.find(priority.tx_hash);
         if (it != mempool.end()) {
-            // Временно отключаем проверку баланса {здесь комментарий}
-            bool valid = true;
-            if (it->second.fromAddress != "SYSTEM") {
-                double balance = getBalance(it->second.fromAddress);
-                if (balance < it->second.amount + it->second.fee) {
-                    valid = false;
-                }
+            // Правила блока — как у BlockPipeline, с индексом, который
+            // транзакция займёт в блоке
+            bool valid = BlockPipeline::checkTransaction(it->second, block.transactions.size()).empty();
+            if (valid && !coversSpend(getBalance(it->second.fromAddress), it->second)) {
+                valid = false;
             }
             if (valid) {
                 block.transactions.push_back(it->second);
@@ -166,28 +227,156 @@ Block Blockchain::createBlock(const std::string& miner) {
 
     // Если не удалось добавить ни одной транзакции, хотя mempool не пуст – очищаем его полностью
     if (txCount == 0 && !mempool.empty()) {
-        std::cout << "No transactions could be included, clearing entire mempool (" << mempool.size() << " txs)" << std::endl;
+        LOG_WARN(CHAIN, "No transactions could be included, clearing mempool").kv("txs", mempool.size());
         mempool.clear();
         mempool_by_priority.clear();
     }
 
     if (!to_remove.empty()) {
-        std::cout << "createBlock: removed " << to_remove.size() << " invalid txs from mempool" << std::endl;
+        for (const auto& p : to_remove) eraseFromMempool(p.tx_hash);
+        LOG_INFO(CHAIN, "createBlock: removed invalid txs from mempool").kv("count", to_remove.size());
     }
     
     block.merkleRoot = block.calculateMerkleRoot();
     
-    std::cout << "Block created with " << block.transactions.size() 
-              << " transactions (1 coinbase + " << txCount << " from mempool)" << std::endl;
+    LOG_DEBUG(CHAIN, "Block created").kv("transactions", block.transactions.size()).kv("from_mempool", txCount);
     
     return block;
 }
 
 std::optional<Block> Blockchain::getBlock(int height) {
+    // Под снимком и обрезкой в хранилище только заголовки
+    if (height > 0 && height <= getPrunedHeight()) return std::nullopt;
     return db->getBlockByHeight(height);
 }
 
-double Blockchain::getBalance(const std::string& address) {
+std::optional<Block> Blockchain::getBlockByHash(const std::string& hash) {
+    const BlockIndexEntry* entry = index_.find(hash);
+    if (!entry) return std::nullopt;
+    if (entry->body) return entry->body;
+    if (!index_.isActive(*entry)) return std::nullopt;
+    return getBlock(entry->height);
+}
+
+int Blockchain::pruneStep() {
+    if (!pruning()) return 0;
+    int tip = getHeight();
+    // Обрезаем до более дальней из границ ограничений, но не ближе MIN_PRUNE_KEEP к вершине
+    int target = 0;
+    if (pruneTarget_.blocks > 0) target = tip - pruneTarget_.blocks;
+    if (pruneTarget_.bytes > 0) {
+        int lowest = db->lowestHeightWithin(pruneTarget_.bytes);
+        if (lowest < 0) return -1;
+        target = std::max(target, lowest - 1);
+    }
+    target = std::min(target, tip - MIN_PRUNE_KEEP);
+    int before = db->getPrunedHeight();
+    if (target <= getPrunedHeight()) return 0;
+
+    int pruned = db->pruneBlocks(target, PRUNE_BATCH);
+    if (pruned < 0) {
+        LOG_ERROR(CHAIN, "Pruning failed").kv("target", target);
+        return -1;
+    }
+    LOG_INFO(CHAIN, "Blocks pruned").kv("to", pruned).kv("target", target).kv("tip", tip);
+    return pruned - std::max(before, snapshotBase_.height);
+}
+
+bool Blockchain::importSnapshot(const StateSnapshot& snapshot) {
+    const SnapshotManifest& manifest = snapshot.manifest;
+    if (getHeight() != 0) {
+        LOG_ERROR(CHAIN, "Snapshot needs a chain with only the genesis block").kv("height", getHeight());
+        return false;
+    }
+    std::string error = verifySnapshot(snapshot, index_.activeHash(0));
+    if (!error.empty()) {
+        LOG_ERROR(CHAIN, "Invalid snapshot").kv("height", manifest.height).kv("error", error);
+        return false;
+    }
+
+    std::vector<SnapshotAccount> accounts;
+    accounts.reserve(manifest.accounts);
+    std::vector<SnapshotAccount> chunk;
+    for (const auto& data : snapshot.chunks) {
+        decodeSnapshotChunk(data, chunk);
+        accounts.insert(accounts.end(), chunk.begin(), chunk.end());
+    }
+    SnapshotBase base{manifest.height, manifest.blockHash, manifest.commitment, false};
+    if (!db->importSnapshot(base, snapshot.headers, accounts)) return false;
+    for (const auto& header : snapshot.headers) {
+        if (!index_.appendConnected(header)) {
+            LOG_ERROR(CHAIN, "Can't index snapshot header").kv("height", header.height);
+            return false;
+        }
+    }
+    snapshotBase_ = db->getSnapshotBase();
+    // Балансы сменились целиком: проверенное против генезиса в mempool не годится
+    mempool.clear();
+    mempool_by_priority.clear();
+    startHistoryCheck();
+
+    LOG_INFO(CHAIN, "Snapshot loaded")
+        .kv("height", manifest.height).kv("hash", manifest.blockHash.substr(0, 8))
+        .kv("accounts", manifest.accounts).kv("commitment", manifest.commitment.substr(0, 16));
+    return true;
+}
+
+void Blockchain::startHistoryCheck() {
+    auto genesis = db->getBlockByHeight(0);
+    if (!genesis || index_.tipHeight() < snapshotBase_.height) {
+        LOG_ERROR(CHAIN, "Can't check history under snapshot").kv("height", snapshotBase_.height);
+        return;
+    }
+    std::vector<std::string> hashes;
+    hashes.reserve(snapshotBase_.height);
+    for (int h = 1; h <= snapshotBase_.height; ++h) hashes.push_back(index_.activeHash(h));
+    historyCheck_ = std::make_unique<SnapshotVerifier>(snapshotBase_, *genesis, std::move(hashes));
+}
+
+HistoryCheckResult Blockchain::checkHistory(const nlohmann::json& blocks) {
+    HistoryCheckResult result;
+    if (!historyCheck_ || !blocks.is_array()) return result;
+    // Хэш, PoW, транзакции и корень Меркла — тем же конвейером, что у новых блоков
+    auto verdicts = pipeline_.submit(blocks);
+    for (auto& future : verdicts) {
+        BlockVerdict verdict = future.get();
+        if (verdict.error.empty() && verdict.block.height < historyCheck_->nextHeight()) continue;
+        std::string error = verdict.error.empty() ? historyCheck_->apply(verdict.block) : verdict.error;
+        if (!error.empty()) {
+            // Следующие блоки пачки без этого всё равно не лягут
+            LOG_WARN(CHAIN, "Rejected history block")
+                .kv("height", verdict.block.height).kv("hash", verdict.block.hash.substr(0, 8)).kv("reason", error);
+            result.rejected++;
+            break;
+        }
+        result.applied++;
+    }
+    if (!historyCheck_->complete()) return result;
+
+    result.finished = true;
+    std::string commitment = historyCheck_->commitment();
+    result.matched = commitment == snapshotBase_.commitment;
+    if (!db->setSnapshotVerified(result.matched)) {
+        LOG_ERROR(CHAIN, "Failed to store snapshot check result").kv("height", snapshotBase_.height);
+    }
+    snapshotBase_.verified = result.matched;
+    snapshotBase_.historyMismatch = !result.matched;
+    if (result.matched) {
+        LOG_INFO(CHAIN, "Snapshot verified against history").kv("height", snapshotBase_.height);
+    } else {
+        // Снимок подделан или испорчен: балансы ложные. Mempool собран
+        // против них — сбрасывается; новые транзакции и майнинг отключены
+        mempool.clear();
+        mempool_by_priority.clear();
+        LOG_ERROR(CHAIN, "Snapshot state doesn't match history; transactions and mining are disabled")
+            .kv("height", snapshotBase_.height).kv("snapshot", snapshotBase_.commitment.substr(0, 16))
+            .kv("history", commitment.substr(0, 16));
+    }
+    historyCheck_.reset();
+    return result;
+}
+
+Amount Blockchain::getBalance(const std::string& address) {
     return db->getBalance(address);
 }
 
@@ -199,6 +388,21 @@ std::vector<Transaction> Blockchain::getMempoolTransactions() {
     return txs;
 }
 
+std::optional<Transaction> Blockchain::getMempoolTransaction(const std::string& txHash) const {
+    auto it = mempool.find(txHash);
+    if (it == mempool.end()) return std::nullopt;
+    return it->second;
+}
+
+std::vector<std::string> Blockchain::getMempoolHashes() const {
+    std::vector<std::string> hashes;
+    hashes.reserve(mempool.size());
+    for (const auto& [hash, tx] : mempool) {
+        hashes.push_back(hash);
+    }
+    return hashes;
+}
+
 int Blockchain::getCurrentDifficulty() const {
     int height = getHeight();
 
@@ -238,50 +442,197 @@ int Blockchain::getCurrentDifficulty() const {
         new_diff = MAX_DIFFICULTY;
     }
 
-    std::cout << "Difficulty adjustment: " << current_diff << " -> " << new_diff
-              << " (time_span=" << time_span << "s, expected=" << expected_time << "s)" << std::endl;
+    LOG_DEBUG(CHAIN, "Difficulty adjustment")
+        .kv("from", current_diff).kv("to", new_diff).kv("time_span", time_span).kv("expected", expected_time);
 
     return new_diff;
 }
 
-bool Blockchain::replaceLastBlock(const Block& new_block) {
-    int current_height = getHeight();
-    if (current_height != new_block.height) {
-        std::cerr << "replaceLastBlock: height mismatch" << std::endl;
-        return false;
+AcceptResult Blockchain::acceptBlocks(const std::vector<Block>& blocks) {
+    AcceptResult result;
+    std::vector<Block> fresh;
+    std::set<std::string> seen;
+    for (const auto& block : blocks) {
+        if (knowsBlock(block.hash) || !seen.insert(block.hash).second) {
+            result.duplicates++;
+            continue;
+        }
+        fresh.push_back(block);
     }
-    auto old_block = getBlock(current_height);
-    if (!old_block) return false;
-    
-    // Проверяем, что новый блок ссылается на тот же предок
-    if (old_block->prevHash != new_block.prevHash) {
-        std::cerr << "replaceLastBlock: prevHash mismatch" << std::endl;
-        return false;
+    return connectVerified(pipeline_.submit(std::move(fresh)), std::move(result));
+}
+
+AcceptResult Blockchain::acceptBlocks(const nlohmann::json& blocks) {
+    AcceptResult result;
+    if (!blocks.is_array()) return result;
+    nlohmann::json fresh = nlohmann::json::array();
+    std::set<std::string> seen;
+    for (const auto& block : blocks) {
+        std::string hash = block.is_object() ? block.value("hash", "") : "";
+        // Без хэша блок отбросит проверка заголовка
+        if (!hash.empty() && (knowsBlock(hash) || !seen.insert(hash).second)) {
+            result.duplicates++;
+            continue;
+        }
+        fresh.push_back(block);
     }
-    
-    // Удаляем старый блок из БД
-    std::string sql = "DELETE FROM blocks WHERE height = " + std::to_string(current_height);
-    if (!db->execute(sql)) return false;
-    // Удаляем его транзакции из таблицы transactions (они будут пересозданы при добавлении нового блока)
-    sql = "DELETE FROM transactions WHERE block_height = " + std::to_string(current_height);
-    db->execute(sql);
-    
-    // Добавляем новый блок
-    if (!db->addBlock(new_block)) return false;
-    
-    // Возвращаем транзакции старого блока обратно в mempool
-    for (const auto& tx : old_block->transactions) {
-        if (tx.fromAddress != "SYSTEM" && tx.amount > 0 && tx.fee >= 0) { // не coinbase
-            addTransaction(tx); // это добавит в mempool
+    return connectVerified(pipeline_.submit(fresh), std::move(result));
+}
+
+AcceptResult Blockchain::connectVerified(std::vector<std::future<BlockVerdict>> verdicts, AcceptResult result) {
+    bool pending = false;
+    for (size_t i = 0; i < verdicts.size(); ++i) {
+        BlockVerdict verdict = verdicts[i].get();
+        if (verdict.error.empty()) {
+            int accepted = result.accepted;
+            attachBlock(std::move(verdict.block), result);
+            pending = pending || result.accepted > accepted;
+        } else {
+            LOG_WARN(CHAIN, "Rejected block")
+                .kv("height", verdict.block.height).kv("hash", verdict.block.hash.substr(0, 8))
+                .kv("reason", verdict.error);
+            result.rejected++;
+        }
+        // Подключаем проверенное, пока следующие блоки ещё в пуле: запись
+        // в хранилище идёт одновременно с их проверкой
+        bool nextReady = i + 1 < verdicts.size() &&
+            verdicts[i + 1].wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        if (pending && !nextReady) {
+            activateBestChain(result);
+            pending = false;
         }
     }
 
+    if (result.connected.empty()) return result;
+    // Очищаем mempool от ставших невалидными транзакций — один раз на пачку
     cleanMempool();
-    
-    std::cout << "Replaced block #" << current_height << " with new block " << new_block.hash.substr(0,8) << std::endl;
+    index_.pruneSideBranches(index_.tipHeight() - SIDE_BRANCH_DEPTH);
+    LOG_INFO(CHAIN, "Connected blocks")
+        .kv("count", result.connected.size()).kv("disconnected", result.disconnected)
+        .kv("height", index_.tipHeight()).kv("mempool", mempool.size());
+    return result;
+}
+
+void Blockchain::attachBlock(Block block, AcceptResult& result) {
+    // Блок тянет за собой сирот, ждавших его; стек вместо рекурсии —
+    // цепочка сирот бывает длинной при синхронизации
+    std::vector<Block> pending;
+    pending.push_back(std::move(block));
+    while (!pending.empty()) {
+        Block next = std::move(pending.back());
+        pending.pop_back();
+
+        if (!index_.contains(next.prevHash)) {
+            // Родитель уже запрошен, если его кто-то ждёт или он сам сирота
+            bool requested = orphans_.awaits(next.prevHash) || orphans_.contains(next.prevHash);
+            std::string parent = next.prevHash;
+            int height = next.height;
+            if (orphans_.add(std::move(next))) {
+                result.orphaned++;
+                if (!requested) result.missingParents.emplace_back(std::move(parent), height - 1);
+            }
+            continue;
+        }
+        if (!index_.insert(next)) {
+            LOG_DEBUG(CHAIN, "Rejected block: height doesn't follow parent")
+                .kv("height", next.height).kv("hash", next.hash.substr(0, 8));
+            result.rejected++;
+            continue;
+        }
+        result.accepted++;
+        for (auto& child : orphans_.takeChildren(next.hash)) pending.push_back(std::move(child));
+    }
+}
+
+void Blockchain::activateBestChain(AcceptResult& result) {
+    for (;;) {
+        const BlockIndexEntry* best = index_.bestTip();
+        const BlockIndexEntry* tip = index_.tip();
+        if (!best || !tip || best == tip) break;
+
+        auto path = index_.branchTo(best->hash);
+        if (path.empty()) {
+            index_.markFailed(best->hash);
+            continue;
+        }
+        std::vector<Block> branch;
+        branch.reserve(path.size());
+        for (const auto* entry : path) branch.push_back(*entry->body);
+
+        // Продолжение нашей вершины — обычное добавление по блоку
+        if (path.front()->prevHash == tip->hash) {
+            for (const auto& block : branch) {
+                nexus::ScopedTimer commit(stageObserver_, "block_commit");
+                if (!db->addBlock(block)) {
+                    LOG_WARN(CHAIN, "Failed to connect block").kv("height", block.height);
+                    index_.markFailed(block.hash);
+                    break;
+                }
+                commit.stop();
+                index_.appendConnected(block);
+                removeBlockFromMempool(block);
+                result.connected.push_back(block);
+            }
+            continue;
+        }
+        switchBranch(branch, result);
+    }
+}
+
+bool Blockchain::switchBranch(const std::vector<Block>& branch, AcceptResult& result) {
+    nexus::ScopedTimer commit(stageObserver_, "block_commit");
+    ReorgResult reorg = ReorgEngine(*db).reorganize(branch);
+    commit.stop();
+    if (!reorg.ok) {
+        // Без этого следующий проход выбрал бы ту же ветку снова
+        const Block& failed = reorg.failedHeight > branch.front().height
+            ? branch[reorg.failedHeight - branch.front().height] : branch.front();
+        index_.markFailed(failed.hash);
+        return false;
+    }
+    index_.switchTo(reorg.forkHeight, std::move(reorg.disconnectedBlocks), branch);
+
+    for (const auto& block : branch) {
+        for (const auto& tx : block.transactions) eraseFromMempool(tx.txHash);
+    }
+    returnToMempool(std::move(reorg.orphaned));
+
+    result.disconnected += reorg.disconnected;
+    result.connected.insert(result.connected.end(), branch.begin(), branch.end());
+    LOG_INFO(CHAIN, "Chain reorganized")
+        .kv("fork_height", reorg.forkHeight).kv("disconnected", reorg.disconnected)
+        .kv("connected", reorg.connected).kv("height", getHeight()).kv("mempool", mempool.size());
     return true;
 }
 
+int Blockchain::removeBlockFromMempool(const Block& block) {
+    int removed = 0;
+    for (const auto& tx : block.transactions) {
+        if (tx.fromAddress != "SYSTEM" && eraseFromMempool(tx.txHash)) removed++;
+    }
+    return removed;
+}
+
+void Blockchain::returnToMempool(std::vector<Transaction> txs) {
+    if (snapshotBase_.historyMismatch) return;
+    for (auto& tx : txs) {
+        if (mempool.count(tx.txHash)) continue;
+        tx.status = "pending";
+        mempool_by_priority.insert(priorityOf(tx));
+        mempool.emplace(tx.txHash, std::move(tx));
+    }
+    trimMempool();
+}
+
+void Blockchain::trimMempool() {
+    // Ограничение размера mempool
+    while (mempool_by_priority.size() > 10000) {
+        auto lowest = --mempool_by_priority.end();
+        mempool.erase(lowest->tx_hash);
+        mempool_by_priority.erase(lowest);
+    }
+}
+
 int Blockchain::cleanMempool() {
     int removed = 0;
     std::vector<TxPriority> to_remove;
@@ -292,24 +643,35 @@ int Blockchain::cleanMempool() {
         
         const Transaction& tx = it->second;
         if (tx.fromAddress != "SYSTEM") {
-            double balance = getBalance(tx.fromAddress);
-            if (balance < tx.amount + tx.fee) {
+            Amount balance = getBalance(tx.fromAddress);
+            if (!coversSpend(balance, tx)) {
                 to_remove.push_back(priority);
                 removed++;
-                std::cout << "Removing invalid tx " << tx.txHash.substr(0,8) 
-                          << " from mempool: balance " << balance 
-                          << " < " << (tx.amount + tx.fee) << std::endl;
+                LOG_DEBUG(CHAIN, "Removing invalid tx from mempool")
+                    .kv("tx", tx.txHash.substr(0, 8)).kv("balance", formatAmount(balance))
+                    .kv("needs", formatAmount(tx.amount + tx.fee));
             }
         }
     }
     
     for (const auto& p : to_remove) {
-        mempool.erase(p.tx_hash);
-        mempool_by_priority.erase(p);
+        eraseFromMempool(p.tx_hash);
     }
     
     if (removed > 0) {
-        std::cout << "Cleaned " << removed << " invalid transactions from mempool" << std::endl;
+        LOG_INFO(CHAIN, "Cleaned invalid transactions from mempool").kv("count", removed);
     }
     return removed;
-}
\ No newline at end of file
+}
+
+TxPriority Blockchain::priorityOf(const Transaction& tx) {
+    return {tx.fee, tx.toJson().size(), tx.txHash, tx.timestamp};
+}
+
+bool Blockchain::eraseFromMempool(const std::string& txHash) {
+    auto it = mempool.find(txHash);
+    if (it == mempool.end()) return false;
+    mempool_by_priority.erase(priorityOf(it->second));
+    mempool.erase(it);
+    return true;
+}
@@ -1,53 +1,178 @@
 // src/blockchain/blockchain.h
 #pragma once
+#include <algorithm>
 #include <memory>
 #include <vector>
 #include <map>
 #include <set>
 #include <optional>
 #include "block.h"
-#include "../storage/ledger_db.h"
+#include "block_index.h"
+#include "block_pipeline.h"
+#include "signature_verifier.h"
+#include "state_snapshot.h"
+#include "../storage/ledger_storage.h"
 
 struct TxPriority {
-    double fee_per_byte;
+    Amount fee;
+    size_t size;         // Байт в JSON транзакции
     std::string tx_hash;
     time_t timestamp;
     
     // Приоритет Mempool реализация
     bool operator<(const TxPriority& other) const {
-        if (fee_per_byte != other.fee_per_byte) {
-            return fee_per_byte > other.fee_per_byte;  // Выше комиссия - выше приоритет
+        // Комиссия за байт сравнивается перекрёстным умножением: без деления
+        // и округления равные ставки равны, а разные не слипаются
+        __int128 rate = static_cast<__int128>(fee) * other.size;
+        __int128 otherRate = static_cast<__int128>(other.fee) * size;
+        if (rate != otherRate) {
+            return rate > otherRate;  // Выше комиссия - выше приоритет
         }
-        return timestamp < other.timestamp;  // Старше - выше приоритет
+        if (timestamp != other.timestamp) {
+            return timestamp < other.timestamp;  // Старше - выше приоритет
+        }
+        return tx_hash < other.tx_hash;  // Иначе равные по цене транзакции одной секунды затирали бы друг друга
     }
 };
 
+// Итог приёма блоков от пира (NEW_BLOCK или BLOCKS_RESPONSE)
+struct AcceptResult {
+    int accepted = 0;         // Новых блоков в индексе, включая дождавшихся родителя сирот
+    int duplicates = 0;       // Уже известные: не проверяются и не хранятся повторно
+    int orphaned = 0;         // Отложены до прихода родителя
+    int rejected = 0;         // Не прошли проверку или высота не следует за родителем
+    int disconnected = 0;     // Отключено своих при переходе на другую ветку
+    std::vector<Block> connected;   // Подключены к основной цепочке, по возрастанию высоты
+    // Родители новых сирот, которых ещё никто не ждал: хэш и высота —
+    // их нужно запросить, остальные уже запрошены
+    std::vector<std::pair<std::string, int>> missingParents;
+};
+
+// Итог проверки пачки блоков истории под снимком
+struct HistoryCheckResult {
+    int applied = 0;          // Приняты по порядку
+    int rejected = 0;         // Не прошли проверку или не из нашей цепочки
+    bool finished = false;    // История пройдена до блока снимка
+    bool matched = false;     // ... и дала состояние с тем же обязательством
+};
+
 class Blockchain {
+public:
+    // Длительность этапов: "tx_admission", "block_validation", "block_commit"
+    using StageObserver = nexus::ScopedTimer::LabelledObserver;
+
 private:
-    std::unique_ptr<LedgerDB> db;
+    std::unique_ptr<LedgerStorage> db;
+    StageObserver stageObserver_;
     std::map<std::string, Transaction> mempool;
     std::set<TxPriority> mempool_by_priority;  // Сортированный по приоритету
-    const double REWARD = 100.0;
+    const Amount REWARD = 100 * COIN;
     int target_block_time_seconds = 60;  // Целевое время между блоками (1 минута)
     int difficulty_adjustment_interval = 10;  // Пересчитывать сложность каждые 10 блоков
+    // Боковые ветки, отошедшие глубже, забываются: догнать основную им не по силам
+    static constexpr int SIDE_BRANCH_DEPTH = 100;
+    BlockIndex index_;
+    OrphanPool orphans_;
+    SignatureVerifier verifier_;
+    BlockPipeline pipeline_;
+    SnapshotBase snapshotBase_;
+    std::unique_ptr<SnapshotVerifier> historyCheck_;
+    PruneTarget pruneTarget_;
     
 public:
-    Blockchain(const std::string& dbPath);
-    LedgerDB* getDB() { return db.get(); }
+    Blockchain(const std::string& dbPath, StorageBackend backend = StorageBackend::SQLITE);
+    LedgerStorage* getDB() { return db.get(); }
+    void setStageObserver(StageObserver observer) {
+        pipeline_.setStageObserver(observer);
+        stageObserver_ = std::move(observer);
+    }
+    // Пул для проверки блоков пиров и исполнения транзакций блока в
+    // хранилище; без него всё идёт в вызывающем потоке. Пул должен жить
+    // дольше Blockchain
+    void setThreadPool(nexus::ThreadPool* pool) {
+        pipeline_.setPool(pool);
+        db->setExecutionPool(pool);
+    }
+    void setProofOfWorkCheck(bool enabled) { pipeline_.setProofOfWorkCheck(enabled); }
+    // Общий для mempool и проверки блоков; потокобезопасен, поэтому
+    // подписи можно проверить заранее вне io-потока
+    SignatureVerifier& getSignatureVerifier() { return verifier_; }
     
+    // Свой блок на вершину (майнер); блоки пиров идут через acceptBlocks
     bool addBlock(Block& block);
     bool addTransaction(const Transaction& tx);
     std::optional<Block> getBlock(int height);
+    // Блок основной цепочки или боковой ветки из индекса
+    std::optional<Block> getBlockByHash(const std::string& hash);
     int getHeight() const { return db->getLatestHeight(); }
-    double getBalance(const std::string& address);
-    bool replaceLastBlock(const Block& new_block);
+    Amount getBalance(const std::string& address);
+    // Блоки от пира в любом порядке: известные пропускаются, остальные
+    // проверяются в BlockPipeline, не прошедшие отбрасываются, не
+    // цепляющиеся ждут родителя в пуле сирот, прочие попадают в индекс.
+    // Основная цепочка переходит на вершину с наибольшей работой —
+    // дописыванием или реорганизацией — не дожидаясь проверки следующих
+    // блоков пачки; транзакции отключённых блоков возвращаются в mempool
+    AcceptResult acceptBlocks(const std::vector<Block>& blocks);
+    // То же для блоков в JSON: разбор идёт вместе с проверкой
+    AcceptResult acceptBlocks(const nlohmann::json& blocks);
+    bool knowsBlock(const std::string& hash) const { return index_.contains(hash) || orphans_.contains(hash); }
+    const BlockIndex& getBlockIndex() const { return index_; }
+    size_t getOrphanCount() const { return orphans_.size(); }
+    // Локатор для GET_BLOCKS и точка, с которой отвечать на чужой
+    std::vector<std::string> getLocator() const { return index_.locator(); }
+    int findLocatorFork(const std::vector<std::string>& locator) const { return index_.findFork(locator); }
     int cleanMempool();
+
+    // Быстрый старт со снимка состояния. Снимок проверяется целиком
+    // (verifySnapshot) и ложится в базу, где есть только генезис; цепочка
+    // продолжается с его блока. Тела блоков 1..height не хранятся и пирам
+    // не отдаются, а сами блоки догружаются и сверяются со снимком в фоне
+    bool importSnapshot(const StateSnapshot& snapshot);
+    const SnapshotBase& getSnapshotBase() const { return snapshotBase_; }
+    // Снимок не сошёлся с историей: балансы ложные, поэтому узел не
+    // принимает транзакции и не майнит, пока базу не загрузят заново
+    bool historyMismatch() const { return snapshotBase_.historyMismatch; }
+    // Следующий блок истории под снимком для проверки; -1 — проверять нечего
+    int historyCheckHeight() const { return historyCheck_ ? historyCheck_->nextHeight() : -1; }
+    // Блоки истории из BLOCKS_RESPONSE, по возрастанию высоты
+    HistoryCheckResult checkHistory(const nlohmann::json& blocks);
+
+    // Обрезка истории: тела хранятся только у последних блоков — числом или
+    // объёмом, по более строгому из ограничений, но не меньше MIN_PRUNE_KEEP,
+    // чтобы реорганизация в пределах SIDE_BRANCH_DEPTH не упёрлась в обрезку
+    static constexpr int MIN_PRUNE_KEEP = 288;
+    // Блоков за один шаг: удаление и возврат места идут небольшими порциями
+    static constexpr int PRUNE_BATCH = 500;
+    void setPruneTarget(const PruneTarget& target) { pruneTarget_ = target; }
+    bool pruning() const { return pruneTarget_.enabled(); }
+    // Блоки 1..этой высоты без тел: под снимком или обрезаны
+    int getPrunedHeight() const { return std::max(snapshotBase_.height, db->getPrunedHeight()); }
+    // Обрезать очередную порцию до цели; число обрезанных блоков, -1 — ошибка
+    int pruneStep();
     
     int getCurrentDifficulty() const;
     Block createBlock(const std::string& miner);
     std::vector<Transaction> getMempoolTransactions();
+    std::optional<Transaction> getMempoolTransaction(const std::string& txHash) const;
+    std::vector<std::string> getMempoolHashes() const;
     int getMempoolSize() const { return mempool.size(); }
-    void removeFromMempool(const std::string& txHash) {
-    mempool.erase(txHash); 
-    }
+    void removeFromMempool(const std::string& txHash) { eraseFromMempool(txHash); }
+
+private:
+    // Ключ приоритета выводится из самой транзакции, поэтому запись в
+    // mempool_by_priority всегда можно найти и удалить вместе с mempool
+    static TxPriority priorityOf(const Transaction& tx);
+    bool eraseFromMempool(const std::string& txHash);
+    // Вставка без проверок баланса и записи в БД: транзакции уже были
+    // подтверждены; невалидные отсеет следующий cleanMempool
+    void returnToMempool(std::vector<Transaction> txs);
+    void trimMempool();
+    int removeBlockFromMempool(const Block& block);
+
+    void startHistoryCheck();
+
+    AcceptResult connectVerified(std::vector<std::future<BlockVerdict>> verdicts, AcceptResult result);
+    void attachBlock(Block block, AcceptResult& result);
+    void activateBestChain(AcceptResult& result);
+    bool switchBranch(const std::vector<Block>& branch, AcceptResult& result);
 };
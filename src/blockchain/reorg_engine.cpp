@@ -0,0 +1,103 @@
+// src/blockchain/reorg_engine.cpp
+#include "reorg_engine.h"
+#include "../logging/logger.h"
+#include <unordered_set>
+
+bool ReorgEngine::findForkPoint(const std::vector<Block>& branch, size_t& firstNew, int& forkHeight) {
+    for (size_t i = 1; i < branch.size(); ++i) {
+        if (branch[i].height != branch[i - 1].height + 1 || branch[i].prevHash != branch[i - 1].hash) {
+            return false;
+        }
+    }
+
+    // Пропускаем начало ветки, совпадающее с нашей цепочкой
+    firstNew = 0;
+    int tip = db_.getLatestHeight();
+    while (firstNew < branch.size() && branch[firstNew].height <= tip) {
+        auto header = db_.getBlockHeader(branch[firstNew].height);
+        if (!header || header->hash != branch[firstNew].hash) break;
+        firstNew++;
+    }
+    if (firstNew == branch.size()) {
+        forkHeight = branch.empty() ? tip : branch.back().height;
+        return true;
+    }
+
+    const Block& first = branch[firstNew];
+    if (first.height <= 0 || first.height > tip + 1) return false;
+    auto parent = db_.getBlockHeader(first.height - 1);
+    if (!parent || parent->hash != first.prevHash) return false;
+    forkHeight = first.height - 1;
+    return true;
+}
+
+ReorgResult ReorgEngine::reorganize(const std::vector<Block>& branch) {
+    ReorgResult result;
+    size_t firstNew = 0;
+    if (!findForkPoint(branch, firstNew, result.forkHeight)) {
+        LOG_WARN(CHAIN, "Reorg branch does not connect to our chain")
+            .kv("from", branch.empty() ? -1 : branch.front().height);
+        return result;
+    }
+
+    // Ветка целиком уже наша
+    if (firstNew == branch.size()) {
+        result.ok = true;
+        return result;
+    }
+
+    int tip = db_.getLatestHeight();
+    std::vector<Block> disconnected;
+    db_.beginTransaction();
+
+    // Отключаем от вершины вниз до общего предка
+    for (int h = tip; h > result.forkHeight; --h) {
+        auto block = db_.getBlockByHeight(h);
+        if (!block || !db_.removeBlock(h)) {
+            LOG_ERROR(CHAIN, "Reorg: can't disconnect block").kv("height", h);
+            restore(result.forkHeight, disconnected);
+            return result;
+        }
+        disconnected.push_back(std::move(*block));
+    }
+
+    for (size_t i = firstNew; i < branch.size(); ++i) {
+        if (!db_.addBlock(branch[i])) {
+            LOG_ERROR(CHAIN, "Reorg: can't connect block").kv("height", branch[i].height);
+            result.failedHeight = branch[i].height;
+            restore(result.forkHeight, disconnected);
+            return result;
+        }
+        result.connected++;
+    }
+    db_.commitTransaction();
+
+    // Транзакции отключённых блоков, не вошедшие в новую ветку, — от старых к новым
+    std::unordered_set<std::string> included;
+    for (size_t i = firstNew; i < branch.size(); ++i) {
+        for (const auto& tx : branch[i].transactions) included.insert(tx.txHash);
+    }
+    for (auto it = disconnected.rbegin(); it != disconnected.rend(); ++it) {
+        for (const auto& tx : it->transactions) {
+            if (tx.fromAddress == "SYSTEM" || included.count(tx.txHash)) continue;
+            result.orphaned.push_back(tx);
+        }
+    }
+    result.disconnected = static_cast<int>(disconnected.size());
+    result.disconnectedBlocks = std::move(disconnected);
+    result.ok = true;
+    return result;
+}
+
+void ReorgEngine::restore(int forkHeight, const std::vector<Block>& disconnected) {
+    // Откат SQL-транзакции не вернул бы блочные файлы и LSM-состояние,
+    // поэтому цепочка восстанавливается теми же removeBlock/addBlock
+    for (int h = db_.getLatestHeight(); h > forkHeight; --h) db_.removeBlock(h);
+    for (auto it = disconnected.rbegin(); it != disconnected.rend(); ++it) {
+        if (!db_.addBlock(*it)) {
+            LOG_ERROR(CHAIN, "Reorg: can't restore block").kv("height", it->height);
+            break;
+        }
+    }
+    db_.commitTransaction();
+}
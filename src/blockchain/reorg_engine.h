@@ -0,0 +1,39 @@
+// src/blockchain/reorg_engine.h
+#pragma once
+#include <vector>
+#include "block.h"
+#include "../storage/ledger_storage.h"
+
+struct ReorgResult {
+    bool ok = false;
+    int forkHeight = -1;                  // Высота общего предка
+    int disconnected = 0;                 // Отключено своих блоков
+    int connected = 0;                    // Подключено блоков новой ветки
+    int failedHeight = -1;                // Блок ветки, который не удалось подключить
+    std::vector<Transaction> orphaned;    // Транзакции отключённых блоков, которых нет в новой ветке
+    std::vector<Block> disconnectedBlocks;  // Отключённые блоки от вершины вниз
+};
+
+// Переключение цепочки на другую ветку. Общий предок ищется сравнением
+// заголовков ветки с нашими, затем блоки выше него отключаются по
+// undo-записям (removeBlock) и подключаются блоки ветки — всё в одной
+// транзакции хранилища. Стоимость пропорциональна глубине перестройки:
+// тела читаются только у отключаемых блоков, история счетов не
+// перечитывается. Выбор ветки остаётся за Blockchain.
+class ReorgEngine {
+public:
+    explicit ReorgEngine(LedgerStorage& db) : db_(db) {}
+
+    // firstNew — первый блок ветки, которого нет в нашей цепочке,
+    // forkHeight — высота его родителя у нас. false — ветка не связна
+    // или её начало не цепляется к нашей цепочке
+    bool findForkPoint(const std::vector<Block>& branch, size_t& firstNew, int& forkHeight);
+
+    ReorgResult reorganize(const std::vector<Block>& branch);
+
+private:
+    // Вернуть отключённые блоки, если ветку подключить не удалось
+    void restore(int forkHeight, const std::vector<Block>& disconnected);
+
+    LedgerStorage& db_;
+};
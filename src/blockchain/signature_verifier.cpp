@@ -0,0 +1,79 @@
+// src/blockchain/signature_verifier.cpp
+#include "signature_verifier.h"
+#include <functional>
+
+bool SignatureVerifier::needsVerification(const Transaction& tx) {
+    return tx.fromAddress != "SYSTEM" && (!tx.publicKey.empty() || Crypto::isKeyAddress(tx.fromAddress));
+}
+
+std::string SignatureVerifier::cacheDigest(const Transaction& tx) {
+    // Подписанная запись входит в дайджест целиком (ключ — её часть): txHash
+    // не различает все поля, и запись кэша не должна отвечать за другие
+    return Crypto::sha256(tx.signingMessage() + tx.signature);
+}
+
+SignatureVerifier::Shard& SignatureVerifier::shardFor(const std::string& txHash) {
+    return shards_[std::hash<std::string>{}(txHash) % CACHE_SHARDS];
+}
+
+bool SignatureVerifier::cached(const Transaction& tx, const std::string& digest) {
+    Shard& shard = shardFor(tx.txHash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(tx.txHash);
+    return it != shard.entries.end() && it->second == digest;
+}
+
+void SignatureVerifier::remember(const Transaction& tx, const std::string& digest) {
+    Shard& shard = shardFor(tx.txHash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto [it, inserted] = shard.entries.insert_or_assign(tx.txHash, digest);
+    if (!inserted) return;
+    shard.order.push_back(tx.txHash);
+    while (shard.order.size() > CACHE_CAPACITY / CACHE_SHARDS) {
+        shard.entries.erase(shard.order.front());
+        shard.order.pop_front();
+    }
+}
+
+std::string SignatureVerifier::check(const Transaction& tx) {
+    if (tx.fromAddress == "SYSTEM") return "";
+    if (tx.signature.empty()) return "missing signature";
+    if (!needsVerification(tx)) return "";
+
+    std::string digest = cacheDigest(tx);
+    if (cached(tx, digest)) {
+        cacheHits_.fetch_add(1, std::memory_order_relaxed);
+        return "";
+    }
+    cacheMisses_.fetch_add(1, std::memory_order_relaxed);
+
+    std::string error;
+    if (tx.publicKey.empty()) {
+        error = "missing public key";
+    } else if (Crypto::addressFromPublicKey(tx.publicKey) != tx.fromAddress) {
+        error = "public key does not match sender";
+    } else if (!Crypto::verify(tx.publicKey, tx.signingMessage(), tx.signature)) {
+        error = "invalid signature";
+    }
+    if (!error.empty()) {
+        invalid_.fetch_add(1, std::memory_order_relaxed);
+        return error;
+    }
+    valid_.fetch_add(1, std::memory_order_relaxed);
+    remember(tx, digest);
+    return "";
+}
+
+bool SignatureVerifier::isVerified(const Transaction& tx) {
+    if (tx.fromAddress == "SYSTEM" || tx.signature.empty() || !needsVerification(tx)) return true;
+    return cached(tx, cacheDigest(tx));
+}
+
+SignatureVerifier::Stats SignatureVerifier::stats() const {
+    Stats stats;
+    stats.valid = valid_.load(std::memory_order_relaxed);
+    stats.invalid = invalid_.load(std::memory_order_relaxed);
+    stats.cacheHits = cacheHits_.load(std::memory_order_relaxed);
+    stats.cacheMisses = cacheMisses_.load(std::memory_order_relaxed);
+    return stats;
+}
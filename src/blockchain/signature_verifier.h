@@ -0,0 +1,57 @@
+// src/blockchain/signature_verifier.h
+#pragma once
+#include <array>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "transaction.h"
+
+// Проверка подписей транзакций с кэшем уже проверенных. Транзакция
+// проверяется при приёме в mempool и ещё раз в составе блока; второй раз
+// отвечает кэш по txHash, без Ed25519. В записи кэша — дайджест подписанной
+// записи и подписи: транзакция с тем же txHash, но другими полями, ключом
+// или подписью проверяется заново.
+// Вызывается из любых потоков: у каждого шарда кэша свой мьютекс.
+class SignatureVerifier {
+public:
+    static constexpr size_t CACHE_SHARDS = 16;
+    // На все шарды; с запасом больше mempool, чтобы его транзакции
+    // дожили в кэше до своего блока
+    static constexpr size_t CACHE_CAPACITY = 32768;
+
+    struct Stats {
+        uint64_t valid = 0;          // Проверено Ed25519, подпись верна
+        uint64_t invalid = 0;        // Отклонено: подпись, ключ или адрес
+        uint64_t cacheHits = 0;
+        uint64_t cacheMisses = 0;
+    };
+
+    // Пусто — подпись верна или не нужна. SYSTEM не подписывается; у
+    // старых адресов без ключа подпись только должна быть непустой. Ключ
+    // обязателен для адресов ключей ("nx...") и проверяется у всех, кто его приложил
+    std::string check(const Transaction& tx);
+    // Подпись уже проверена или проверять нечего: check ответит без Ed25519
+    bool isVerified(const Transaction& tx);
+    Stats stats() const;
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::string> entries;  // txHash -> дайджест записи и подписи
+        std::deque<std::string> order;                          // Порядок вставки, для вытеснения
+    };
+
+    static bool needsVerification(const Transaction& tx);
+    static std::string cacheDigest(const Transaction& tx);
+    Shard& shardFor(const std::string& txHash);
+    bool cached(const Transaction& tx, const std::string& digest);
+    void remember(const Transaction& tx, const std::string& digest);
+
+    std::array<Shard, CACHE_SHARDS> shards_;
+    std::atomic<uint64_t> valid_{0};
+    std::atomic<uint64_t> invalid_{0};
+    std::atomic<uint64_t> cacheHits_{0};
+    std::atomic<uint64_t> cacheMisses_{0};
+};
@@ -0,0 +1,337 @@
+// src/blockchain/state_snapshot.cpp
+#include "state_snapshot.h"
+#include "block_pipeline.h"
+#include "../storage/block_codec.h"
+#include "../logging/logger.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[] = "NXSNAP";
+constexpr uint8_t SNAPSHOT_FILE_VERSION = 1;
+
+void put_le(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+void put_str(std::string& out, std::string_view value) {
+    put_le(out, value.size(), 4);
+    out.append(value);
+}
+
+// Чтение записи с проверкой границ: после первой ошибки ok() ложно
+class Cursor {
+public:
+    explicit Cursor(std::string_view in) : in_(in) {}
+
+    bool ok() const { return ok_; }
+    bool atEnd() const { return pos_ == in_.size(); }
+
+    uint64_t le(size_t bytes) {
+        if (!ok_ || bytes > in_.size() - pos_) {
+            ok_ = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(in_[pos_ + i])) << (8 * i);
+        }
+        pos_ += bytes;
+        return value;
+    }
+
+    std::string_view str() {
+        uint64_t size = le(4);
+        if (!ok_ || size > in_.size() - pos_) {
+            ok_ = false;
+            return {};
+        }
+        std::string_view value = in_.substr(pos_, size);
+        pos_ += size;
+        return value;
+    }
+
+    std::string_view raw(size_t size) {
+        if (!ok_ || size > in_.size() - pos_) {
+            ok_ = false;
+            return {};
+        }
+        std::string_view value = in_.substr(pos_, size);
+        pos_ += size;
+        return value;
+    }
+
+private:
+    std::string_view in_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+} // namespace
+
+nlohmann::json SnapshotManifest::toJson() const {
+    return {
+        {"height", height},
+        {"hash", blockHash},
+        {"accounts", accounts},
+        {"chunks", chunkHashes},
+        {"commitment", commitment}
+    };
+}
+
+bool SnapshotManifest::fromJson(const nlohmann::json& j, SnapshotManifest& manifest) {
+    if (!j.is_object() || !j.contains("height") || !j["height"].is_number_integer() ||
+        !j.contains("chunks") || !j["chunks"].is_array()) {
+        return false;
+    }
+    try {
+        manifest.height = j["height"].get<int>();
+        manifest.blockHash = j.value("hash", "");
+        manifest.accounts = j.value("accounts", uint64_t(0));
+        manifest.commitment = j.value("commitment", "");
+        manifest.chunkHashes = j["chunks"].get<std::vector<std::string>>();
+    } catch (const nlohmann::json::exception&) {
+        return false;
+    }
+    return true;
+}
+
+std::string encodeSnapshotChunk(const std::vector<SnapshotAccount>& accounts) {
+    std::string out;
+    put_le(out, accounts.size(), 4);
+    for (const auto& account : accounts) {
+        put_str(out, account.address);
+        put_le(out, static_cast<uint64_t>(account.balance), 8);
+    }
+    return out;
+}
+
+bool decodeSnapshotChunk(std::string_view data, std::vector<SnapshotAccount>& accounts) {
+    Cursor in(data);
+    uint64_t count = in.le(4);
+    // Счёт занимает не меньше 12 байт: не верим числу больше записи
+    if (!in.ok() || count > data.size() / 12) return false;
+    accounts.clear();
+    accounts.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        SnapshotAccount account;
+        account.address = std::string(in.str());
+        account.balance = static_cast<Amount>(in.le(8));
+        accounts.push_back(std::move(account));
+    }
+    return in.ok() && in.atEnd();
+}
+
+std::string snapshotCommitment(const SnapshotManifest& manifest) {
+    std::string preimage = "nexus-snapshot|" + std::to_string(manifest.height) + "|" + manifest.blockHash + "|" +
+                           std::to_string(manifest.accounts) + "|";
+    for (const auto& hash : manifest.chunkHashes) preimage += hash;
+    return Crypto::sha256(preimage);
+}
+
+void buildSnapshot(int height, const std::string& blockHash, const std::map<std::string, Amount>& balances,
+                   StateSnapshot& snapshot) {
+    SnapshotManifest& manifest = snapshot.manifest;
+    manifest = SnapshotManifest{};
+    manifest.height = height;
+    manifest.blockHash = blockHash;
+    snapshot.chunks.clear();
+
+    std::vector<SnapshotAccount> chunk;
+    auto flush = [&]() {
+        snapshot.chunks.push_back(encodeSnapshotChunk(chunk));
+        manifest.chunkHashes.push_back(Crypto::sha256(snapshot.chunks.back()));
+        chunk.clear();
+    };
+    for (const auto& [address, balance] : balances) {
+        if (balance == 0) continue;
+        chunk.push_back({address, balance});
+        manifest.accounts++;
+        if (chunk.size() == SNAPSHOT_CHUNK_ACCOUNTS) flush();
+    }
+    if (!chunk.empty()) flush();
+    manifest.commitment = snapshotCommitment(manifest);
+}
+
+bool makeStateSnapshot(LedgerStorage& db, int height, bool withHeaders, StateSnapshot& snapshot) {
+    int tip = db.getLatestHeight();
+    // Отменять можно только блоки с undo-записями: выше базы снимка и обрезки
+    if (height < 1 || height > tip || height < db.getSnapshotBase().height || height < db.getPrunedHeight()) {
+        return false;
+    }
+    auto header = db.getBlockHeader(height);
+    if (!header) return false;
+
+    std::map<std::string, Amount> balances;
+    if (!db.scanBalances([&balances](const std::string& address, Amount balance) {
+            balances.emplace(address, balance);
+        })) {
+        return false;
+    }
+    // Назад от вершины: блоки выше height отменяются по undo-записям, а
+    // в базах без них — по транзакциям блока
+    for (int h = tip; h > height; --h) {
+        auto undo = db.getBlockUndo(h);
+        if (!undo) {
+            auto block = db.getBlockByHeight(h);
+            undo.emplace();
+            if (!block || !makeBlockUndo(*block, *undo)) return false;
+        }
+        for (const auto& [address, delta] : undo->balanceDeltas) {
+            Amount& balance = balances[address];
+            if (!subAmount(balance, delta, balance)) return false;
+        }
+    }
+    buildSnapshot(height, header->hash, balances, snapshot);
+
+    snapshot.headers.clear();
+    if (withHeaders) {
+        snapshot.headers.reserve(height);
+        for (int h = 1; h <= height; ++h) {
+            auto stored = db.getBlockHeader(h);
+            if (!stored) return false;
+            snapshot.headers.push_back(std::move(*stored));
+        }
+    }
+    return true;
+}
+
+std::string verifySnapshot(const StateSnapshot& snapshot, const std::string& genesisHash) {
+    const SnapshotManifest& manifest = snapshot.manifest;
+    if (manifest.height < 1) return "snapshot has no blocks";
+    if (snapshot.chunks.size() != manifest.chunkHashes.size()) return "chunk count mismatch";
+    if (snapshotCommitment(manifest) != manifest.commitment) return "commitment mismatch";
+
+    // Разбиение однозначно: полные части и неполная последняя, иначе у
+    // одного состояния было бы несколько обязательств
+    uint64_t accounts = 0;
+    std::string last;
+    std::vector<SnapshotAccount> chunk;
+    for (size_t i = 0; i < snapshot.chunks.size(); ++i) {
+        if (Crypto::sha256(snapshot.chunks[i]) != manifest.chunkHashes[i]) return "chunk hash mismatch";
+        if (!decodeSnapshotChunk(snapshot.chunks[i], chunk)) return "malformed chunk";
+        bool lastChunk = i + 1 == snapshot.chunks.size();
+        if (chunk.empty() || chunk.size() > SNAPSHOT_CHUNK_ACCOUNTS ||
+            (!lastChunk && chunk.size() != SNAPSHOT_CHUNK_ACCOUNTS)) {
+            return "uneven chunk";
+        }
+        for (const auto& account : chunk) {
+            if (accounts > 0 && account.address <= last) return "accounts out of order";
+            if (account.balance == 0) return "zero balance in snapshot";
+            last = account.address;
+            accounts++;
+        }
+    }
+    if (accounts != manifest.accounts) return "account count mismatch";
+
+    if (snapshot.headers.size() != static_cast<size_t>(manifest.height)) return "header count mismatch";
+    std::string prev = genesisHash;
+    for (size_t i = 0; i < snapshot.headers.size(); ++i) {
+        const Block& header = snapshot.headers[i];
+        if (header.height != static_cast<int>(i) + 1) return "header height mismatch";
+        if (header.prevHash != prev) return "headers are not linked";
+        std::string error = BlockPipeline::checkHeader(header, true);
+        if (!error.empty()) return "header " + std::to_string(header.height) + ": " + error;
+        prev = header.hash;
+    }
+    if (prev != manifest.blockHash) return "headers don't end at the snapshot block";
+    return "";
+}
+
+bool writeSnapshotFile(const std::string& path, const StateSnapshot& snapshot) {
+    const SnapshotManifest& manifest = snapshot.manifest;
+    std::string out(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC) - 1);
+    put_le(out, SNAPSHOT_FILE_VERSION, 1);
+    put_le(out, static_cast<uint64_t>(static_cast<int64_t>(manifest.height)), 8);
+    put_str(out, manifest.blockHash);
+    put_le(out, manifest.accounts, 8);
+    put_str(out, manifest.commitment);
+    put_le(out, manifest.chunkHashes.size(), 4);
+    for (const auto& hash : manifest.chunkHashes) put_str(out, hash);
+    put_le(out, snapshot.headers.size(), 4);
+    for (const auto& header : snapshot.headers) put_str(out, encodeBlock(header));
+    for (const auto& chunk : snapshot.chunks) put_str(out, chunk);
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(out.data(), static_cast<std::streamsize>(out.size())) || !file.flush()) {
+        LOG_ERROR(STORAGE, "Can't write snapshot file").kv("path", path);
+        return false;
+    }
+    return true;
+}
+
+bool readSnapshotFile(const std::string& path, StateSnapshot& snapshot) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        LOG_ERROR(STORAGE, "Can't open snapshot file").kv("path", path);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string data = buffer.str();
+
+    Cursor in(data);
+    if (in.raw(sizeof(SNAPSHOT_MAGIC) - 1) != SNAPSHOT_MAGIC || in.le(1) != SNAPSHOT_FILE_VERSION) {
+        LOG_ERROR(STORAGE, "Not a snapshot file or unknown version").kv("path", path);
+        return false;
+    }
+    SnapshotManifest& manifest = snapshot.manifest;
+    manifest.height = static_cast<int>(static_cast<int64_t>(in.le(8)));
+    manifest.blockHash = std::string(in.str());
+    manifest.accounts = in.le(8);
+    manifest.commitment = std::string(in.str());
+    uint64_t chunks = in.le(4);
+    manifest.chunkHashes.clear();
+    for (uint64_t i = 0; i < chunks && in.ok(); ++i) manifest.chunkHashes.emplace_back(in.str());
+    uint64_t headers = in.le(4);
+    snapshot.headers.clear();
+    for (uint64_t i = 0; i < headers && in.ok(); ++i) {
+        Block header;
+        if (!decodeBlock(in.str(), header)) {
+            LOG_ERROR(STORAGE, "Corrupted header in snapshot file").kv("index", i);
+            return false;
+        }
+        snapshot.headers.push_back(std::move(header));
+    }
+    snapshot.chunks.clear();
+    for (uint64_t i = 0; i < chunks && in.ok(); ++i) snapshot.chunks.emplace_back(in.str());
+    if (!in.ok() || !in.atEnd()) {
+        LOG_ERROR(STORAGE, "Truncated snapshot file").kv("path", path);
+        return false;
+    }
+    return true;
+}
+
+SnapshotVerifier::SnapshotVerifier(SnapshotBase base, const Block& genesis, std::vector<std::string> hashes)
+    : base_(std::move(base)), hashes_(std::move(hashes)) {
+    addDeltas(genesis);
+}
+
+bool SnapshotVerifier::addDeltas(const Block& block) {
+    BlockUndo undo;
+    if (!makeBlockUndo(block, undo)) {
+        overflow_ = true;
+        return false;
+    }
+    for (const auto& [address, delta] : undo.balanceDeltas) {
+        Amount& balance = balances_[address];
+        if (!addAmount(balance, delta, balance)) overflow_ = true;
+    }
+    return !overflow_;
+}
+
+std::string SnapshotVerifier::apply(const Block& block) {
+    if (complete()) return "history already verified";
+    if (block.height != nextHeight()) return "unexpected height";
+    if (block.hash != hashes_[applied_]) return "block is not in the chain";
+    if (!addDeltas(block)) return "balance overflow";
+    applied_++;
+    return "";
+}
+
+std::string SnapshotVerifier::commitment() const {
+    StateSnapshot snapshot;
+    buildSnapshot(base_.height, base_.hash, balances_, snapshot);
+    return snapshot.manifest.commitment;
+}
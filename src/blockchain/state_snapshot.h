@@ -0,0 +1,95 @@
+// src/blockchain/state_snapshot.h
+#pragma once
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "block.h"
+#include "../storage/ledger_storage.h"
+
+// Снимок состояния счетов на высоте: балансы всех ненулевых счетов по
+// возрастанию адреса, разбитые на части по SNAPSHOT_CHUNK_ACCOUNTS. Хэш
+// части — sha256 её двоичной записи, обязательство снимка — sha256 от
+// высоты, хэша блока, числа счетов и хэшей частей по порядку. Части можно
+// грузить у разных пиров и проверять по одной, а итог — сравнить с
+// состоянием, полученным проверкой истории. Nonce в цепочке не участвует,
+// поэтому в снимок не входит.
+constexpr size_t SNAPSHOT_CHUNK_ACCOUNTS = 4096;
+// Заголовков в одной части при передаче по сети
+constexpr size_t SNAPSHOT_HEADER_CHUNK = 1000;
+
+struct SnapshotManifest {
+    int height = -1;
+    std::string blockHash;
+    uint64_t accounts = 0;
+    std::vector<std::string> chunkHashes;
+    std::string commitment;
+
+    int headerChunks() const {
+        return height <= 0 ? 0 : static_cast<int>((height + SNAPSHOT_HEADER_CHUNK - 1) / SNAPSHOT_HEADER_CHUNK);
+    }
+    nlohmann::json toJson() const;
+    // false — поля отсутствуют или не того типа
+    static bool fromJson(const nlohmann::json& j, SnapshotManifest& manifest);
+};
+
+struct StateSnapshot {
+    SnapshotManifest manifest;
+    std::vector<Block> headers;        // Заголовки 1..height основной цепочки
+    std::vector<std::string> chunks;   // Записи частей (encodeSnapshotChunk)
+};
+
+// Часть: u32 число счетов, затем адрес (u32 длина, байты) и i64 баланс
+std::string encodeSnapshotChunk(const std::vector<SnapshotAccount>& accounts);
+bool decodeSnapshotChunk(std::string_view data, std::vector<SnapshotAccount>& accounts);
+std::string snapshotCommitment(const SnapshotManifest& manifest);
+
+// Разложить балансы (адрес -> баланс; нулевые пропускаются) по частям и
+// заполнить манифест. Заголовки не трогает
+void buildSnapshot(int height, const std::string& blockHash, const std::map<std::string, Amount>& balances,
+                   StateSnapshot& snapshot);
+
+// Снимок из хранилища: текущие балансы минус изменения блоков выше height
+// по их undo-записям. withHeaders — прочитать и заголовки 1..height (для
+// файла; пиру они отдаются частями по запросу). false — height вне цепочки,
+// ниже базы снимка, из которого загружена сама база, или обрезанной истории
+bool makeStateSnapshot(LedgerStorage& db, int height, bool withHeaders, StateSnapshot& snapshot);
+
+// Проверка без состояния цепочки: части совпадают с хэшами манифеста, счета
+// в них по возрастанию адреса и ненулевые, обязательство сходится,
+// заголовки связаны от genesisHash до блока манифеста, их хэши и PoW верны.
+// Пустая строка — снимок цел
+std::string verifySnapshot(const StateSnapshot& snapshot, const std::string& genesisHash);
+
+// Файл: "NXSNAP", u8 версия, манифест, заголовки (block_codec), части
+bool writeSnapshotFile(const std::string& path, const StateSnapshot& snapshot);
+bool readSnapshotFile(const std::string& path, StateSnapshot& snapshot);
+
+// Проверка истории под загруженным снимком: блоки 1..height приходят от
+// пиров по порядку (уже проверенные BlockPipeline), их хэши сверяются с
+// заголовками цепочки, изменения балансов копятся в памяти. После блока
+// height состояние сводится в снимок и сравнивается с обязательством базы.
+class SnapshotVerifier {
+public:
+    // genesis — блок 0 с транзакциями, hashes — хэши блоков 1..base.height
+    SnapshotVerifier(SnapshotBase base, const Block& genesis, std::vector<std::string> hashes);
+
+    int nextHeight() const { return static_cast<int>(applied_) + 1; }
+    bool complete() const { return applied_ == hashes_.size(); }
+    const SnapshotBase& base() const { return base_; }
+
+    // Блок nextHeight(); пустая строка — принят
+    std::string apply(const Block& block);
+    // Обязательство состояния после всех блоков (только при complete())
+    std::string commitment() const;
+
+private:
+    bool addDeltas(const Block& block);
+
+    SnapshotBase base_;
+    std::vector<std::string> hashes_;
+    size_t applied_ = 0;
+    std::map<std::string, Amount> balances_;
+    bool overflow_ = false;
+};
@@ -3,18 +3,48 @@
 #include <sstream>
 #include <nlohmann/json.hpp>
 
+namespace {
+
+// Целые — 8 байт big-endian, строки — длина и байты: разные наборы полей
+// не дают одинаковую запись
+void putU64(std::string& out, uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) out.push_back(static_cast<char>(value >> shift));
+}
+
+void putString(std::string& out, const std::string& value) {
+    putU64(out, value.size());
+    out += value;
+}
+
+} // namespace
+
 Transaction::Transaction() 
-    : amount(0), fee(0), timestamp(time(nullptr)), status("pending") {
+    : amount(0), fee(0), timestamp(time(nullptr)), status("pending"), nonce(0) {
 }
 
 std::string Transaction::calculateHash() const {
+    std::string record = "nexus-tx-v2";
+    record.reserve(record.size() + 8 * 8 + fromAddress.size() + toAddress.size() + data.size());
+    putString(record, fromAddress);
+    putString(record, toAddress);
+    putU64(record, static_cast<uint64_t>(amount));
+    putU64(record, static_cast<uint64_t>(fee));
+    putU64(record, nonce);
+    putU64(record, static_cast<uint64_t>(static_cast<int64_t>(timestamp)));
+    putString(record, data);
+    return Crypto::sha256(record);
+}
+
+std::string Transaction::calculateLegacyHash() const {
     std::stringstream ss;
+    // Суммы — в монетах через double с точностью потока по умолчанию,
+    // как до перехода на целые единицы
     ss << fromAddress << toAddress 
-       << amount << fee << timestamp;
+       << amountToCoins(amount) << amountToCoins(fee) << timestamp;
     return Crypto::sha256(ss.str());
 }
 
-Transaction Transaction::createCoinbase(const std::string& to, double reward) {
+Transaction Transaction::createCoinbase(const std::string& to, Amount reward) {
     Transaction tx;
     tx.fromAddress = "SYSTEM";
     tx.toAddress = to;
@@ -28,17 +58,64 @@ Transaction Transaction::createCoinbase(const std::string& to, double reward) {
     return tx;
 }
 
+std::string Transaction::signingMessage() const {
+    std::string message = "nexus-tx-sig-v1";
+    message.reserve(message.size() + 8 * 9 + fromAddress.size() + toAddress.size() +
+                    data.size() + publicKey.size());
+    putString(message, fromAddress);
+    putString(message, toAddress);
+    putU64(message, static_cast<uint64_t>(amount));
+    putU64(message, static_cast<uint64_t>(fee));
+    putU64(message, nonce);
+    putU64(message, static_cast<uint64_t>(static_cast<int64_t>(timestamp)));
+    putString(message, data);
+    putString(message, publicKey);
+    return message;
+}
+
+void Transaction::sign(const std::string& privateKeyHex) {
+    txHash = calculateHash();
+    // Открытый ключ выводится из закрытого и входит в подписанную запись
+    publicKey = Crypto::publicKeyFromPrivate(privateKeyHex);
+    signature = publicKey.empty() ? "" : Crypto::sign(privateKeyHex, signingMessage());
+    if (signature.empty()) publicKey.clear();
+}
+
 std::string Transaction::toJson() const {
+    return toJsonObject().dump();
+}
+
+nlohmann::json Transaction::toJsonObject() const {
     nlohmann::json j;
     j["txHash"] = txHash;
     j["from"] = fromAddress;
     j["to"] = toAddress;
-    j["amount"] = amount;
-    j["fee"] = fee;
+    j["amount"] = amountToJson(amount);
+    j["fee"] = amountToJson(fee);
     j["signature"] = signature;
+    if (!publicKey.empty()) j["public_key"] = publicKey;
     j["timestamp"] = timestamp;
     j["data"] = data;
     j["status"] = status;
     j["nonce"] = static_cast<uint64_t>(nonce);
-    return j.dump();
+    return j;
+}
+
+Transaction Transaction::fromJson(const nlohmann::json& j) {
+    Transaction tx;
+    tx.fromAddress = j.value("from", "");
+    tx.toAddress = j.value("to", "");
+    tx.amount = j.contains("amount") ? amountFromJson(j.at("amount")) : 0;
+    tx.fee = j.contains("fee") ? amountFromJson(j.at("fee")) : 0;
+    tx.signature = j.value("signature", "");
+    tx.publicKey = j.value("public_key", "");
+    tx.timestamp = j.value("timestamp", 0L);
+    tx.data = j.value("data", "");
+    tx.status = j.value("status", "pending");
+    tx.nonce = j.value("nonce", 0ULL);
+    tx.txHash = tx.calculateHash();
+    // Транзакции старых блоков и узлов несут хэш версии 1
+    std::string claimed = j.value("txHash", "");
+    if (!claimed.empty() && claimed != tx.txHash && claimed == tx.calculateLegacyHash()) tx.txHash = claimed;
+    return tx;
 }
\ No newline at end of file
@@ -2,22 +2,41 @@
 #pragma once
 #include <string>
 #include <ctime>
+#include <nlohmann/json.hpp>
 #include "../crypto/crypto.h"
+#include "amount.h"
 
 struct Transaction {
     std::string txHash;
     std::string fromAddress;
     std::string toAddress;
-    double amount;
-    double fee;
+    Amount amount;
+    Amount fee;
     std::string signature;
+    std::string publicKey;   // Ed25519, hex; пусто у транзакций со старых адресов
     long timestamp;
     std::string data;
     std::string status;
     uint64_t nonce;  // Счётчик транзакций отправителя. Защита от replay-атак
     
     Transaction();
+    // Хэш версии 2: SHA-256 точной записи адресов, сумм в минимальных
+    // единицах, nonce, времени и data
     std::string calculateHash() const;
+    // Хэш версии 1 — суммы в монетах через double, без nonce; разные суммы
+    // могут дать один хэш. Он у транзакций, записанных до версии 2
+    std::string calculateLegacyHash() const;
+    // txHash — хэш этой транзакции любой версии: так проверяются транзакции
+    // блоков. В mempool принимается только версия 2
+    bool hasValidHash() const { return txHash == calculateHash() || txHash == calculateLegacyHash(); }
     std::string toJson() const;
-    static Transaction createCoinbase(const std::string& to, double reward);
-};
\ No newline at end of file
+    nlohmann::json toJsonObject() const;
+    // txHash пересчитывается; хэш версии 1 сохраняется, только если он
+    // пришёл в JSON и совпал. Некорректная сумма — std::invalid_argument
+    static Transaction fromJson(const nlohmann::json& j);
+    static Transaction createCoinbase(const std::string& to, Amount reward);
+    // Подписывается точная кодировка: адреса, суммы в минимальных единицах,
+    // nonce, время, data и ключ, каждое поле — с длиной или фиксированной ширины
+    std::string signingMessage() const;
+    void sign(const std::string& privateKeyHex);   // Заполняет txHash, publicKey и signature
+};
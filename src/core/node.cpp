@@ -1,6 +1,7 @@
 // src/core/node.cpp
 #include "node.h"
-#include <iostream>
+#include "../logging/logger.h"
+#include "../network/traffic_capture.h"
 #include <chrono>
 #include <thread>
 #include <sys/socket.h>
@@ -8,70 +9,127 @@
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <algorithm>
+#include <future>
+#include <sstream>
 
 namespace nexus {
 
-Node::Node(const std::string& dbPath, int p2pPort, int metricsPort, const std::string& nodeId)
+Node::Node(const std::string& dbPath, int p2pPort, int metricsPort, const std::string& nodeId,
+           StorageBackend storage)
     : nodeId_(nodeId), p2pPort_(p2pPort), metricsPort_(metricsPort)
     , work_(std::make_unique<boost::asio::io_context::work>(ioContext_)) {
     
-    blockchain_ = std::make_unique<Blockchain>(dbPath);
+    blockchain_ = std::make_unique<Blockchain>(dbPath, storage);
+    // Проверка блоков пиров и исполнение транзакций блока — на остальных ядрах
+    workerPool_ = std::make_unique<ThreadPool>();
+    blockchain_->setThreadPool(workerPool_.get());
+    signatureQueue_ = std::make_unique<SignatureQueue>(
+        blockchain_->getSignatureVerifier(), workerPool_.get(),
+        [this](std::function<void()> task) { boost::asio::post(ioContext_, std::move(task)); });
 
-    // Загружаем сохранённых пиров из БД
-    auto saved_peers = blockchain_->getDB()->getPeers(10);
-    std::cout << "Loaded " << saved_peers.size() << " saved peers from database" << std::endl;
-    for (const auto& [ip, port] : saved_peers) {
-        // Не подключаемся к самому себе
-        if (port != p2pPort_) {
-            connectToPeer(ip, port);
-        }
-    }
-    // Если нет ни одного сохранённого пира, используем seed-узлы (пример)
-    if (saved_peers.empty()) {
-        std::cout << "No saved peers, using seed nodes..." << std::endl;
-        // Здесь можно задать список seed-узлов. Для демо используем localhost с разными портами.
-        // В реальной сети это должны быть известные стабильные узлы.
-        std::vector<std::pair<std::string, int>> seeds = {
-            {"139.100.207.199", 8000},
-            {"139.100.207.83", 8001},
-            {"139.100.207.102", 8002}
-        };
-        for (const auto& [ip, port] : seeds) {
-            if (port != p2pPort_) {
-                connectToPeer(ip, port);
-            }
-        }
-    }
+    relay_ = std::make_unique<TxRelay>(nodeId_);
+    relay_->set_send_handler([this](const Message& msg, std::shared_ptr<Peer> peer) {
+        peer->send(msg);
+        if (metrics_) metrics_->incPacketsSent(msg.type);
+    });
+
+    reconciler_ = std::make_unique<MempoolReconciler>(nodeId_, *relay_);
+    reconciler_->set_send_handler([this](const Message& msg, std::shared_ptr<Peer> peer) {
+        peer->send(msg);
+        if (metrics_) metrics_->incPacketsSent(msg.type);
+    });
+    reconciler_->set_mempool_provider([this]() { return blockchain_->getMempoolHashes(); });
+
+    snapshotSync_ = std::make_unique<SnapshotSync>(nodeId_, [this](const Message& msg, const std::shared_ptr<Peer>& peer) {
+        peer->send(msg);
+        if (metrics_) metrics_->incPacketsSent(msg.type);
+    });
+    snapshotSync_->setProviders([this]() { return servedSnapshot(); },
+                                [this](int height) { return blockchain_->getDB()->getBlockHeader(height); });
+    snapshotSync_->setCompleteHandler([this](const StateSnapshot* snapshot) { return completeSnapshotSync(snapshot); });
 
     server_ = std::make_unique<Server>(ioContext_, p2pPort);
     
     if (metricsPort_ > 0) {
         try {
             metrics_ = std::make_unique<MetricsRegistry>(metricsPort_);
-            std::cout << "Metrics server started on port " << metricsPort_ << std::endl;
+            LOG_DEBUG(METRICS, "Metrics enabled").kv("port", metricsPort_);
         } catch (const std::exception& e) {
-            std::cerr << "Failed to start metrics: " << e.what() << std::endl;
+            LOG_ERROR(METRICS, "Failed to start metrics").kv("error", e.what());
             metrics_ = nullptr;
         }
     } else {
-        std::cout << "Metrics disabled" << std::endl;
+        LOG_INFO(METRICS, "Metrics disabled");
         metrics_ = nullptr;
     }
     
-    startHttpServer();
+    if (metrics_) {
+        MetricsRegistry* metrics = metrics_.get();
+        blockchain_->setStageObserver([metrics](const char* stage, double seconds) {
+            metrics->observeStage(stage, seconds);
+        });
+        blockchain_->getDB()->setQueryObserver([metrics](const char* kind, double seconds) {
+            metrics->observeQuery(kind, seconds);
+        });
+    }
+
+    scheduler_ = std::make_unique<Scheduler>(ioContext_);
+    if (metrics_) {
+        scheduler_->setDurationObserver([this](const std::string& task, double seconds) {
+            metrics_->observeScheduledTask(task, seconds);
+        });
+    }
+
+    connections_ = std::make_unique<ConnectionManager>(ioContext_, *scheduler_, nodeId_);
+    connections_->set_message_handler([this](const Message& msg, std::shared_ptr<Peer> peer) {
+        if (metrics_) metrics_->incPacketsReceived(msg.type);
+        handleMessage(msg, peer);
+    });
+    connections_->set_connected_handler([this](std::shared_ptr<Client> client) {
+        clients_.push_back(client);
+        auto peer = client->get_peer();
+        addrman_->mark_good(peer->address, peer->port);
+        client->send(makeHandshake());
+        if (metrics_) metrics_->incPacketsSent(MessageType::HANDSHAKE);
+        if (!snapshotSync_->active()) syncWithPeer(peer);
+        updateMetrics();
+    });
+    connections_->set_attempts_store(
+        [this](const std::string& ip, int port) {
+            return blockchain_->getDB()->getPeerFailedAttempts(ip, port);
+        },
+        [this](const std::string& ip, int port, int attempts) {
+            blockchain_->getDB()->setPeerFailedAttempts(ip, port, attempts);
+            if (attempts > 0) addrman_->mark_failed(ip, port);
+        });
+
+    addrman_ = std::make_unique<AddressManager>();
+    loadAddressBook();
 
     setupHandlers();
+
+    // Подключения асинхронные и начнутся только после запуска io-потока в start()
+    boost::asio::post(ioContext_, [this]() { fillOutboundSlots(); });
     
-    std::cout << "Node created: " << nodeId_ << " (P2P: " << p2pPort_ << ")" << std::endl;
+    LOG_INFO(CORE, "Node created").kv("node", nodeId_).kv("p2p_port", p2pPort_)
+        .kv("worker_threads", workerPool_->size());
 }
 
 Node::~Node() {
     stop();
+    // Задачи пула дорабатывают до разрушения io_context и очереди подписей
+    blockchain_->setThreadPool(nullptr);
+    workerPool_.reset();
+    // Сокеты и таймеры должны уничтожаться раньше io_context
+    clients_.clear();
+    replayPeers_.clear();
+    connections_.reset();
+    scheduler_.reset();
 }
 
 void Node::setupHandlers() {
     server_->set_message_handler([this](const Message& msg, std::shared_ptr<Peer> peer) {
-        if (metrics_) metrics_->incPacketsReceived(message_type_to_string(msg.type));
+        if (metrics_) metrics_->incPacketsReceived(msg.type);
         handleMessage(msg, peer);
     });
     
@@ -90,71 +148,64 @@ void Node::start() {
         ioContext_.run();
     });
 
-    std::thread([this]() {
-    while (running_) {
-        std::this_thread::sleep_for(std::chrono::seconds(15));
-        if (!running_) break;
-        for (auto& client : clients_) {
-            if (client->is_connected()) {
-                auto ping = Message::create_ping(nodeId_);
-                client->send(ping);
-            }
-        }
-    }
-    }).detach();
-
-    background_threads_.emplace_back([this]() { gossipPeers(); }); // Запускаем периодическую рассылку пиров
-
-    // Периодический запрос списка пиров у всех подключённых
-    background_threads_.emplace_back([this]() {
-        while (running_) {
-            std::this_thread::sleep_for(std::chrono::seconds(45));
-            if (!running_) break;   // ← добавить
-            Message get_peers_msg = Message::create_get_peers(nodeId_);
-            for (auto& client : clients_) {
-                if (client && client->is_connected()) {
-                    client->send(get_peers_msg);
-                    if (metrics_) metrics_->incPacketsSent("GET_PEERS");
-                }
-            }
-            std::cout << "Requested peer lists from " << clients_.size() << " peers" << std::endl;
-        }
-    });
-    
-    // Периодическая синхронизация каждые 30 секунд
-    background_threads_.emplace_back([this]() {
-        while (running_) {
-            std::this_thread::sleep_for(std::chrono::seconds(30));
-            if (!running_) break;
-            if (!clients_.empty() && running_) {
-                std::cout << "Periodic sync: requesting blocks from first peer" << std::endl;
-                syncWithPeer(clients_[0]->get_peer());
-                broadcastPeersToAll();
-            }
-        }
-    });
+    scheduleBackgroundTasks();
 
-    // Периодическая очистка mempool
-    mempool_cleaner_thread_ = std::thread([this]() {
-        while (running_) {
-            std::this_thread::sleep_for(std::chrono::seconds(30));
-            if (!running_) break;
-            int removed = blockchain_->cleanMempool();
-            if (removed > 0) {
-                std::cout << "Cleaned " << removed << " invalid transactions from mempool" << std::endl;
-            }
-        }
-    });
+    // HTTP-запросы исполняются в io-потоке, поэтому сервер поднимается после
+    // него и после running_ = true (иначе цикл accept мог завершиться сразу)
+    startHttpServer();
 
     blockchain_->cleanMempool();
 
      // Запускаем майнинг
-    mining_ = true;
-    mining_thread_ = std::thread([this]() { mine_loop(); });
+    startMining();
     
     updateMetrics();
     
-    std::cout << "Node " << nodeId_ << " started on port " << p2pPort_ << std::endl;
+    LOG_INFO(CORE, "Node started").kv("node", nodeId_).kv("p2p_port", p2pPort_);
+}
+
+void Node::startReplay() {
+    if (running_) return;
+    running_ = true;
+    replay_ = true;
+
+    // Ни сервера, ни исходящих подключений, ни майнинга, ни периодических
+    // задач: состояние меняет только воспроизводимый трафик
+    ioThread_ = std::thread([this]() {
+        ioContext_.run();
+    });
+
+    LOG_INFO(CORE, "Node started in replay mode").kv("node", nodeId_);
+}
+
+void Node::injectMessage(const std::string& source, const std::string& data, InjectDone done) {
+    auto queued = std::chrono::steady_clock::now();
+    boost::asio::post(ioContext_, [this, source, data, done = std::move(done), queued]() {
+        auto& peer = replayPeers_[source];
+        if (!peer) {
+            // Пир-заглушка без сокета: ответы узла уходят в никуда, а
+            // счётчики и фильтры пира работают как у настоящего
+            peer = std::make_shared<Peer>(ioContext_);
+            size_t colon = source.rfind(':');
+            peer->address = source.substr(0, colon);
+            peer->port = colon == std::string::npos ? 0 : std::atoi(source.c_str() + colon + 1);
+            peer->inbound = true;
+        }
+
+        MessageType type = MessageType::ERROR;
+        try {
+            Message msg = Message::deserialize(data);
+            type = msg.type;
+            peer->stats.record_received(msg.type, data.size() + 1);
+            if (metrics_) metrics_->incPacketsReceived(msg.type);
+            handleMessage(msg, peer);
+        } catch (const std::exception& e) {
+            peer->score.record_invalid();
+        }
+        if (done) {
+            done(type, std::chrono::duration<double>(std::chrono::steady_clock::now() - queued).count());
+        }
+    });
 }
 
 void Node::stop() {
@@ -162,10 +213,10 @@ void Node::stop() {
     running_ = false;
 
     // Остановка майнинга
-    mining_ = false;
-    if (mining_thread_.joinable()) {
-        mining_thread_.join();
-    }
+    stopMining();
+
+    // Отмена периодических задач (таймеры, без ожидания)
+    scheduler_->stop();
 
     // Остановка io_context
     work_.reset();
@@ -174,48 +225,374 @@ void Node::stop() {
         ioThread_.join();
     }
 
+    // io-поток остановлен: адресную книгу можно сохранить без гонок
+    saveAddressBook();
+
     // Остановка сервера (закрывает сокеты)
     server_->stop();
 
+    // HTTP-поток висит в accept(): shutdown() сокета будит его сразу
+    int http_fd = httpFd_.exchange(-1);
+    if (http_fd >= 0) {
+        shutdown(http_fd, SHUT_RDWR);
+    }
+
     // Ожидание завершения всех фоновых потоков
     for (auto& th : background_threads_) {
         if (th.joinable()) th.join();
     }
     background_threads_.clear();
 
-    std::cout << "Node " << nodeId_ << " stopped" << std::endl;
+    LOG_INFO(CORE, "Node stopped").kv("node", nodeId_);
+}
+
+void Node::scheduleBackgroundTasks() {
+    using std::chrono::seconds;
+    using std::chrono::milliseconds;
+
+    scheduler_->schedulePeriodic("prune_connections", seconds(5), milliseconds(500), [this]() { pruneConnections(); });
+    scheduler_->schedulePeriodic("fill_outbound", seconds(10), milliseconds(1000), [this]() { fillOutboundSlots(); });
+    scheduler_->schedulePeriodic("peer_metrics", seconds(5), milliseconds(500), [this]() { exportPeerMetrics(); });
+    scheduler_->schedulePeriodic("save_address_book", seconds(60), milliseconds(5000), [this]() { saveAddressBook(); });
+    scheduler_->schedulePeriodic("ping", seconds(15), milliseconds(2000), [this]() { pingPeers(); });
+    scheduler_->schedulePeriodic("gossip_peers", seconds(30), milliseconds(5000), [this]() { gossipPeers(); });
+    scheduler_->schedulePeriodic("request_peers", seconds(45), milliseconds(5000), [this]() { requestPeerLists(); });
+    scheduler_->schedulePeriodic("sync", seconds(30), milliseconds(3000), [this]() { periodicSync(); });
+    scheduler_->schedulePeriodic("snapshot", seconds(5), milliseconds(500), [this]() {
+        if (snapshotSync_->active()) {
+            snapshotSync_->tick(connectedPeers());
+        } else {
+            requestHistory();
+        }
+    });
+    if (blockchain_->pruning()) {
+        // По порции за раз: io-поток не занят надолго даже при первой обрезке длинной цепочки
+        scheduler_->schedulePeriodic("prune", seconds(2), milliseconds(500), [this]() { blockchain_->pruneStep(); });
+    }
+    scheduler_->schedulePeriodic("mempool_clean", seconds(30), milliseconds(3000), [this]() {
+        int removed = blockchain_->cleanMempool();
+        if (removed > 0) {
+            LOG_INFO(CHAIN, "Cleaned invalid transactions from mempool").kv("count", removed);
+        }
+    });
+}
+
+void Node::pingPeers() {
+    for (auto& client : clients_) {
+        if (client->is_connected()) {
+            uint64_t nonce = rng_() | 1;  // 0 означает "без nonce"
+            client->get_peer()->stats.ping_sent(nonce);
+            client->send(Message::create_ping(nodeId_, nonce));
+        }
+    }
+}
+
+// Периодический запрос списка пиров у всех подключённых
+void Node::requestPeerLists() {
+    Message get_peers_msg = Message::create_get_peers(nodeId_);
+    for (auto& client : clients_) {
+        if (client && client->is_connected()) {
+            client->send(get_peers_msg);
+            if (metrics_) metrics_->incPacketsSent(MessageType::GET_PEERS);
+        }
+    }
+    LOG_DEBUG(NET, "Requested peer lists").kv("peers", clients_.size());
+}
+
+// Периодическая синхронизация блоков, рассылка пиров и сверка mempool
+void Node::periodicSync() {
+    auto source = bestSyncPeer();
+    if (!source || snapshotSync_->active()) return;
+    LOG_DEBUG(CORE, "Periodic sync").kv("peer", source->get_endpoint()).kv("score", source->score.value());
+    syncWithPeer(source);
+    broadcastPeersToAll();
+    // Сверка mempool со случайным пиром
+    auto peers = connectedPeers();
+    if (!peers.empty()) reconciler_->start(peers[rng_() % peers.size()]);
+}
+
+void Node::startMining() {
+    if (replay_) return;
+    mining_ = true;
+    mining_thread_ = std::thread([this]() { mine_loop(); });
+}
+
+void Node::stopMining() {
+    {
+        std::lock_guard<std::mutex> lock(mining_mutex_);
+        mining_ = false;
+    }
+    mining_cv_.notify_all();
+    if (mining_thread_.joinable()) {
+        mining_thread_.join();
+    }
 }
 
 void Node::connectToPeer(const std::string& ip, int port) {
-    auto client = std::make_shared<Client>(ioContext_);
-    
-    client->set_message_handler([this](const Message& msg, std::shared_ptr<Peer> peer) {
-        if (metrics_) metrics_->incPacketsReceived(message_type_to_string(msg.type));
-        handleMessage(msg, peer);
+    // Менеджер подключений живёт в io-потоке; дубликаты и лимиты отсекаются там
+    boost::asio::post(ioContext_, [this, ip, port]() {
+        addrman_->add(ip, port, ip);
+        connections_->connect(ip, port);
     });
-    
-    client->set_connection_handler([this, client](bool connected) {
-        if (connected) {
-            clients_.push_back(client);
-            auto handshake = Message::create_handshake(nodeId_, p2pPort_);
-            client->send(handshake);
-            if (metrics_) metrics_->incPacketsSent("HANDSHAKE");
-            syncWithPeer(client->get_peer());
-            updateMetrics();
+}
+
+// Убираем закрытые соединения и освобождаем их слоты
+void Node::pruneConnections() {
+    size_t before = clients_.size();
+    clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [this](const std::shared_ptr<Client>& client) {
+        auto peer = client->get_peer();
+        if (peer && peer->is_connected()) return false;
+        if (peer) {
+            dropPeerMetrics(peer);
+            reconciler_->peer_disconnected(peer);
         }
+        if (peer && peer->inbound) {
+            connections_->inbound_closed();
+            server_->remove_peer(peer);
+        } else if (peer) {
+            addrman_->update_score(peer->address, peer->port, peer->score.value());
+            connections_->connection_closed(peer->address, peer->port);
+        }
+        return true;
+    }), clients_.end());
+    if (clients_.size() != before) {
+        updateMetrics();
+    }
+}
+
+// Добираем исходящие подключения из адресной книги до лимита
+void Node::fillOutboundSlots() {
+    if (replay_) return;
+    if (connections_->outbound_count() >= ConnectionManager::MAX_OUTBOUND) return;
+    size_t wanted = ConnectionManager::MAX_OUTBOUND - connections_->outbound_count();
+    auto picks = addrman_->select(wanted, [this](const std::string& ip, int port) {
+        return port == p2pPort_ || connections_->is_known_endpoint(ip, port);
     });
-    
-    client->connect(ip, port, nodeId_);
+    for (const auto& [ip, port] : picks) {
+        connections_->connect(ip, port);
+    }
+}
+
+void Node::loadAddressBook() {
+    auto records = blockchain_->getDB()->loadAddressBook(
+        AddressManager::NEW_BUCKET_COUNT * AddressManager::BUCKET_SIZE);
+    for (const auto& r : records) {
+        AddressManager::Entry entry;
+        entry.ip = r.ip;
+        entry.port = r.port;
+        entry.source_group = r.source_group.empty() ? network_group(r.ip) : r.source_group;
+        entry.tried = r.tried;
+        entry.score = r.score;
+        entry.last_seen = r.last_seen;
+        entry.last_success = r.last_success;
+        entry.failures = r.failed_attempts;
+        addrman_->load(entry);
+    }
+    LOG_INFO(NET, "Loaded address book").kv("addresses", addrman_->size()).kv("tried", addrman_->tried_count());
+
+    // Если нет ни одного сохранённого пира, используем seed-узлы (пример)
+    if (addrman_->size() == 0) {
+        LOG_INFO(NET, "No saved peers, using seed nodes");
+        // В реальной сети это должны быть известные стабильные узлы.
+        std::vector<std::pair<std::string, int>> seeds = {
+            {"139.100.207.199", 8000},
+            {"139.100.207.83", 8001},
+            {"139.100.207.102", 8002}
+        };
+        for (const auto& [ip, port] : seeds) {
+            addrman_->add(ip, port, "seed");
+        }
+    }
+}
+
+void Node::saveAddressBook() {
+    // Свежие оценки подключённых пиров попадают в книгу перед сохранением
+    for (const auto& peer : connectedPeers()) {
+        if (!peer->inbound) addrman_->update_score(peer->address, peer->port, peer->score.value());
+    }
+    std::vector<PeerAddressRecord> records;
+    for (const auto& entry : addrman_->entries()) {
+        PeerAddressRecord r;
+        r.ip = entry.ip;
+        r.port = entry.port;
+        r.source_group = entry.source_group;
+        r.tried = entry.tried;
+        r.score = entry.score;
+        r.last_success = entry.last_success;
+        records.push_back(r);
+    }
+    blockchain_->getDB()->saveAddressBook(records);
+}
+
+Message Node::makeHandshake() const {
+    auto handshake = Message::create_handshake(nodeId_, p2pPort_);
+    handshake.payload["pruned_height"] = blockchain_->getPrunedHeight();
+    return handshake;
+}
+
+// Источник синхронизации — готовый пир с лучшей оценкой; пиры, у которых
+// нет тел сразу над нашей вершиной, — только если других нет
+std::shared_ptr<Peer> Node::bestSyncPeer() const {
+    std::shared_ptr<Peer> best;
+    int height = blockchain_->getHeight();
+    for (const auto& peer : connectedPeers()) {
+        if (!peer->is_ready()) continue;
+        if (best) {
+            bool serves = peer->pruned_height <= height;
+            bool bestServes = best->pruned_height <= height;
+            if (serves != bestServes) {
+                if (!serves) continue;
+            } else if (peer->score.value() <= best->score.value()) {
+                continue;
+            }
+        }
+        best = peer;
+    }
+    return best;
+}
+
+// Освобождаем входящий слот за счёт худшего входящего пира
+bool Node::evictInboundPeer() {
+    std::vector<std::shared_ptr<Peer>> inbound;
+    for (const auto& peer : connectedPeers()) {
+        if (peer->inbound) inbound.push_back(peer);
+    }
+    auto victim = select_eviction_candidate(inbound, time(nullptr));
+    if (!victim) return false;
+
+    LOG_INFO(NET, "Evicting inbound peer").kv("peer", victim->get_endpoint()).kv("score", victim->score.value());
+    victim->disconnect();
+    dropPeerMetrics(victim);
+    reconciler_->peer_disconnected(victim);
+    clients_.erase(std::remove_if(clients_.begin(), clients_.end(), [&victim](const std::shared_ptr<Client>& c) {
+        return c->get_peer() == victim;
+    }), clients_.end());
+    server_->remove_peer(victim);
+    connections_->inbound_closed();
+    return true;
+}
+
+void Node::exportPeerMetrics() {
+    if (!metrics_) return;
+    for (const auto& peer : connectedPeers()) {
+        metrics_->updatePeerStats(peer->get_endpoint(), peer->stats);
+    }
+}
+
+void Node::dropPeerMetrics(const std::shared_ptr<Peer>& peer) {
+    if (metrics_) metrics_->removePeer(peer->get_endpoint());
+}
+
+// Состояние пиров и снимка для GET /peers; вызывается из io-потока
+nlohmann::json Node::peersJson() const {
+    nlohmann::json arr = nlohmann::json::array();
+    time_t now = time(nullptr);
+    for (const auto& peer : connectedPeers()) {
+        nlohmann::json p = peer->stats.to_json();
+        p["endpoint"] = peer->get_endpoint();
+        p["node_id"] = peer->id;
+        p["inbound"] = peer->inbound;
+        p["ready"] = peer->is_ready();
+        p["connected_seconds"] = peer->score.connected_at > 0 ? now - peer->score.connected_at : 0;
+        p["score"] = peer->score.value();
+        arr.push_back(p);
+    }
+    // Снимок, не сошедшийся с историей, выключает приём транзакций и майнинг
+    const SnapshotBase& base = blockchain_->getSnapshotBase();
+    nlohmann::json snapshot = {{"height", base.height}, {"verified", base.verified},
+                               {"history_mismatch", base.historyMismatch},
+                               {"history_check_height", blockchain_->historyCheckHeight()}};
+    return {{"peers", std::move(arr)}, {"snapshot", std::move(snapshot)}};
+}
+
+// Подписанный клиентом запрос несёт public_key, signature, timestamp и nonce
+// (все входят в подписанную запись); со старых адресов можно без них.
+// Суммы — десятичные строки ("0.001"); числа принимаются от старых клиентов
+Transaction Node::transactionFromRequest(const nlohmann::json& request) {
+    Transaction tx;
+    tx.fromAddress = request.value("from", "unknown");
+    tx.toAddress = request.value("to", "unknown");
+    tx.amount = request.contains("amount") ? amountFromJson(request.at("amount")) : 0;
+    tx.fee = request.contains("fee") ? amountFromJson(request.at("fee")) : DEFAULT_FEE;
+    tx.timestamp = request.value("timestamp", static_cast<long>(time(nullptr)));
+    tx.nonce = request.value("nonce", 0ULL);
+    tx.data = request.value("data", "");
+    tx.txHash = tx.calculateHash();
+    tx.signature = request.value("signature", "http_sig");
+    tx.publicKey = request.value("public_key", "");
+    return tx;
+}
+
+nlohmann::json Node::submitTransaction(const nlohmann::json& request) {
+    Transaction tx = transactionFromRequest(request);
+    if (blockchain_->historyMismatch()) {
+        return {{"status", "REJECTED"}, {"tx_hash", tx.txHash}, {"error", "state doesn't match history"}};
+    }
+    // Клиент, ведущий свой счётчик, передаёт nonce сам; иначе берём следующий
+    // из БД — такую транзакцию с адреса ключа подпись уже не покроет
+    if (!request.contains("nonce")) {
+        tx.nonce = blockchain_->getDB()->getNextNonce(tx.fromAddress);
+        tx.txHash = tx.calculateHash();
+    }
+
+    if (!blockchain_->addTransaction(tx)) {
+        return {{"status", "REJECTED"}, {"tx_hash", tx.txHash}};
+    }
+    broadcastTransaction(tx);
+    LOG_DEBUG(HTTP, "HTTP transaction added")
+        .kv("from", tx.fromAddress).kv("to", tx.toAddress).kv("amount", formatAmount(tx.amount));
+    return {{"status", "OK"}, {"tx_hash", tx.txHash}};
+}
+
+nlohmann::json Node::txStatusJson(const std::string& txHash) {
+    nlohmann::json status = {{"tx_hash", txHash}};
+    if (blockchain_->getMempoolTransaction(txHash)) {
+        status["status"] = "mempool";
+        return status;
+    }
+    auto tx = blockchain_->getDB()->getTransactionByHash(txHash);
+    if (!tx) {
+        status["status"] = "unknown";
+        return status;
+    }
+    status["status"] = tx->status;
+    int height = blockchain_->getDB()->getTransactionHeight(txHash);
+    if (height >= 0) status["block_height"] = height;
+    return status;
+}
+
+nlohmann::json Node::addressHistoryJson(const std::string& address, const std::string& cursor, int limit) {
+    AddressHistoryPage page;
+    if (!blockchain_->getDB()->getAddressHistory(address, cursor, limit, page)) return nullptr;
+    nlohmann::json txs = nlohmann::json::array();
+    for (const auto& entry : page.entries) {
+        nlohmann::json tx = entry.tx.toJsonObject();
+        tx["block_height"] = entry.height;
+        tx["tx_index"] = entry.txIndex;
+        txs.push_back(std::move(tx));
+    }
+    nlohmann::json result = {{"address", address}, {"transactions", std::move(txs)}};
+    result["next_cursor"] = page.nextCursor.empty() ? nlohmann::json(nullptr) : nlohmann::json(page.nextCursor);
+    return result;
 }
 
 void Node::handleMessage(const Message& msg, std::shared_ptr<Peer> peer) {
+    // Тип сообщения захватывается в наблюдатель: гистограмма выбирается по индексу, без строк
+    ScopedTimer::Observer observe_handling;
+    if (metrics_) {
+        observe_handling = [this, type = msg.type](double seconds) {
+            metrics_->observeMessageHandling(type, seconds);
+        };
+    }
+    ScopedTimer timer(observe_handling);
+    std::string type_name = message_type_to_string(msg.type);
 
     // Обновляем время последнего контакта с пиром в БД
     if (peer) {
         blockchain_->getDB()->updatePeerSeen(peer->address, peer->port);
     }
 
-    std::cout << "Received " << message_type_to_string(msg.type) << " from " << peer->get_endpoint() << std::endl;
+    LOG_TRACE(NET, "Received").kv("type", type_name).kv("peer", peer->get_endpoint());
     
     switch (msg.type) {
         case MessageType::HANDSHAKE: {
@@ -224,20 +601,37 @@ void Node::handleMessage(const Message& msg, std::shared_ptr<Peer> peer) {
             if (msg.payload.contains("port")) {
                 peer->p2p_port = msg.payload["port"].get<int>();
             }
+            // Старые узлы поле не шлют: у них все тела
+            peer->pruned_height = std::max(0, msg.payload.value("pruned_height", 0));
             peer->state = PeerState::READY;
-            std::cout << "Handshake with " << peer->id 
-                    << " (p2p_port=" << peer->p2p_port << ")" << std::endl;
+            LOG_INFO(NET, "Handshake").kv("node", peer->id).kv("p2p_port", peer->p2p_port)
+                .kv("pruned_height", peer->pruned_height);
             // Отправляем ему список наших пиров
             broadcastPeersToAll();
-            // Синхронизируем блокчейн
-            syncWithPeer(peer);
+            // Синхронизируем блокчейн; при быстром старте сначала нужен снимок
+            if (snapshotSync_->active()) {
+                snapshotSync_->peerReady(peer);
+            } else {
+                // Обрезавший историю пир не отдаст блоки ниже своей границы
+                syncWithPeer(peer->pruned_height <= blockchain_->getHeight() ? peer : bestSyncPeer());
+            }
+            // И mempool: после переподключения он мог разойтись с пиром
+            reconciler_->start(peer);
             updateMetrics();
             break;
         }
         
         case MessageType::PING: {
-            peer->send(Message::create_pong(nodeId_).serialize());
-            if (metrics_) metrics_->incPacketsSent("PONG");
+            // Старые узлы шлют PING без nonce, им и отвечаем без него
+            peer->send(Message::create_pong(nodeId_, msg.payload.value("nonce", uint64_t(0))));
+            if (metrics_) metrics_->incPacketsSent(MessageType::PONG);
+            break;
+        }
+
+        case MessageType::PONG: {
+            if (auto rtt = peer->stats.pong_received(msg.payload.value("nonce", uint64_t(0)))) {
+                peer->score.record_latency(*rtt);
+            }
             break;
         }
         
@@ -252,24 +646,56 @@ void Node::handleMessage(const Message& msg, std::shared_ptr<Peer> peer) {
                     std::string ip = p.value("ip", "");
                     int port = p.value("port", 0);
                     if (!ip.empty() && port > 0 && port != p2pPort_) {
-                        // Сохраняем в БД
+                        // Бакет адреса зависит от того, кто его прислал
+                        addrman_->add(ip, port, peer->address);
                         blockchain_->getDB()->addPeer(ip, port, "");
-                        // Подключаемся, если ещё не подключены
-                        connectToPeer(ip, port);
                     }
                 }
+                fillOutboundSlots();
             }
             break;
         }
         
         case MessageType::GET_BLOCKS: {
+            // Тела анонсированных блоков запрашиваются по хэшам
+            if (msg.payload.contains("hashes") && msg.payload["hashes"].is_array()) {
+                nlohmann::json jsonBlocks = nlohmann::json::array();
+                for (const auto& h : msg.payload["hashes"]) {
+                    if (jsonBlocks.size() >= MAX_BLOCKS_BY_HASH || !h.is_string()) break;
+                    if (auto block = blockchain_->getBlockByHash(h.get<std::string>())) {
+                        jsonBlocks.push_back(block->toJson());
+                    }
+                }
+                if (jsonBlocks.empty()) break;
+                Message response(MessageType::BLOCKS_RESPONSE);
+                response.sender_id = nodeId_;
+                response.payload = std::move(jsonBlocks);
+                peer->send(response);
+                break;
+            }
+
             int from = msg.payload.value("from_height", 0);
             int current_height = blockchain_->getHeight();
-            std::cout << "[DEBUG] GET_BLOCKS: from=" << from << ", my height=" << current_height << std::endl;
+            // Локатор точнее высоты: ответ начинается сразу после общего
+            // предка, поэтому общие блоки не пересылаются, а разошедшаяся
+            // ниже вершины ветка приходит целиком
+            if (msg.payload.contains("locator") && msg.payload["locator"].is_array()) {
+                std::vector<std::string> locator;
+                for (const auto& h : msg.payload["locator"]) {
+                    if (locator.size() >= MAX_LOCATOR_SIZE || !h.is_string()) break;
+                    locator.push_back(h.get<std::string>());
+                }
+                int fork = blockchain_->findLocatorFork(locator);
+                if (fork >= 0) from = fork + 1;
+            }
+            int to = std::min(current_height, msg.payload.value("to_height", current_height));
+            // Тел блоков под загруженным снимком и обрезанных у нас нет
+            if (from > 0 && from <= blockchain_->getPrunedHeight()) break;
+            LOG_DEBUG(NET, "GET_BLOCKS").kv("from", from).kv("to", to).kv("height", current_height);
             
-            // Отправляем все блоки от запрошенной высоты
+            // Отправляем блоки от запрошенной высоты
             std::vector<Block> blocks;
-            for (int h = from; h <= current_height; ++h) {
+            for (int h = from; h <= to; ++h) {
                 auto block = blockchain_->getBlock(h);
                 if (block) blocks.push_back(*block);
             }
@@ -284,119 +710,180 @@ void Node::handleMessage(const Message& msg, std::shared_ptr<Peer> peer) {
                 response.type = MessageType::BLOCKS_RESPONSE;
                 response.sender_id = nodeId_;
                 response.payload = jsonBlocks;
-                peer->send(response.serialize());
-                std::cout << "Sent " << blocks.size() << " blocks (heights " << from << "-" << current_height << ")" << std::endl;
+                peer->send(response);
+                LOG_DEBUG(NET, "Sent blocks").kv("count", blocks.size()).kv("from", from).kv("to", to);
             }
             break;
         }
         
         case MessageType::BLOCKS_RESPONSE: {
-            if (msg.payload.is_array()) {
-                std::cout << "Received " << msg.payload.size() << " blocks" << std::endl;
-                int added = 0;
+            peer->score.blocks_received();
+            // Пока грузится снимок, цепочка не растёт: его можно положить только на генезис
+            if (msg.payload.is_array() && !snapshotSync_->active()) {
+                LOG_DEBUG(NET, "Received blocks").kv("count", msg.payload.size());
+                nlohmann::json history = nlohmann::json::array();
+                nlohmann::json blocks = nlohmann::json::array();
+                int base = blockchain_->historyCheckHeight() >= 0 ? blockchain_->getSnapshotBase().height : -1;
                 for (const auto& bj : msg.payload) {
-                    Block block;
-                    block.height = bj.value("height", 0);
-                    block.hash = bj.value("hash", "");
-                    block.prevHash = bj.value("prevHash", "");
-                    block.merkleRoot = bj.value("merkleRoot", "");
-                    block.timestamp = bj.value("timestamp", 0L);
-                    block.nonce = bj.value("nonce", 0);
-                    block.difficulty = bj.value("difficulty", 2.0);
-                    block.minedBy = bj.value("minedBy", "");
-                    
-                    // ← ПРОВЕРКА: если блок уже есть, пропускаем
-                    if (block.height <= blockchain_->getHeight()) {
-                        std::cout << "Block #" << block.height << " already exists, skipping" << std::endl;
-                        continue;
-                    }
-                    
-                    std::cout << "Processing block #" << block.height << " (prev: " << block.prevHash.substr(0, 8) << "...)" << std::endl;
-
-                    if (blockchain_->addBlock(block)) {
-                        added++;
-                        std::cout << "Added block #" << block.height << std::endl;
-                    } else {
-                        std::cout << "Failed to add block #" << block.height << std::endl;
-                    }
+                    std::string hash = bj.is_object() ? bj.value("hash", "") : "";
+                    peer->known_blocks.insert(hash);
+                    blocksInFlight_.erase(hash);
+                    int height = bj.is_object() ? bj.value("height", -1) : -1;
+                    (height > 0 && height <= base ? history : blocks).push_back(bj);
+                }
+                if (!history.empty()) {
+                    // Блоки под снимком не подключаются, а сверяются с ним
+                    HistoryCheckResult checked = blockchain_->checkHistory(history);
+                    if (checked.finished) updateMetrics();
+                    if (checked.applied > 0) peer->score.record_served(history.dump().size());
+                    for (int i = 0; i < checked.rejected; ++i) peer->score.record_invalid();
+                    historyRequestedAt_ = {};
+                    if (!checked.finished) requestHistory();
+                    if (blocks.empty()) break;
                 }
-                if (added > 0) {
-                    updateMetrics();
-                    std::cout << "Synced " << added << " new blocks" << std::endl;
+                // Блоки разбираются и проверяются в пуле; известные пропускаются,
+                // пришедшие не по порядку ждут родителя; ветка, которая
+                // расходится с нашей ниже вершины и несёт больше работы,
+                // подключается реорганизацией
+                AcceptResult result = blockchain_->acceptBlocks(blocks);
+                if (result.accepted > 0) {
+                    peer->score.record_served(blocks.dump().size());
+                    LOG_INFO(CHAIN, "Synced new blocks")
+                        .kv("accepted", result.accepted).kv("connected", result.connected.size())
+                        .kv("disconnected", result.disconnected).kv("duplicates", result.duplicates);
+                } else if (result.rejected > 0) {
+                    LOG_WARN(CHAIN, "Failed to connect synced blocks")
+                        .kv("count", blocks.size()).kv("rejected", result.rejected);
                 }
+                handleAcceptedBlocks(result, peer);
             }
             break;
         }
         
         case MessageType::NEW_TRANSACTION: {
-            Transaction tx;
-            tx.fromAddress = msg.payload.value("from", "");
-            tx.toAddress = msg.payload.value("to", "");
-            tx.amount = msg.payload.value("amount", 0.0);
-            tx.fee = msg.payload.value("fee", 0.001);
-            tx.nonce = msg.payload.value("nonce", 1ULL);
-            tx.timestamp = time(nullptr);
-            tx.signature = msg.payload.value("signature", "p2p_sig");
-            tx.txHash = tx.calculateHash();
-
-            if (blockchain_->addTransaction(tx)) {
-                if (metrics_) metrics_->incTransactionsProcessed();
-                broadcastTransaction(tx);
-                std::cout << "New transaction: " << tx.fromAddress << " -> " << tx.toAddress 
-                        << " (" << tx.amount << ", fee=" << tx.fee << ")" << std::endl;
+            // Транзакция передаётся целиком, хэш пересчитываем по её полям
+            Transaction tx = Transaction::fromJson(msg.payload);
+            std::string claimed_hash = msg.payload.value("txHash", "");
+            if (!claimed_hash.empty() && claimed_hash != tx.txHash) {
+                LOG_DEBUG(NET, "Rejecting tx with mismatched hash")
+                    .kv("tx", claimed_hash.substr(0, 8)).kv("peer", peer->get_endpoint());
+                peer->score.record_invalid();
+                break;
+            }
+
+            bool already_seen = relay_->is_known(tx.txHash);
+            relay_->transaction_received(peer, tx.txHash);
+            if (already_seen) break;
+
+            // Подпись проверяется на пуле; в mempool транзакция попадает
+            // позже, в io-потоке, и addTransaction берёт итог из кэша
+            size_t bytes = msg.payload.dump().size();
+            signatureQueue_->submit(std::move(tx), [this, peer, bytes](const Transaction& tx, const std::string& error) {
+                if (!error.empty()) {
+                    if (error == SignatureQueue::OVERLOADED) {
+                        // Не проверена — позволяем запросить её снова по следующему INV
+                        relay_->transaction_dropped(tx.txHash);
+                        if (metrics_) metrics_->incTransactionsOverloaded();
+                        return;
+                    }
+                    LOG_DEBUG(NET, "Rejecting tx with bad signature")
+                        .kv("tx", tx.txHash.substr(0, 8)).kv("peer", peer->get_endpoint()).kv("error", error);
+                    peer->score.record_invalid();
+                    return;
+                }
+                if (blockchain_->addTransaction(tx)) {
+                    if (metrics_) metrics_->incTransactionsProcessed();
+                    peer->score.record_served(bytes);
+                    broadcastTransaction(tx, peer);
+                    LOG_DEBUG(CHAIN, "New transaction")
+                        .kv("from", tx.fromAddress).kv("to", tx.toAddress).kv("amount", formatAmount(tx.amount)).kv("fee", formatAmount(tx.fee));
+                }
+            });
+            break;
+        }
+
+        case MessageType::INV: {
+            std::vector<std::string> hashes;
+            if (msg.payload.contains("hashes") && msg.payload["hashes"].is_array()) {
+                for (const auto& h : msg.payload["hashes"]) {
+                    if (h.is_string()) hashes.push_back(h.get<std::string>());
+                }
+            }
+            auto wanted = relay_->handle_inventory(peer, hashes);
+            if (!wanted.empty()) {
+                peer->send(Message::create_get_data(nodeId_, wanted));
+                if (metrics_) metrics_->incPacketsSent(MessageType::GET_DATA);
+            }
+            break;
+        }
+
+        case MessageType::GET_DATA: {
+            if (!msg.payload.contains("hashes") || !msg.payload["hashes"].is_array()) break;
+            size_t served = 0;
+            for (const auto& h : msg.payload["hashes"]) {
+                if (served >= TxRelay::MAX_INV_SIZE || !h.is_string()) break;
+                auto tx = blockchain_->getMempoolTransaction(h.get<std::string>());
+                if (!tx) continue;
+                peer->known_txs.insert(tx->txHash);
+                peer->send(Message::create_new_transaction(nodeId_, tx->toJsonObject()));
+                if (metrics_) metrics_->incPacketsSent(MessageType::NEW_TRANSACTION);
+                served++;
             }
             break;
         }
         
+        case MessageType::RECON_SKETCH: {
+            reconciler_->handle_sketch(peer, msg.payload);
+            break;
+        }
+
+        case MessageType::RECON_DIFF: {
+            reconciler_->handle_diff(peer, msg.payload);
+            break;
+        }
+
+        case MessageType::GET_SNAPSHOT: {
+            snapshotSync_->handleGetSnapshot(peer);
+            break;
+        }
+
+        case MessageType::SNAPSHOT_MANIFEST: {
+            snapshotSync_->handleManifest(peer, msg.payload);
+            break;
+        }
+
+        case MessageType::GET_SNAPSHOT_CHUNK: {
+            snapshotSync_->handleGetChunk(peer, msg.payload);
+            break;
+        }
+
+        case MessageType::SNAPSHOT_CHUNK: {
+            snapshotSync_->handleChunk(peer, msg.payload);
+            break;
+        }
+
         case MessageType::NEW_BLOCK: {
+            if (snapshotSync_->active()) break;
             Block block;
             block.fromJson(msg.payload);
-            
-            int my_height = blockchain_->getHeight();
-            auto last_block = blockchain_->getBlock(my_height);
-            
-            // 1. Блок является прямым продолжением
-            if (block.height == my_height + 1 && block.prevHash == last_block->hash) {
-                if (blockchain_->addBlock(block)) {
-                    // Останавливаем майнинг и перезапускаем
-                    mining_ = false;
-                    if (mining_thread_.joinable()) mining_thread_.join();
-                    broadcastBlock(block);
-                    mining_ = true;
-                    mining_thread_ = std::thread([this]() { mine_loop(); });
-                }
-            }
-            // 2. Блок с той же высотой, что и текущий последний (конкурирующий блок)
-            else if (block.height == my_height && block.prevHash == last_block->prevHash) {
-                // Заменяем последний блок
-                if (blockchain_->replaceLastBlock(block)) {
-                    std::cout << "Fork resolved by replacing block #" << my_height << std::endl;
-                    broadcastBlock(block);
-                    // Перезапускаем майнинг
-                    mining_ = false;
-                    if (mining_thread_.joinable()) mining_thread_.join();
-                    mining_ = true;
-                    mining_thread_ = std::thread([this]() { mine_loop(); });
-                }
+            peer->known_blocks.insert(block.hash);
+            // Уже известный блок (в том числе наш же, вернувшийся от пира)
+            // не запрашивается и не рассылается повторно
+            if (blockchain_->knowsBlock(block.hash)) {
+                LOG_DEBUG(CHAIN, "Ignoring known block").kv("height", block.height).kv("hash", block.hash.substr(0, 8));
+                break;
             }
-            // 3. Блок выше текущей цепи, но не является прямым продолжением (форк с отставанием)
-            else if (block.height > my_height + 1 || (block.height == my_height + 1 && block.prevHash != last_block->hash)) {
-                std::cout << "Potential fork detected: received block #" << block.height 
-                        << " with prevHash " << block.prevHash.substr(0,8)
-                        << ", my last block #" << my_height << " hash " << last_block->hash.substr(0,8)
-                        << ". Requesting missing blocks." << std::endl;
-                // Запрашиваем у отправителя цепочку начиная с высоты расхождения
-                // Ищем общий предок – проще всего запросить с высоты my_height+1
-                Message req;
-                req.type = MessageType::GET_BLOCKS;
-                req.sender_id = nodeId_;
-                req.payload = {{"from_height", my_height + 1}};
-                peer->send(req.serialize());
-                // Сохраняем запрошенную цепочку для последующей обработки (можно сохранить в отдельный кеш)
-                // Для упрощения будем обрабатывать при получении BLOCKS_RESPONSE
+            if (metrics_ && block.timestamp > 0) {
+                metrics_->observeBlockPropagation(std::max(0.0, difftime(time(nullptr), block.timestamp)));
             }
-            else {
-                std::cout << "Ignoring block #" << block.height << " (my height=" << my_height << ")" << std::endl;
+            // Анонс — только заголовок; блок с телом приходит от старых узлов
+            // и при воспроизведении своих блоков из захвата. Куда он встанет
+            // (вершина, более тяжёлая ветка, сирота) — решает индекс блоков
+            if (msg.payload.contains("transactions")) {
+                blocksInFlight_.erase(block.hash);
+                handleAcceptedBlocks(blockchain_->acceptBlocks({block}), peer);
+            } else {
+                requestBlock(peer, block);
             }
             break;
         }
@@ -410,36 +897,36 @@ void Node::handleMessage(const Message& msg, std::shared_ptr<Peer> peer) {
 void Node::handleConnection(std::shared_ptr<Peer> peer) {
     // Проверяем, не подключен ли уже ЭТОТ ЖЕ пир (по порту)
     for (const auto& client : clients_) {
-        if (client->get_peer()->address == peer->address && 
-            client->get_peer()->port == peer->port) {
-            std::cout << "Peer " << peer->get_endpoint() << " already connected, rejecting" << std::endl;
+        auto existing = client->get_peer();
+        if (existing && existing->address == peer->address && existing->port == peer->port) {
+            LOG_DEBUG(NET, "Peer already connected, rejecting").kv("peer", peer->get_endpoint());
             peer->disconnect();
+            server_->remove_peer(peer);
             return;
         }
     }
+
+    if (!connections_->has_inbound_slot() && !evictInboundPeer()) {
+        LOG_INFO(NET, "Inbound slots full, rejecting").kv("peer", peer->get_endpoint());
+        peer->disconnect();
+        server_->remove_peer(peer);
+        return;
+    }
+    connections_->inbound_opened();
     
     // НЕ БЛОКИРУЕМ подключения с одного IP, если порты разные!
-    std::cout << "New connection from " << peer->get_endpoint() << std::endl;
+    LOG_DEBUG(NET, "New connection").kv("peer", peer->get_endpoint());
     
+    // Чтение уже запущено сервером, здесь только регистрируем пира
     auto client = std::make_shared<Client>(ioContext_);
     client->set_peer(peer);
     clients_.push_back(client);
     
-    peer->read([this, peer](const std::string& data) {
-        try {
-            Message msg = Message::deserialize(data);
-            handleMessage(msg, peer);
-        } catch (const std::exception& e) {
-            std::cout << "Error parsing message: " << e.what() << std::endl;
-        }
-    });
-    
-    auto handshake = Message::create_handshake(nodeId_, p2pPort_);
-    peer->send(handshake.serialize());
+    peer->send(makeHandshake());
     updateMetrics();
 }
 
-void Node::syncWithPeer(std::shared_ptr<Peer> peer) {
+void Node::syncWithPeer(std::shared_ptr<Peer> peer, int toHeight) {
     if (!peer || !peer->is_connected()) return;
     
     int my_height = blockchain_->getHeight();
@@ -447,10 +934,130 @@ void Node::syncWithPeer(std::shared_ptr<Peer> peer) {
     Message req;
     req.type = MessageType::GET_BLOCKS;
     req.sender_id = nodeId_;
-    req.payload = {{"from_height", my_height + 1}};  // Запрашиваем ТОЛЬКО новые блоки
-    peer->send(req.serialize());
+    // from_height — для узлов, не понимающих локатор
+    req.payload = {{"from_height", my_height + 1}, {"locator", blockchain_->getLocator()}};
+    if (toHeight >= 0) req.payload["to_height"] = toHeight;
+    peer->score.blocks_requested();
+    peer->send(req);
     
-    std::cout << "Requesting blocks from height " << (my_height + 1) << std::endl;
+    LOG_DEBUG(NET, "Requesting blocks").kv("from", my_height + 1).kv("to", toHeight).kv("peer", peer->get_endpoint());
+}
+
+void Node::handleAcceptedBlocks(const AcceptResult& result, const std::shared_ptr<Peer>& peer) {
+    if (metrics_ && result.duplicates > 0) metrics_->incDuplicateBlocks(result.duplicates);
+    for (int i = 0; i < result.rejected; ++i) peer->score.record_invalid();
+    if (!result.connected.empty()) {
+        // Вершина сменилась: майнер бросает шаблон, пиры получают её
+        tipGeneration_.fetch_add(1);
+        broadcastBlock(result.connected.back());
+    }
+    for (const auto& [parent, height] : result.missingParents) {
+        if (isBlockInFlight(parent)) continue;
+        LOG_INFO(CHAIN, "Orphan block, requesting missing parents")
+            .kv("parent", parent.substr(0, 8)).kv("height", height).kv("my_height", blockchain_->getHeight());
+        syncWithPeer(peer, height);
+    }
+    if (metrics_) metrics_->setOrphanBlocks(static_cast<int>(blockchain_->getOrphanCount()));
+}
+
+void Node::syncFromSnapshot() {
+    if (blockchain_->getHeight() != 0) {
+        LOG_INFO(CORE, "Chain already present, snapshot sync skipped").kv("height", blockchain_->getHeight());
+        return;
+    }
+    LOG_INFO(CORE, "Waiting for a state snapshot from peers");
+    snapshotSync_->start();
+}
+
+bool Node::loadSnapshotFile(const std::string& path) {
+    if (blockchain_->getHeight() != 0) {
+        LOG_INFO(CORE, "Chain already present, snapshot file skipped").kv("height", blockchain_->getHeight());
+        return true;
+    }
+    StateSnapshot snapshot;
+    if (!readSnapshotFile(path, snapshot)) return false;
+    return blockchain_->importSnapshot(snapshot);
+}
+
+std::shared_ptr<const StateSnapshot> Node::servedSnapshot() {
+    int height = (blockchain_->getHeight() - SNAPSHOT_CONFIRMATIONS) / SNAPSHOT_INTERVAL * SNAPSHOT_INTERVAL;
+    const SnapshotBase& base = blockchain_->getSnapshotBase();
+    // Непроверенное состояние дальше не раздаём
+    if (height <= 0 || (base.height >= 0 && !base.verified)) return nullptr;
+    auto header = blockchain_->getDB()->getBlockHeader(height);
+    if (!header) return nullptr;
+    if (servedSnapshot_ && servedSnapshot_->manifest.height == height &&
+        servedSnapshot_->manifest.blockHash == header->hash) {
+        return servedSnapshot_;
+    }
+    auto snapshot = std::make_shared<StateSnapshot>();
+    if (!makeStateSnapshot(*blockchain_->getDB(), height, false, *snapshot)) return nullptr;
+    LOG_INFO(CORE, "Built state snapshot")
+        .kv("height", height).kv("accounts", snapshot->manifest.accounts).kv("chunks", snapshot->chunks.size());
+    servedSnapshot_ = std::move(snapshot);
+    return servedSnapshot_;
+}
+
+bool Node::completeSnapshotSync(const StateSnapshot* snapshot) {
+    if (snapshot && !blockchain_->importSnapshot(*snapshot)) return false;
+    tipGeneration_.fetch_add(1);
+    // Дальше — обычная синхронизация от блока снимка (или от генезиса)
+    syncWithPeer(bestSyncPeer());
+    requestHistory();
+    updateMetrics();
+    return true;
+}
+
+void Node::requestHistory() {
+    int next = blockchain_->historyCheckHeight();
+    if (next < 0 || std::chrono::steady_clock::now() - historyRequestedAt_ < HISTORY_REQUEST_TIMEOUT) return;
+    // Случайный готовый пир, не обрезавший эти высоты: узел со своим
+    // снимком тел под ним тоже не отдаёт, и после таймаута запрос уходит
+    // другому. Если все объявили обрезку — пробуем любого
+    std::vector<std::shared_ptr<Peer>> ready;
+    std::vector<std::shared_ptr<Peer>> pruned;
+    for (const auto& peer : connectedPeers()) {
+        if (!peer->is_ready()) continue;
+        (peer->pruned_height < next ? ready : pruned).push_back(peer);
+    }
+    if (ready.empty()) ready = std::move(pruned);
+    if (ready.empty()) return;
+    auto peer = ready[rng_() % ready.size()];
+    Message req(MessageType::GET_BLOCKS);
+    req.sender_id = nodeId_;
+    // Без локатора: нужны именно эти высоты, а не продолжение нашей цепочки
+    int to = std::min(next + HISTORY_BATCH - 1, blockchain_->getSnapshotBase().height);
+    req.payload = {{"from_height", next}, {"to_height", to}};
+    peer->score.blocks_requested();
+    peer->send(req);
+    historyRequestedAt_ = std::chrono::steady_clock::now();
+    LOG_DEBUG(NET, "Requesting history blocks").kv("from", next).kv("to", to).kv("peer", peer->get_endpoint());
+}
+
+bool Node::isBlockInFlight(const std::string& hash) const {
+    auto it = blocksInFlight_.find(hash);
+    return it != blocksInFlight_.end() && std::chrono::steady_clock::now() - it->second < BLOCK_REQUEST_TIMEOUT;
+}
+
+void Node::requestBlock(const std::shared_ptr<Peer>& peer, const Block& header) {
+    if (isBlockInFlight(header.hash)) return;
+    auto now = std::chrono::steady_clock::now();
+    if (blocksInFlight_.size() >= 1024) {
+        std::erase_if(blocksInFlight_, [&](const auto& item) { return now - item.second >= BLOCK_REQUEST_TIMEOUT; });
+    }
+    blocksInFlight_[header.hash] = now;
+
+    // Родитель неизвестен и никем не везётся — нужна вся ветка до блока
+    if (!blockchain_->knowsBlock(header.prevHash) && !isBlockInFlight(header.prevHash)) {
+        syncWithPeer(peer, header.height);
+        return;
+    }
+    Message req(MessageType::GET_BLOCKS);
+    req.sender_id = nodeId_;
+    // from_height — для узлов, не понимающих запрос по хэшам
+    req.payload = {{"from_height", header.height}, {"hashes", {header.hash}}};
+    peer->score.blocks_requested();
+    peer->send(req);
 }
 
 void Node::broadcastPeers() {
@@ -473,28 +1080,28 @@ void Node::broadcastPeers() {
     msg.payload = arr;
     for (auto& c : clients_) {
         c->send(msg);
-        if (metrics_) metrics_->incPacketsSent("PEERS_LIST");
+        if (metrics_) metrics_->incPacketsSent(MessageType::PEERS_LIST);
     }
 }
 
-void Node::broadcastTransaction(const Transaction& tx) {
-    Message msg;
-    msg.type = MessageType::NEW_TRANSACTION;
-    msg.sender_id = nodeId_;
-    msg.payload = {
-        {"from", tx.fromAddress},
-        {"to", tx.toAddress},
-        {"amount", tx.amount}
-    };
-    for (auto& c : clients_) {
-        c->send(msg);
-        if (metrics_) metrics_->incPacketsSent("NEW_TRANSACTION");
+void Node::broadcastTransaction(const Transaction& tx, std::shared_ptr<Peer> source) {
+    relay_->announce(tx.txHash, connectedPeers(), source);
+}
+
+std::vector<std::shared_ptr<Peer>> Node::connectedPeers() const {
+    std::vector<std::shared_ptr<Peer>> peers;
+    peers.reserve(clients_.size());
+    for (const auto& c : clients_) {
+        auto peer = c->get_peer();
+        if (peer && peer->is_connected()) peers.push_back(peer);
     }
+    return peers;
 }
 
 void Node::broadcastBlock(const Block& block) {
-    Message msg;
-    msg.type = MessageType::NEW_BLOCK;
+    // Только заголовок: тело каждый пир запросит один раз. Пирам, которые
+    // блок уже прислали или получили, не отправляем
+    Message msg(MessageType::NEW_BLOCK);
     msg.sender_id = nodeId_;
     msg.payload = {
         {"height", block.height},
@@ -506,20 +1113,25 @@ void Node::broadcastBlock(const Block& block) {
         {"difficulty", block.difficulty},
         {"minedBy", block.minedBy}
     };
-    for (auto& c : clients_) {
-        c->send(msg);
-        if (metrics_) metrics_->incPacketsSent("NEW_BLOCK");
+    std::string wire = msg.serialize();
+    for (const auto& peer : connectedPeers()) {
+        if (peer->known_blocks.contains(block.hash)) continue;
+        peer->known_blocks.insert(block.hash);
+        peer->send(MessageType::NEW_BLOCK, wire);
+        if (metrics_) metrics_->incPacketsSent(MessageType::NEW_BLOCK);
     }
 }
 
 void Node::updateMetrics() {
     if (!metrics_) return;
-    std::cout << "Updating metrics: peers=" << clients_.size() 
-              << ", height=" << blockchain_->getHeight() 
-              << ", mempool=" << blockchain_->getMempoolSize() << std::endl;
+    LOG_TRACE(METRICS, "Updating metrics")
+        .kv("peers", clients_.size()).kv("height", blockchain_->getHeight()).kv("mempool", blockchain_->getMempoolSize());
     metrics_->setPeers(clients_.size());
     metrics_->setBlockchainHeight(blockchain_->getHeight());
     metrics_->setMempoolSize(blockchain_->getMempoolSize());
+    metrics_->setHistoryMismatch(blockchain_->historyMismatch());
+    auto signatures = blockchain_->getSignatureVerifier().stats();
+    metrics_->updateSignatureStats(signatures.valid, signatures.invalid, signatures.cacheHits, signatures.cacheMisses);
 }
 
 void Node::startHttpServer() {
@@ -534,7 +1146,7 @@ void Node::startHttpServer() {
         // Создаём сокет
         server_fd = socket(AF_INET, SOCK_STREAM, 0);
         if (server_fd < 0) {
-            std::cerr << "HTTP socket creation failed" << std::endl;
+            LOG_ERROR(HTTP, "HTTP socket creation failed");
             return;
         }
         
@@ -547,84 +1159,43 @@ void Node::startHttpServer() {
         
         // Привязываем
         if (bind(server_fd, (struct sockaddr*)&address, sizeof(address)) < 0) {
-            std::cerr << "HTTP bind failed on port " << http_port << std::endl;
+            LOG_ERROR(HTTP, "HTTP bind failed").kv("port", http_port);
             close(server_fd);
             return;
         }
         
         // Начинаем слушать
-        if (listen(server_fd, 3) < 0) {
-            std::cerr << "HTTP listen failed" << std::endl;
+        // Очередь на всю глубину: запросы обслуживаются по одному, а при
+        // короткой очереди клиенты под нагрузкой ловят повторы SYN по секунде
+        if (listen(server_fd, SOMAXCONN) < 0) {
+            LOG_ERROR(HTTP, "HTTP listen failed");
             close(server_fd);
             return;
         }
         
-        std::cout << "HTTP API started on port " << http_port << " (POST /transaction)" << std::endl;
+        httpFd_ = server_fd;
+        LOG_INFO(HTTP, "HTTP API started").kv("port", http_port).kv("endpoints", "POST /transaction, GET /tx/<hash>, GET /peers");
         
         while (running_) {
             client_fd = accept(server_fd, (struct sockaddr*)&address, (socklen_t*)&addrlen);
-            if (client_fd < 0) continue;
+            if (client_fd < 0) {
+                if (!running_) break;
+                continue;
+            }
             
             // Читаем запрос
             char buffer[4096] = {0};
             int bytes_read = read(client_fd, buffer, sizeof(buffer) - 1);
-            
             if (bytes_read > 0) {
                 std::string request(buffer);
-                
-                // Проверяем POST /transaction
-                if (request.find("POST /transaction") != std::string::npos) {
-                    // Находим тело запроса (после \r\n\r\n)
-                    size_t body_pos = request.find("\r\n\r\n");
-                    if (body_pos != std::string::npos) {
-                        std::string body = request.substr(body_pos + 4);
-                        // Очистка от любых пробельных символов и символов управления
-                        body.erase(std::remove_if(body.begin(), body.end(), [](char c) {
-                            return c == '\r' || c == '\n' || c == ' ' || c == '\t';
-                        }), body.end());
-                        // Если после очистки тело пустое – ошибка
-                        if (body.empty()) {
-                            std::string response = "HTTP/1.1 400 Bad Request\r\nContent-Length: 15\r\n\r\nEmpty Body";
-                            write(client_fd, response.c_str(), response.size());
-                            close(client_fd);
-                            continue;
-                        }
-                        
-                        try {
-                            auto j = nlohmann::json::parse(body);
-                            
-                            Transaction tx;
-                            tx.fromAddress = j.value("from", "unknown");
-                            tx.toAddress = j.value("to", "unknown");
-                            tx.amount = j.value("amount", 0.0);
-                            tx.fee = 0.001;
-                            tx.timestamp = time(nullptr);
-                            // Получаем корректный nonce для отправителя
-                            tx.nonce = blockchain_->getDB()->getNextNonce(tx.fromAddress);
-                            tx.txHash = tx.calculateHash();
-                            tx.signature = "http_sig";
-                            
-                            if (blockchain_->addTransaction(tx)) {
-                                std::string response = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nOK";
-                                write(client_fd, response.c_str(), response.size());
-                                std::cout << "HTTP transaction added: " << tx.fromAddress << " -> " << tx.toAddress << " (" << tx.amount << ")" << std::endl;
-                            } else {
-                                std::string response = "HTTP/1.1 400 Bad Request\r\nContent-Length: 11\r\n\r\nInsufficient";
-                                write(client_fd, response.c_str(), response.size());
-                            }
-                        } catch (const std::exception& e) {
-                            std::string response = "HTTP/1.1 400 Bad Request\r\nContent-Length: 15\r\n\r\nInvalid JSON";
-                            write(client_fd, response.c_str(), response.size());
-                            std::cerr << "HTTP error: " << e.what() << std::endl;
-                        }
-                    } else {
-                        std::string response = "HTTP/1.1 400 Bad Request\r\nContent-Length: 15\r\n\r\nNo Body";
-                        write(client_fd, response.c_str(), response.size());
-                    }
-                } else {
-                    std::string response = "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nNot Found";
-                    write(client_fd, response.c_str(), response.size());
+                if (auto* capture = TrafficCapture::active()) {
+                    capture->record(CaptureSource::HTTP, "", request);
                 }
+                HttpResponse response = handleHttpRequest(request);
+                std::string raw = "HTTP/1.1 " + response.status + "\r\nContent-Type: " + response.content_type +
+                                  "\r\nContent-Length: " + std::to_string(response.body.size()) + "\r\n\r\n" +
+                                  response.body;
+                write(client_fd, raw.c_str(), raw.size());
             }
             close(client_fd);
         }
@@ -632,6 +1203,126 @@ void Node::startHttpServer() {
     });
 }
 
+HttpResponse Node::handleHttpRequest(const std::string& request) {
+    auto reply = [](const char* status, std::string body, const char* content_type = "text/plain") {
+        return HttpResponse{status, std::move(body), content_type};
+    };
+
+    // Проверяем POST /transaction
+    if (request.find("POST /transaction") != std::string::npos) {
+        // Находим тело запроса (после \r\n\r\n)
+        size_t body_pos = request.find("\r\n\r\n");
+        if (body_pos == std::string::npos) {
+            return reply("400 Bad Request", "No Body");
+        }
+        std::string body = request.substr(body_pos + 4);
+        // Очистка от любых пробельных символов и символов управления
+        body.erase(std::remove_if(body.begin(), body.end(), [](char c) {
+            return c == '\r' || c == '\n' || c == ' ' || c == '\t';
+        }), body.end());
+        // Если после очистки тело пустое – ошибка
+        if (body.empty()) {
+            return reply("400 Bad Request", "Empty Body");
+        }
+
+        try {
+            auto j = nlohmann::json::parse(body);
+            // Подпись проверяется в HTTP-потоке: io-поток получит итог из кэша
+            Transaction tx = transactionFromRequest(j);
+            std::string signature_error = blockchain_->getSignatureVerifier().check(tx);
+            if (!signature_error.empty()) {
+                nlohmann::json rejected = {{"status", "REJECTED"}, {"tx_hash", tx.txHash}, {"error", signature_error}};
+                return reply("400 Bad Request", rejected.dump(), "application/json");
+            }
+            auto result = callOnIo<nlohmann::json>([this, j]() { return submitTransaction(j); },
+                                                   std::chrono::seconds(2));
+            if (!result) {
+                return reply("503 Service Unavailable", "Busy");
+            }
+            if ((*result)["status"] == "OK") {
+                return reply("200 OK", result->dump(), "application/json");
+            }
+            return reply("400 Bad Request", result->dump(), "application/json");
+        } catch (const std::exception& e) {
+            LOG_WARN(HTTP, "HTTP error").kv("error", e.what());
+            return reply("400 Bad Request", "Invalid JSON");
+        }
+    }
+
+    if (request.find("GET /tx/") == 0) {
+        size_t end = request.find_first_of(" ?\r\n", 8);
+        std::string hash = request.substr(8, end == std::string::npos ? std::string::npos : end - 8);
+        auto status = callOnIo<nlohmann::json>([this, hash]() { return txStatusJson(hash); },
+                                               std::chrono::seconds(2));
+        if (!status) {
+            return reply("503 Service Unavailable", "Busy");
+        }
+        return reply((*status)["status"] == "unknown" ? "404 Not Found" : "200 OK",
+                     status->dump(), "application/json");
+    }
+
+    // GET /address/<адрес>/history?limit=50&cursor=<next_cursor предыдущей страницы>
+    if (request.find("GET /address/") == 0) {
+        const std::string PREFIX = "/address/";
+        const std::string SUFFIX = "/history";
+        const int DEFAULT_LIMIT = 50;
+        const int MAX_LIMIT = 500;
+        std::string target = request.substr(4, request.find_first_of(" \r\n", 4) - 4);
+        std::string path = target.substr(0, target.find('?'));
+        std::string query = path.size() < target.size() ? target.substr(path.size() + 1) : "";
+        if (path.size() <= PREFIX.size() + SUFFIX.size() ||
+            path.compare(path.size() - SUFFIX.size(), SUFFIX.size(), SUFFIX) != 0) {
+            return reply("404 Not Found", "Not Found");
+        }
+        std::string address = path.substr(PREFIX.size(), path.size() - PREFIX.size() - SUFFIX.size());
+
+        std::string cursor;
+        int limit = DEFAULT_LIMIT;
+        std::stringstream params(query);
+        std::string param;
+        while (std::getline(params, param, '&')) {
+            size_t eq = param.find('=');
+            if (eq == std::string::npos) continue;
+            std::string key = param.substr(0, eq);
+            std::string value = param.substr(eq + 1);
+            if (key == "cursor") {
+                cursor = value;
+            } else if (key == "limit") {
+                try {
+                    limit = std::stoi(value);
+                } catch (const std::exception&) {
+                    return reply("400 Bad Request", "Invalid limit");
+                }
+            }
+        }
+        if (limit <= 0) return reply("400 Bad Request", "Invalid limit");
+        limit = std::min(limit, MAX_LIMIT);
+
+        auto page = callOnIo<nlohmann::json>(
+            [this, address, cursor, limit]() { return addressHistoryJson(address, cursor, limit); },
+            std::chrono::seconds(2));
+        if (!page) {
+            return reply("503 Service Unavailable", "Busy");
+        }
+        if (page->is_null()) {
+            return reply("400 Bad Request", "Invalid cursor");
+        }
+        return reply("200 OK", page->dump(), "application/json");
+    }
+
+    if (request.find("GET /peers") == 0) {
+        // Пиры живут в io-потоке: снимок берём там и ждём с таймаутом
+        auto snapshot = callOnIo<std::string>([this]() { return peersJson().dump(); },
+                                              std::chrono::seconds(2));
+        if (snapshot) {
+            return reply("200 OK", *snapshot, "application/json");
+        }
+        return reply("503 Service Unavailable", "Busy");
+    }
+
+    return reply("404 Not Found", "Not Found");
+}
+
 void Node::broadcastPeersToAll() {
     if (clients_.empty()) return;
     nlohmann::json arr = nlohmann::json::array();
@@ -653,9 +1344,9 @@ void Node::broadcastPeersToAll() {
     msg.payload = arr;
     for (auto& c : clients_) {
         c->send(msg);
-        if (metrics_) metrics_->incPacketsSent("PEERS_LIST");
+        if (metrics_) metrics_->incPacketsSent(MessageType::PEERS_LIST);
     }
-    std::cout << "Broadcasted " << arr.size() << " peers to all connections" << std::endl;
+    LOG_DEBUG(NET, "Broadcasted peer list").kv("peers", arr.size());
 }
 
 void Node::mine_loop() {
@@ -664,22 +1355,34 @@ void Node::mine_loop() {
     uint64_t hashes_done = 0;
 
     while (mining_) {
-        // Очищаем mempool от невалидных транзакций перед созданием нового блока
-        blockchain_->cleanMempool();
-        
-        std::this_thread::sleep_for(std::chrono::seconds(10));
+        {
+            std::unique_lock<std::mutex> lock(mining_mutex_);
+            mining_cv_.wait_for(lock, std::chrono::seconds(10), [this]() { return !mining_; });
+        }
         if (!mining_) break;
 
-        if (blockchain_->getMempoolSize() == 0) {
+        // Шаблон блока собирается в io-потоке: mempool меняется там же.
+        // Перед этим mempool очищается от ставших невалидными транзакций.
+        // Поколение вершины берётся там же, вместе с шаблоном
+        using Template = std::pair<Block, uint64_t>;
+        auto candidate = callOnIo<std::optional<Template>>([this]() -> std::optional<Template> {
+            // До снимка цепочка должна остаться на генезисе; на состоянии,
+            // не сошедшемся с историей, блоки не строятся
+            if (snapshotSync_->active() || blockchain_->historyMismatch()) return std::nullopt;
+            blockchain_->cleanMempool();
+            if (blockchain_->getMempoolSize() == 0) return std::nullopt;
+            return Template{blockchain_->createBlock(nodeId_), tipGeneration_.load()};
+        }, std::chrono::seconds(5));
+        if (!candidate || !*candidate) {
             continue;
         }
 
-        int target_height = blockchain_->getHeight() + 1;
-        Block new_block = blockchain_->createBlock(nodeId_);
+        Block new_block = std::move((*candidate)->first);
+        uint64_t generation = (*candidate)->second;
 
-        // Обновляем метрику сложности в Prometheus
+        // Сложность шаблона — текущая сложность цепочки
         if (metrics_) {
-            metrics_->setMiningDifficulty(blockchain_->getCurrentDifficulty());
+            metrics_->setMiningDifficulty(new_block.difficulty);
         }
 
         bool mined = false;
@@ -687,6 +1390,7 @@ void Node::mine_loop() {
             new_block.nonce = nonce;
             new_block.hash = new_block.calculateHash();
             hashes_done++;
+            if (metrics_) metrics_->incHashes();
 
             // Обновляем хэшрейт раз в 5 секунд
             auto now = steady_clock::now();
@@ -698,20 +1402,35 @@ void Node::mine_loop() {
                 last_time = now;
             }
 
-            // Если кто-то уже нашёл блок этой высоты, останавливаем майнинг
-            if (blockchain_->getHeight() >= target_height) {
-                std::cout << "Stopping mining, block #" << target_height << " already found" << std::endl;
+            // Вершина сменилась (чужой блок, реорганизация): шаблон устарел
+            if (tipGeneration_.load(std::memory_order_relaxed) != generation) {
+                LOG_DEBUG(MINING, "Stopping mining, tip changed").kv("height", new_block.height);
                 break;
             }
 
             std::string target(new_block.difficulty, '0');
             if (new_block.hash.substr(0, new_block.difficulty) == target) {
-                if (blockchain_->addBlock(new_block)) {
+                // Найденный блок отдаётся io-потоку без ожидания: майнер не
+                // держит его, а следующий шаблон встанет в очередь после него
+                boost::asio::post(ioContext_, [this, new_block]() mutable {
+                    if (!blockchain_->addBlock(new_block)) {
+                        LOG_DEBUG(MINING, "Mined block not added").kv("height", new_block.height);
+                        return;
+                    }
+                    tipGeneration_.fetch_add(1);
                     broadcastBlock(new_block);
-                    std::cout << "MINED BLOCK #" << new_block.height << "!" << std::endl;
-                    mined = true;
+                    // Свой блок не приходит по сети, но без него воспроизведение
+                    // захвата не восстановит цепочку: пишем его целиком
+                    if (auto* capture = TrafficCapture::active()) {
+                        Message msg(MessageType::NEW_BLOCK);
+                        msg.sender_id = nodeId_;
+                        msg.payload = new_block.toJson();
+                        capture->record(CaptureSource::LOCAL_BLOCK, nodeId_, msg.serialize());
+                    }
+                    LOG_INFO(MINING, "Mined block").kv("height", new_block.height).kv("hash", new_block.hash.substr(0, 8));
                     if (metrics_) metrics_->incBlocksMined();
-                }
+                });
+                mined = true;
                 break;
             }
         }
@@ -721,51 +1440,29 @@ void Node::mine_loop() {
 }
 
 void Node::gossipPeers() {
-    while (running_) {
-        std::this_thread::sleep_for(std::chrono::seconds(30));
-        if (!running_) break;
-
-        if (clients_.size() < 2) continue;
-
-        int idx = rand() % clients_.size();
-        auto target = clients_[idx];
-
-        nlohmann::json peer_list = nlohmann::json::array();
-        for (const auto& client : clients_) {
-            auto peer = client->get_peer();
-            if (client != target && peer && peer->p2p_port != 0 && !peer->id.empty()) {
-                peer_list.push_back({
-                    {"ip", peer->address},
-                    {"port", peer->p2p_port}
-                });
-            }
-        }
+    if (clients_.size() < 2) return;
+
+    int idx = rand() % clients_.size();
+    auto target = clients_[idx];
 
-        if (!peer_list.empty()) {
-            Message msg;
-            msg.type = MessageType::PEERS_LIST;
-            msg.sender_id = nodeId_;
-            msg.payload = peer_list;
-            target->send(msg);
-            std::cout << "Gossip: sent " << peer_list.size()
-                      << " peers to " << target->get_peer()->get_endpoint() << std::endl;
+    nlohmann::json peer_list = nlohmann::json::array();
+    for (const auto& client : clients_) {
+        auto peer = client->get_peer();
+        if (client != target && peer && peer->p2p_port != 0 && !peer->id.empty()) {
+            peer_list.push_back({
+                {"ip", peer->address},
+                {"port", peer->p2p_port}
+            });
         }
     }
-}
-
-void Node::handleFork(const std::vector<Block>& alternative_chain) {
-    if (alternative_chain.empty()) return;
-    int current_height = blockchain_->getHeight();
-    int new_height = alternative_chain.back().height;
-    if (new_height <= current_height) return;
 
-    std::cout << "Switching to longer chain (new height: " << new_height
-              << ", current: " << current_height << ")" << std::endl;
-
-    for (const auto& block : alternative_chain) {
-        if (block.height > current_height) {
-            blockchain_->addBlock(const_cast<Block&>(block));
-        }
+    if (!peer_list.empty()) {
+        Message msg;
+        msg.type = MessageType::PEERS_LIST;
+        msg.sender_id = nodeId_;
+        msg.payload = peer_list;
+        target->send(msg);
+        LOG_DEBUG(NET, "Gossip").kv("peers", peer_list.size()).kv("target", target->get_peer()->get_endpoint());
     }
 }
 
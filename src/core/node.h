@@ -5,56 +5,200 @@
 #include <atomic>
 #include <thread>
 #include <vector>
+#include <mutex>
+#include <condition_variable>
+#include <random>
+#include <future>
+#include <optional>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
 #include <boost/asio.hpp>
 #include "../blockchain/blockchain.h"
 #include "../network/server.h"
 #include "../network/client.h"
 #include "../network/message.h"
+#include "../network/tx_relay.h"
+#include "../network/mempool_sync.h"
+#include "../network/connection_manager.h"
+#include "../network/address_manager.h"
 #include "../metrics/metrics_registry.h"
+#include "../metrics/scoped_timer.h"
+#include "scheduler.h"
+#include "thread_pool.h"
+#include "signature_queue.h"
+#include "snapshot_sync.h"
 
 namespace nexus {
 
+struct HttpResponse {
+    std::string status;          // "200 OK"
+    std::string body;
+    std::string content_type = "text/plain";
+};
+
 class Node {
 public:
-    Node(const std::string& dbPath, int p2pPort, int metricsPort, const std::string& nodeId);
+    // Тип обработанного сообщения (ERROR — не разобралось) и время от
+    // постановки в очередь io-потока до конца обработки, в секундах
+    using InjectDone = std::function<void(MessageType type, double seconds)>;
+
+    Node(const std::string& dbPath, int p2pPort, int metricsPort, const std::string& nodeId,
+         StorageBackend storage = StorageBackend::SQLITE);
     ~Node();
 
     void start();
     void stop();
     void connectToPeer(const std::string& ip, int port);
 
+    // Быстрый старт (до start()): снимок у пиров или из файла. Только для
+    // пустой базы; история под снимком догружается и проверяется в фоне
+    void syncFromSnapshot();
+    bool loadSnapshotFile(const std::string& path);
+    // Средняя задержка пакетных анонсов транзакций (trickle) пирам
+    void setTrickleInterval(std::chrono::milliseconds mean) { relay_->set_trickle_interval(mean); }
+    // Хранить тела только последних блоков (до start()); граница обрезки
+    // сообщается пирам в HANDSHAKE
+    void setPruneTarget(const PruneTarget& target) { blockchain_->setPruneTarget(target); }
+
+    // Воспроизведение захваченного трафика (tools/nexus_replay): узел без
+    // сети и майнинга, входящие сообщения и HTTP-запросы подаются вызовами
+    void startReplay();
+    void injectMessage(const std::string& source, const std::string& data, InjectDone done = {});
+    // Разбор HTTP-запроса API; вызывается из HTTP-потока или при воспроизведении
+    HttpResponse handleHttpRequest(const std::string& request);
+
 private:
+    // Сколько хэшей локатора разбирать: у честного узла их ~10 + log2(высоты)
+    static constexpr size_t MAX_LOCATOR_SIZE = 64;
+    // Сколько блоков отдавать по хэшам в одном BLOCKS_RESPONSE
+    static constexpr size_t MAX_BLOCKS_BY_HASH = 16;
+    // Тело запрошенного блока ждём у одного пира; по истечении срока его
+    // запросят у следующего, кто анонсирует блок
+    static constexpr std::chrono::seconds BLOCK_REQUEST_TIMEOUT{10};
+    // Комиссия HTTP-транзакции, если клиент её не указал: 0.001
+    static constexpr Amount DEFAULT_FEE = COIN / 1000;
+    // Снимок для пиров — на высоте, кратной интервалу, не ближе
+    // SNAPSHOT_CONFIRMATIONS к вершине: так он не уходит в реорганизацию
+    // и у соседних узлов обычно совпадает
+    static constexpr int SNAPSHOT_INTERVAL = 1000;
+    static constexpr int SNAPSHOT_CONFIRMATIONS = 100;
+    // Блоков истории под снимком в одном запросе и срок ответа на него
+    static constexpr int HISTORY_BATCH = 500;
+    static constexpr std::chrono::seconds HISTORY_REQUEST_TIMEOUT{30};
+
     void setupHandlers();
     void handleMessage(const Message& msg, std::shared_ptr<Peer> peer);
     void handleConnection(std::shared_ptr<Peer> peer);
-    void syncWithPeer(std::shared_ptr<Peer> peer);
+    // HANDSHAKE с нашей границей обрезки (pruned_height)
+    Message makeHandshake() const;
+    // GET_BLOCKS с локатором нашей цепочки; toHeight >= 0 — только до этой высоты
+    void syncWithPeer(std::shared_ptr<Peer> peer, int toHeight = -1);
+    // Разослать новую вершину, перезапустить майнинг, запросить родителей сирот
+    void handleAcceptedBlocks(const AcceptResult& result, const std::shared_ptr<Peer>& peer);
+    // Тело анонсированного блока — у анонсировавшего пира, если его ещё никто не везёт
+    void requestBlock(const std::shared_ptr<Peer>& peer, const Block& header);
+    bool isBlockInFlight(const std::string& hash) const;
+    // Снимок, который отдаётся пирам; nullptr — цепочка коротка или своя
+    // база ещё не проверена
+    std::shared_ptr<const StateSnapshot> servedSnapshot();
+    bool completeSnapshotSync(const StateSnapshot* snapshot);
+    // Следующая пачка блоков под снимком у случайного готового пира, у
+    // которого эти тела есть
+    void requestHistory();
     void broadcastPeers();
-    void broadcastTransaction(const Transaction& tx);
+    void broadcastTransaction(const Transaction& tx, std::shared_ptr<Peer> source = nullptr);
+    std::vector<std::shared_ptr<Peer>> connectedPeers() const;
     void broadcastBlock(const Block& block);
     void updateMetrics();
     void startHttpServer();
     void broadcastPeersToAll();
     void mine_loop();
+    void startMining();
+    // Только из stop(): ждёт поток майнера, а тот может ждать io-поток
+    void stopMining();
+    void scheduleBackgroundTasks();
+    void pingPeers();
+    void requestPeerLists();
+    void periodicSync();
+    void pruneConnections();
+    void fillOutboundSlots();
+    void loadAddressBook();
+    void saveAddressBook();
+    std::shared_ptr<Peer> bestSyncPeer() const;
+    bool evictInboundPeer();
+    void dropPeerMetrics(const std::shared_ptr<Peer>& peer);
+    void exportPeerMetrics();
+    nlohmann::json peersJson() const;
+    static Transaction transactionFromRequest(const nlohmann::json& request);
+    nlohmann::json submitTransaction(const nlohmann::json& request);
+    nlohmann::json txStatusJson(const std::string& txHash);
+    // Страница истории адреса; null — курсор не разобран
+    nlohmann::json addressHistoryJson(const std::string& address, const std::string& cursor, int limit);
+
+    // Состояние цепочки и пиров принадлежит io-потоку. HTTP-поток и майнер
+    // выполняют через этот вызов задачу в io-потоке и ждут результат;
+    // nullopt — io-поток не ответил за timeout (перегружен или остановлен)
+    template <typename T>
+    std::optional<T> callOnIo(std::function<T()> task, std::chrono::milliseconds timeout);
     void gossipPeers();
-    void handleFork(const std::vector<Block>& alternative_chain);
 
     std::string nodeId_;
     int p2pPort_;
     int metricsPort_;
+    // Объявлен раньше blockchain_: разрушается после него. Останавливается
+    // в деструкторе раньше io_context: очередь подписей шлёт туда итоги
+    std::unique_ptr<ThreadPool> workerPool_;
     std::unique_ptr<Blockchain> blockchain_;
+    // Подписи транзакций от пиров проверяются на workerPool_ до addTransaction
+    std::unique_ptr<SignatureQueue> signatureQueue_;
     std::unique_ptr<Server> server_;
     std::unique_ptr<MetricsRegistry> metrics_;
+    std::unique_ptr<TxRelay> relay_;
+    std::unique_ptr<MempoolReconciler> reconciler_;
+    std::unique_ptr<SnapshotSync> snapshotSync_;
+    std::shared_ptr<const StateSnapshot> servedSnapshot_;
     std::vector<std::shared_ptr<Client>> clients_;
     std::atomic<bool> running_{false};
+    bool replay_{false};
+    std::unordered_map<std::string, std::shared_ptr<Peer>> replayPeers_;  // Источник захвата -> пир-заглушка
     std::atomic<bool> mining_{false};
     std::thread mining_thread_;
-    std::thread mempool_cleaner_thread_;
+    std::mutex mining_mutex_;
+    std::condition_variable mining_cv_;  // Прерывает паузу майнера при остановке
+    // Меняется в io-потоке при каждой смене вершины. Майнер сравнивает его
+    // с поколением своего шаблона, не трогая цепочку из своего потока
+    std::atomic<uint64_t> tipGeneration_{0};
 
     std::vector<std::thread> background_threads_;
+    std::atomic<int> httpFd_{-1};
+    std::mt19937_64 rng_{std::random_device{}()};
+    // Запрошенные, но ещё не полученные тела блоков: хэш -> время запроса
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> blocksInFlight_;
+    std::chrono::steady_clock::time_point historyRequestedAt_{};
 
     boost::asio::io_context ioContext_;
     std::unique_ptr<boost::asio::io_context::work> work_;
     std::thread ioThread_;
+    std::unique_ptr<Scheduler> scheduler_;
+    std::unique_ptr<ConnectionManager> connections_;
+    std::unique_ptr<AddressManager> addrman_;
 };
 
+template <typename T>
+std::optional<T> Node::callOnIo(std::function<T()> task, std::chrono::milliseconds timeout) {
+    // Обещание разделяется с задачей: при таймауте она допишет результат в никуда
+    auto promise = std::make_shared<std::promise<T>>();
+    auto result = promise->get_future();
+    boost::asio::post(ioContext_, [promise, task = std::move(task)]() {
+        try {
+            promise->set_value(task());
+        } catch (...) {
+            promise->set_exception(std::current_exception());
+        }
+    });
+    if (result.wait_for(timeout) != std::future_status::ready) return std::nullopt;
+    return result.get();
+}
+
 } // namespace nexus
@@ -0,0 +1,107 @@
+// src/core/scheduler.cpp
+#include "scheduler.h"
+#include "../logging/logger.h"
+
+namespace nexus {
+
+Scheduler::Scheduler(boost::asio::io_context& io_context)
+    : io_context_(io_context) {
+}
+
+Scheduler::~Scheduler() {
+    stop();
+}
+
+Scheduler::TaskId Scheduler::schedulePeriodic(const std::string& name,
+                                              std::chrono::milliseconds interval,
+                                              std::chrono::milliseconds jitter,
+                                              Task task) {
+    return add(name, interval, jitter, true, std::move(task));
+}
+
+Scheduler::TaskId Scheduler::scheduleOnce(const std::string& name,
+                                          std::chrono::milliseconds delay,
+                                          Task task) {
+    return add(name, delay, std::chrono::milliseconds(0), false, std::move(task));
+}
+
+Scheduler::TaskId Scheduler::add(const std::string& name, std::chrono::milliseconds interval,
+                                 std::chrono::milliseconds jitter, bool periodic, Task task) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_) return 0;
+        TaskId id = next_id_++;
+        entry = std::make_shared<Entry>(io_context_, id, name, interval, jitter, periodic, std::move(task));
+        tasks_[id] = entry;
+    }
+    // Таймер трогаем только из io-потока
+    boost::asio::post(io_context_, [this, entry]() { arm(entry); });
+    return entry->id;
+}
+
+std::chrono::milliseconds Scheduler::nextDelay(const Entry& entry) {
+    if (entry.jitter.count() <= 0) return entry.interval;
+    std::uniform_int_distribution<long> dist(-entry.jitter.count(), entry.jitter.count());
+    auto delay = entry.interval.count() + dist(rng_);
+    return std::chrono::milliseconds(std::max<long>(0, delay));
+}
+
+void Scheduler::arm(std::shared_ptr<Entry> entry) {
+    if (entry->cancelled || stopped_) return;
+    entry->timer.expires_after(nextDelay(*entry));
+    entry->timer.async_wait([this, entry](const boost::system::error_code& error) {
+        if (error || entry->cancelled || stopped_) return;
+        run(entry);
+        if (entry->periodic) {
+            arm(entry);
+        } else {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.erase(entry->id);
+        }
+    });
+}
+
+void Scheduler::run(std::shared_ptr<Entry> entry) {
+    auto started = std::chrono::steady_clock::now();
+    try {
+        entry->task();
+    } catch (const std::exception& e) {
+        LOG_ERROR(CORE, "Scheduled task failed").kv("task", entry->name).kv("error", e.what());
+    }
+    if (observer_) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+        observer_(entry->name, elapsed.count());
+    }
+}
+
+void Scheduler::cancel(TaskId id) {
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = tasks_.find(id);
+        if (it == tasks_.end()) return;
+        entry = it->second;
+        tasks_.erase(it);
+    }
+    entry->cancelled = true;
+    boost::asio::post(io_context_, [entry]() { entry->timer.cancel(); });
+}
+
+void Scheduler::stop() {
+    std::unordered_map<TaskId, std::shared_ptr<Entry>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_) return;
+        stopped_ = true;
+        tasks.swap(tasks_);
+    }
+    // Флаг отмены срабатывает сразу; сами таймеры гасим в io-потоке,
+    // если он ещё работает (иначе их обработчики просто не будут вызваны)
+    for (auto& [id, entry] : tasks) {
+        entry->cancelled = true;
+        boost::asio::post(io_context_, [entry]() { entry->timer.cancel(); });
+    }
+}
+
+} // namespace nexus
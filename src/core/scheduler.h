@@ -0,0 +1,76 @@
+// src/core/scheduler.h
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <functional>
+#include <unordered_map>
+#include <boost/asio.hpp>
+
+namespace nexus {
+
+// Планировщик фоновых задач узла на boost::asio::steady_timer.
+// Задачи выполняются в io-потоке узла (последовательно с обработчиками сети),
+// поэтому не требуют собственной синхронизации с ними. Отмена мгновенная:
+// не нужно ждать окончания sleep, как у отдельных потоков.
+class Scheduler {
+public:
+    using Task = std::function<void()>;
+    using TaskId = uint64_t;
+    using DurationObserver = std::function<void(const std::string& name, double seconds)>;
+
+    explicit Scheduler(boost::asio::io_context& io_context);
+    ~Scheduler();
+
+    // Периодическая задача; каждый запуск сдвигается на случайное значение в [-jitter, +jitter]
+    TaskId schedulePeriodic(const std::string& name,
+                            std::chrono::milliseconds interval,
+                            std::chrono::milliseconds jitter,
+                            Task task);
+
+    // Однократный запуск через delay
+    TaskId scheduleOnce(const std::string& name, std::chrono::milliseconds delay, Task task);
+
+    void cancel(TaskId id);
+    void stop();
+
+    // Вызывается после каждого выполнения задачи с его длительностью
+    void setDurationObserver(DurationObserver observer) { observer_ = std::move(observer); }
+
+private:
+    struct Entry {
+        TaskId id;
+        std::string name;
+        std::chrono::milliseconds interval;
+        std::chrono::milliseconds jitter;
+        bool periodic;
+        Task task;
+        boost::asio::steady_timer timer;
+        std::atomic<bool> cancelled{false};
+
+        Entry(boost::asio::io_context& io, TaskId id_, const std::string& name_,
+              std::chrono::milliseconds interval_, std::chrono::milliseconds jitter_,
+              bool periodic_, Task task_)
+            : id(id_), name(name_), interval(interval_), jitter(jitter_),
+              periodic(periodic_), task(std::move(task_)), timer(io) {}
+    };
+
+    TaskId add(const std::string& name, std::chrono::milliseconds interval,
+               std::chrono::milliseconds jitter, bool periodic, Task task);
+    void arm(std::shared_ptr<Entry> entry);
+    void run(std::shared_ptr<Entry> entry);
+    std::chrono::milliseconds nextDelay(const Entry& entry);
+
+    boost::asio::io_context& io_context_;
+    std::mutex mutex_;
+    std::unordered_map<TaskId, std::shared_ptr<Entry>> tasks_;
+    TaskId next_id_{1};
+    std::atomic<bool> stopped_{false};
+    std::mt19937 rng_{std::random_device{}()};
+    DurationObserver observer_;
+};
+
+} // namespace nexus
@@ -0,0 +1,57 @@
+// src/core/signature_queue.cpp
+#include "signature_queue.h"
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace nexus {
+
+SignatureQueue::SignatureQueue(SignatureVerifier& verifier, ThreadPool* pool, Dispatcher dispatch)
+    : verifier_(verifier), pool_(pool), dispatch_(std::move(dispatch)) {}
+
+void SignatureQueue::submit(Transaction tx, Done done) {
+    if (!pool_ || verifier_.isVerified(tx)) {
+        done(tx, verifier_.check(tx));
+        return;
+    }
+    if (!next_) next_ = std::make_shared<Batch>();
+    if (next_->txs.size() >= MAX_PENDING) {
+        done(tx, OVERLOADED);
+        return;
+    }
+    next_->txs.push_back(std::move(tx));
+    next_->done.push_back(std::move(done));
+    if (!busy_) startBatch();
+}
+
+void SignatureQueue::startBatch() {
+    std::shared_ptr<Batch> batch = std::move(next_);
+    next_.reset();
+    if (!batch || batch->txs.empty()) return;
+    busy_ = true;
+
+    size_t count = batch->txs.size();
+    size_t chunks = (count + CHUNK - 1) / CHUNK;
+    batch->errors.resize(count);
+    batch->pendingChunks = chunks;
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        pool_->submit([this, batch, chunk, count]() {
+            size_t end = std::min(count, (chunk + 1) * CHUNK);
+            for (size_t i = chunk * CHUNK; i < end; ++i) {
+                batch->errors[i] = verifier_.check(batch->txs[i]);
+            }
+            // Последняя часть отправляет итоги пачки
+            if (batch->pendingChunks.fetch_sub(1) == 1) {
+                dispatch_([this, batch]() { finishBatch(batch); });
+            }
+        });
+    }
+}
+
+void SignatureQueue::finishBatch(const std::shared_ptr<Batch>& batch) {
+    busy_ = false;
+    for (size_t i = 0; i < batch->txs.size(); ++i) batch->done[i](batch->txs[i], batch->errors[i]);
+    // Пока пачка проверялась, накопилась следующая
+    if (!busy_ && next_) startBatch();
+}
+
+} // namespace nexus
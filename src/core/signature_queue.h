@@ -0,0 +1,56 @@
+// src/core/signature_queue.h
+#pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../blockchain/signature_verifier.h"
+
+namespace nexus {
+
+class ThreadPool;
+
+// Проверка подписей входящих транзакций вне io-потока. Транзакции копятся,
+// пока проверяется предыдущая пачка; пачка делится на части по CHUNK и
+// проверяется на потоках пула. Итоги возвращаются через dispatch (в io-поток)
+// одной задачей, в порядке поступления транзакций. Уже проверенные
+// (из кэша верификатора) в пачку не попадают и отвечают сразу.
+// submit и продолжения вызываются только из одного потока — того, куда
+// ведёт dispatch, поэтому очередь без блокировок.
+class SignatureQueue {
+public:
+    static constexpr size_t CHUNK = 32;
+    // Больше в ожидании не держим: лишние получают OVERLOADED без проверки
+    static constexpr size_t MAX_PENDING = 4096;
+    static constexpr const char* OVERLOADED = "signature queue is full";
+
+    // error пуст — подпись верна
+    using Done = std::function<void(const Transaction& tx, const std::string& error)>;
+    using Dispatcher = std::function<void(std::function<void()>)>;
+
+    // pool == nullptr — проверка сразу в submit
+    SignatureQueue(SignatureVerifier& verifier, ThreadPool* pool, Dispatcher dispatch);
+
+    void submit(Transaction tx, Done done);
+    size_t pending() const { return next_ ? next_->txs.size() : 0; }
+
+private:
+    struct Batch {
+        std::vector<Transaction> txs;
+        std::vector<Done> done;
+        std::vector<std::string> errors;
+        std::atomic<size_t> pendingChunks{0};
+    };
+
+    void startBatch();
+    void finishBatch(const std::shared_ptr<Batch>& batch);
+
+    SignatureVerifier& verifier_;
+    ThreadPool* pool_;
+    Dispatcher dispatch_;
+    std::shared_ptr<Batch> next_;     // Копится, пока пачка в работе
+    bool busy_ = false;
+};
+
+} // namespace nexus
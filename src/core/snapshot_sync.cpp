@@ -0,0 +1,258 @@
+// src/core/snapshot_sync.cpp
+#include "snapshot_sync.h"
+#include "../blockchain/block_pipeline.h"
+#include "../logging/logger.h"
+
+namespace nexus {
+
+namespace {
+
+const char* HEADERS = "headers";
+const char* ACCOUNTS = "accounts";
+
+std::string toHex(const std::string& data) {
+    static const char* HEX = "0123456789abcdef";
+    std::string out(data.size() * 2, '0');
+    for (size_t i = 0; i < data.size(); ++i) {
+        auto byte = static_cast<unsigned char>(data[i]);
+        out[2 * i] = HEX[byte >> 4];
+        out[2 * i + 1] = HEX[byte & 0xf];
+    }
+    return out;
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+bool fromHex(const std::string& hex, std::string& out) {
+    if (hex.size() % 2 != 0) return false;
+    out.resize(hex.size() / 2);
+    for (size_t i = 0; i < out.size(); ++i) {
+        int hi = hexDigit(hex[2 * i]);
+        int lo = hexDigit(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = static_cast<char>((hi << 4) | lo);
+    }
+    return true;
+}
+
+// Поля заголовка, как в анонсе NEW_BLOCK
+nlohmann::json headerJson(const Block& block) {
+    return {
+        {"height", block.height},
+        {"hash", block.hash},
+        {"prevHash", block.prevHash},
+        {"merkleRoot", block.merkleRoot},
+        {"timestamp", block.timestamp},
+        {"nonce", block.nonce},
+        {"difficulty", block.difficulty},
+        {"minedBy", block.minedBy}
+    };
+}
+
+} // namespace
+
+SnapshotSync::SnapshotSync(const std::string& nodeId, SendHandler send)
+    : nodeId_(nodeId), send_(std::move(send)) {
+}
+
+void SnapshotSync::peerReady(const std::shared_ptr<Peer>& peer) {
+    if (active_ && !source_) requestManifest(peer);
+}
+
+void SnapshotSync::requestManifest(const std::shared_ptr<Peer>& peer) {
+    Message msg(MessageType::GET_SNAPSHOT);
+    msg.sender_id = nodeId_;
+    requestedAt_ = std::chrono::steady_clock::now();
+    send_(msg, peer);
+}
+
+void SnapshotSync::tick(const std::vector<std::shared_ptr<Peer>>& peers) {
+    if (!active_ || std::chrono::steady_clock::now() - requestedAt_ < REQUEST_TIMEOUT) return;
+    if (source_) {
+        LOG_INFO(CORE, "Snapshot source timed out").kv("peer", source_->get_endpoint());
+        source_ = nullptr;
+    } else if (haveManifest_) {
+        // За целый таймаут никто не предложил тот же снимок: сеть ушла к новому
+        LOG_INFO(CORE, "Snapshot no longer offered, starting over").kv("height", received_.manifest.height);
+        reset();
+    }
+    for (const auto& peer : peers) {
+        if (peer->is_ready()) requestManifest(peer);
+    }
+}
+
+void SnapshotSync::handleManifest(const std::shared_ptr<Peer>& peer, const nlohmann::json& payload) {
+    if (!active_) return;
+    SnapshotManifest manifest;
+    if (!SnapshotManifest::fromJson(payload, manifest)) {
+        peer->score.record_invalid();
+        return;
+    }
+    if (manifest.height < 1) {
+        if (haveManifest_) return;
+        if (++emptyManifests_ >= MAX_EMPTY_MANIFESTS) {
+            LOG_INFO(CORE, "Peers offer no snapshot, syncing from genesis");
+            active_ = false;
+            if (complete_) complete_(nullptr);
+            return;
+        }
+        // Спросим снова на следующем tick: у пира снимок мог ещё не созреть
+        requestedAt_ = {};
+        return;
+    }
+    emptyManifests_ = 0;
+
+    if (haveManifest_) {
+        // Продолжаем у нового источника, только если снимок тот же
+        if (source_ || manifest.commitment != received_.manifest.commitment) return;
+        source_ = peer;
+        LOG_INFO(CORE, "Resuming snapshot download").kv("peer", peer->get_endpoint());
+        requestNext();
+        return;
+    }
+    if (snapshotCommitment(manifest) != manifest.commitment) {
+        peer->score.record_invalid();
+        return;
+    }
+    received_ = StateSnapshot{};
+    received_.manifest = std::move(manifest);
+    haveManifest_ = true;
+    source_ = peer;
+    LOG_INFO(CORE, "Downloading snapshot")
+        .kv("height", received_.manifest.height).kv("accounts", received_.manifest.accounts)
+        .kv("chunks", received_.manifest.chunkHashes.size()).kv("peer", peer->get_endpoint());
+    requestNext();
+}
+
+void SnapshotSync::requestNext() {
+    const SnapshotManifest& manifest = received_.manifest;
+    Message msg(MessageType::GET_SNAPSHOT_CHUNK);
+    msg.sender_id = nodeId_;
+    if (headersReceived() < manifest.height) {
+        msg.payload = {{"kind", HEADERS}, {"index", headersReceived() / static_cast<int>(SNAPSHOT_HEADER_CHUNK)}};
+    } else if (received_.chunks.size() < manifest.chunkHashes.size()) {
+        msg.payload = {{"kind", ACCOUNTS}, {"index", received_.chunks.size()}};
+    } else {
+        finish();
+        return;
+    }
+    if (!source_->is_connected()) {
+        // Следующий tick найдёт другого пира с тем же снимком
+        source_ = nullptr;
+        return;
+    }
+    msg.payload["commitment"] = manifest.commitment;
+    requestedAt_ = std::chrono::steady_clock::now();
+    send_(msg, source_);
+}
+
+void SnapshotSync::handleChunk(const std::shared_ptr<Peer>& peer, const nlohmann::json& payload) {
+    if (!active_ || !haveManifest_ || peer != source_ || !payload.is_object()) return;
+    const SnapshotManifest& manifest = received_.manifest;
+    if (payload.value("commitment", "") != manifest.commitment) return;
+
+    auto reject = [&](const char* reason) {
+        LOG_WARN(CORE, "Bad snapshot chunk").kv("peer", peer->get_endpoint()).kv("reason", reason);
+        peer->score.record_invalid();
+        source_ = nullptr;
+        requestedAt_ = {};
+    };
+
+    std::string kind = payload.value("kind", "");
+    int index = payload.value("index", -1);
+    if (kind == HEADERS) {
+        int first = headersReceived() + 1;
+        if (index != headersReceived() / static_cast<int>(SNAPSHOT_HEADER_CHUNK)) return;
+        if (!payload.contains(HEADERS) || !payload[HEADERS].is_array()) return reject("no headers");
+        size_t expected = std::min<size_t>(SNAPSHOT_HEADER_CHUNK, manifest.height - headersReceived());
+        if (payload[HEADERS].size() != expected) return reject("wrong header count");
+        std::vector<Block> headers;
+        for (const auto& j : payload[HEADERS]) {
+            Block header;
+            try {
+                header.headerFromJson(j);
+            } catch (const nlohmann::json::exception&) {
+                return reject("malformed header");
+            }
+            const std::string& prev = !headers.empty() ? headers.back().hash
+                                    : !received_.headers.empty() ? received_.headers.back().hash : header.prevHash;
+            if (header.height != first + static_cast<int>(headers.size()) || header.prevHash != prev ||
+                !BlockPipeline::checkHeader(header, true).empty()) {
+                return reject("invalid header");
+            }
+            headers.push_back(std::move(header));
+        }
+        received_.headers.insert(received_.headers.end(), headers.begin(), headers.end());
+    } else if (kind == ACCOUNTS) {
+        if (index != static_cast<int>(received_.chunks.size())) return;
+        std::string data;
+        if (!fromHex(payload.value("data", ""), data) || Crypto::sha256(data) != manifest.chunkHashes[index]) {
+            return reject("chunk hash mismatch");
+        }
+        received_.chunks.push_back(std::move(data));
+    } else {
+        return;
+    }
+    requestNext();
+}
+
+void SnapshotSync::finish() {
+    std::shared_ptr<Peer> source = source_;
+    if (complete_ && complete_(&received_)) {
+        active_ = false;
+        reset();
+        return;
+    }
+    LOG_WARN(CORE, "Snapshot rejected, starting over").kv("height", received_.manifest.height);
+    if (source) source->score.record_invalid();
+    reset();
+}
+
+void SnapshotSync::reset() {
+    haveManifest_ = false;
+    received_ = StateSnapshot{};
+    source_ = nullptr;
+    requestedAt_ = {};
+}
+
+void SnapshotSync::handleGetSnapshot(const std::shared_ptr<Peer>& peer) {
+    auto snapshot = snapshot_ ? snapshot_() : nullptr;
+    Message msg(MessageType::SNAPSHOT_MANIFEST);
+    msg.sender_id = nodeId_;
+    msg.payload = snapshot ? snapshot->manifest.toJson() : SnapshotManifest{}.toJson();
+    send_(msg, peer);
+}
+
+void SnapshotSync::handleGetChunk(const std::shared_ptr<Peer>& peer, const nlohmann::json& payload) {
+    auto snapshot = snapshot_ ? snapshot_() : nullptr;
+    if (!snapshot || !payload.is_object() || payload.value("commitment", "") != snapshot->manifest.commitment) return;
+    const SnapshotManifest& manifest = snapshot->manifest;
+    std::string kind = payload.value("kind", "");
+    int index = payload.value("index", -1);
+
+    Message msg(MessageType::SNAPSHOT_CHUNK);
+    msg.sender_id = nodeId_;
+    msg.payload = {{"commitment", manifest.commitment}, {"kind", kind}, {"index", index}};
+    if (kind == HEADERS && index >= 0 && index < manifest.headerChunks()) {
+        int first = index * static_cast<int>(SNAPSHOT_HEADER_CHUNK) + 1;
+        int last = std::min(manifest.height, first + static_cast<int>(SNAPSHOT_HEADER_CHUNK) - 1);
+        nlohmann::json headers = nlohmann::json::array();
+        for (int h = first; h <= last; ++h) {
+            auto header = headers_ ? headers_(h) : std::nullopt;
+            if (!header) return;
+            headers.push_back(headerJson(*header));
+        }
+        msg.payload[HEADERS] = std::move(headers);
+    } else if (kind == ACCOUNTS && index >= 0 && index < static_cast<int>(snapshot->chunks.size())) {
+        msg.payload["data"] = toHex(snapshot->chunks[index]);
+    } else {
+        return;
+    }
+    send_(msg, peer);
+}
+
+} // namespace nexus
@@ -0,0 +1,82 @@
+// src/core/snapshot_sync.h
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "../blockchain/state_snapshot.h"
+#include "../network/message.h"
+#include "../network/peer.h"
+
+namespace nexus {
+
+// Снимки состояния по P2P: раздача своего и загрузка чужого для быстрого
+// старта (NEXUS_SNAPSHOT=p2p).
+//
+// Загрузка: манифест спрашивается у каждого готового пира (GET_SNAPSHOT),
+// первый непустой становится целью, и его части — сначала заголовки, потом
+// счета — по одной запрашиваются у пира-источника (GET_SNAPSHOT_CHUNK).
+// Часть счетов сверяется с хэшем из манифеста сразу, снимок целиком
+// проверяет Blockchain::importSnapshot. Замолчавший на REQUEST_TIMEOUT
+// источник сменяется любым пиром с тем же манифестом; если снимок не
+// принят, загрузка начинается заново. После MAX_EMPTY_MANIFESTS пустых
+// ответов подряд снимка не ждём: цепочка грузится обычным порядком.
+//
+// Раздача: снимок даёт provider (Node строит его на высоте, кратной
+// интервалу), заголовки частей читаются через headers. Все методы — из io-потока.
+class SnapshotSync {
+public:
+    static constexpr std::chrono::seconds REQUEST_TIMEOUT{30};
+    static constexpr int MAX_EMPTY_MANIFESTS = 3;
+
+    using SendHandler = std::function<void(const Message&, const std::shared_ptr<Peer>&)>;
+    // Собранный снимок; false — не принят. nullptr — снимка у пиров нет
+    using CompleteHandler = std::function<bool(const StateSnapshot*)>;
+    using SnapshotProvider = std::function<std::shared_ptr<const StateSnapshot>()>;
+    using HeaderProvider = std::function<std::optional<Block>(int height)>;
+
+    SnapshotSync(const std::string& nodeId, SendHandler send);
+
+    void setCompleteHandler(CompleteHandler handler) { complete_ = std::move(handler); }
+    void setProviders(SnapshotProvider snapshot, HeaderProvider headers) {
+        snapshot_ = std::move(snapshot);
+        headers_ = std::move(headers);
+    }
+
+    // Загрузка
+    void start() { active_ = true; }
+    bool active() const { return active_; }
+    void peerReady(const std::shared_ptr<Peer>& peer);
+    // Повтор запросов по таймауту; вызывается периодически
+    void tick(const std::vector<std::shared_ptr<Peer>>& peers);
+    void handleManifest(const std::shared_ptr<Peer>& peer, const nlohmann::json& payload);
+    void handleChunk(const std::shared_ptr<Peer>& peer, const nlohmann::json& payload);
+
+    // Раздача
+    void handleGetSnapshot(const std::shared_ptr<Peer>& peer);
+    void handleGetChunk(const std::shared_ptr<Peer>& peer, const nlohmann::json& payload);
+
+private:
+    void requestManifest(const std::shared_ptr<Peer>& peer);
+    void requestNext();
+    void finish();
+    void reset();
+    int headersReceived() const { return static_cast<int>(received_.headers.size()); }
+
+    std::string nodeId_;
+    SendHandler send_;
+    CompleteHandler complete_;
+    SnapshotProvider snapshot_;
+    HeaderProvider headers_;
+
+    bool active_ = false;
+    bool haveManifest_ = false;
+    StateSnapshot received_;             // Манифест цели и полученные части
+    std::shared_ptr<Peer> source_;
+    std::chrono::steady_clock::time_point requestedAt_{};
+    int emptyManifests_ = 0;
+};
+
+} // namespace nexus
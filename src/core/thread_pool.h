@@ -0,0 +1,41 @@
+// src/core/thread_pool.h
+#pragma once
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+namespace nexus {
+
+// Пул потоков фиксированного размера для счётной работы вне io-потока
+// (проверка блоков). Задача не должна ждать другую задачу этого же пула:
+// пул не растёт, и при занятых потоках ожидание не дождётся никогда.
+// Вместо ожидания последняя из задач сама запускает продолжение.
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+
+    // threads == 0 — по числу ядер за вычетом io-потока, но не меньше одного
+    explicit ThreadPool(size_t threads = 0);
+    // Дорабатывает уже поставленные задачи и останавливает потоки
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(Task task);
+    size_t size() const { return workers_.size(); }
+
+private:
+    void run();
+
+    std::vector<std::thread> workers_;
+    std::deque<Task> queue_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_ = false;
+};
+
+} // namespace nexus
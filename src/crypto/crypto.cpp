@@ -1,3 +1,124 @@
 // src/crypto/crypto.cpp
 #include "crypto.h"
-// Всё в header
\ No newline at end of file
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr size_t ED25519_KEY_SIZE = 32;
+constexpr size_t ED25519_SIGNATURE_SIZE = 64;
+constexpr size_t ADDRESS_HEX_SIZE = 40;
+const std::string ADDRESS_PREFIX = "nx";
+
+using PKeyPtr = std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)>;
+using MdCtxPtr = std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>;
+
+std::string toHex(const unsigned char* data, size_t size) {
+    static const char* digits = "0123456789abcdef";
+    std::string out(size * 2, '0');
+    for (size_t i = 0; i < size; ++i) {
+        out[2 * i] = digits[data[i] >> 4];
+        out[2 * i + 1] = digits[data[i] & 0x0f];
+    }
+    return out;
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// false — не hex или длина не та
+bool fromHex(const std::string& hex, size_t size, std::vector<unsigned char>& out) {
+    if (hex.size() != size * 2) return false;
+    out.resize(size);
+    for (size_t i = 0; i < size; ++i) {
+        int hi = hexDigit(hex[2 * i]);
+        int lo = hexDigit(hex[2 * i + 1]);
+        if (hi < 0 || lo < 0) return false;
+        out[i] = static_cast<unsigned char>(hi << 4 | lo);
+    }
+    return true;
+}
+
+} // namespace
+
+Crypto::KeyPair Crypto::generateKeyPair() {
+    KeyPair pair;
+    EVP_PKEY* raw = nullptr;
+    EVP_PKEY_CTX* ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_ED25519, nullptr);
+    if (ctx && EVP_PKEY_keygen_init(ctx) > 0) EVP_PKEY_keygen(ctx, &raw);
+    EVP_PKEY_CTX_free(ctx);
+    PKeyPtr key(raw, EVP_PKEY_free);
+    if (!key) return pair;
+
+    unsigned char buf[ED25519_KEY_SIZE];
+    size_t size = sizeof(buf);
+    if (EVP_PKEY_get_raw_private_key(key.get(), buf, &size) > 0) pair.privateKey = toHex(buf, size);
+    size = sizeof(buf);
+    if (EVP_PKEY_get_raw_public_key(key.get(), buf, &size) > 0) pair.publicKey = toHex(buf, size);
+    return pair;
+}
+
+std::string Crypto::publicKeyFromPrivate(const std::string& privateKeyHex) {
+    std::vector<unsigned char> raw;
+    if (!fromHex(privateKeyHex, ED25519_KEY_SIZE, raw)) return "";
+    PKeyPtr key(EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, raw.data(), raw.size()), EVP_PKEY_free);
+    unsigned char buf[ED25519_KEY_SIZE];
+    size_t size = sizeof(buf);
+    if (!key || EVP_PKEY_get_raw_public_key(key.get(), buf, &size) <= 0) return "";
+    return toHex(buf, size);
+}
+
+std::string Crypto::sign(const std::string& privateKeyHex, const std::string& message) {
+    std::vector<unsigned char> raw;
+    if (!fromHex(privateKeyHex, ED25519_KEY_SIZE, raw)) return "";
+    PKeyPtr key(EVP_PKEY_new_raw_private_key(EVP_PKEY_ED25519, nullptr, raw.data(), raw.size()), EVP_PKEY_free);
+    MdCtxPtr ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    if (!key || !ctx) return "";
+
+    // Ed25519 хэширует сообщение сам: дайджест не задаётся, подпись — за один вызов
+    unsigned char signature[ED25519_SIGNATURE_SIZE];
+    size_t size = sizeof(signature);
+    if (EVP_DigestSignInit(ctx.get(), nullptr, nullptr, nullptr, key.get()) <= 0 ||
+        EVP_DigestSign(ctx.get(), signature, &size,
+                       reinterpret_cast<const unsigned char*>(message.data()), message.size()) <= 0) {
+        return "";
+    }
+    return toHex(signature, size);
+}
+
+bool Crypto::verify(const std::string& publicKeyHex, const std::string& message, const std::string& signatureHex) {
+    std::vector<unsigned char> rawKey;
+    std::vector<unsigned char> signature;
+    if (!fromHex(publicKeyHex, ED25519_KEY_SIZE, rawKey) ||
+        !fromHex(signatureHex, ED25519_SIGNATURE_SIZE, signature)) {
+        return false;
+    }
+    PKeyPtr key(EVP_PKEY_new_raw_public_key(EVP_PKEY_ED25519, nullptr, rawKey.data(), rawKey.size()), EVP_PKEY_free);
+    MdCtxPtr ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+    if (!key || !ctx) return false;
+    return EVP_DigestVerifyInit(ctx.get(), nullptr, nullptr, nullptr, key.get()) > 0 &&
+           EVP_DigestVerify(ctx.get(), signature.data(), signature.size(),
+                            reinterpret_cast<const unsigned char*>(message.data()), message.size()) == 1;
+}
+
+std::string Crypto::addressFromPublicKey(const std::string& publicKeyHex) {
+    std::vector<unsigned char> raw;
+    if (!fromHex(publicKeyHex, ED25519_KEY_SIZE, raw)) return "";
+    // Хэш от байтов ключа, а не от hex: регистр hex на адрес не влияет
+    std::string digest = sha256(std::string(raw.begin(), raw.end()));
+    return ADDRESS_PREFIX + digest.substr(0, ADDRESS_HEX_SIZE);
+}
+
+bool Crypto::isKeyAddress(const std::string& address) {
+    if (address.size() != ADDRESS_PREFIX.size() + ADDRESS_HEX_SIZE) return false;
+    if (address.compare(0, ADDRESS_PREFIX.size(), ADDRESS_PREFIX) != 0) return false;
+    for (size_t i = ADDRESS_PREFIX.size(); i < address.size(); ++i) {
+        char c = address[i];
+        if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) return false;
+    }
+    return true;
+}
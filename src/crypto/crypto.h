@@ -23,4 +23,20 @@ public:
         }
         return ss.str();
     }
-};
\ No newline at end of file
+
+    // Ed25519: ключи и подписи — hex (32 и 64 байта)
+    struct KeyPair {
+        std::string privateKey;
+        std::string publicKey;
+    };
+    static KeyPair generateKeyPair();
+    static std::string publicKeyFromPrivate(const std::string& privateKeyHex);
+    // Пустая строка — ключ не разобран
+    static std::string sign(const std::string& privateKeyHex, const std::string& message);
+    static bool verify(const std::string& publicKeyHex, const std::string& message, const std::string& signatureHex);
+
+    // Адрес ключа: "nx" и первые 20 байт sha256 от открытого ключа. Старые
+    // адреса (genesis_miner, адреса генератора нагрузки) под формат не подходят
+    static std::string addressFromPublicKey(const std::string& publicKeyHex);
+    static bool isKeyAddress(const std::string& address);
+};
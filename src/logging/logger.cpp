@@ -0,0 +1,242 @@
+// src/logging/logger.cpp
+#include "logger.h"
+#include <cctype>
+#include <cstdio>
+#include <iostream>
+#include <cstring>
+#include <ctime>
+
+namespace nexus {
+
+namespace {
+
+const char* const LEVEL_NAMES[] = {"TRACE", "DEBUG", "INFO", "WARN", "ERROR", "OFF"};
+const char* const CATEGORY_NAMES[] = {"core", "net", "chain", "storage", "mining", "metrics", "http"};
+
+bool parse_level(std::string name, LogLevel& level) {
+    for (auto& c : name) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    for (int i = 0; i <= static_cast<int>(LogLevel::OFF); ++i) {
+        if (name == LEVEL_NAMES[i]) {
+            level = static_cast<LogLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parse_category(const std::string& name, LogCategory& category) {
+    for (int i = 0; i < static_cast<int>(LogCategory::COUNT); ++i) {
+        if (name == CATEGORY_NAMES[i]) {
+            category = static_cast<LogCategory>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Метка времени с миллисекундами: 2024-01-01T12:00:00.123
+void append_timestamp(std::string& out) {
+    auto now = std::chrono::system_clock::now();
+    time_t seconds = std::chrono::system_clock::to_time_t(now);
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    std::tm tm{};
+    localtime_r(&seconds, &tm);
+    char buffer[32];
+    size_t len = std::strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%S", &tm);
+    len += std::snprintf(buffer + len, sizeof(buffer) - len, ".%03d", static_cast<int>(ms));
+    out.append(buffer, len);
+}
+
+bool needs_quotes(const std::string& value) {
+    if (value.empty()) return true;
+    for (char c : value) {
+        if (c == ' ' || c == '"' || c == '=' || c == '\n' || c == '\t') return true;
+    }
+    return false;
+}
+
+} // namespace
+
+const char* log_level_name(LogLevel level) {
+    return LEVEL_NAMES[static_cast<int>(level)];
+}
+
+const char* log_category_name(LogCategory category) {
+    return CATEGORY_NAMES[static_cast<int>(category)];
+}
+
+bool LogSite::allow(uint32_t& suppressed) {
+    int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t window = window_.load(std::memory_order_relaxed);
+    if (window != second && window_.compare_exchange_strong(window, second, std::memory_order_relaxed)) {
+        count_.store(0, std::memory_order_relaxed);
+    }
+    if (count_.fetch_add(1, std::memory_order_relaxed) >= LIMIT) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+Logger& Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger() : ring_(new Slot[RING_SIZE]) {
+    for (auto& level : levels_) level.store(static_cast<int>(LogLevel::INFO), std::memory_order_relaxed);
+    for (size_t i = 0; i < RING_SIZE; ++i) ring_[i].sequence.store(i, std::memory_order_relaxed);
+    writer_ = std::thread([this]() { writer_loop(); });
+}
+
+Logger::~Logger() {
+    running_ = false;
+    if (writer_.joinable()) writer_.join();
+}
+
+void Logger::configure(const std::string& spec) {
+    size_t start = 0;
+    while (start <= spec.size()) {
+        size_t end = spec.find(',', start);
+        if (end == std::string::npos) end = spec.size();
+        std::string item = spec.substr(start, end - start);
+        start = end + 1;
+        if (item.empty()) continue;
+
+        LogLevel level;
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            if (parse_level(item, level)) setLevel(level);
+            else std::cerr << "Unknown log level: " << item << std::endl;
+            continue;
+        }
+        LogCategory category;
+        if (!parse_category(item.substr(0, eq), category) || !parse_level(item.substr(eq + 1), level)) {
+            std::cerr << "Invalid log setting: " << item << std::endl;
+            continue;
+        }
+        setCategoryLevel(category, level);
+    }
+}
+
+void Logger::setLevel(LogLevel level) {
+    for (auto& value : levels_) value.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Logger::setCategoryLevel(LogCategory category, LogLevel level) {
+    levels_[static_cast<int>(category)].store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+// Очередь Вьюкова: позиция резервируется CAS по head_, готовность ячейки
+// публикуется через её sequence. Писатель один, tail_ двигает только он.
+void Logger::submit(std::string&& line) {
+    size_t pos = head_.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot& slot = ring_[pos & (RING_SIZE - 1)];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                slot.line = std::move(line);
+                slot.sequence.store(pos + 1, std::memory_order_release);
+                return;
+            }
+        } else if (diff < 0) {
+            // Кольцо заполнено: писатель не успевает, строку теряем
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        } else {
+            pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+bool Logger::try_pop(std::string& line) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    Slot& slot = ring_[tail & (RING_SIZE - 1)];
+    size_t seq = slot.sequence.load(std::memory_order_acquire);
+    if (seq != tail + 1) return false;
+    line.swap(slot.line);
+    slot.line.clear();
+    slot.sequence.store(tail + RING_SIZE, std::memory_order_release);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+void Logger::writer_loop() {
+    std::string line;
+    uint64_t reported_drops = 0;
+    for (;;) {
+        bool stopping = !running_.load(std::memory_order_acquire);
+        size_t batch = 0;
+        while (try_pop(line)) {
+            std::fwrite(line.data(), 1, line.size(), stdout);
+            batch++;
+        }
+
+        uint64_t drops = dropped_.load(std::memory_order_relaxed);
+        if (drops != reported_drops) {
+            std::string notice;
+            append_timestamp(notice);
+            notice += " WARN  core    Log lines dropped dropped=" + std::to_string(drops - reported_drops) + "\n";
+            std::fwrite(notice.data(), 1, notice.size(), stdout);
+            reported_drops = drops;
+            batch++;
+        }
+
+        if (batch > 0) std::fflush(stdout);
+        if (stopping) break;
+        if (batch == 0) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+void Logger::flush() {
+    // Ждём, пока писатель догонит всё, что было поставлено до вызова
+    // (не дольше секунды, чтобы зависший вывод не держал остановку узла)
+    size_t target = head_.load(std::memory_order_acquire);
+    for (int i = 0; i < 500 && tail_.load(std::memory_order_acquire) < target; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+}
+
+LogLine::LogLine(LogLevel level, LogCategory category, const char* message, uint32_t suppressed) {
+    line_.reserve(128);
+    append_timestamp(line_);
+    line_ += ' ';
+    const char* level_name = log_level_name(level);
+    line_ += level_name;
+    line_.append(6 - std::strlen(level_name), ' ');
+    const char* category_name = log_category_name(category);
+    line_ += category_name;
+    line_.append(8 - std::strlen(category_name), ' ');
+    line_ += message;
+    if (suppressed > 0) {
+        append("suppressed", std::to_string(suppressed));
+    }
+}
+
+LogLine::~LogLine() {
+    line_ += '\n';
+    Logger::instance().submit(std::move(line_));
+}
+
+void LogLine::append(const char* key, const std::string& value) {
+    line_ += ' ';
+    line_ += key;
+    line_ += '=';
+    if (!needs_quotes(value)) {
+        line_ += value;
+        return;
+    }
+    line_ += '"';
+    for (char c : value) {
+        if (c == '"' || c == '\\') line_ += '\\';
+        if (c == '\n') { line_ += "\\n"; continue; }
+        line_ += c;
+    }
+    line_ += '"';
+}
+
+} // namespace nexus
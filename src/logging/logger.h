@@ -0,0 +1,152 @@
+// src/logging/logger.h
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <memory>
+#include <cstdint>
+#include <sstream>
+
+// Уровни ниже этого вырезаются компилятором целиком (0 — TRACE ... 4 — ERROR).
+// Пример: -DNEXUS_MIN_LOG_LEVEL=2 оставляет в бинарнике только INFO и выше.
+#ifndef NEXUS_MIN_LOG_LEVEL
+#define NEXUS_MIN_LOG_LEVEL 1
+#endif
+
+namespace nexus {
+
+enum class LogLevel : int {
+    TRACE = 0,
+    DEBUG = 1,
+    INFO = 2,
+    WARN = 3,
+    ERROR = 4,
+    OFF = 5
+};
+
+enum class LogCategory : int {
+    CORE = 0,
+    NET,
+    CHAIN,
+    STORAGE,
+    MINING,
+    METRICS,
+    HTTP,
+    COUNT
+};
+
+const char* log_level_name(LogLevel level);
+const char* log_category_name(LogCategory category);
+
+// Ограничение повторов для одного места вызова: не больше LIMIT строк в секунду,
+// остальные отбрасываются, а их число дописывается к первой строке следующего окна.
+// Только relaxed-атомики: гонка на границе окна допускает пару лишних строк.
+class LogSite {
+public:
+    static constexpr uint32_t LIMIT = 20;
+
+    // true — строку писать; suppressed — сколько строк было выброшено до неё
+    bool allow(uint32_t& suppressed);
+
+private:
+    std::atomic<int64_t> window_{0};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint32_t> suppressed_{0};
+};
+
+// Асинхронный логгер: производители кладут готовые строки в ограниченное
+// lock-free кольцо (MPSC), фоновый поток пишет их пачками в stdout без
+// сброса буфера на каждой строке. При переполнении строки отбрасываются
+// и считаются — горячий путь никогда не ждёт вывода.
+class Logger {
+public:
+    static constexpr size_t RING_SIZE = 8192;  // Степень двойки
+
+    static Logger& instance();
+
+    // Уровни из строки вида "info,net=debug,storage=warn"
+    void configure(const std::string& spec);
+    void setLevel(LogLevel level);
+    void setCategoryLevel(LogCategory category, LogLevel level);
+
+    bool enabled(LogLevel level, LogCategory category) const {
+        return static_cast<int>(level) >=
+               levels_[static_cast<int>(category)].load(std::memory_order_relaxed);
+    }
+
+    void submit(std::string&& line);
+
+    // Дописать всё накопленное (вызывается при остановке узла)
+    void flush();
+
+    uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+    ~Logger();
+
+private:
+    Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+
+    struct Slot {
+        std::atomic<size_t> sequence;
+        std::string line;
+    };
+
+    bool try_pop(std::string& line);
+    void writer_loop();
+
+    std::array<std::atomic<int>, static_cast<int>(LogCategory::COUNT)> levels_;
+    std::unique_ptr<Slot[]> ring_;
+    std::atomic<size_t> head_{0};  // Следующая позиция записи (производители)
+    std::atomic<size_t> tail_{0};  // Следующая позиция чтения (пишет только писатель)
+    std::atomic<uint64_t> dropped_{0};
+    std::atomic<bool> running_{true};
+    std::thread writer_;
+};
+
+// Одна строка лога: "сообщение key=value key=value". Отправляется в деструкторе.
+class LogLine {
+public:
+    LogLine(LogLevel level, LogCategory category, const char* message, uint32_t suppressed);
+    ~LogLine();
+
+    LogLine(const LogLine&) = delete;
+    LogLine& operator=(const LogLine&) = delete;
+
+    template <typename T>
+    LogLine& kv(const char* key, const T& value) {
+        std::ostringstream os;
+        os << value;
+        append(key, os.str());
+        return *this;
+    }
+    LogLine& kv(const char* key, const std::string& value) { append(key, value); return *this; }
+    LogLine& kv(const char* key, const char* value) { append(key, value ? value : ""); return *this; }
+    LogLine& kv(const char* key, bool value) { append(key, value ? "true" : "false"); return *this; }
+
+private:
+    void append(const char* key, const std::string& value);
+
+    std::string line_;
+};
+
+} // namespace nexus
+
+// Вызов: LOG_INFO(NET, "Peer connected").kv("endpoint", ep).kv("inbound", true);
+// Аргументы .kv() не вычисляются, если уровень отключён.
+#define NEXUS_LOG(LEVEL, CATEGORY, MESSAGE)                                                   \
+    if (static_cast<int>(LEVEL) < NEXUS_MIN_LOG_LEVEL ||                                      \
+        !::nexus::Logger::instance().enabled(LEVEL, CATEGORY)) {                              \
+    } else if (uint32_t nexus_log_suppressed_ = 0;                                            \
+               ![]() -> ::nexus::LogSite& { static ::nexus::LogSite site; return site; }()     \
+                   .allow(nexus_log_suppressed_)) {                                           \
+    } else ::nexus::LogLine(LEVEL, CATEGORY, MESSAGE, nexus_log_suppressed_)
+
+#define LOG_TRACE(CATEGORY, MESSAGE) NEXUS_LOG(::nexus::LogLevel::TRACE, ::nexus::LogCategory::CATEGORY, MESSAGE)
+#define LOG_DEBUG(CATEGORY, MESSAGE) NEXUS_LOG(::nexus::LogLevel::DEBUG, ::nexus::LogCategory::CATEGORY, MESSAGE)
+#define LOG_INFO(CATEGORY, MESSAGE) NEXUS_LOG(::nexus::LogLevel::INFO, ::nexus::LogCategory::CATEGORY, MESSAGE)
+#define LOG_WARN(CATEGORY, MESSAGE) NEXUS_LOG(::nexus::LogLevel::WARN, ::nexus::LogCategory::CATEGORY, MESSAGE)
+#define LOG_ERROR(CATEGORY, MESSAGE) NEXUS_LOG(::nexus::LogLevel::ERROR, ::nexus::LogCategory::CATEGORY, MESSAGE)
@@ -1,9 +1,9 @@
 // src/main.cpp
 #include <iostream>
-#include <iomanip>
 #include <memory>
 #include <thread>
 #include <chrono>
+#include <cstdlib>
 #include <csignal>
 #include <boost/asio.hpp>
 
@@ -14,8 +14,10 @@
 #include "network/server.h"
 #include "network/client.h"
 #include "network/message.h"
+#include "network/traffic_capture.h"
 
 #include "core/node.h"
+#include "logging/logger.h"
 
 using namespace nexus;
 
@@ -28,7 +30,7 @@ void signal_handler(int /*signal*/) {
 
 void printBalance(Blockchain& chain, const std::string& name, const std::string& address) {
     std::cout << "  " << name << " (" << address << "): " 
-              << std::fixed << std::setprecision(2) << chain.getBalance(address) << std::endl;
+              << formatAmount(chain.getBalance(address)) << std::endl;
 }
 
 void testBlockchain(const std::string& dbPath) {
@@ -59,8 +61,8 @@ void testBlockchain(const std::string& dbPath) {
         Transaction tx1;
         tx1.fromAddress = "genesis_miner";
         tx1.toAddress = "alice";
-        tx1.amount = 10.0;
-        tx1.fee = 0.1;
+        tx1.amount = 10 * COIN;
+        tx1.fee = COIN / 10;
         tx1.signature = "test_sig_1";
         tx1.timestamp = time(nullptr);
         tx1.txHash = tx1.calculateHash();
@@ -110,7 +112,7 @@ void testNetwork(unsigned short port) {
         
         // Отправляем приветственное сообщение
         auto msg = nexus::Message::create_handshake("test-server", 8000);
-        peer->send(msg.serialize());
+        peer->send(msg);
     });
     
     server.set_message_handler([](const nexus::Message& msg, std::shared_ptr<nexus::Peer> peer) {
@@ -120,7 +122,7 @@ void testNetwork(unsigned short port) {
         // Отвечаем на ping
         if (msg.type == nexus::MessageType::PING) {
             auto pong = nexus::Message::create_pong("test-server");
-            peer->send(pong.serialize());
+            peer->send(pong);
             std::cout << "  ↳ Sent PONG" << std::endl;
         }
     });
@@ -179,6 +181,39 @@ void testClient(const std::string& server_ip, int server_port) {
     std::cout << "Client finished." << std::endl;
 }
 
+// Хранилище из NEXUS_STORAGE; false — имя не распознано
+bool storageFromEnv(StorageBackend& storage) {
+    storage = StorageBackend::SQLITE;
+    const char* storage_name = std::getenv("NEXUS_STORAGE");
+    if (storage_name && !parseStorageBackend(storage_name, storage)) {
+        std::cerr << "Error: unknown NEXUS_STORAGE '" << storage_name << "' (sqlite, blockfile or lsm)" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Снимок состояния базы в файл; по умолчанию — на последней высоте, кратной 1000
+int exportSnapshot(const std::string& dbPath, const std::string& outPath, int height) {
+    StorageBackend storage;
+    if (!storageFromEnv(storage)) return 1;
+    Blockchain chain(dbPath, storage);
+    if (height < 0) height = chain.getHeight() / 1000 * 1000;
+    StateSnapshot snapshot;
+    if (height <= 0 || !makeStateSnapshot(*chain.getDB(), height, true, snapshot)) {
+        std::cerr << "Error: can't build snapshot at height " << height << " (chain height "
+                  << chain.getHeight() << ")" << std::endl;
+        return 1;
+    }
+    if (!writeSnapshotFile(outPath, snapshot)) {
+        std::cerr << "Error: can't write " << outPath << std::endl;
+        return 1;
+    }
+    std::cout << "Snapshot at height " << height << ": " << snapshot.manifest.accounts << " accounts, "
+              << snapshot.chunks.size() << " chunks" << std::endl;
+    std::cout << "Commitment: " << snapshot.manifest.commitment << std::endl;
+    return 0;
+}
+
 void printUsage(const char* program_name) {
     std::cout << "Usage:" << std::endl;
     std::cout << "  " << program_name << " blockchain [db_path]          - Run blockchain test" << std::endl;
@@ -186,6 +221,16 @@ void printUsage(const char* program_name) {
     std::cout << "  " << program_name << " client <ip> <port>            - Run P2P client" << std::endl;
     std::cout << "  " << program_name << " network-test                  - Run network test" << std::endl;
     std::cout << "  " << program_name << " node <p2p_port> <db_path> <metrics_port> [connect_to] - Run P2P node" << std::endl;
+    std::cout << "  " << program_name << " snapshot <db_path> <out_file> [height] - Export account state snapshot" << std::endl;
+    std::cout << std::endl;
+    std::cout << "Environment:" << std::endl;
+    std::cout << "  NEXUS_LOG=info,net=debug,storage=warn  - Log levels: trace, debug, info, warn, error, off" << std::endl;
+    std::cout << "  NEXUS_CAPTURE=traffic.cap              - Record inbound P2P and HTTP traffic for nexus-replay" << std::endl;
+    std::cout << "  NEXUS_STORAGE=sqlite|blockfile         - Keep block bodies in SQLite (default) or in <db_path>.blocks/" << std::endl;
+    std::cout << "  NEXUS_STORAGE=lsm                      - Block files plus accounts and tx index in <db_path>.state/" << std::endl;
+    std::cout << "  NEXUS_SNAPSHOT=p2p|<file>              - Start an empty node from a peer's or a file state snapshot" << std::endl;
+    std::cout << "  NEXUS_TRICKLE_MS=100                   - Mean delay of batched transaction announcements" << std::endl;
+    std::cout << "  NEXUS_PRUNE=5000|500MB|2GB             - Keep bodies only of the latest blocks (count or size)" << std::endl;
     std::cout << std::endl;
     std::cout << "Examples:" << std::endl;
     std::cout << "  " << program_name << " blockchain" << std::endl;
@@ -194,6 +239,7 @@ void printUsage(const char* program_name) {
     std::cout << "  " << program_name << " client 127.0.0.1 8000" << std::endl;
     std::cout << "  " << program_name << " node 8000 node1.db 9100" << std::endl;
     std::cout << "  " << program_name << " node 8001 node2.db 9101 127.0.0.1:8000" << std::endl;
+    std::cout << "  " << program_name << " snapshot node1.db state.snap" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
@@ -247,7 +293,7 @@ int main(int argc, char* argv[]) {
                 std::cout << "[SERVER] Received: " << nexus::message_type_to_string(msg.type) << std::endl;
                 if (msg.type == nexus::MessageType::PING) {
                     auto pong = nexus::Message::create_pong("test-server");
-                    peer->send(pong.serialize());
+                    peer->send(pong);
                 }
             });
             
@@ -312,6 +358,25 @@ int main(int argc, char* argv[]) {
         int metrics_port = std::stoi(argv[4]);
         std::string connect_to = (argc > 5) ? argv[5] : "";
 
+        StorageBackend storage;
+        if (!storageFromEnv(storage)) return 1;
+        PruneTarget prune;
+        const char* prune_spec = std::getenv("NEXUS_PRUNE");
+        if (prune_spec && !parsePruneTarget(prune_spec, prune)) {
+            std::cerr << "Error: bad NEXUS_PRUNE '" << prune_spec << "' (block count, <N>MB or <N>GB)" << std::endl;
+            return 1;
+        }
+        int trickle_ms = 0;
+        if (const char* trickle_spec = std::getenv("NEXUS_TRICKLE_MS")) {
+            char* end = nullptr;
+            long value = std::strtol(trickle_spec, &end, 10);
+            if (end == trickle_spec || *end != '\0' || value < 1 || value > 60000) {
+                std::cerr << "Error: bad NEXUS_TRICKLE_MS '" << trickle_spec << "' (1..60000)" << std::endl;
+                return 1;
+            }
+            trickle_ms = static_cast<int>(value);
+        }
+
         std::cout << "=== Starting Nexus Node ===" << std::endl;
         std::cout << "Node ID: node_" << p2p_port << std::endl;
         std::cout << "P2P port: " << p2p_port << std::endl;
@@ -320,8 +385,38 @@ int main(int argc, char* argv[]) {
         if (!connect_to.empty()) {
             std::cout << "Connect to: " << connect_to << std::endl;
         }
+        if (prune.enabled()) {
+            std::cout << "Pruning: keep " << prune_spec << " of block bodies" << std::endl;
+        }
 
-        nexus::Node node(dbPath, p2p_port, metrics_port, "node_" + std::to_string(p2p_port));
+        // Сигналы блокируем до создания потоков узла, чтобы их получил только sigwait ниже
+        sigset_t wait_mask;
+        sigemptyset(&wait_mask);
+        sigaddset(&wait_mask, SIGINT);
+        sigaddset(&wait_mask, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &wait_mask, nullptr);
+
+        // Поток логгера стартует здесь, уже с заблокированными сигналами
+        const char* log_spec = std::getenv("NEXUS_LOG");
+        nexus::Logger::instance().configure(log_spec ? log_spec : "info");
+
+        // Захват входящего трафика для tools/nexus_replay
+        if (const char* capture_path = std::getenv("NEXUS_CAPTURE")) {
+            nexus::TrafficCapture::start(capture_path);
+        }
+
+        nexus::Node node(dbPath, p2p_port, metrics_port, "node_" + std::to_string(p2p_port), storage);
+        node.setPruneTarget(prune);
+        if (trickle_ms > 0) node.setTrickleInterval(std::chrono::milliseconds(trickle_ms));
+        if (const char* snapshot = std::getenv("NEXUS_SNAPSHOT")) {
+            if (std::string(snapshot) == "p2p") {
+                node.syncFromSnapshot();
+            } else if (!node.loadSnapshotFile(snapshot)) {
+                std::cerr << "Error: can't load snapshot " << snapshot << std::endl;
+                nexus::Logger::instance().flush();
+                return 1;
+            }
+        }
         node.start();
 
         if (!connect_to.empty()) {
@@ -336,19 +431,30 @@ int main(int argc, char* argv[]) {
         std::cout << "Node running. Press Ctrl+C to stop..." << std::endl;
 
         // Ждём сигнала завершения
-        sigset_t wait_mask;
-        sigemptyset(&wait_mask);
-        sigaddset(&wait_mask, SIGINT);
-        sigaddset(&wait_mask, SIGTERM);
         int sig;
         sigwait(&wait_mask, &sig);
 
         std::cout << "\nShutting down..." << std::endl;
         node.stop();
+        nexus::TrafficCapture::stop();
+        nexus::Logger::instance().flush();
 
         return 0;
     }
 
+    else if (command == "snapshot") {
+        if (argc < 4) {
+            std::cerr << "Error: database and output file required" << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+        const char* log_spec = std::getenv("NEXUS_LOG");
+        nexus::Logger::instance().configure(log_spec ? log_spec : "warn");
+        int code = exportSnapshot(argv[2], argv[3], argc > 4 ? std::stoi(argv[4]) : -1);
+        nexus::Logger::instance().flush();
+        return code;
+    }
+
     else {
         std::cerr << "Unknown command: " << command << std::endl;
         printUsage(argv[0]);
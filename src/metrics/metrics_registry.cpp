@@ -1,96 +1,379 @@
 // src/metrics/metrics_registry.cpp
 #include "metrics_registry.h"
-#include <iostream>
+#include "../logging/logger.h"
 
 namespace nexus {
 
+namespace {
+
+// От 50 мкс до 10 с: SQL-запросы и обработка сообщений укладываются в нижние
+// корзины, запись блока и медленные диски — в верхние
+const prometheus::Histogram::BucketBoundaries LATENCY_BUCKETS = {
+    0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01,
+    0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10
+};
+
+// timestamp блока в секундах, поэтому корзины грубее
+const prometheus::Histogram::BucketBoundaries PROPAGATION_BUCKETS = {
+    0.5, 1, 2, 5, 10, 20, 30, 60, 120, 300
+};
+
+} // namespace
+
 MetricsRegistry::MetricsRegistry(int port) {
     exposer_ = std::make_unique<prometheus::Exposer>("0.0.0.0:" + std::to_string(port));
     registry_ = std::make_shared<prometheus::Registry>();
+    hot_counters_ = std::make_shared<ShardedCounterSet>();
     
     peers_gauge_ = &prometheus::BuildGauge()
         .Name("nexus_peers_active")
         .Help("Current number of active peers")
-        .Register(*registry_);
+        .Register(*registry_).Add({});
     
     height_gauge_ = &prometheus::BuildGauge()
         .Name("nexus_blockchain_height")
         .Help("Current blockchain height")
-        .Register(*registry_);
+        .Register(*registry_).Add({});
     
     mempool_gauge_ = &prometheus::BuildGauge()
         .Name("nexus_mempool_size")
         .Help("Number of pending transactions")
-        .Register(*registry_);
+        .Register(*registry_).Add({});
     
-    packets_recv_counter_ = &prometheus::BuildCounter()
-        .Name("nexus_packets_received_total")
-        .Help("Total packets received")
-        .Register(*registry_);
+    orphan_blocks_gauge_ = &prometheus::BuildGauge()
+        .Name("nexus_orphan_blocks")
+        .Help("Blocks waiting for their parent")
+        .Register(*registry_).Add({});
+    
+    history_mismatch_gauge_ = &prometheus::BuildGauge()
+        .Name("nexus_snapshot_history_mismatch")
+        .Help("1 if the loaded state snapshot doesn't match the block history")
+        .Register(*registry_).Add({});
+    
+    duplicate_blocks_counter_ = &prometheus::BuildCounter()
+        .Name("nexus_blocks_duplicate_total")
+        .Help("Received blocks that were already known")
+        .Register(*registry_).Add({});
+
+    overloaded_txs_counter_ = &prometheus::BuildCounter()
+        .Name("nexus_transactions_overloaded_total")
+        .Help("Received transactions dropped because the signature queue was full")
+        .Register(*registry_).Add({});
     
-    packets_sent_counter_ = &prometheus::BuildCounter()
-        .Name("nexus_packets_sent_total")
-        .Help("Total packets sent")
+    auto& signatures_family = prometheus::BuildCounter()
+        .Name("nexus_signature_verifications_total")
+        .Help("Ed25519 transaction signature verifications by result")
+        .Register(*registry_);
+    signatures_valid_counter_ = &signatures_family.Add({{"result", "valid"}});
+    signatures_invalid_counter_ = &signatures_family.Add({{"result", "invalid"}});
+
+    auto& signature_cache_family = prometheus::BuildCounter()
+        .Name("nexus_signature_cache_lookups_total")
+        .Help("Verified-signature cache lookups by result")
         .Register(*registry_);
+    signature_cache_hits_counter_ = &signature_cache_family.Add({{"result", "hit"}});
+    signature_cache_misses_counter_ = &signature_cache_family.Add({{"result", "miss"}});
+
+    signature_cache_ratio_gauge_ = &prometheus::BuildGauge()
+        .Name("nexus_signature_cache_hit_ratio")
+        .Help("Share of signature checks answered by the cache since start")
+        .Register(*registry_).Add({});
+    
+    for (size_t i = 0; i < PeerStats::TYPE_SLOTS; ++i) {
+        std::string type = PeerStats::slot_name(i);
+        packets_received_[i] = &hot_counters_->add("nexus_packets_received_total", "Total packets received",
+                                                   {{"type", type}});
+    }
+    for (size_t i = 0; i < PeerStats::TYPE_SLOTS; ++i) {
+        std::string type = PeerStats::slot_name(i);
+        packets_sent_[i] = &hot_counters_->add("nexus_packets_sent_total", "Total packets sent",
+                                               {{"type", type}});
+    }
+    hashes_ = &hot_counters_->add("nexus_mining_hashes_total", "Total block hashes computed by the miner");
     
     blocks_counter_ = &prometheus::BuildCounter()
         .Name("nexus_blocks_mined_total")
         .Help("Total blocks mined")
-        .Register(*registry_);
+        .Register(*registry_).Add({});
     
     transactions_counter_ = &prometheus::BuildCounter()
         .Name("nexus_transactions_processed_total")
         .Help("Total transactions processed")
-        .Register(*registry_);
+        .Register(*registry_).Add({});
 
     hashrate_gauge_ = &prometheus::BuildGauge()
         .Name("nexus_hashrate")
         .Help("Current network hashrate (hashes per second)")
-        .Register(*registry_);
+        .Register(*registry_).Add({});
     
     difficulty_gauge_ = &prometheus::BuildGauge()
         .Name("nexus_mining_difficulty")
         .Help("Current mining difficulty")
-        .Register(*registry_);
+        .Register(*registry_).Add({});
     
+    task_last_duration_gauge_ = &prometheus::BuildGauge()
+        .Name("nexus_scheduler_task_last_duration_seconds")
+        .Help("Duration of the last run of a scheduled task")
+        .Register(*registry_);
+
+    task_runs_counter_ = &prometheus::BuildCounter()
+        .Name("nexus_scheduler_task_runs_total")
+        .Help("Total runs of a scheduled task")
+        .Register(*registry_);
+
+    task_duration_counter_ = &prometheus::BuildCounter()
+        .Name("nexus_scheduler_task_duration_seconds_total")
+        .Help("Total time spent in a scheduled task")
+        .Register(*registry_);
+
+    stage_histograms_.family = &prometheus::BuildHistogram()
+        .Name("nexus_stage_duration_seconds")
+        .Help("Duration of transaction admission, block validation and block commit")
+        .Register(*registry_);
+    stage_histograms_.label_name = "stage";
+    stage_histograms_.resolve({"tx_admission", "block_validation", "block_commit"});
+
+    query_histograms_.family = &prometheus::BuildHistogram()
+        .Name("nexus_db_query_duration_seconds")
+        .Help("Latency of ledger database operations by query kind")
+        .Register(*registry_);
+    query_histograms_.label_name = "kind";
+    query_histograms_.resolve({"wallet", "add_block", "get_block", "get_block_by_hash", "latest_height",
+                               "add_tx", "update_tx", "block_txs", "get_tx", "balance",
+                               "mempool_add", "mempool_read", "nonce", "peers"});
+
+    auto& message_family = prometheus::BuildHistogram()
+        .Name("nexus_message_handling_seconds")
+        .Help("Time spent handling a P2P message by message type")
+        .Register(*registry_);
+    for (size_t i = 0; i < PeerStats::TYPE_SLOTS; ++i) {
+        message_histograms_[i] = &message_family.Add({{"type", PeerStats::slot_name(i)}}, LATENCY_BUCKETS);
+    }
+
+    propagation_histogram_ = &prometheus::BuildHistogram()
+        .Name("nexus_block_propagation_delay_seconds")
+        .Help("Delay between block timestamp and its arrival at this node")
+        .Register(*registry_).Add({}, PROPAGATION_BUCKETS);
+
+    peer_messages_sent_ = &prometheus::BuildCounter()
+        .Name("nexus_peer_messages_sent_total")
+        .Help("Messages sent to a peer by message type")
+        .Register(*registry_);
+
+    peer_messages_received_ = &prometheus::BuildCounter()
+        .Name("nexus_peer_messages_received_total")
+        .Help("Messages received from a peer by message type")
+        .Register(*registry_);
+
+    peer_bytes_sent_ = &prometheus::BuildCounter()
+        .Name("nexus_peer_bytes_sent_total")
+        .Help("Bytes sent to a peer by message type")
+        .Register(*registry_);
+
+    peer_bytes_received_ = &prometheus::BuildCounter()
+        .Name("nexus_peer_bytes_received_total")
+        .Help("Bytes received from a peer by message type")
+        .Register(*registry_);
+
+    peer_send_stall_ = &prometheus::BuildCounter()
+        .Name("nexus_peer_send_stall_seconds_total")
+        .Help("Time the send queue of a peer was not empty")
+        .Register(*registry_);
+
+    peer_rtt_gauge_ = &prometheus::BuildGauge()
+        .Name("nexus_peer_ping_rtt_seconds")
+        .Help("Last PING/PONG round trip time to a peer")
+        .Register(*registry_);
+
+    peer_queue_gauge_ = &prometheus::BuildGauge()
+        .Name("nexus_peer_send_queue_depth")
+        .Help("Messages waiting in the send queue of a peer")
+        .Register(*registry_);
+
     exposer_->RegisterCollectable(registry_);
-    std::cout << "Metrics server started on port " << port << std::endl;
+    exposer_->RegisterCollectable(hot_counters_);
+    LOG_INFO(METRICS, "Metrics server started").kv("port", port);
 }
 
 void MetricsRegistry::setHashrate(double hashrate) {
-    hashrate_gauge_->Add({}).Set(hashrate);
+    hashrate_gauge_->Set(hashrate);
 }
 
 void MetricsRegistry::setMiningDifficulty(int difficulty) {
-    difficulty_gauge_->Add({}).Set(difficulty);
+    difficulty_gauge_->Set(difficulty);
 }
 
 void MetricsRegistry::setPeers(int count) {
-    peers_gauge_->Add({}).Set(count);
+    peers_gauge_->Set(count);
 }
 
 void MetricsRegistry::setBlockchainHeight(int height) {
-    height_gauge_->Add({}).Set(height);
+    height_gauge_->Set(height);
 }
 
 void MetricsRegistry::setMempoolSize(int size) {
-    mempool_gauge_->Add({}).Set(size);
+    mempool_gauge_->Set(size);
+}
+
+void MetricsRegistry::setOrphanBlocks(int count) {
+    orphan_blocks_gauge_->Set(count);
+}
+
+void MetricsRegistry::setHistoryMismatch(bool mismatch) {
+    history_mismatch_gauge_->Set(mismatch ? 1 : 0);
+}
+
+void MetricsRegistry::incDuplicateBlocks(int n) {
+    duplicate_blocks_counter_->Increment(n);
+}
+
+void MetricsRegistry::incTransactionsOverloaded() {
+    overloaded_txs_counter_->Increment();
+}
+
+void MetricsRegistry::updateSignatureStats(uint64_t valid, uint64_t invalid, uint64_t cacheHits,
+                                           uint64_t cacheMisses) {
+    std::array<uint64_t, 4> current = {valid, invalid, cacheHits, cacheMisses};
+    std::array<prometheus::Counter*, 4> counters = {signatures_valid_counter_, signatures_invalid_counter_,
+                                                    signature_cache_hits_counter_, signature_cache_misses_counter_};
+    for (size_t i = 0; i < current.size(); ++i) {
+        if (current[i] > signature_cursor_[i]) counters[i]->Increment(static_cast<double>(current[i] - signature_cursor_[i]));
+        signature_cursor_[i] = current[i];
+    }
+    uint64_t lookups = cacheHits + cacheMisses;
+    signature_cache_ratio_gauge_->Set(lookups > 0 ? static_cast<double>(cacheHits) / static_cast<double>(lookups) : 0);
+}
+
+void MetricsRegistry::observeScheduledTask(const std::string& task, double seconds) {
+    task_last_duration_gauge_->Add({{"task", task}}).Set(seconds);
+    task_runs_counter_->Add({{"task", task}}).Increment();
+    task_duration_counter_->Add({{"task", task}}).Increment(seconds);
+}
+
+void MetricsRegistry::LabelledHistograms::resolve(const std::vector<const char*>& labels) {
+    for (const char* label : labels) {
+        known.emplace_back(label, &family->Add({{label_name, label}}, LATENCY_BUCKETS));
+    }
+}
+
+prometheus::Histogram& MetricsRegistry::LabelledHistograms::get(const char* label) {
+    // Наборы меток короткие: линейный поиск дешевле хэширования и без блокировок
+    for (auto& [name, histogram] : known) {
+        if (name == label) return *histogram;
+    }
+    return family->Add({{label_name, label}}, LATENCY_BUCKETS);
+}
+
+void MetricsRegistry::observeStage(const char* stage, double seconds) {
+    stage_histograms_.get(stage).Observe(seconds);
+}
+
+void MetricsRegistry::observeQuery(const char* kind, double seconds) {
+    query_histograms_.get(kind).Observe(seconds);
+}
+
+void MetricsRegistry::observeMessageHandling(MessageType type, double seconds) {
+    message_histograms_[PeerStats::slot(type)]->Observe(seconds);
+}
+
+void MetricsRegistry::observeBlockPropagation(double seconds) {
+    propagation_histogram_->Observe(seconds);
+}
+
+MetricsRegistry::LabelSeries& MetricsRegistry::labelSeries(const std::string& label) {
+    auto it = label_series_.find(label);
+    if (it != label_series_.end()) return it->second;
+    LabelSeries series;
+    series.stall = &peer_send_stall_->Add({{"peer", label}});
+    if (label != "other") {
+        // Задержка и очередь — свойства одного соединения, для "other" их не суммируем
+        series.rtt = &peer_rtt_gauge_->Add({{"peer", label}});
+        series.queue_depth = &peer_queue_gauge_->Add({{"peer", label}});
+    }
+    return label_series_.emplace(label, series).first->second;
+}
+
+prometheus::Counter& MetricsRegistry::typeCounter(prometheus::Family<prometheus::Counter>* family,
+                                                  TypeCounters& counters, const std::string& label, size_t slot) {
+    if (!counters[slot]) {
+        counters[slot] = &family->Add({{"peer", label}, {"type", PeerStats::slot_name(slot)}});
+    }
+    return *counters[slot];
+}
+
+void MetricsRegistry::updatePeerStats(const std::string& peer, const PeerStats& stats) {
+    auto it = peer_cursors_.find(peer);
+    if (it == peer_cursors_.end()) {
+        PeerCursor cursor;
+        size_t labelled = label_series_.size() - label_series_.count("other");
+        cursor.label = labelled < MAX_PEER_LABELS ? peer : "other";
+        it = peer_cursors_.emplace(peer, cursor).first;
+    }
+    PeerCursor& cursor = it->second;
+    LabelSeries& series = labelSeries(cursor.label);
+
+    for (size_t i = 0; i < PeerStats::TYPE_SLOTS; ++i) {
+        const auto& sent = stats.sent[i];
+        const auto& received = stats.received[i];
+        if (sent.messages > cursor.sent[i].messages) {
+            typeCounter(peer_messages_sent_, series.messages_sent, cursor.label, i)
+                .Increment(static_cast<double>(sent.messages - cursor.sent[i].messages));
+            typeCounter(peer_bytes_sent_, series.bytes_sent, cursor.label, i)
+                .Increment(static_cast<double>(sent.bytes - cursor.sent[i].bytes));
+            cursor.sent[i] = sent;
+        }
+        if (received.messages > cursor.received[i].messages) {
+            typeCounter(peer_messages_received_, series.messages_received, cursor.label, i)
+                .Increment(static_cast<double>(received.messages - cursor.received[i].messages));
+            typeCounter(peer_bytes_received_, series.bytes_received, cursor.label, i)
+                .Increment(static_cast<double>(received.bytes - cursor.received[i].bytes));
+            cursor.received[i] = received;
+        }
+    }
+
+    double stall = stats.current_stall_ms();
+    if (stall > cursor.stall_ms) {
+        series.stall->Increment((stall - cursor.stall_ms) / 1000.0);
+        cursor.stall_ms = stall;
+    }
+    if (series.rtt) series.rtt->Set(stats.last_rtt_ms / 1000.0);
+    if (series.queue_depth) series.queue_depth->Set(static_cast<double>(stats.send_queue_depth));
 }
 
-void MetricsRegistry::incPacketsReceived(const std::string& type) {
-    packets_recv_counter_->Add({{"type", type}}).Increment();
+void MetricsRegistry::removePeer(const std::string& peer) {
+    auto it = peer_cursors_.find(peer);
+    if (it == peer_cursors_.end()) return;
+    if (it->second.label != "other") {
+        removeLabel(it->second.label);
+    }
+    peer_cursors_.erase(it);
 }
 
-void MetricsRegistry::incPacketsSent(const std::string& type) {
-    packets_sent_counter_->Add({{"type", type}}).Increment();
+void MetricsRegistry::removeLabel(const std::string& label) {
+    auto it = label_series_.find(label);
+    if (it == label_series_.end()) return;
+    LabelSeries& series = it->second;
+    auto remove_all = [](prometheus::Family<prometheus::Counter>* family, TypeCounters& counters) {
+        for (auto* c : counters) {
+            if (c) family->Remove(c);
+        }
+    };
+    remove_all(peer_messages_sent_, series.messages_sent);
+    remove_all(peer_messages_received_, series.messages_received);
+    remove_all(peer_bytes_sent_, series.bytes_sent);
+    remove_all(peer_bytes_received_, series.bytes_received);
+    peer_send_stall_->Remove(series.stall);
+    if (series.rtt) peer_rtt_gauge_->Remove(series.rtt);
+    if (series.queue_depth) peer_queue_gauge_->Remove(series.queue_depth);
+    label_series_.erase(it);
 }
 
 void MetricsRegistry::incBlocksMined() {
-    blocks_counter_->Add({}).Increment();
+    blocks_counter_->Increment();
 }
 
 void MetricsRegistry::incTransactionsProcessed() {
-    transactions_counter_->Add({}).Increment();
+    transactions_counter_->Increment();
 }
 
 } // namespace nexus
\ No newline at end of file
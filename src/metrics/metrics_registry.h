@@ -2,10 +2,15 @@
 #pragma once
 #include <memory>
 #include <string>
+#include <array>
+#include <unordered_map>
 #include <prometheus/registry.h>
 #include <prometheus/counter.h>
 #include <prometheus/gauge.h>
+#include <prometheus/histogram.h>
 #include <prometheus/exposer.h>
+#include "../network/peer_stats.h"
+#include "sharded_counter.h"
 
 namespace nexus {
 
@@ -17,26 +22,118 @@ public:
     void setPeers(int count);
     void setBlockchainHeight(int height);
     void setMempoolSize(int size);
-    void incPacketsReceived(const std::string& type);
-    void incPacketsSent(const std::string& type);
+    void setOrphanBlocks(int count);
+    void setHistoryMismatch(bool mismatch);
+    void incDuplicateBlocks(int n);
+    void incTransactionsOverloaded();
+    // Накопленные счётчики верификатора подписей; выгружаются приращения
+    void updateSignatureStats(uint64_t valid, uint64_t invalid, uint64_t cacheHits, uint64_t cacheMisses);
+    void incPacketsReceived(MessageType type) { packets_received_[PeerStats::slot(type)]->inc(); }
+    void incPacketsSent(MessageType type) { packets_sent_[PeerStats::slot(type)]->inc(); }
+    void incHashes(uint64_t n = 1) { hashes_->inc(n); }
     void incBlocksMined();
     void incTransactionsProcessed();
     void setHashrate(double hashrate);
     void setMiningDifficulty(int difficulty);
+    void observeScheduledTask(const std::string& task, double seconds);
+
+    // Гистограммы задержек (секунды)
+    void observeStage(const char* stage, double seconds);        // Приём tx, проверка и запись блока
+    void observeQuery(const char* kind, double seconds);         // SQL-операции LedgerDB
+    void observeMessageHandling(MessageType type, double seconds);
+    void observeBlockPropagation(double seconds);                // Получение минус timestamp блока
+
+    // Серии с меткой peer. Чтобы число серий не росло без границ, отдельную
+    // метку получают только первые MAX_PEER_LABELS пиров, остальные
+    // суммируются под peer="other"; серии отключившихся пиров удаляются.
+    static constexpr size_t MAX_PEER_LABELS = 32;
+    void updatePeerStats(const std::string& peer, const PeerStats& stats);
+    void removePeer(const std::string& peer);
     
 private:
     std::shared_ptr<prometheus::Registry> registry_;
     std::unique_ptr<prometheus::Exposer> exposer_;
     
-    prometheus::Family<prometheus::Gauge>* peers_gauge_;
-    prometheus::Family<prometheus::Gauge>* height_gauge_;
-    prometheus::Family<prometheus::Gauge>* mempool_gauge_;
-    prometheus::Family<prometheus::Gauge>* hashrate_gauge_;
-    prometheus::Family<prometheus::Gauge>* difficulty_gauge_;
-    prometheus::Family<prometheus::Counter>* packets_recv_counter_;
-    prometheus::Family<prometheus::Counter>* packets_sent_counter_;
-    prometheus::Family<prometheus::Counter>* blocks_counter_;
-    prometheus::Family<prometheus::Counter>* transactions_counter_;
+    // Дочерние серии разрешаются один раз в конструкторе: Family::Add на каждый
+    // вызов строит карту меток и берёт мьютекс семейства
+    prometheus::Gauge* peers_gauge_;
+    prometheus::Gauge* height_gauge_;
+    prometheus::Gauge* mempool_gauge_;
+    prometheus::Gauge* orphan_blocks_gauge_;
+    prometheus::Gauge* history_mismatch_gauge_;
+    prometheus::Counter* duplicate_blocks_counter_;
+    prometheus::Counter* overloaded_txs_counter_;
+    prometheus::Counter* signatures_valid_counter_;
+    prometheus::Counter* signatures_invalid_counter_;
+    prometheus::Counter* signature_cache_hits_counter_;
+    prometheus::Counter* signature_cache_misses_counter_;
+    prometheus::Gauge* signature_cache_ratio_gauge_;
+    std::array<uint64_t, 4> signature_cursor_{};   // Уже выгруженные valid, invalid, hits, misses
+    prometheus::Gauge* hashrate_gauge_;
+    prometheus::Gauge* difficulty_gauge_;
+    prometheus::Counter* blocks_counter_;
+    prometheus::Counter* transactions_counter_;
+    prometheus::Histogram* propagation_histogram_;
+    std::array<prometheus::Histogram*, PeerStats::TYPE_SLOTS> message_histograms_{};
+
+    // Пакеты и хэши считаются на каждом сообщении и каждой попытке nonce
+    std::shared_ptr<ShardedCounterSet> hot_counters_;
+    std::array<ShardedCounter*, PeerStats::TYPE_SLOTS> packets_received_{};
+    std::array<ShardedCounter*, PeerStats::TYPE_SLOTS> packets_sent_{};
+    ShardedCounter* hashes_;
+
+    // Гистограммы с меткой из фиксированного набора строк (этапы, виды запросов):
+    // известные метки разрешены заранее, неизвестные идут через Family::Add
+    struct LabelledHistograms {
+        prometheus::Family<prometheus::Histogram>* family{nullptr};
+        std::string label_name;
+        std::vector<std::pair<std::string, prometheus::Histogram*>> known;
+
+        void resolve(const std::vector<const char*>& labels);
+        prometheus::Histogram& get(const char* label);
+    };
+    LabelledHistograms stage_histograms_;
+    LabelledHistograms query_histograms_;
+
+    prometheus::Family<prometheus::Gauge>* task_last_duration_gauge_;
+    prometheus::Family<prometheus::Counter>* task_runs_counter_;
+    prometheus::Family<prometheus::Counter>* task_duration_counter_;
+
+    using TypeCounters = std::array<prometheus::Counter*, PeerStats::TYPE_SLOTS>;
+
+    // Серии одной метки peer (создаются по мере появления трафика)
+    struct LabelSeries {
+        prometheus::Gauge* rtt{nullptr};
+        prometheus::Gauge* queue_depth{nullptr};
+        prometheus::Counter* stall{nullptr};
+        TypeCounters messages_sent{};
+        TypeCounters messages_received{};
+        TypeCounters bytes_sent{};
+        TypeCounters bytes_received{};
+    };
+
+    // Уже выгруженные значения пира: счётчики Prometheus принимают только приращения
+    struct PeerCursor {
+        std::string label;
+        std::array<PeerStats::Counters, PeerStats::TYPE_SLOTS> sent{};
+        std::array<PeerStats::Counters, PeerStats::TYPE_SLOTS> received{};
+        double stall_ms{0};
+    };
+
+    LabelSeries& labelSeries(const std::string& label);
+    prometheus::Counter& typeCounter(prometheus::Family<prometheus::Counter>* family, TypeCounters& counters,
+                                     const std::string& label, size_t slot);
+    void removeLabel(const std::string& label);
+
+    prometheus::Family<prometheus::Counter>* peer_messages_sent_;
+    prometheus::Family<prometheus::Counter>* peer_messages_received_;
+    prometheus::Family<prometheus::Counter>* peer_bytes_sent_;
+    prometheus::Family<prometheus::Counter>* peer_bytes_received_;
+    prometheus::Family<prometheus::Counter>* peer_send_stall_;
+    prometheus::Family<prometheus::Gauge>* peer_rtt_gauge_;
+    prometheus::Family<prometheus::Gauge>* peer_queue_gauge_;
+    std::unordered_map<std::string, PeerCursor> peer_cursors_;   // Ключ — пир
+    std::unordered_map<std::string, LabelSeries> label_series_;  // Ключ — значение метки
 };
 
 } // namespace nexus
\ No newline at end of file
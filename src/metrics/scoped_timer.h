@@ -0,0 +1,59 @@
+// src/metrics/scoped_timer.h
+#pragma once
+#include <chrono>
+#include <string>
+#include <functional>
+
+namespace nexus {
+
+// RAII-таймер участка кода: при выходе из области видимости передаёт
+// длительность в секундах наблюдателю. Не зависит от Prometheus, поэтому
+// годится для хранилища и блокчейна. Если наблюдатель не задан, часы
+// не читаются вовсе — выключенные метрики ничего не стоят.
+class ScopedTimer {
+public:
+    using Observer = std::function<void(double seconds)>;
+    using LabelledObserver = std::function<void(const char* label, double seconds)>;
+
+    explicit ScopedTimer(const Observer& observer)
+        : observer_(observer ? &observer : nullptr) {
+        if (observer_) started_ = Clock::now();
+    }
+
+    // Метка — строковая константа (вид запроса, этап), не должна быть временной
+    ScopedTimer(const LabelledObserver& observer, const char* label)
+        : labelled_(observer ? &observer : nullptr), label_(label) {
+        if (labelled_) started_ = Clock::now();
+    }
+
+    ~ScopedTimer() { stop(); }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    // Досрочная остановка; повторные вызовы ничего не делают
+    void stop() {
+        if (!observer_ && !labelled_) return;
+        double seconds = std::chrono::duration<double>(Clock::now() - started_).count();
+        if (observer_) (*observer_)(seconds);
+        if (labelled_) (*labelled_)(label_, seconds);
+        observer_ = nullptr;
+        labelled_ = nullptr;
+    }
+
+    // Не отчитываться (например, операция завершилась ошибкой)
+    void cancel() {
+        observer_ = nullptr;
+        labelled_ = nullptr;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    const Observer* observer_{nullptr};
+    const LabelledObserver* labelled_{nullptr};
+    const char* label_{nullptr};
+    Clock::time_point started_{};
+};
+
+} // namespace nexus
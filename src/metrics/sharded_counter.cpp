@@ -0,0 +1,57 @@
+// src/metrics/sharded_counter.cpp
+#include "sharded_counter.h"
+#include <map>
+
+namespace nexus {
+
+uint64_t ShardedCounter::value() const {
+    uint64_t total = 0;
+    for (const auto& shard : shards_) {
+        total += shard.value.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+size_t ShardedCounter::shard_index() {
+    static std::atomic<size_t> next{0};
+    thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return index;
+}
+
+ShardedCounter& ShardedCounterSet::add(const std::string& name, const std::string& help, const Labels& labels) {
+    auto entry = std::make_unique<Entry>();
+    entry->name = name;
+    entry->help = help;
+    entry->labels = labels;
+    ShardedCounter& counter = entry->counter;
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.push_back(std::move(entry));
+    return counter;
+}
+
+std::vector<prometheus::MetricFamily> ShardedCounterSet::Collect() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // Семейства в порядке первой регистрации имени
+    std::vector<prometheus::MetricFamily> families;
+    std::map<std::string, size_t> index;
+    for (const auto& entry : entries_) {
+        auto it = index.find(entry->name);
+        if (it == index.end()) {
+            prometheus::MetricFamily family;
+            family.name = entry->name;
+            family.help = entry->help;
+            family.type = prometheus::MetricType::Counter;
+            it = index.emplace(entry->name, families.size()).first;
+            families.push_back(std::move(family));
+        }
+        prometheus::ClientMetric metric;
+        for (const auto& [name, value] : entry->labels) {
+            metric.label.push_back({name, value});
+        }
+        metric.counter.value = static_cast<double>(entry->counter.value());
+        families[it->second].metric.push_back(std::move(metric));
+    }
+    return families;
+}
+
+} // namespace nexus
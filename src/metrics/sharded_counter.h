@@ -0,0 +1,61 @@
+// src/metrics/sharded_counter.h
+#pragma once
+#include <array>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <prometheus/collectable.h>
+#include <prometheus/metric_family.h>
+
+namespace nexus {
+
+// Счётчик для горячих путей (каждый пакет, каждый хэш майнера).
+// Каждый поток пишет в свой шард relaxed-инкрементом без общей
+// кэш-линии и без мьютекса; сумма шардов считается только при сборе метрик.
+class ShardedCounter {
+public:
+    static constexpr size_t SHARDS = 16;
+
+    void inc(uint64_t n = 1) {
+        shards_[shard_index()].value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    uint64_t value() const;
+
+private:
+    struct alignas(64) Shard {
+        std::atomic<uint64_t> value{0};
+    };
+
+    // Номер шарда закрепляется за потоком при первом обращении
+    static size_t shard_index();
+
+    std::array<Shard, SHARDS> shards_;
+};
+
+// Набор шардированных счётчиков, отдаваемых Prometheus как обычные counter-семейства.
+// Счётчики регистрируются при старте и живут столько же, сколько набор.
+class ShardedCounterSet : public prometheus::Collectable {
+public:
+    using Labels = std::vector<std::pair<std::string, std::string>>;
+
+    ShardedCounter& add(const std::string& name, const std::string& help, const Labels& labels = {});
+
+    std::vector<prometheus::MetricFamily> Collect() const override;
+
+private:
+    struct Entry {
+        std::string name;
+        std::string help;
+        Labels labels;
+        ShardedCounter counter;
+    };
+
+    mutable std::mutex mutex_;          // Защищает только список, не инкременты
+    std::vector<std::unique_ptr<Entry>> entries_;
+};
+
+} // namespace nexus
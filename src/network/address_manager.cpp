@@ -0,0 +1,176 @@
+// src/network/address_manager.cpp
+#include "address_manager.h"
+#include "peer_score.h"
+#include <algorithm>
+
+namespace nexus {
+
+AddressManager::AddressManager()
+    : new_table_(NEW_BUCKET_COUNT * BUCKET_SIZE),
+      tried_table_(TRIED_BUCKET_COUNT * BUCKET_SIZE) {
+    salt_ = (static_cast<uint64_t>(rng_()) << 32) | rng_();
+}
+
+uint64_t AddressManager::hash(const std::string& data) const {
+    // FNV-1a с солью и финальным перемешиванием (splitmix64)
+    uint64_t h = 14695981039346656037ULL ^ salt_;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 30; h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27; h *= 0x94d049bb133111ebULL;
+    h ^= h >> 31;
+    return h;
+}
+
+size_t AddressManager::new_slot(const Entry& entry) const {
+    std::string group = network_group(entry.ip);
+    uint64_t source_bucket = hash(group + "|" + entry.source_group) % SOURCE_BUCKETS;
+    size_t bucket = hash(entry.source_group + "|" + std::to_string(source_bucket)) % NEW_BUCKET_COUNT;
+    size_t pos = hash("N|" + std::to_string(bucket) + "|" + key(entry.ip, entry.port)) % BUCKET_SIZE;
+    return bucket * BUCKET_SIZE + pos;
+}
+
+size_t AddressManager::tried_slot(const Entry& entry) const {
+    std::string k = key(entry.ip, entry.port);
+    uint64_t group_bucket = hash(k) % TRIED_GROUP_BUCKETS;
+    size_t bucket = hash(network_group(entry.ip) + "|" + std::to_string(group_bucket)) % TRIED_BUCKET_COUNT;
+    size_t pos = hash("T|" + std::to_string(bucket) + "|" + k) % BUCKET_SIZE;
+    return bucket * BUCKET_SIZE + pos;
+}
+
+bool AddressManager::is_terrible(const Entry& entry, time_t now) const {
+    if (entry.failures >= MAX_FAILURES) return true;
+    return entry.last_seen > 0 && now - entry.last_seen > HORIZON_SECONDS;
+}
+
+bool AddressManager::place_new(const std::string& k) {
+    Entry& entry = entries_[k];
+    size_t slot = new_slot(entry);
+    const std::string occupant = new_table_[slot];
+    if (!occupant.empty() && occupant != k) {
+        if (!is_terrible(entries_[occupant], time(nullptr))) {
+            // Ячейка занята живым адресом: новичок отбрасывается
+            entries_.erase(k);
+            slot_of_.erase(k);
+            return false;
+        }
+        entries_.erase(occupant);
+        slot_of_.erase(occupant);
+    }
+    new_table_[slot] = k;
+    slot_of_[k] = slot;
+    return true;
+}
+
+void AddressManager::remove_from_new(const std::string& k) {
+    auto it = slot_of_.find(k);
+    if (it == slot_of_.end()) return;
+    if (new_table_[it->second] == k) new_table_[it->second].clear();
+    slot_of_.erase(it);
+}
+
+bool AddressManager::add(const std::string& ip, int port, const std::string& source_ip) {
+    std::string k = key(ip, port);
+    auto it = entries_.find(k);
+    if (it != entries_.end()) {
+        it->second.last_seen = time(nullptr);
+        return false;
+    }
+    Entry entry;
+    entry.ip = ip;
+    entry.port = port;
+    entry.source_group = network_group(source_ip);
+    entry.last_seen = time(nullptr);
+    entries_[k] = entry;
+    return place_new(k);
+}
+
+void AddressManager::load(const Entry& entry) {
+    std::string k = key(entry.ip, entry.port);
+    if (entries_.count(k)) return;
+    entries_[k] = entry;
+    if (entry.tried) {
+        size_t slot = tried_slot(entry);
+        if (tried_table_[slot].empty()) {
+            tried_table_[slot] = k;
+            slot_of_[k] = slot;
+            tried_count_++;
+            return;
+        }
+        entries_[k].tried = false;
+    }
+    place_new(k);
+}
+
+void AddressManager::mark_good(const std::string& ip, int port) {
+    std::string k = key(ip, port);
+    auto it = entries_.find(k);
+    if (it == entries_.end()) {
+        add(ip, port, ip);
+        it = entries_.find(k);
+        if (it == entries_.end()) return;
+    }
+    time_t now = time(nullptr);
+    it->second.failures = 0;
+    it->second.last_success = now;
+    it->second.last_seen = now;
+    if (it->second.tried) return;
+
+    remove_from_new(k);
+    size_t slot = tried_slot(it->second);
+    const std::string occupant = tried_table_[slot];
+    if (!occupant.empty()) {
+        // Вытесненный из tried возвращается в new, а не теряется
+        entries_[occupant].tried = false;
+        slot_of_.erase(occupant);
+        tried_count_--;
+        place_new(occupant);
+    }
+    tried_table_[slot] = k;
+    slot_of_[k] = slot;
+    entries_[k].tried = true;
+    tried_count_++;
+}
+
+void AddressManager::mark_failed(const std::string& ip, int port) {
+    auto it = entries_.find(key(ip, port));
+    if (it != entries_.end()) it->second.failures++;
+}
+
+void AddressManager::update_score(const std::string& ip, int port, double score) {
+    auto it = entries_.find(key(ip, port));
+    if (it != entries_.end()) it->second.score = score;
+}
+
+std::vector<std::pair<std::string, int>> AddressManager::select(size_t count,
+        const std::function<bool(const std::string&, int)>& skip) const {
+    std::vector<std::pair<double, const Entry*>> candidates;
+    std::uniform_real_distribution<double> noise(0.0, 25.0);
+    for (const auto& [k, entry] : entries_) {
+        if (skip && skip(entry.ip, entry.port)) continue;
+        double priority = entry.score + (entry.tried ? 20.0 : 0.0) - entry.failures * 15.0 + noise(rng_);
+        candidates.emplace_back(priority, &entry);
+    }
+    count = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    std::vector<std::pair<std::string, int>> result;
+    for (size_t i = 0; i < count; ++i) {
+        result.emplace_back(candidates[i].second->ip, candidates[i].second->port);
+    }
+    return result;
+}
+
+std::vector<AddressManager::Entry> AddressManager::entries() const {
+    std::vector<Entry> result;
+    result.reserve(entries_.size());
+    for (const auto& [k, entry] : entries_) {
+        result.push_back(entry);
+    }
+    return result;
+}
+
+} // namespace nexus
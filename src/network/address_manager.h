@@ -0,0 +1,79 @@
+// src/network/address_manager.h
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+#include <random>
+#include <cstdint>
+#include <ctime>
+
+namespace nexus {
+
+// Адресная книга узла. Адреса лежат в двух таблицах бакетов:
+//  - new:   услышанные от других пиров; бакет определяется сетевой группой
+//           адреса и группой источника, так что один источник заполняет
+//           не больше SOURCE_BUCKETS бакетов и не может вытеснить всю книгу;
+//  - tried: адреса, к которым удалось подключиться; бакет зависит от группы адреса.
+// Занятая ячейка освобождается только под "плохой" адрес-старожил.
+// Все методы вызываются из io-потока узла.
+class AddressManager {
+public:
+    static constexpr size_t NEW_BUCKET_COUNT = 256;
+    static constexpr size_t TRIED_BUCKET_COUNT = 64;
+    static constexpr size_t BUCKET_SIZE = 64;
+    static constexpr size_t SOURCE_BUCKETS = 16;    // Бакетов new на одну группу источника
+    static constexpr size_t TRIED_GROUP_BUCKETS = 8; // Бакетов tried на одну группу адреса
+    static constexpr int MAX_FAILURES = 3;           // После стольких неудач подряд адрес "плохой"
+    static constexpr time_t HORIZON_SECONDS = 30 * 24 * 3600;
+
+    struct Entry {
+        std::string ip;
+        int port{0};
+        std::string source_group;
+        bool tried{false};
+        double score{0};
+        time_t last_seen{0};
+        time_t last_success{0};
+        int failures{0};
+    };
+
+    AddressManager();
+
+    // Адрес, услышанный от source_ip (для seed-узлов и БД — любая метка группы)
+    bool add(const std::string& ip, int port, const std::string& source_ip);
+    // Восстановление из БД с сохранёнными полями
+    void load(const Entry& entry);
+
+    void mark_good(const std::string& ip, int port);
+    void mark_failed(const std::string& ip, int port);
+    void update_score(const std::string& ip, int port, double score);
+
+    // До count адресов для исходящих подключений: tried и высокая оценка
+    // в приоритете, случайная добавка не даёт всегда выбирать одних и тех же
+    std::vector<std::pair<std::string, int>> select(size_t count,
+        const std::function<bool(const std::string&, int)>& skip) const;
+
+    std::vector<Entry> entries() const;
+    size_t size() const { return entries_.size(); }
+    size_t tried_count() const { return tried_count_; }
+
+private:
+    static std::string key(const std::string& ip, int port) { return ip + ":" + std::to_string(port); }
+    uint64_t hash(const std::string& data) const;
+    size_t new_slot(const Entry& entry) const;
+    size_t tried_slot(const Entry& entry) const;
+    bool is_terrible(const Entry& entry, time_t now) const;
+    bool place_new(const std::string& k);
+    void remove_from_new(const std::string& k);
+
+    uint64_t salt_;  // Случайный на каждый запуск: раскладку нельзя предсказать извне
+    std::unordered_map<std::string, Entry> entries_;
+    std::unordered_map<std::string, size_t> slot_of_;   // Ячейка в своей таблице
+    std::vector<std::string> new_table_;                 // Пустая строка — свободная ячейка
+    std::vector<std::string> tried_table_;
+    size_t tried_count_{0};
+    mutable std::mt19937 rng_{std::random_device{}()};
+};
+
+} // namespace nexus
@@ -1,79 +1,88 @@
 // src/network/client.cpp
 #include "client.h"
-#include <iostream>
+#include "../logging/logger.h"
 
 namespace nexus {
 
 Client::Client(boost::asio::io_context& io_context) 
     : io_context_(io_context), peer_(nullptr), is_connecting_(false) {}
 
-bool Client::connect(const std::string& address, int port, const std::string& node_id) {
+bool Client::connect(const std::string& address, int port, const std::string& node_id,
+                     std::chrono::milliseconds timeout) {
     if (is_connected() || is_connecting_) {
-        std::cout << "Already connected or connecting to " 
-                  << (peer_ ? peer_->get_endpoint() : "unknown") << std::endl;
+        LOG_DEBUG(NET, "Already connected or connecting")
+            .kv("peer", peer_ ? peer_->get_endpoint() : "unknown");
         return false;
     }
     
+    boost::system::error_code ec;
+    auto ip = boost::asio::ip::make_address(address, ec);
+    if (ec) {
+        LOG_WARN(NET, "Invalid address").kv("address", address).kv("error", ec.message());
+        return false;
+    }
+    boost::asio::ip::tcp::endpoint endpoint(ip, static_cast<unsigned short>(port));
+    
     is_connecting_ = true;
     
     peer_ = std::make_shared<Peer>(io_context_);
     peer_->id = node_id;
+    peer_->address = address;
+    peer_->port = port;
+    peer_->state = PeerState::CONNECTING;
     
-    // Устанавливаем обработчик сообщений для чтения
-    peer_->read([this](const std::string& data) {
-        try {
-            Message msg = Message::deserialize(data);
-            if (message_handler_) {
-                message_handler_(msg, peer_);
-            }
-        } catch (const std::exception& e) {
-            // std::cout << "Error parsing message: " << e.what() << std::endl; Делаем логи чище
+    // Таймаут: закрытие сокета прерывает async_connect с operation_aborted
+    auto peer = peer_;
+    auto timer = std::make_shared<boost::asio::steady_timer>(io_context_);
+    timer->expires_after(timeout);
+    timer->async_wait([peer](const boost::system::error_code& error) {
+        if (!error && peer->state == PeerState::CONNECTING) {
+            boost::system::error_code ignored;
+            peer->socket->close(ignored);
         }
     });
     
-    try {
-        boost::asio::ip::tcp::endpoint endpoint(
-            boost::asio::ip::make_address(address), 
-            static_cast<unsigned short>(port));
-        
-        boost::system::error_code ec;
-        peer_->socket->connect(endpoint, ec);
+    peer->socket->async_connect(endpoint, [this, peer, timer, address, port](const boost::system::error_code& error) {
+        timer->cancel();
+        if (peer != peer_) return;  // За время подключения клиент отключили
+        is_connecting_ = false;
         
-        if (!ec) {
+        if (!error) {
             peer_->state = PeerState::CONNECTED;
-            peer_->address = address;
-            peer_->port = port;
             peer_->update_last_seen();
-            
-            // НАЧИНАЕМ ЧИТАТЬ ОТВЕТЫ
-            peer_->read([this](const std::string& data) {
-                try {
-                    Message msg = Message::deserialize(data);
-                    if (message_handler_) {
-                        message_handler_(msg, peer_);
-                    }
-                } catch (const std::exception& e) {
-                    // std::cout << "Error parsing message: " << e.what() << std::endl; Делаем логи чище
-                }
-            });
-            return true;
+            peer_->score.connected_at = peer_->last_seen;
+            start_reading();
+            if (connection_handler_) {
+                connection_handler_(true);
+            }
         } else {
-            std::cout << "Connection failed to " << address << ":" << port 
-                      << " - " << ec.message() << std::endl;
-            is_connecting_ = false;
+            LOG_INFO(NET, "Connection failed")
+                .kv("address", address).kv("port", port)
+                .kv("error", error == boost::asio::error::operation_aborted ? "timeout" : error.message());
+            peer_->state = PeerState::DISCONNECTED;
             peer_.reset();
-            
             if (connection_handler_) {
                 connection_handler_(false);
             }
-            return false;
         }
-    } catch (const std::exception& e) {
-        std::cout << "Exception during connection: " << e.what() << std::endl;
-        is_connecting_ = false;
-        peer_.reset();
-        return false;
-    }
+    });
+    return true;
+}
+
+void Client::start_reading() {
+    auto peer = peer_;
+    peer->read([this, peer](const std::string& data) {
+        try {
+            Message msg = Message::deserialize(data);
+            peer->stats.record_received(msg.type, data.size() + 1);
+            if (message_handler_) {
+                message_handler_(msg, peer);
+            }
+        } catch (const std::exception& e) {
+            peer->score.record_invalid();
+            // std::cout << "Error parsing message: " << e.what() << std::endl; Делаем логи чище
+        }
+    });
 }
 
 void Client::disconnect() {
@@ -86,11 +95,10 @@ void Client::disconnect() {
 
 void Client::send(const Message& msg) {
     if (peer_ && peer_->is_connected()) {
-        peer_->send(msg.serialize());
+        peer_->send(msg);
     } else {
-        std::cout << "Cannot send message to " 
-                  << (peer_ ? peer_->get_endpoint() : "unknown") 
-                  << " - not connected" << std::endl;
+        LOG_DEBUG(NET, "Cannot send message, not connected")
+            .kv("peer", peer_ ? peer_->get_endpoint() : "unknown");
     }
 }
 
@@ -2,6 +2,7 @@
 #pragma once
 #include <boost/asio.hpp>
 #include <memory>
+#include <chrono>
 #include <functional>
 #include "peer.h"
 #include "message.h"
@@ -13,6 +14,8 @@ public:
     using MessageHandler = std::function<void(const Message&, std::shared_ptr<Peer>)>;
     using ConnectionHandler = std::function<void(bool)>;
 
+    static constexpr auto DEFAULT_CONNECT_TIMEOUT = std::chrono::milliseconds(5000);
+
 private:
     boost::asio::io_context& io_context_;
     std::shared_ptr<Peer> peer_;
@@ -20,13 +23,18 @@ private:
     ConnectionHandler connection_handler_;
     bool is_connecting_{false};
     
+    void start_reading();
+    
 public:
     explicit Client(boost::asio::io_context& io_context);
     
     void set_message_handler(MessageHandler handler) { message_handler_ = std::move(handler); }
     void set_connection_handler(ConnectionHandler handler) { connection_handler_ = std::move(handler); }
     
-    bool connect(const std::string& address, int port, const std::string& node_id = "");
+    // Неблокирующее подключение: результат приходит в connection_handler из io-потока.
+    // Возвращает false, если попытка не начата (уже подключены или адрес некорректен).
+    bool connect(const std::string& address, int port, const std::string& node_id = "",
+                 std::chrono::milliseconds timeout = DEFAULT_CONNECT_TIMEOUT);
     void disconnect();
     void send(const Message& msg);
     
@@ -36,4 +44,4 @@ public:
     void set_peer(std::shared_ptr<Peer> peer) { peer_ = peer; }
 };
 
-} // namespace nexus
\ No newline at end of file
+} // namespace nexus
@@ -0,0 +1,88 @@
+// src/network/connection_manager.cpp
+#include "connection_manager.h"
+#include "../logging/logger.h"
+#include <algorithm>
+
+namespace nexus {
+
+ConnectionManager::ConnectionManager(boost::asio::io_context& io_context, Scheduler& scheduler,
+                                     const std::string& node_id)
+    : io_context_(io_context), scheduler_(scheduler), node_id_(node_id) {
+}
+
+bool ConnectionManager::is_known_endpoint(const std::string& ip, int port) const {
+    auto k = key(ip, port);
+    return pending_.count(k) || connected_.count(k) || retry_scheduled_.count(k);
+}
+
+bool ConnectionManager::connect(const std::string& ip, int port) {
+    auto k = key(ip, port);
+    if (pending_.count(k) || connected_.count(k)) {
+        return false;  // Повторные PEERS_LIST не должны порождать новых попыток
+    }
+    if (outbound_count() >= MAX_OUTBOUND) {
+        return false;
+    }
+    int attempts = attempts_loader_ ? attempts_loader_(ip, port) : 0;
+    if (attempts >= MAX_FAILED_ATTEMPTS) {
+        return false;
+    }
+    retry_scheduled_.erase(k);
+
+    auto client = std::make_shared<Client>(io_context_);
+    client->set_message_handler(message_handler_);
+    std::weak_ptr<Client> weak_client = client;
+    client->set_connection_handler([this, ip, port, weak_client](bool connected) {
+        if (auto c = weak_client.lock()) on_result(ip, port, c, connected);
+    });
+
+    if (!client->connect(ip, port, node_id_, CONNECT_TIMEOUT)) {
+        return false;
+    }
+    pending_[k] = client;
+    return true;
+}
+
+void ConnectionManager::on_result(const std::string& ip, int port, std::shared_ptr<Client> client, bool connected) {
+    auto k = key(ip, port);
+    pending_.erase(k);
+
+    if (connected) {
+        connected_.insert(k);
+        if (attempts_recorder_) attempts_recorder_(ip, port, 0);
+        if (connected_handler_) connected_handler_(client);
+        return;
+    }
+
+    int attempts = (attempts_loader_ ? attempts_loader_(ip, port) : 0) + 1;
+    if (attempts_recorder_) attempts_recorder_(ip, port, attempts);
+    schedule_retry(ip, port, attempts);
+}
+
+void ConnectionManager::connection_closed(const std::string& ip, int port) {
+    auto k = key(ip, port);
+    if (connected_.erase(k)) {
+        // Разрыв установленного соединения — пробуем восстановить с минимальной задержкой
+        schedule_retry(ip, port, 0);
+    }
+}
+
+void ConnectionManager::schedule_retry(const std::string& ip, int port, int attempts) {
+    if (attempts >= MAX_FAILED_ATTEMPTS) {
+        LOG_INFO(NET, "Giving up on peer").kv("peer", key(ip, port)).kv("attempts", attempts);
+        return;
+    }
+    auto k = key(ip, port);
+    if (!retry_scheduled_.insert(k).second) return;
+
+    auto delay = BASE_BACKOFF * (1LL << std::min(attempts, 20));
+    delay = std::min<std::chrono::milliseconds>(delay, MAX_BACKOFF);
+
+    scheduler_.scheduleOnce("reconnect", delay, [this, ip, port, k]() {
+        if (retry_scheduled_.erase(k)) {
+            connect(ip, port);
+        }
+    });
+}
+
+} // namespace nexus
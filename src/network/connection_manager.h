@@ -0,0 +1,76 @@
+// src/network/connection_manager.h
+#pragma once
+#include <string>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <boost/asio.hpp>
+#include "client.h"
+#include "peer.h"
+#include "../core/scheduler.h"
+
+namespace nexus {
+
+// Управление исходящими подключениями: неблокирующий connect с таймаутом,
+// дедупликация по адресу, лимиты исходящих/входящих слотов и повторные
+// попытки с экспоненциальной задержкой по счётчику peers.failed_attempts.
+// Все методы вызываются из io-потока узла (кроме конструирования).
+class ConnectionManager {
+public:
+    using ConnectedHandler = std::function<void(std::shared_ptr<Client>)>;
+    using AttemptsLoader = std::function<int(const std::string& ip, int port)>;
+    using AttemptsRecorder = std::function<void(const std::string& ip, int port, int attempts)>;
+
+    static constexpr size_t MAX_OUTBOUND = 8;
+    static constexpr size_t MAX_INBOUND = 117;
+    static constexpr int MAX_FAILED_ATTEMPTS = 10;  // После этого адрес больше не пробуем
+    static constexpr auto CONNECT_TIMEOUT = std::chrono::milliseconds(5000);
+    static constexpr auto BASE_BACKOFF = std::chrono::milliseconds(5000);
+    static constexpr auto MAX_BACKOFF = std::chrono::milliseconds(600000);
+
+    ConnectionManager(boost::asio::io_context& io_context, Scheduler& scheduler, const std::string& node_id);
+
+    void set_message_handler(Client::MessageHandler handler) { message_handler_ = std::move(handler); }
+    void set_connected_handler(ConnectedHandler handler) { connected_handler_ = std::move(handler); }
+    void set_attempts_store(AttemptsLoader loader, AttemptsRecorder recorder) {
+        attempts_loader_ = std::move(loader);
+        attempts_recorder_ = std::move(recorder);
+    }
+
+    // Начать подключение; false — адрес уже подключён/подключается, слоты заняты или адрес "мёртв"
+    bool connect(const std::string& ip, int port);
+
+    // Исходящее соединение закрыто: освобождаем слот, при необходимости планируем переподключение
+    void connection_closed(const std::string& ip, int port);
+
+    // Учёт входящих соединений
+    bool has_inbound_slot() const { return inbound_count_ < MAX_INBOUND; }
+    void inbound_opened() { inbound_count_++; }
+    void inbound_closed() { if (inbound_count_ > 0) inbound_count_--; }
+
+    bool is_known_endpoint(const std::string& ip, int port) const;
+    size_t outbound_count() const { return connected_.size() + pending_.size(); }
+    size_t inbound_count() const { return inbound_count_; }
+
+private:
+    static std::string key(const std::string& ip, int port) { return ip + ":" + std::to_string(port); }
+    void on_result(const std::string& ip, int port, std::shared_ptr<Client> client, bool connected);
+    void schedule_retry(const std::string& ip, int port, int attempts);
+
+    boost::asio::io_context& io_context_;
+    Scheduler& scheduler_;
+    std::string node_id_;
+    Client::MessageHandler message_handler_;
+    ConnectedHandler connected_handler_;
+    AttemptsLoader attempts_loader_;
+    AttemptsRecorder attempts_recorder_;
+
+    std::unordered_map<std::string, std::shared_ptr<Client>> pending_;   // Идёт подключение
+    std::unordered_set<std::string> connected_;                           // Установленные исходящие
+    std::unordered_set<std::string> retry_scheduled_;                     // Ждут повторной попытки
+    size_t inbound_count_{0};
+};
+
+} // namespace nexus
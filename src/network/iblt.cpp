@@ -0,0 +1,141 @@
+// src/network/iblt.cpp
+#include "iblt.h"
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+
+namespace nexus {
+
+namespace {
+
+uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+Iblt::Iblt(size_t cells) {
+    // Таблица делится на HASH_COUNT равных частей, чтобы хэши элемента не совпадали
+    size_t per_part = std::max<size_t>(1, (cells + HASH_COUNT - 1) / HASH_COUNT);
+    cells_.resize(per_part * HASH_COUNT);
+}
+
+size_t Iblt::cell_index(uint64_t id, int i) const {
+    size_t per_part = cells_.size() / HASH_COUNT;
+    uint64_t h = mix64(id + 0x9e3779b97f4a7c15ULL * (i + 1));
+    return i * per_part + (h % per_part);
+}
+
+uint64_t Iblt::short_id(const std::string& hex_hash, uint64_t salt) {
+    uint64_t prefix = 0;
+    try {
+        prefix = std::stoull(hex_hash.substr(0, 16), nullptr, 16);
+    } catch (const std::exception&) {
+        for (unsigned char c : hex_hash) {
+            prefix = (prefix ^ c) * 1099511628211ULL;
+        }
+    }
+    return mix64(prefix ^ salt);
+}
+
+uint64_t Iblt::check_hash(uint64_t id) {
+    return mix64(id ^ 0x5851f42d4c957f2dULL);
+}
+
+void Iblt::update(uint64_t id, int32_t delta) {
+    uint64_t check = check_hash(id);
+    for (int i = 0; i < HASH_COUNT; ++i) {
+        Cell& cell = cells_[cell_index(id, i)];
+        cell.count += delta;
+        cell.key_sum ^= id;
+        cell.check_sum ^= check;
+    }
+}
+
+bool Iblt::is_pure(const Cell& cell) {
+    return (cell.count == 1 || cell.count == -1) && cell.check_sum == check_hash(cell.key_sum);
+}
+
+Iblt Iblt::subtract(const Iblt& other) const {
+    Iblt result(*this);
+    if (other.cells_.size() != cells_.size()) return result;
+    for (size_t i = 0; i < cells_.size(); ++i) {
+        result.cells_[i].count -= other.cells_[i].count;
+        result.cells_[i].key_sum ^= other.cells_[i].key_sum;
+        result.cells_[i].check_sum ^= other.cells_[i].check_sum;
+    }
+    return result;
+}
+
+bool Iblt::decode(std::vector<uint64_t>& ids_only_here, std::vector<uint64_t>& ids_only_there) const {
+    Iblt work(*this);
+    std::vector<size_t> pure;
+    for (size_t i = 0; i < work.cells_.size(); ++i) {
+        if (is_pure(work.cells_[i])) pure.push_back(i);
+    }
+
+    while (!pure.empty()) {
+        size_t idx = pure.back();
+        pure.pop_back();
+        const Cell cell = work.cells_[idx];
+        if (!is_pure(cell)) continue;
+
+        uint64_t id = cell.key_sum;
+        if (cell.count == 1) {
+            ids_only_here.push_back(id);
+        } else {
+            ids_only_there.push_back(id);
+        }
+        work.update(id, -cell.count);
+
+        for (int i = 0; i < HASH_COUNT; ++i) {
+            size_t j = work.cell_index(id, i);
+            if (is_pure(work.cells_[j])) pure.push_back(j);
+        }
+    }
+
+    for (const auto& cell : work.cells_) {
+        if (cell.count != 0 || cell.key_sum != 0 || cell.check_sum != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Iblt::serialize() const {
+    std::string out;
+    out.reserve(cells_.size() * 40);
+    char buf[41];
+    for (const auto& cell : cells_) {
+        std::snprintf(buf, sizeof(buf), "%08x%016llx%016llx",
+                      static_cast<uint32_t>(cell.count),
+                      static_cast<unsigned long long>(cell.key_sum),
+                      static_cast<unsigned long long>(cell.check_sum));
+        out.append(buf, 40);
+    }
+    return out;
+}
+
+bool Iblt::deserialize(const std::string& data, Iblt& out) {
+    if (data.size() % 40 != 0 || data.empty()) return false;
+    size_t count = data.size() / 40;
+    if (count % HASH_COUNT != 0) return false;
+
+    Iblt table(count);
+    for (size_t i = 0; i < count; ++i) {
+        const std::string chunk = data.substr(i * 40, 40);
+        try {
+            table.cells_[i].count = static_cast<int32_t>(std::stoul(chunk.substr(0, 8), nullptr, 16));
+            table.cells_[i].key_sum = std::stoull(chunk.substr(8, 16), nullptr, 16);
+            table.cells_[i].check_sum = std::stoull(chunk.substr(24, 16), nullptr, 16);
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    out = std::move(table);
+    return true;
+}
+
+} // namespace nexus
@@ -0,0 +1,52 @@
+// src/network/iblt.h
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace nexus {
+
+// Invertible Bloom Lookup Table над 64-битными короткими идентификаторами.
+// Разность двух таблиц одинакового размера декодируется в симметричную
+// разность множеств, если она не превышает ~cells/1.5 элементов.
+class Iblt {
+public:
+    static constexpr int HASH_COUNT = 3;
+
+    explicit Iblt(size_t cells);
+
+    void insert(uint64_t id) { update(id, 1); }
+    void erase(uint64_t id) { update(id, -1); }
+
+    // this - other; таблицы должны иметь одинаковый размер
+    Iblt subtract(const Iblt& other) const;
+
+    // Пиковое декодирование: ids_only_here — есть в уменьшаемом, ids_only_there — в вычитаемом.
+    // Возвращает false, если таблица переполнена и разность не восстановить целиком.
+    bool decode(std::vector<uint64_t>& ids_only_here, std::vector<uint64_t>& ids_only_there) const;
+
+    size_t cell_count() const { return cells_.size(); }
+
+    // Короткий 64-битный id из hex-хэша транзакции, перемешанный с солью сессии
+    static uint64_t short_id(const std::string& hex_hash, uint64_t salt);
+
+    // Компактная hex-сериализация для передачи в сообщениях
+    std::string serialize() const;
+    static bool deserialize(const std::string& data, Iblt& out);
+
+private:
+    struct Cell {
+        int32_t count = 0;
+        uint64_t key_sum = 0;
+        uint64_t check_sum = 0;
+    };
+
+    void update(uint64_t id, int32_t delta);
+    size_t cell_index(uint64_t id, int i) const;
+    static uint64_t check_hash(uint64_t id);
+    static bool is_pure(const Cell& cell);
+
+    std::vector<Cell> cells_;
+};
+
+} // namespace nexus
@@ -0,0 +1,167 @@
+// src/network/mempool_sync.cpp
+#include "mempool_sync.h"
+#include "../logging/logger.h"
+#include <algorithm>
+#include <cstdio>
+
+namespace nexus {
+
+namespace {
+
+std::string to_hex(uint64_t v) {
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(v));
+    return buf;
+}
+
+} // namespace
+
+MempoolReconciler::MempoolReconciler(const std::string& node_id, TxRelay& relay)
+    : node_id_(node_id), relay_(relay) {
+}
+
+std::unordered_map<uint64_t, std::string> MempoolReconciler::short_ids(uint64_t salt) const {
+    std::unordered_map<uint64_t, std::string> ids;
+    if (!mempool_provider_) return ids;
+    for (auto& hash : mempool_provider_()) {
+        ids.emplace(Iblt::short_id(hash, salt), std::move(hash));
+    }
+    return ids;
+}
+
+void MempoolReconciler::start(std::shared_ptr<Peer> peer) {
+    if (!peer || !peer->is_connected() || !send_handler_) return;
+
+    expire_sessions();
+    // Соль новая на каждую сессию, чтобы коллизии коротких id не повторялись
+    Session session{rng_(), MIN_CELLS, std::chrono::steady_clock::now()};
+    sessions_[peer] = session;
+    send_sketch(peer, session);
+}
+
+void MempoolReconciler::peer_disconnected(const std::shared_ptr<Peer>& peer) {
+    sessions_.erase(peer);
+}
+
+void MempoolReconciler::expire_sessions() {
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+        if (it->first.expired() || now - it->second.sent_at >= SESSION_TIMEOUT) {
+            it = sessions_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void MempoolReconciler::send_sketch(std::shared_ptr<Peer> peer, const Session& session) {
+    auto ids = short_ids(session.salt);
+    Iblt table(session.cells);
+    for (const auto& [id, hash] : ids) {
+        table.insert(id);
+    }
+
+    Message msg(MessageType::RECON_SKETCH);
+    msg.sender_id = node_id_;
+    msg.payload = {
+        {"salt", to_hex(session.salt)},
+        {"count", ids.size()},
+        {"final", session.cells >= MAX_CELLS},
+        {"sketch", table.serialize()}
+    };
+    send_handler_(msg, peer);
+}
+
+void MempoolReconciler::handle_sketch(std::shared_ptr<Peer> peer, const nlohmann::json& payload) {
+    Iblt theirs(1);
+    if (!Iblt::deserialize(payload.value("sketch", ""), theirs) || theirs.cell_count() > MAX_CELLS) {
+        return;
+    }
+    uint64_t salt = std::stoull(payload.value("salt", "0"), nullptr, 16);
+
+    auto ids = short_ids(salt);
+    Iblt mine(theirs.cell_count());
+    for (const auto& [id, hash] : ids) {
+        mine.insert(id);
+    }
+
+    std::vector<uint64_t> only_theirs, only_mine;
+    Message reply(MessageType::RECON_DIFF);
+    reply.sender_id = node_id_;
+
+    if (!theirs.subtract(mine).decode(only_theirs, only_mine)) {
+        if (payload.value("final", false)) {
+            // Скетч максимального размера не декодируется: анонсируем весь mempool хэшами
+            std::vector<std::string> all;
+            for (const auto& [id, hash] : ids) all.push_back(hash);
+            relay_.announce_to(peer, all);
+        }
+        reply.payload = {{"ok", false}, {"count", ids.size()}};
+        send_handler_(reply, peer);
+        return;
+    }
+
+    std::vector<std::string> to_announce;
+    for (uint64_t id : only_mine) {
+        auto it = ids.find(id);
+        if (it != ids.end()) to_announce.push_back(it->second);
+    }
+    relay_.announce_to(peer, to_announce);
+
+    nlohmann::json want = nlohmann::json::array();
+    for (uint64_t id : only_theirs) {
+        want.push_back(to_hex(id));
+    }
+    reply.payload = {{"ok", true}, {"want", want}};
+    send_handler_(reply, peer);
+
+    if (!to_announce.empty() || !only_theirs.empty()) {
+        LOG_DEBUG(NET, "Mempool reconciliation")
+            .kv("peer", peer->get_endpoint()).kv("sending", to_announce.size()).kv("missing", only_theirs.size());
+    }
+}
+
+void MempoolReconciler::handle_diff(std::shared_ptr<Peer> peer, const nlohmann::json& payload) {
+    auto it = sessions_.find(peer);
+    if (it == sessions_.end()) return;
+    if (std::chrono::steady_clock::now() - it->second.sent_at >= SESSION_TIMEOUT) {
+        sessions_.erase(it);
+        return;
+    }
+    Session session = it->second;
+
+    if (!payload.value("ok", false)) {
+        if (session.cells >= MAX_CELLS) {
+            // Последняя попытка не удалась: ответчик уже анонсировал всё, отвечаем тем же
+            sessions_.erase(it);
+            std::vector<std::string> all;
+            for (const auto& [id, hash] : short_ids(session.salt)) all.push_back(hash);
+            relay_.announce_to(peer, all);
+            return;
+        }
+        // Разность больше ёмкости таблицы: увеличиваем с учётом разницы размеров mempool
+        size_t their_count = payload.value("count", 0);
+        size_t my_count = short_ids(session.salt).size();
+        size_t size_gap = their_count > my_count ? their_count - my_count : my_count - their_count;
+        session.cells = std::min(MAX_CELLS, std::max(session.cells * 2, size_gap * 3 / 2 + MIN_CELLS));
+        session.salt = rng_();
+        session.sent_at = std::chrono::steady_clock::now();
+        it->second = session;
+        send_sketch(peer, session);
+        return;
+    }
+
+    sessions_.erase(it);
+    if (!payload.contains("want") || !payload["want"].is_array()) return;
+
+    auto ids = short_ids(session.salt);
+    std::vector<std::string> to_announce;
+    for (const auto& w : payload["want"]) {
+        if (!w.is_string()) continue;
+        auto found = ids.find(std::stoull(w.get<std::string>(), nullptr, 16));
+        if (found != ids.end()) to_announce.push_back(found->second);
+    }
+    relay_.announce_to(peer, to_announce);
+}
+
+} // namespace nexus
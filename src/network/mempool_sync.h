@@ -0,0 +1,69 @@
+// src/network/mempool_sync.h
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "peer.h"
+#include "message.h"
+#include "iblt.h"
+#include "tx_relay.h"
+
+namespace nexus {
+
+// Периодическая сверка mempool двух пиров через IBLT-скетчи.
+// Инициатор шлёт скетч своих коротких id (RECON_SKETCH), ответчик вычитает
+// свой скетч, декодирует разность, анонсирует свои недостающие у инициатора
+// транзакции и возвращает id, которых не хватает ему (RECON_DIFF).
+// Трафик пропорционален размеру разности, а не размеру mempool.
+// Все методы вызываются из io-потока узла.
+class MempoolReconciler {
+public:
+    using SendHandler = std::function<void(const Message&, std::shared_ptr<Peer>)>;
+    using MempoolProvider = std::function<std::vector<std::string>()>;
+
+    static constexpr size_t MIN_CELLS = 48;
+    static constexpr size_t MAX_CELLS = 6144;
+    // Сессия без ответа RECON_DIFF на последний скетч дольше этого срока забывается
+    static constexpr std::chrono::seconds SESSION_TIMEOUT{30};
+
+    MempoolReconciler(const std::string& node_id, TxRelay& relay);
+
+    void set_send_handler(SendHandler handler) { send_handler_ = std::move(handler); }
+    void set_mempool_provider(MempoolProvider provider) { mempool_provider_ = std::move(provider); }
+
+    // Начать сверку с пиром (инициатор)
+    void start(std::shared_ptr<Peer> peer);
+
+    void handle_sketch(std::shared_ptr<Peer> peer, const nlohmann::json& payload);
+    void handle_diff(std::shared_ptr<Peer> peer, const nlohmann::json& payload);
+
+    // Пир отключён: его сессия больше не нужна
+    void peer_disconnected(const std::shared_ptr<Peer>& peer);
+
+private:
+    struct Session {
+        uint64_t salt;
+        size_t cells;
+        std::chrono::steady_clock::time_point sent_at;
+    };
+
+    void send_sketch(std::shared_ptr<Peer> peer, const Session& session);
+    std::unordered_map<uint64_t, std::string> short_ids(uint64_t salt) const;
+    void expire_sessions();
+
+    std::string node_id_;
+    TxRelay& relay_;
+    SendHandler send_handler_;
+    MempoolProvider mempool_provider_;
+    std::mt19937_64 rng_{std::random_device{}()};
+    // По weak_ptr: новый пир по адресу отключённого не примет его сессию
+    std::map<std::weak_ptr<Peer>, Session, std::owner_less<std::weak_ptr<Peer>>> sessions_;
+};
+
+} // namespace nexus
@@ -18,6 +18,14 @@ enum class MessageType {
     NEW_BLOCK = 8,
     SYNC_REQUEST = 9,
     SYNC_RESPONSE = 10,
+    INV = 11,          // Анонс хэшей транзакций
+    GET_DATA = 12,     // Запрос полных транзакций по хэшам
+    RECON_SKETCH = 13, // IBLT-скетч mempool для сверки множеств
+    RECON_DIFF = 14,   // Результат сверки: недостающие у отвечающего id
+    GET_SNAPSHOT = 15,        // Запрос манифеста снимка состояния
+    SNAPSHOT_MANIFEST = 16,   // Манифест: высота, хэши частей, обязательство
+    GET_SNAPSHOT_CHUNK = 17,  // Часть снимка: заголовки или счета по номеру
+    SNAPSHOT_CHUNK = 18,
     ERROR = 99
 };
 
@@ -35,6 +43,14 @@ inline std::string message_type_to_string(MessageType type) {
         case MessageType::NEW_BLOCK: return "NEW_BLOCK";
         case MessageType::SYNC_REQUEST: return "SYNC_REQUEST";
         case MessageType::SYNC_RESPONSE: return "SYNC_RESPONSE";
+        case MessageType::INV: return "INV";
+        case MessageType::GET_DATA: return "GET_DATA";
+        case MessageType::RECON_SKETCH: return "RECON_SKETCH";
+        case MessageType::RECON_DIFF: return "RECON_DIFF";
+        case MessageType::GET_SNAPSHOT: return "GET_SNAPSHOT";
+        case MessageType::SNAPSHOT_MANIFEST: return "SNAPSHOT_MANIFEST";
+        case MessageType::GET_SNAPSHOT_CHUNK: return "GET_SNAPSHOT_CHUNK";
+        case MessageType::SNAPSHOT_CHUNK: return "SNAPSHOT_CHUNK";
         default: return "UNKNOWN";
     }
 }
@@ -80,15 +96,22 @@ struct Message {
         return msg;
     }
     
-    static Message create_ping(const std::string& node_id) {
+    // nonce связывает PONG с конкретным PING для измерения RTT
+    static Message create_ping(const std::string& node_id, uint64_t nonce = 0) {
         Message msg(MessageType::PING);
         msg.sender_id = node_id;
+        if (nonce != 0) {
+            msg.payload = {{"nonce", nonce}};
+        }
         return msg;
     }
     
-    static Message create_pong(const std::string& node_id) {
+    static Message create_pong(const std::string& node_id, uint64_t nonce = 0) {
         Message msg(MessageType::PONG);
         msg.sender_id = node_id;
+        if (nonce != 0) {
+            msg.payload = {{"nonce", nonce}};
+        }
         return msg;
     }
     
@@ -125,6 +148,21 @@ struct Message {
         return msg;
     }
     
+    // Пакетный анонс: только хэши, полные транзакции запрашиваются через GET_DATA
+    static Message create_inv(const std::string& node_id, const std::vector<std::string>& hashes) {
+        Message msg(MessageType::INV);
+        msg.sender_id = node_id;
+        msg.payload = {{"hashes", hashes}};
+        return msg;
+    }
+    
+    static Message create_get_data(const std::string& node_id, const std::vector<std::string>& hashes) {
+        Message msg(MessageType::GET_DATA);
+        msg.sender_id = node_id;
+        msg.payload = {{"hashes", hashes}};
+        return msg;
+    }
+    
     static Message create_new_block(const std::string& node_id, const nlohmann::json& block_json) {
         Message msg(MessageType::NEW_BLOCK);
         msg.sender_id = node_id;
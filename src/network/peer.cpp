@@ -1,15 +1,24 @@
 // src/network/peer.cpp
 #include "peer.h"
-#include <iostream>
+#include "traffic_capture.h"
+#include "../logging/logger.h"
 
 namespace nexus {
 
 Peer::Peer(boost::asio::io_context& io_context)
     : p2p_port(0),
+      pruned_height(0),
       state(PeerState::DISCONNECTED),
       socket(std::make_unique<boost::asio::ip::tcp::socket>(io_context)),
       last_seen(0),
-      failed_attempts(0) {
+      failed_attempts(0),
+      inbound(false),
+      known_txs(5000, 0.000001),
+      known_blocks(1000, 0.000001),
+      inv_queue_bytes(0),
+      trickle_scheduled(false),
+      trickle_generation(0),
+      trickle_timer(std::make_unique<boost::asio::steady_timer>(io_context)) {
 }
 
 Peer::~Peer() {
@@ -18,7 +27,7 @@ Peer::~Peer() {
 
 void Peer::connect(const std::string& addr, int port) {
     if (state != PeerState::DISCONNECTED) {
-        std::cout << "Peer already connecting, ignoring connect request" << std::endl;
+        LOG_DEBUG(NET, "Peer already connecting, ignoring connect request");
         return;
     }
     
@@ -26,7 +35,7 @@ void Peer::connect(const std::string& addr, int port) {
     this->port = port;
     state = PeerState::CONNECTING;
     
-    std::cout << "Connecting to " << addr << ":" << port << "..." << std::endl;
+    LOG_DEBUG(NET, "Connecting").kv("address", addr).kv("port", port);
     
     // Копируем нужные значения для лямбды
     std::string target_addr = addr;
@@ -42,23 +51,26 @@ void Peer::connect(const std::string& addr, int port) {
             if (!error) {
                 state = PeerState::CONNECTED;
                 last_seen = time(nullptr);
-                std::cout << "Connected to " << target_addr << ":" << target_port << std::endl;
+                LOG_INFO(NET, "Connected").kv("address", target_addr).kv("port", target_port);
             } else {
                 state = PeerState::DISCONNECTED;
                 failed_attempts++;
-                std::cout << "Failed to connect to " << target_addr << ":" << target_port 
-                          << " - " << error.message() << std::endl;
+                LOG_INFO(NET, "Failed to connect")
+                    .kv("address", target_addr).kv("port", target_port).kv("error", error.message());
             }
         });
 }
 
 void Peer::disconnect() {
+    if (trickle_timer) {
+        trickle_timer->cancel();
+    }
     if (socket && socket->is_open()) {
         boost::system::error_code ec;
         socket->close(ec);
     }
     state = PeerState::DISCONNECTED;
-    std::cout << "Disconnected from " << get_endpoint() << std::endl;
+    LOG_INFO(NET, "Disconnected").kv("peer", get_endpoint());
 }
 
 bool Peer::is_connected() const {
@@ -70,23 +82,41 @@ std::string Peer::get_endpoint() const {
     return address + ":" + std::to_string(port);
 }
 
-void Peer::send(const std::string& data) {
+void Peer::send(MessageType type, const std::string& data) {
     if (!is_connected()) {
-        std::cout << "Cannot send to " << get_endpoint() << " - not connected" << std::endl;
+        LOG_DEBUG(NET, "Cannot send, not connected").kv("peer", get_endpoint());
         return;
     }
     
-    std::string message = data + "\n";
-    std::cout << "Sending to " << get_endpoint() << ": " << data.substr(0, 100) << "..." << std::endl;
+    LOG_TRACE(NET, "Sending").kv("peer", get_endpoint()).kv("type", static_cast<int>(type)).kv("bytes", data.size());
     
-    boost::asio::async_write(*socket, boost::asio::buffer(message),
-        [this](const boost::system::error_code& error, size_t bytes) {
+    // Параллельные async_write в один сокет перемешивают байты сообщений,
+    // поэтому пишем строго по очереди
+    write_queue_.push_back(data + "\n");
+    stats.record_sent(type, write_queue_.back().size());
+    stats.queue_changed(write_queue_.size());
+    if (write_queue_.size() == 1) {
+        write_next();
+    }
+}
+
+void Peer::write_next() {
+    auto self = shared_from_this();
+    boost::asio::async_write(*socket, boost::asio::buffer(write_queue_.front()),
+        [this, self](const boost::system::error_code& error, size_t bytes) {
             if (error) {
-                std::cout << "Send error to " << get_endpoint() << ": " << error.message() << std::endl;
+                LOG_WARN(NET, "Send error").kv("peer", get_endpoint()).kv("error", error.message());
+                write_queue_.clear();
+                stats.queue_changed(0);
                 disconnect();
-            } else {
-                std::cout << "Sent " << bytes << " bytes to " << get_endpoint() << std::endl;
-                last_seen = time(nullptr);
+                return;
+            }
+            LOG_TRACE(NET, "Sent").kv("peer", get_endpoint()).kv("bytes", bytes);
+            last_seen = time(nullptr);
+            write_queue_.pop_front();
+            stats.queue_changed(write_queue_.size());
+            if (!write_queue_.empty()) {
+                write_next();
             }
         });
 }
@@ -98,9 +128,9 @@ void Peer::read(std::function<void(const std::string&)> callback) {
     boost::asio::async_read_until(*socket, read_buffer_, '\n',
         [this, callback, self](const boost::system::error_code& error, size_t bytes) {
             if (!error) {
-                std::string data;
-                std::istream is(&read_buffer_);
-                std::getline(is, data);
+                // Берём ровно одну строку: в буфере уже могут лежать следующие сообщения
+                auto begin = boost::asio::buffers_begin(read_buffer_.data());
+                std::string data(begin, begin + bytes);
                 read_buffer_.consume(bytes);
 
                 // Очистка от лишних символов
@@ -113,12 +143,15 @@ void Peer::read(std::function<void(const std::string&)> callback) {
 
                 if (!data.empty()) {
                     last_seen = time(nullptr);
+                    if (auto* capture = TrafficCapture::active()) {
+                        capture->record(CaptureSource::P2P, get_endpoint(), data);
+                    }
                     callback(data);
                 }
                 // Продолжаем читать
                 read(callback);
             } else if (error != boost::asio::error::operation_aborted) {
-                std::cout << "❌ Read error: " << error.message() << std::endl;
+                LOG_DEBUG(NET, "Read error").kv("peer", get_endpoint()).kv("error", error.message());
                 disconnect();
             }
         });
@@ -3,7 +3,13 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <vector>
+#include <deque>
 #include <boost/asio.hpp>
+#include "rolling_bloom.h"
+#include "peer_score.h"
+#include "peer_stats.h"
+#include "message.h"
 
 namespace nexus {
 
@@ -22,10 +28,23 @@ public:
     std::string address;
     int port;
     int p2p_port;
+    int pruned_height;             // Из HANDSHAKE: тел блоков 1..этой высоты у пира нет
     PeerState state;
     std::unique_ptr<boost::asio::ip::tcp::socket> socket;
     time_t last_seen;
     int failed_attempts;
+    bool inbound;                  // Соединение принято нашим сервером
+    RollingBloomFilter known_txs;  // Хэши, которые пир уже знает (не анонсируем повторно)
+    RollingBloomFilter known_blocks;  // Блоки, которые пир прислал или получил от нас
+    PeerScore score;               // Качество пира по живым наблюдениям
+    PeerStats stats;               // Трафик, очередь отправки, RTT
+    
+    // Очередь исходящих анонсов, сбрасывается одним INV по таймеру или по объёму
+    std::vector<std::string> inv_queue;
+    size_t inv_queue_bytes;
+    bool trickle_scheduled;
+    uint64_t trickle_generation;   // Меняется при каждом взводе и отмене таймера
+    std::unique_ptr<boost::asio::steady_timer> trickle_timer;
     
     explicit Peer(boost::asio::io_context& io_context);
     ~Peer();
@@ -37,7 +56,8 @@ public:
     bool is_ready() const { return state == PeerState::READY; }
     
     // Отправка/получение данных
-    void send(const std::string& data);
+    void send(const Message& msg) { send(msg.type, msg.serialize()); }
+    void send(MessageType type, const std::string& data);
     void read(std::function<void(const std::string&)> callback);
     
     // Вспомогательные методы
@@ -45,7 +65,10 @@ public:
     void update_last_seen() { last_seen = time(nullptr); }
     
 private:
+    void write_next();
+
     boost::asio::streambuf read_buffer_;
+    std::deque<std::string> write_queue_;  // Одновременно в сокете только одна async_write
 };
 
 } // namespace nexus
\ No newline at end of file
@@ -0,0 +1,95 @@
+// src/network/peer_score.cpp
+#include "peer_score.h"
+#include "peer.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <cstdio>
+#include <boost/asio/ip/address.hpp>
+
+namespace nexus {
+
+namespace {
+
+constexpr time_t PROTECT_NEW_SECONDS = 60;  // Новичок ещё не успел себя показать
+constexpr size_t PROTECT_BEST = 4;
+
+double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+void PeerScore::blocks_received() {
+    if (blocks_requested_at == std::chrono::steady_clock::time_point{}) return;
+    record_block_delivery(elapsed_ms(blocks_requested_at));
+    blocks_requested_at = {};
+}
+
+void PeerScore::record_latency(double ms) {
+    latency_ms = latency_ms == 0 ? ms : latency_ms + EWMA_ALPHA * (ms - latency_ms);
+}
+
+void PeerScore::record_block_delivery(double ms) {
+    block_delivery_ms = block_delivery_ms == 0 ? ms : block_delivery_ms + EWMA_ALPHA * (ms - block_delivery_ms);
+}
+
+double PeerScore::value() const {
+    double score = 50;
+    // Без измерений штраф средний, чтобы новые пиры не проигрывали заведомо
+    score -= latency_ms > 0 ? std::min(latency_ms / 20.0, 25.0) : 10.0;
+    score -= block_delivery_ms > 0 ? std::min(block_delivery_ms / 100.0, 25.0) : 10.0;
+    score += std::min(std::log2(1.0 + bytes_served / 1024.0) * 2.0, 30.0);
+    score -= invalid_messages * 10.0;
+    return score;
+}
+
+std::string network_group(const std::string& ip) {
+    boost::system::error_code ec;
+    auto addr = boost::asio::ip::make_address(ip, ec);
+    if (ec) return "unroutable";
+    if (addr.is_loopback()) return "local";
+    if (addr.is_v4()) {
+        auto bytes = addr.to_v4().to_bytes();
+        return std::to_string(bytes[0]) + "." + std::to_string(bytes[1]);
+    }
+    auto v6 = addr.to_v6();
+    if (v6.is_v4_mapped()) {
+        auto bytes = boost::asio::ip::make_address_v4(boost::asio::ip::v4_mapped, v6).to_bytes();
+        return std::to_string(bytes[0]) + "." + std::to_string(bytes[1]);
+    }
+    auto bytes = v6.to_bytes();
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "%02x%02x:%02x%02x", bytes[0], bytes[1], bytes[2], bytes[3]);
+    return buf;
+}
+
+std::shared_ptr<Peer> select_eviction_candidate(const std::vector<std::shared_ptr<Peer>>& inbound, time_t now) {
+    std::vector<std::shared_ptr<Peer>> candidates;
+    for (const auto& peer : inbound) {
+        if (peer && peer->is_connected() && now - peer->score.connected_at >= PROTECT_NEW_SECONDS) {
+            candidates.push_back(peer);
+        }
+    }
+
+    std::sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) {
+        return a->score.value() > b->score.value();
+    });
+    if (candidates.size() <= PROTECT_BEST) return nullptr;
+    candidates.erase(candidates.begin(), candidates.begin() + PROTECT_BEST);
+
+    // Самая многочисленная группа: так атакующему из одной подсети
+    // не удастся вытеснить разнообразных честных пиров
+    std::map<std::string, std::vector<std::shared_ptr<Peer>>> groups;
+    for (const auto& peer : candidates) {
+        groups[network_group(peer->address)].push_back(peer);
+    }
+    const std::vector<std::shared_ptr<Peer>>* largest = nullptr;
+    for (const auto& [group, peers] : groups) {
+        if (!largest || peers.size() > largest->size()) largest = &peers;
+    }
+    // Кандидаты отсортированы по убыванию оценки, последний в группе — худший
+    return largest->back();
+}
+
+} // namespace nexus
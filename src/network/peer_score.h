@@ -0,0 +1,49 @@
+// src/network/peer_score.h
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+
+namespace nexus {
+
+class Peer;
+
+// Живая оценка качества пира: задержка, скорость доставки блоков,
+// объём полезных данных и число некорректных сообщений.
+// Используется для выбора источника синхронизации и вытеснения входящих пиров.
+struct PeerScore {
+    static constexpr double EWMA_ALPHA = 0.3;
+
+    double latency_ms{0};         // Сглаженный RTT по PING/PONG
+    double block_delivery_ms{0};  // Сглаженное время от GET_BLOCKS до BLOCKS_RESPONSE
+    uint64_t bytes_served{0};     // Принятые от пира блоки и новые транзакции
+    uint32_t invalid_messages{0};
+    time_t connected_at{0};
+
+    std::chrono::steady_clock::time_point blocks_requested_at{};
+
+    void blocks_requested() { blocks_requested_at = std::chrono::steady_clock::now(); }
+    void blocks_received();
+
+    void record_latency(double ms);
+    void record_block_delivery(double ms);
+    void record_served(size_t bytes) { bytes_served += bytes; }
+    void record_invalid() { invalid_messages++; }
+
+    // Итоговая оценка: больше — лучше. Пир без измерений получает нейтральные 50
+    double value() const;
+};
+
+// Сетевая группа адреса (/16 для IPv4, /32 для IPv6): пиры из одной группы
+// считаются одним источником при раскладке по бакетам и вытеснении
+std::string network_group(const std::string& ip);
+
+// Кандидат на вытеснение, когда входящие слоты заняты. Защищены недавно
+// подключившиеся и несколько лучших по оценке; из остальных выбирается
+// худший пир самой многочисленной сетевой группы. nullptr — вытеснять некого.
+std::shared_ptr<Peer> select_eviction_candidate(const std::vector<std::shared_ptr<Peer>>& inbound, time_t now);
+
+} // namespace nexus
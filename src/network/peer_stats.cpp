@@ -0,0 +1,95 @@
+// src/network/peer_stats.cpp
+#include "peer_stats.h"
+#include <algorithm>
+
+namespace nexus {
+
+namespace {
+
+double ms_since(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+void PeerStats::record_sent(MessageType type, size_t bytes) {
+    auto& c = sent[slot(type)];
+    c.messages++;
+    c.bytes += bytes;
+}
+
+void PeerStats::record_received(MessageType type, size_t bytes) {
+    auto& c = received[slot(type)];
+    c.messages++;
+    c.bytes += bytes;
+}
+
+uint64_t PeerStats::total_bytes_sent() const {
+    uint64_t total = 0;
+    for (const auto& c : sent) total += c.bytes;
+    return total;
+}
+
+uint64_t PeerStats::total_bytes_received() const {
+    uint64_t total = 0;
+    for (const auto& c : received) total += c.bytes;
+    return total;
+}
+
+void PeerStats::queue_changed(size_t depth) {
+    if (send_queue_depth == 0 && depth > 0) {
+        queue_busy_since_ = std::chrono::steady_clock::now();
+    } else if (send_queue_depth > 0 && depth == 0) {
+        send_stall_ms += ms_since(queue_busy_since_);
+    }
+    send_queue_depth = depth;
+    max_send_queue_depth = std::max(max_send_queue_depth, depth);
+}
+
+double PeerStats::current_stall_ms() const {
+    return send_stall_ms + (send_queue_depth > 0 ? ms_since(queue_busy_since_) : 0.0);
+}
+
+void PeerStats::ping_sent(uint64_t nonce) {
+    if (pending_pings_.size() >= MAX_PENDING_PINGS) {
+        pending_pings_.pop_front();  // Ответа уже не ждём
+    }
+    pending_pings_.emplace_back(nonce, std::chrono::steady_clock::now());
+}
+
+std::optional<double> PeerStats::pong_received(uint64_t nonce) {
+    auto it = std::find_if(pending_pings_.begin(), pending_pings_.end(),
+                           [nonce](const auto& p) { return p.first == nonce; });
+    if (it == pending_pings_.end()) return std::nullopt;
+    double rtt = ms_since(it->second);
+    // Более ранние пинги без ответа считаем потерянными
+    pending_pings_.erase(pending_pings_.begin(), it + 1);
+    last_rtt_ms = rtt;
+    min_rtt_ms = min_rtt_ms == 0 ? rtt : std::min(min_rtt_ms, rtt);
+    return rtt;
+}
+
+nlohmann::json PeerStats::to_json() const {
+    nlohmann::json messages = nlohmann::json::object();
+    for (size_t i = 0; i < TYPE_SLOTS; ++i) {
+        if (sent[i].messages == 0 && received[i].messages == 0) continue;
+        messages[slot_name(i)] = {
+            {"sent", sent[i].messages},
+            {"sent_bytes", sent[i].bytes},
+            {"received", received[i].messages},
+            {"received_bytes", received[i].bytes}
+        };
+    }
+    return {
+        {"bytes_sent", total_bytes_sent()},
+        {"bytes_received", total_bytes_received()},
+        {"send_queue_depth", send_queue_depth},
+        {"max_send_queue_depth", max_send_queue_depth},
+        {"send_stall_ms", current_stall_ms()},
+        {"rtt_ms", last_rtt_ms},
+        {"min_rtt_ms", min_rtt_ms},
+        {"messages", messages}
+    };
+}
+
+} // namespace nexus
@@ -0,0 +1,64 @@
+// src/network/peer_stats.h
+#pragma once
+#include <array>
+#include <deque>
+#include <chrono>
+#include <optional>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include "message.h"
+
+namespace nexus {
+
+// Телеметрия соединения с пиром: сообщения и байты по типам в обе стороны,
+// глубина очереди отправки и время, когда сокет не успевал за очередью,
+// а также RTT по PING/PONG с nonce. Обновляется только из io-потока.
+struct PeerStats {
+    // Типы 0..18 получают свой слот, всё остальное (ERROR, неизвестные) — последний
+    static constexpr size_t TYPE_SLOTS = 20;
+    static constexpr size_t MAX_PENDING_PINGS = 8;
+
+    struct Counters {
+        uint64_t messages{0};
+        uint64_t bytes{0};
+    };
+
+    std::array<Counters, TYPE_SLOTS> sent{};
+    std::array<Counters, TYPE_SLOTS> received{};
+
+    size_t send_queue_depth{0};
+    size_t max_send_queue_depth{0};
+    double send_stall_ms{0};  // Суммарное время с непустой очередью отправки
+
+    double last_rtt_ms{0};
+    double min_rtt_ms{0};
+
+    static size_t slot(MessageType type) {
+        int t = static_cast<int>(type);
+        return t >= 0 && t < static_cast<int>(TYPE_SLOTS) - 1 ? static_cast<size_t>(t) : TYPE_SLOTS - 1;
+    }
+    static std::string slot_name(size_t slot) {
+        return slot == TYPE_SLOTS - 1 ? "OTHER" : message_type_to_string(static_cast<MessageType>(slot));
+    }
+
+    void record_sent(MessageType type, size_t bytes);
+    void record_received(MessageType type, size_t bytes);
+    uint64_t total_bytes_sent() const;
+    uint64_t total_bytes_received() const;
+
+    // Очередь отправки: вызывается при каждом изменении её длины
+    void queue_changed(size_t depth);
+    double current_stall_ms() const;
+
+    void ping_sent(uint64_t nonce);
+    // RTT в мс, если nonce ожидался (чужие и просроченные PONG игнорируются)
+    std::optional<double> pong_received(uint64_t nonce);
+
+    nlohmann::json to_json() const;
+
+private:
+    std::chrono::steady_clock::time_point queue_busy_since_{};
+    std::deque<std::pair<uint64_t, std::chrono::steady_clock::time_point>> pending_pings_;
+};
+
+} // namespace nexus
@@ -0,0 +1,80 @@
+// src/network/rolling_bloom.cpp
+#include "rolling_bloom.h"
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+namespace nexus {
+
+RollingBloomFilter::RollingBloomFilter(size_t elements, double fp_rate) {
+    // Каждое поколение хранит половину окна, поиск идёт по всем трём,
+    // поэтому вероятность ложного срабатывания делим между поколениями
+    generation_capacity_ = std::max<size_t>(1, (elements + 1) / 2);
+    double per_generation_fp = fp_rate / GENERATIONS;
+    double ln2 = std::log(2.0);
+    double bits = -static_cast<double>(generation_capacity_) * std::log(per_generation_fp) / (ln2 * ln2);
+    bits_per_generation_ = std::max<size_t>(64, static_cast<size_t>(std::ceil(bits)));
+    bits_per_generation_ = (bits_per_generation_ + 63) / 64 * 64;
+    hash_count_ = std::clamp(static_cast<int>(std::round(bits / generation_capacity_ * ln2)), 1, 32);
+
+    std::random_device rd;
+    tweak_ = (static_cast<uint64_t>(rd()) << 32) | rd();
+
+    generations_.assign(GENERATIONS, std::vector<uint64_t>(bits_per_generation_ / 64, 0));
+}
+
+void RollingBloomFilter::hash_pair(const std::string& key, uint64_t& h1, uint64_t& h2) const {
+    // FNV-1a с солью узла, второй хэш получаем перемешиванием первого
+    uint64_t h = 14695981039346656037ULL ^ tweak_;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h1 = h;
+    uint64_t z = h + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    h2 = (z ^ (z >> 31)) | 1;
+}
+
+void RollingBloomFilter::insert(const std::string& key) {
+    if (current_count_ >= generation_capacity_) {
+        // Переходим к следующему поколению, стирая самое старое
+        current_ = (current_ + 1) % GENERATIONS;
+        std::fill(generations_[current_].begin(), generations_[current_].end(), 0);
+        current_count_ = 0;
+    }
+
+    uint64_t h1, h2;
+    hash_pair(key, h1, h2);
+    auto& bits = generations_[current_];
+    for (int i = 0; i < hash_count_; ++i) {
+        size_t bit = (h1 + i * h2) % bits_per_generation_;
+        bits[bit / 64] |= (1ULL << (bit % 64));
+    }
+    current_count_++;
+}
+
+bool RollingBloomFilter::contains(const std::string& key) const {
+    uint64_t h1, h2;
+    hash_pair(key, h1, h2);
+    for (const auto& bits : generations_) {
+        bool found = true;
+        for (int i = 0; i < hash_count_ && found; ++i) {
+            size_t bit = (h1 + i * h2) % bits_per_generation_;
+            found = (bits[bit / 64] >> (bit % 64)) & 1ULL;
+        }
+        if (found) return true;
+    }
+    return false;
+}
+
+void RollingBloomFilter::reset() {
+    for (auto& bits : generations_) {
+        std::fill(bits.begin(), bits.end(), 0);
+    }
+    current_ = 0;
+    current_count_ = 0;
+}
+
+} // namespace nexus
@@ -0,0 +1,34 @@
+// src/network/rolling_bloom.h
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace nexus {
+
+// Bloom-фильтр "скользящего окна": помнит как минимум последние `elements`
+// вставленных ключей, более старые постепенно забываются сменой поколений.
+// Используется для подавления повторной рассылки уже виденных хэшей.
+class RollingBloomFilter {
+public:
+    RollingBloomFilter(size_t elements, double fp_rate);
+
+    void insert(const std::string& key);
+    bool contains(const std::string& key) const;
+    void reset();
+
+private:
+    static constexpr int GENERATIONS = 3;
+
+    void hash_pair(const std::string& key, uint64_t& h1, uint64_t& h2) const;
+
+    size_t generation_capacity_;
+    size_t bits_per_generation_;
+    int hash_count_;
+    uint64_t tweak_;
+    int current_{0};
+    size_t current_count_{0};
+    std::vector<std::vector<uint64_t>> generations_;
+};
+
+} // namespace nexus
@@ -1,13 +1,13 @@
 // src/network/server.cpp
 #include "server.h"
-#include <iostream>
+#include "../logging/logger.h"
 
 namespace nexus {
 
 Server::Server(boost::asio::io_context& io_context, int port)
     : io_context_(io_context),
       acceptor_(io_context, boost::asio::ip::tcp::endpoint(boost::asio::ip::tcp::v4(), port)) {
-    std::cout << "Server listening on port " << port << std::endl;
+    LOG_INFO(NET, "Server listening").kv("port", port);
 }
 
 Server::~Server() {
@@ -30,7 +30,7 @@ void Server::stop() {
     }
     clients_.clear();
     
-    std::cout << "Server stopped" << std::endl;
+    LOG_INFO(NET, "Server stopped");
 }
 
 void Server::start_accept() {
@@ -46,6 +46,14 @@ void Server::start_accept() {
 
 void Server::handle_accept(std::shared_ptr<Peer> peer, const boost::system::error_code& error) {
     if (!error) {
+        peer->state = PeerState::CONNECTED;
+        peer->inbound = true;
+        peer->address = peer->socket->remote_endpoint().address().to_string();
+        peer->port = peer->socket->remote_endpoint().port();
+        peer->update_last_seen();
+        peer->score.connected_at = peer->last_seen;
+
+        // Чтение запускаем только после перевода в CONNECTED, иначе read() сразу выходит.
         // Проверяем первые байты на HTTP заголовки
         peer->read([this, peer](const std::string& data) {
             if (data.size() > 0 && (data[0] == 'P' || data[0] == 'G' || data[0] == 'H')) {
@@ -56,28 +64,26 @@ void Server::handle_accept(std::shared_ptr<Peer> peer, const boost::system::erro
             }
             try {
                 Message msg = Message::deserialize(data);
+                peer->stats.record_received(msg.type, data.size() + 1);
                 if (message_handler_) {
                     message_handler_(msg, peer);
                 }
             } catch (const std::exception& e) {
                 // Убираем вывод ошибки для HTTP запросов для чистоты логов
+                peer->score.record_invalid();
             }
         });
-        peer->state = PeerState::CONNECTED;
-        peer->address = peer->socket->remote_endpoint().address().to_string();
-        peer->port = peer->socket->remote_endpoint().port();
-        peer->update_last_seen();
-        
+
         clients_.push_back(peer);
         
-        std::cout << "New incoming connection from " << peer->get_endpoint() << std::endl;
+        LOG_INFO(NET, "New incoming connection").kv("peer", peer->get_endpoint());
         
         if (connection_handler_) {
             connection_handler_(peer);
         }
         
     } else {
-        std::cout << "Accept error: " << error.message() << std::endl;
+        LOG_WARN(NET, "Accept error").kv("error", error.message());
     }
     
     start_accept();
@@ -88,14 +94,14 @@ void Server::broadcast(const Message& msg, std::shared_ptr<Peer> exclude) {
     
     for (auto& client : clients_) {
         if (client != exclude && client->is_connected()) {
-            client->send(data);
+            client->send(msg.type, data);
         }
     }
 }
 
 void Server::send_to_peer(const Message& msg, std::shared_ptr<Peer> peer) {
     if (peer && peer->is_connected()) {
-        peer->send(msg.serialize());
+        peer->send(msg);
     }
 }
 
@@ -103,7 +109,7 @@ void Server::remove_peer(std::shared_ptr<Peer> peer) {
     auto it = std::find(clients_.begin(), clients_.end(), peer);
     if (it != clients_.end()) {
         clients_.erase(it);
-        std::cout << "Removed peer " << peer->get_endpoint() << std::endl;
+        LOG_DEBUG(NET, "Removed peer").kv("peer", peer->get_endpoint());
     }
 }
 
@@ -0,0 +1,107 @@
+// src/network/traffic_capture.cpp
+#include "traffic_capture.h"
+#include "../logging/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace nexus {
+
+namespace {
+
+const size_t HEADER_SIZE = 8 + 1 + 2 + 4;
+const size_t WRITE_BUFFER = 1 << 20;
+
+void put_le(unsigned char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+uint64_t get_le(const unsigned char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+} // namespace
+
+std::atomic<TrafficCapture*> TrafficCapture::active_{nullptr};
+std::unique_ptr<TrafficCapture> TrafficCapture::instance_;
+
+bool TrafficCapture::start(const std::string& path) {
+    if (active()) return true;
+    // Каждый запуск — отдельный захват: смещения отсчитываются от его начала
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        LOG_ERROR(NET, "Can't open capture file").kv("path", path).kv("error", std::strerror(errno));
+        return false;
+    }
+    std::fwrite(MAGIC, 1, sizeof(MAGIC), file);
+    instance_.reset(new TrafficCapture(file));
+    active_.store(instance_.get(), std::memory_order_release);
+    LOG_INFO(NET, "Traffic capture started").kv("path", path);
+    return true;
+}
+
+void TrafficCapture::stop() {
+    active_.store(nullptr, std::memory_order_release);
+    if (!instance_) return;
+    LOG_INFO(NET, "Traffic capture stopped").kv("records", instance_->records());
+    instance_.reset();
+}
+
+TrafficCapture::TrafficCapture(FILE* file)
+    : file_(file), started_(std::chrono::steady_clock::now()) {
+    std::setvbuf(file_, nullptr, _IOFBF, WRITE_BUFFER);
+}
+
+TrafficCapture::~TrafficCapture() {
+    std::fclose(file_);
+}
+
+void TrafficCapture::record(CaptureSource source, const std::string& peer, const std::string& data) {
+    uint64_t offset = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - started_).count();
+    unsigned char header[HEADER_SIZE];
+    size_t peer_len = std::min<size_t>(peer.size(), UINT16_MAX);
+    put_le(header, offset, 8);
+    header[8] = static_cast<unsigned char>(source);
+    put_le(header + 9, peer_len, 2);
+    put_le(header + 11, data.size(), 4);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::fwrite(header, 1, HEADER_SIZE, file_);
+    std::fwrite(peer.data(), 1, peer_len, file_);
+    std::fwrite(data.data(), 1, data.size(), file_);
+    records_.fetch_add(1, std::memory_order_relaxed);
+}
+
+CaptureReader::CaptureReader(const std::string& path) {
+    FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) return;
+    char magic[sizeof(TrafficCapture::MAGIC)];
+    if (std::fread(magic, 1, sizeof(magic), file) != sizeof(magic) ||
+        std::memcmp(magic, TrafficCapture::MAGIC, sizeof(magic)) != 0) {
+        std::fclose(file);
+        return;
+    }
+    file_ = file;
+}
+
+CaptureReader::~CaptureReader() {
+    if (file_) std::fclose(file_);
+}
+
+bool CaptureReader::next(CaptureRecord& record) {
+    if (!file_) return false;
+    unsigned char header[HEADER_SIZE];
+    if (std::fread(header, 1, HEADER_SIZE, file_) != HEADER_SIZE) return false;
+    record.offset_us = get_le(header, 8);
+    record.source = static_cast<CaptureSource>(header[8]);
+    record.peer.resize(get_le(header + 9, 2));
+    record.data.resize(get_le(header + 11, 4));
+    if (std::fread(record.peer.data(), 1, record.peer.size(), file_) != record.peer.size()) return false;
+    if (std::fread(record.data.data(), 1, record.data.size(), file_) != record.data.size()) return false;
+    return true;
+}
+
+} // namespace nexus
@@ -0,0 +1,75 @@
+// src/network/traffic_capture.h
+#pragma once
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+
+namespace nexus {
+
+enum class CaptureSource : uint8_t {
+    P2P = 0,          // Строка сообщения, прочитанная Peer::read
+    HTTP = 1,         // Сырой HTTP-запрос к API узла
+    LOCAL_BLOCK = 2   // Блок, найденный самим узлом: NEW_BLOCK с транзакциями
+};
+
+struct CaptureRecord {
+    uint64_t offset_us = 0;      // От начала захвата
+    CaptureSource source = CaptureSource::P2P;
+    std::string peer;            // Конечная точка пира ("ip:port"), для HTTP пусто, для блока — id узла
+    std::string data;
+};
+
+// Захват входящего трафика узла в append-only файл для последующего
+// воспроизведения (tools/nexus_replay). Формат: заголовок "NXCAP1\n\0",
+// затем записи: u64 offset_us, u8 source, u16 длина peer, u32 длина data
+// (little-endian) и сами байты. Запись идёт в буфер stdio под мьютексом:
+// пишут io-поток и HTTP-поток.
+class TrafficCapture {
+public:
+    static constexpr char MAGIC[8] = {'N', 'X', 'C', 'A', 'P', '1', '\n', '\0'};
+
+    // Включить захват для всего процесса; false — файл не открылся
+    static bool start(const std::string& path);
+    // Выключить и дописать буфер. Вызывается после остановки узла,
+    // когда record() уже никто не вызывает
+    static void stop();
+    // Текущий захват или nullptr — проверка на горячем пути одна загрузка
+    static TrafficCapture* active() { return active_.load(std::memory_order_acquire); }
+
+    void record(CaptureSource source, const std::string& peer, const std::string& data);
+    uint64_t records() const { return records_.load(std::memory_order_relaxed); }
+
+    ~TrafficCapture();
+
+private:
+    explicit TrafficCapture(FILE* file);
+
+    static std::atomic<TrafficCapture*> active_;
+    static std::unique_ptr<TrafficCapture> instance_;
+
+    FILE* file_;
+    std::mutex mutex_;
+    std::chrono::steady_clock::time_point started_;
+    std::atomic<uint64_t> records_{0};
+};
+
+// Последовательное чтение файла захвата
+class CaptureReader {
+public:
+    explicit CaptureReader(const std::string& path);
+    ~CaptureReader();
+
+    // Файл открыт и заголовок верный
+    bool ok() const { return file_ != nullptr; }
+    // Следующая запись; false — конец файла или обрезанная запись
+    bool next(CaptureRecord& record);
+
+private:
+    FILE* file_{nullptr};
+};
+
+} // namespace nexus
@@ -0,0 +1,135 @@
+// src/network/tx_relay.cpp
+#include "tx_relay.h"
+#include <algorithm>
+
+namespace nexus {
+
+TxRelay::TxRelay(const std::string& node_id)
+    : node_id_(node_id),
+      recent_txs_(120000, 0.000001) {
+}
+
+void TxRelay::announce(const std::string& hash,
+                       const std::vector<std::shared_ptr<Peer>>& peers,
+                       std::shared_ptr<Peer> source) {
+    mark_known(hash);
+    if (!send_handler_) return;
+
+    for (const auto& peer : peers) {
+        if (!peer || peer == source || !peer->is_connected()) continue;
+        if (peer->known_txs.contains(hash)) continue;
+        peer->known_txs.insert(hash);
+        queue_announcement(peer, hash);
+    }
+}
+
+void TxRelay::announce_to(std::shared_ptr<Peer> peer, const std::vector<std::string>& hashes) {
+    if (!send_handler_ || !peer || !peer->is_connected()) return;
+    for (const auto& hash : hashes) {
+        if (peer->known_txs.contains(hash)) continue;
+        peer->known_txs.insert(hash);
+        queue_announcement(peer, hash);
+    }
+}
+
+void TxRelay::queue_announcement(std::shared_ptr<Peer> peer, const std::string& hash) {
+    peer->inv_queue.push_back(hash);
+    peer->inv_queue_bytes += hash.size() + 3;  // кавычки и запятая в JSON-массиве
+
+    if (peer->inv_queue_bytes >= TRICKLE_FLUSH_BYTES || peer->inv_queue.size() >= MAX_INV_SIZE) {
+        flush(peer);
+    } else if (!peer->trickle_scheduled) {
+        schedule_trickle(peer);
+    }
+}
+
+void TxRelay::schedule_trickle(std::shared_ptr<Peer> peer) {
+    // Случайная задержка не даёт наблюдателю восстановить источник транзакции по времени анонсов
+    std::exponential_distribution<double> dist(1.0 / trickle_mean_.count());
+    auto delay_ms = static_cast<long>(dist(rng_));
+    delay_ms = std::clamp<long>(delay_ms, trickle_mean_.count() / 5, trickle_mean_.count() * 5);
+
+    peer->trickle_scheduled = true;
+    uint64_t generation = ++peer->trickle_generation;
+    peer->trickle_timer->expires_after(std::chrono::milliseconds(delay_ms));
+    std::weak_ptr<Peer> weak_peer = peer;
+    peer->trickle_timer->async_wait([this, weak_peer, generation](const boost::system::error_code& error) {
+        // Отменённый таймер не трогаем: флаг уже сброшен в flush()
+        if (error == boost::asio::error::operation_aborted) return;
+        auto peer = weak_peer.lock();
+        // Обработчик мог встать в очередь до cancel() в flush(): тогда он
+        // не отменяется, а поколение уже сменилось
+        if (!peer || peer->trickle_generation != generation) return;
+        peer->trickle_scheduled = false;
+        flush(peer);
+    });
+}
+
+void TxRelay::flush(std::shared_ptr<Peer> peer) {
+    if (peer->trickle_scheduled) {
+        peer->trickle_timer->cancel();
+        peer->trickle_scheduled = false;
+        ++peer->trickle_generation;
+    }
+    if (peer->inv_queue.empty()) return;
+
+    std::vector<std::string> queue;
+    queue.swap(peer->inv_queue);
+    peer->inv_queue_bytes = 0;
+    if (!peer->is_connected()) return;
+
+    for (size_t i = 0; i < queue.size(); i += MAX_INV_SIZE) {
+        size_t end = std::min(queue.size(), i + MAX_INV_SIZE);
+        std::vector<std::string> batch(queue.begin() + i, queue.begin() + end);
+        send_handler_(Message::create_inv(node_id_, batch), peer);
+    }
+}
+
+std::vector<std::string> TxRelay::handle_inventory(std::shared_ptr<Peer> peer,
+                                                   const std::vector<std::string>& hashes) {
+    std::vector<std::string> to_request;
+    if (in_flight_.size() > MAX_INV_SIZE * 10) {
+        expire_requests();
+    }
+
+    auto now = Clock::now();
+    for (const auto& hash : hashes) {
+        if (to_request.size() >= MAX_INV_SIZE) break;
+        peer->known_txs.insert(hash);
+        if (is_known(hash)) continue;
+
+        auto it = in_flight_.find(hash);
+        if (it != in_flight_.end() && now - it->second < REQUEST_TIMEOUT) {
+            continue;  // Уже запросили у другого пира
+        }
+        in_flight_[hash] = now;
+        to_request.push_back(hash);
+    }
+    return to_request;
+}
+
+void TxRelay::transaction_received(std::shared_ptr<Peer> peer, const std::string& hash) {
+    if (peer) peer->known_txs.insert(hash);
+    in_flight_.erase(hash);
+    mark_known(hash);
+}
+
+void TxRelay::transaction_dropped(const std::string& hash) {
+    // Под долгой перегрузкой набор не растёт без границ: при сбросе
+    // отброшенные ранее хэши снова считаются известными
+    if (dropped_.size() >= MAX_INV_SIZE * 10) dropped_.clear();
+    dropped_.insert(hash);
+}
+
+void TxRelay::expire_requests() {
+    auto now = Clock::now();
+    for (auto it = in_flight_.begin(); it != in_flight_.end();) {
+        if (now - it->second >= REQUEST_TIMEOUT) {
+            it = in_flight_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace nexus
@@ -0,0 +1,87 @@
+// src/network/tx_relay.h
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <random>
+#include "peer.h"
+#include "message.h"
+#include "rolling_bloom.h"
+
+namespace nexus {
+
+// Ретрансляция транзакций по схеме announce/request:
+// пирам рассылаются только хэши (INV), полные транзакции
+// запрашиваются (GET_DATA) лишь теми, кто их ещё не видел.
+// Анонсы копятся в очереди пира и уходят одним INV по случайному
+// короткому таймеру (trickle) либо при достижении порога по объёму.
+// Все методы вызываются из io-потока узла.
+class TxRelay {
+public:
+    using SendHandler = std::function<void(const Message&, std::shared_ptr<Peer>)>;
+
+    static constexpr size_t MAX_INV_SIZE = 1000;          // Хэшей в одном INV/GET_DATA
+    static constexpr size_t TRICKLE_FLUSH_BYTES = 16384;  // Порог немедленного сброса очереди
+
+    explicit TxRelay(const std::string& node_id);
+
+    void set_send_handler(SendHandler handler) { send_handler_ = std::move(handler); }
+
+    // Средняя задержка trickle-таймера; фактическая выбирается случайно
+    // (экспоненциально) и ограничивается диапазоном [mean/5, mean*5]
+    void set_trickle_interval(std::chrono::milliseconds mean) { trickle_mean_ = mean; }
+
+    // Хэш уже встречался узлу (принят, отклонён или анонсирован нами)
+    bool is_known(const std::string& hash) const {
+        return recent_txs_.contains(hash) && !dropped_.contains(hash);
+    }
+    void mark_known(const std::string& hash) {
+        recent_txs_.insert(hash);
+        dropped_.erase(hash);
+    }
+
+    // Поставить хэш в очередь анонсов всех пиров, которые его ещё не знают (кроме источника)
+    void announce(const std::string& hash,
+                  const std::vector<std::shared_ptr<Peer>>& peers,
+                  std::shared_ptr<Peer> source = nullptr);
+
+    // Поставить хэши в очередь анонсов одного пира (например, по итогам сверки mempool)
+    void announce_to(std::shared_ptr<Peer> peer, const std::vector<std::string>& hashes);
+
+    // Немедленно отправить накопленные анонсы пира
+    void flush(std::shared_ptr<Peer> peer);
+
+    // Обработать входящий INV; возвращает хэши, которые нужно запросить у пира
+    std::vector<std::string> handle_inventory(std::shared_ptr<Peer> peer,
+                                              const std::vector<std::string>& hashes);
+
+    // Полная транзакция получена: снимаем её с ожидания и помечаем виденной
+    void transaction_received(std::shared_ptr<Peer> peer, const std::string& hash);
+
+    // Полученная транзакция не обработана (очередь проверки переполнена):
+    // из фильтра хэш не удалить, поэтому он считается неизвестным,
+    // пока транзакция не придёт снова — по INV его можно запросить повторно
+    void transaction_dropped(const std::string& hash);
+
+private:
+    using Clock = std::chrono::steady_clock;
+    static constexpr auto REQUEST_TIMEOUT = std::chrono::seconds(30);
+
+    void expire_requests();
+    void queue_announcement(std::shared_ptr<Peer> peer, const std::string& hash);
+    void schedule_trickle(std::shared_ptr<Peer> peer);
+
+    std::string node_id_;
+    SendHandler send_handler_;
+    RollingBloomFilter recent_txs_;
+    std::chrono::milliseconds trickle_mean_{100};
+    std::mt19937 rng_{std::random_device{}()};
+    std::unordered_map<std::string, Clock::time_point> in_flight_;  // hash -> время запроса
+    std::unordered_set<std::string> dropped_;                        // Отброшены при перегрузке
+};
+
+} // namespace nexus
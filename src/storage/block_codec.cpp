@@ -0,0 +1,244 @@
+// src/storage/block_codec.cpp
+#include "block_codec.h"
+#include <cstring>
+
+namespace {
+
+class Writer {
+public:
+    explicit Writer(std::string& out) : out_(out) {}
+
+    void u8(uint8_t value) { out_.push_back(static_cast<char>(value)); }
+
+    void u64(uint64_t value) {
+        char raw[8];
+        for (int i = 0; i < 8; ++i) raw[i] = static_cast<char>(value >> (8 * i));
+        out_.append(raw, 8);
+    }
+
+    void i64(int64_t value) { u64(static_cast<uint64_t>(value)); }
+
+    void f64(double value) {
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        u64(bits);
+    }
+
+    void str(const std::string& value) {
+        uint32_t size = static_cast<uint32_t>(value.size());
+        for (int i = 0; i < 4; ++i) out_.push_back(static_cast<char>(size >> (8 * i)));
+        out_.append(value);
+    }
+
+private:
+    std::string& out_;
+};
+
+class Reader {
+public:
+    explicit Reader(std::string_view in) : in_(in) {}
+
+    bool ok() const { return ok_; }
+
+    uint8_t u8() { return static_cast<uint8_t>(take(1)); }
+    uint64_t u64() { return take(8); }
+    int64_t i64() { return static_cast<int64_t>(take(8)); }
+
+    double f64() {
+        uint64_t bits = u64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    void str(std::string& out) {
+        uint64_t size = take(4);
+        if (!ok_ || size > in_.size() - pos_) {
+            ok_ = false;
+            return;
+        }
+        out.assign(in_.data() + pos_, size);
+        pos_ += size;
+    }
+
+private:
+    uint64_t take(size_t bytes) {
+        if (!ok_ || bytes > in_.size() - pos_) {
+            ok_ = false;
+            return 0;
+        }
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i) {
+            value |= static_cast<uint64_t>(static_cast<unsigned char>(in_[pos_ + i])) << (8 * i);
+        }
+        pos_ += bytes;
+        return value;
+    }
+
+    std::string_view in_;
+    size_t pos_ = 0;
+    bool ok_ = true;
+};
+
+// До версии 3 суммы хранились монетами в f64
+Amount readAmount(Reader& r, uint8_t version) {
+    if (version >= 3) return r.i64();
+    Amount amount = 0;
+    amountFromCoins(r.f64(), amount);
+    return amount;
+}
+
+void writeTransaction(Writer& w, const Transaction& tx) {
+    w.str(tx.txHash);
+    w.str(tx.fromAddress);
+    w.str(tx.toAddress);
+    w.i64(tx.amount);
+    w.i64(tx.fee);
+    w.str(tx.signature);
+    w.u64(static_cast<uint64_t>(tx.timestamp));
+    w.str(tx.data);
+    w.u64(tx.nonce);
+    w.str(tx.publicKey);
+}
+
+void readTransaction(Reader& r, Transaction& tx, uint8_t version) {
+    r.str(tx.txHash);
+    r.str(tx.fromAddress);
+    r.str(tx.toAddress);
+    tx.amount = readAmount(r, version);
+    tx.fee = readAmount(r, version);
+    r.str(tx.signature);
+    tx.timestamp = static_cast<long>(r.u64());
+    r.str(tx.data);
+    tx.nonce = r.u64();
+    if (version >= 2) r.str(tx.publicKey);
+}
+
+bool knownVersion(uint8_t version) {
+    return version >= 1 && version <= BLOCK_CODEC_VERSION;
+}
+
+} // namespace
+
+std::string encodeBlock(const Block& block) {
+    std::string out;
+    size_t estimate = 128;
+    for (const auto& tx : block.transactions) {
+        estimate += 64 + tx.txHash.size() + tx.fromAddress.size() + tx.toAddress.size() +
+                    tx.signature.size() + tx.data.size() + tx.publicKey.size();
+    }
+    out.reserve(estimate);
+
+    Writer w(out);
+    w.u8(BLOCK_CODEC_VERSION);
+    w.u64(static_cast<uint64_t>(block.height));
+    w.str(block.hash);
+    w.str(block.prevHash);
+    w.str(block.merkleRoot);
+    w.u64(static_cast<uint64_t>(block.timestamp));
+    w.u64(static_cast<uint64_t>(static_cast<int64_t>(block.nonce)));
+    w.f64(block.difficulty);
+    w.str(block.minedBy);
+    w.u64(block.transactions.size());
+    for (const auto& tx : block.transactions) writeTransaction(w, tx);
+    return out;
+}
+
+size_t encodedBlockSize(const Block& block) {
+    // Версия, 4 числа заголовка и число транзакций, 4 строки; у транзакции 6 строк и 4 числа
+    size_t size = 1 + 5 * 8 + 4 * 4 + block.hash.size() + block.prevHash.size() + block.merkleRoot.size() +
+                  block.minedBy.size();
+    for (const auto& tx : block.transactions) {
+        size += 6 * 4 + 4 * 8 + tx.txHash.size() + tx.fromAddress.size() + tx.toAddress.size() +
+                tx.signature.size() + tx.data.size() + tx.publicKey.size();
+    }
+    return size;
+}
+
+bool decodeBlock(std::string_view data, Block& block) {
+    Reader r(data);
+    uint8_t version = r.u8();
+    if (!knownVersion(version)) return false;
+    block.height = static_cast<int>(r.u64());
+    r.str(block.hash);
+    r.str(block.prevHash);
+    r.str(block.merkleRoot);
+    block.timestamp = static_cast<long>(r.u64());
+    block.nonce = static_cast<int>(static_cast<int64_t>(r.u64()));
+    block.difficulty = r.f64();
+    r.str(block.minedBy);
+
+    uint64_t count = r.u64();
+    // Каждая транзакция занимает не меньше 56 байт: защита от мусорного счётчика
+    if (!r.ok() || count > data.size() / 56) return false;
+    block.transactions.assign(count, Transaction());
+    for (auto& tx : block.transactions) {
+        readTransaction(r, tx, version);
+        tx.status = "confirmed";
+    }
+    return r.ok();
+}
+
+std::string encodeTransaction(const Transaction& tx) {
+    std::string out;
+    out.reserve(64 + tx.txHash.size() + tx.fromAddress.size() + tx.toAddress.size() +
+                tx.signature.size() + tx.data.size() + tx.publicKey.size());
+    Writer w(out);
+    w.u8(BLOCK_CODEC_VERSION);
+    writeTransaction(w, tx);
+    return out;
+}
+
+bool decodeTransaction(std::string_view data, Transaction& tx) {
+    Reader r(data);
+    uint8_t version = r.u8();
+    if (!knownVersion(version)) return false;
+    readTransaction(r, tx, version);
+    return r.ok();
+}
+
+std::string encodeBlockUndo(const BlockUndo& undo) {
+    std::string out;
+    Writer w(out);
+    w.u8(BLOCK_CODEC_VERSION);
+    w.u64(static_cast<uint64_t>(static_cast<int64_t>(undo.height)));
+    w.str(undo.hash);
+    w.u64(undo.balanceDeltas.size());
+    for (const auto& [address, delta] : undo.balanceDeltas) {
+        w.str(address);
+        w.i64(delta);
+    }
+    w.u64(undo.previousNonces.size());
+    for (const auto& [address, nonce] : undo.previousNonces) {
+        w.str(address);
+        w.u64(nonce);
+    }
+    return out;
+}
+
+bool decodeBlockUndo(std::string_view data, BlockUndo& undo) {
+    Reader r(data);
+    uint8_t version = r.u8();
+    if (!knownVersion(version)) return false;
+    undo.height = static_cast<int>(static_cast<int64_t>(r.u64()));
+    r.str(undo.hash);
+    uint64_t count = r.u64();
+    // Запись адреса — не меньше 12 байт
+    if (!r.ok() || count > data.size() / 12) return false;
+    undo.balanceDeltas.assign(count, {});
+    for (auto& [address, delta] : undo.balanceDeltas) {
+        r.str(address);
+        delta = readAmount(r, version);
+    }
+    undo.previousNonces.clear();
+    if (version >= 4) {
+        count = r.u64();
+        if (!r.ok() || count > data.size() / 12) return false;
+        undo.previousNonces.assign(count, {});
+        for (auto& [address, nonce] : undo.previousNonces) {
+            r.str(address);
+            nonce = r.u64();
+        }
+    }
+    return r.ok();
+}
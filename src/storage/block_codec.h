@@ -0,0 +1,32 @@
+// src/storage/block_codec.h
+#pragma once
+#include <string>
+#include <string_view>
+#include "../blockchain/block.h"
+#include "ledger_storage.h"
+
+// Компактная двоичная запись блока для файлового хранилища: поля подряд,
+// строки с префиксом длины u32, числа little-endian. В отличие от
+// Block::fromJson разбор не пересчитывает хэши транзакций — тело пишет
+// сам узел после проверки блока. Статус транзакций не хранится: в теле
+// блока они всегда confirmed. Версия 2 добавила открытый ключ отправителя;
+// записи версии 1 читаются с пустым ключом. В версии 3 суммы и изменения
+// балансов — i64 минимальных единиц вместо f64 монет; старые записи
+// переводятся в единицы при чтении. Версия 4 добавила в undo-запись
+// прежние nonce отправителей; у старых записей их нет.
+constexpr uint8_t BLOCK_CODEC_VERSION = 4;
+
+std::string encodeBlock(const Block& block);
+// Длина encodeBlock(block) без самой записи
+size_t encodedBlockSize(const Block& block);
+// false — неизвестная версия или обрезанная запись
+bool decodeBlock(std::string_view data, Block& block);
+
+// Одна транзакция в той же записи (без статуса, он остаётся прежним)
+std::string encodeTransaction(const Transaction& tx);
+bool decodeTransaction(std::string_view data, Transaction& tx);
+
+// Undo-запись блока: высота, хэш, пары адрес/изменение баланса, пары
+// адрес/прежний nonce
+std::string encodeBlockUndo(const BlockUndo& undo);
+bool decodeBlockUndo(std::string_view data, BlockUndo& undo);
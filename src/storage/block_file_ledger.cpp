@@ -0,0 +1,103 @@
+// src/storage/block_file_ledger.cpp
+#include "block_file_ledger.h"
+#include "block_codec.h"
+#include "../logging/logger.h"
+#include <stdexcept>
+
+BlockFileLedger::BlockFileLedger(const std::string& path, const std::string& blockDir)
+    : BlockFileLedger(path, blockDir, false) {
+}
+
+BlockFileLedger::BlockFileLedger(const std::string& path, const std::string& blockDir, bool deferReconcile)
+    : LedgerDB(path), store_(blockDir) {
+    if (!store_.ok()) {
+        LOG_ERROR(STORAGE, "Can't open block file store").kv("path", blockDir);
+        throw std::runtime_error("Can't open block file store");
+    }
+    if (!deferReconcile) reconcile();
+}
+
+std::optional<Block> BlockFileLedger::storedBlock(int height, const std::string& hash) const {
+    auto body = store_.read(height);
+    Block block;
+    if (!body || !decodeBlock(*body, block) || block.hash != hash) return std::nullopt;
+    return block;
+}
+
+void BlockFileLedger::reconcile() {
+    int height = getLatestHeight();
+    int kept = std::min(store_.count(), height + 1);
+
+    // Вершина в файлах могла остаться от заменённого блока
+    while (kept > 0) {
+        auto body = store_.read(kept - 1);
+        Block stored;
+        auto row = LedgerDB::getBlockByHeight(kept - 1);
+        if (!body || (row && decodeBlock(*body, stored) && stored.hash == row->hash)) break;
+        kept--;
+    }
+    store_.truncate(kept);
+
+    for (int h = kept; h <= height; ++h) {
+        auto block = LedgerDB::getBlockByHeight(h);
+        if (!block || !appendBody(*block)) break;
+    }
+    if (kept <= height) {
+        LOG_INFO(STORAGE, "Block files restored from database").kv("from", kept).kv("to", store_.count() - 1);
+    }
+    // Граница обрезки хранится в базе, файлам её сообщаем при каждом открытии
+    if (getPrunedHeight() > 0) store_.prune(getPrunedHeight() + 1);
+}
+
+bool BlockFileLedger::appendBody(const Block& block) {
+    return store_.append(block.height, encodeBlock(block));
+}
+
+bool BlockFileLedger::addBlock(const Block& block) {
+    if (!LedgerDB::addBlock(block)) return false;
+    nexus::ScopedTimer timer(queryObserver(), "append_block");
+    // Блок уже записан в базу: при сбое файлов он читается оттуда,
+    // а файлы догоняются при следующем открытии
+    if (!appendBody(block)) {
+        LOG_WARN(STORAGE, "Block body not appended, served from database").kv("height", block.height);
+    }
+    return true;
+}
+
+std::optional<Block> BlockFileLedger::getBlockByHeight(int height) {
+    auto body = store_.read(height);
+    if (!body) return LedgerDB::getBlockByHeight(height);
+
+    nexus::ScopedTimer timer(queryObserver(), "get_block");
+    Block block;
+    if (!decodeBlock(*body, block)) {
+        LOG_ERROR(STORAGE, "Corrupted block body").kv("height", height);
+        return LedgerDB::getBlockByHeight(height);
+    }
+    return block;
+}
+
+bool BlockFileLedger::removeBlock(int height) {
+    if (!LedgerDB::removeBlock(height)) return false;
+    return store_.truncate(height);
+}
+
+bool BlockFileLedger::rollbackTransaction() {
+    bool ok = LedgerDB::rollbackTransaction();
+    // Отменённые блоки могли успеть попасть в файлы
+    store_.truncate(getLatestHeight() + 1);
+    return ok;
+}
+
+bool BlockFileLedger::importSnapshot(const SnapshotBase& base, const std::vector<Block>& headers,
+                                     const std::vector<SnapshotAccount>& accounts) {
+    if (!LedgerDB::importSnapshot(base, headers, accounts)) return false;
+    reconcile();
+    return true;
+}
+
+int BlockFileLedger::pruneBlocks(int height, int maxBlocks) {
+    int pruned = LedgerDB::pruneBlocks(height, maxBlocks);
+    if (pruned > 0) store_.prune(pruned + 1);
+    return pruned;
+}
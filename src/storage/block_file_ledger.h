@@ -0,0 +1,44 @@
+// src/storage/block_file_ledger.h
+#pragma once
+#include "ledger_db.h"
+#include "block_file_store.h"
+
+// Хранилище с телами блоков в BlockFileStore. В SQLite остаются заголовки
+// блоков (индекс по хэшу, высота вершины), строки транзакций, из которых
+// считаются балансы, nonce, mempool и пиры. Базой по-прежнему можно
+// открыть узел с бэкендом SQLITE: все данные для сборки блоков в ней есть.
+//
+// Файлы не синхронизируются с диском отдельно, поэтому источником истины
+// остаётся SQLite: при открытии лишние блоки в файлах отбрасываются, а
+// недостающие дописываются из базы. Пока блока нет в файлах (например,
+// после ошибки записи), он читается из SQLite. Обрезанных тел нет ни там,
+// ни там.
+class BlockFileLedger : public LedgerDB {
+public:
+    BlockFileLedger(const std::string& path, const std::string& blockDir);
+
+    bool addBlock(const Block& block) override;
+    std::optional<Block> getBlockByHeight(int height) override;
+    bool removeBlock(int height) override;
+    bool rollbackTransaction() override;
+    // Заголовки снимка ложатся в файлы телами без транзакций: высоты в
+    // хранилище идут подряд
+    bool importSnapshot(const SnapshotBase& base, const std::vector<Block>& headers,
+                        const std::vector<SnapshotAccount>& accounts) override;
+    // Вслед за базой освобождаются и тела в файлах
+    int pruneBlocks(int height, int maxBlocks) override;
+
+protected:
+    // Для наследников, которым до сверки файлов нужно открыть своё хранилище:
+    // reconcile() они вызывают сами в конце конструктора
+    BlockFileLedger(const std::string& path, const std::string& blockDir, bool deferReconcile);
+    // Привести файлы в соответствие с блоками в базе
+    void reconcile();
+    // Блок из файлов, если его тело там есть и совпадает с заголовком в базе
+    std::optional<Block> storedBlock(int height, const std::string& hash) const;
+
+private:
+    bool appendBody(const Block& block);
+
+    BlockFileStore store_;
+};
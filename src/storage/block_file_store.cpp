@@ -0,0 +1,265 @@
+// src/storage/block_file_store.cpp
+#include "block_file_store.h"
+#include "../logging/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fcntl.h>
+#include <linux/falloc.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t INDEX_ENTRY_SIZE = 4 + 4 + 8;
+
+void put_le(unsigned char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+uint64_t get_le(const unsigned char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    return value;
+}
+
+bool writeAll(int fd, const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(fd, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+
+BlockFileStore::BlockFileStore(const std::string& dir, uint64_t segmentLimit)
+    : dir_(dir), segmentLimit_(segmentLimit) {
+    ok_ = load();
+}
+
+BlockFileStore::~BlockFileStore() {
+    for (auto& segment : segments_) closeSegment(segment);
+    if (indexFd_ >= 0) close(indexFd_);
+}
+
+std::string BlockFileStore::segmentPath(uint32_t number) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "blk%05u.dat", number);
+    return (std::filesystem::path(dir_) / name).string();
+}
+
+bool BlockFileStore::openSegment(uint32_t number, bool create) {
+    std::string path = segmentPath(number);
+    int fd = open(path.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        LOG_ERROR(STORAGE, "Can't open block segment").kv("path", path).kv("error", std::strerror(errno));
+        if (fd >= 0) close(fd);
+        return false;
+    }
+
+    Segment segment;
+    segment.fd = fd;
+    segment.size = static_cast<uint64_t>(st.st_size);
+    // Отображение сразу на весь допустимый размер сегмента: дописанные
+    // позже блоки видны без перемапливания, а выданные view не сдвигаются
+    segment.mapped = std::max(segmentLimit_, segment.size);
+    void* map = mmap(nullptr, segment.mapped, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_ERROR(STORAGE, "Can't map block segment").kv("path", path).kv("error", std::strerror(errno));
+        close(fd);
+        return false;
+    }
+    segment.map = static_cast<const char*>(map);
+    segments_.push_back(segment);
+    return true;
+}
+
+void BlockFileStore::closeSegment(Segment& segment) {
+    if (segment.map) munmap(const_cast<char*>(segment.map), segment.mapped);
+    if (segment.fd >= 0) close(segment.fd);
+    segment = Segment{};
+}
+
+bool BlockFileStore::load() {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        LOG_ERROR(STORAGE, "Can't create block directory").kv("path", dir_).kv("error", ec.message());
+        return false;
+    }
+
+    std::string indexPath = (std::filesystem::path(dir_) / "index.dat").string();
+    indexFd_ = open(indexPath.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat st;
+    if (indexFd_ < 0 || fstat(indexFd_, &st) != 0) {
+        LOG_ERROR(STORAGE, "Can't open block index").kv("path", indexPath).kv("error", std::strerror(errno));
+        return false;
+    }
+
+    std::vector<unsigned char> raw(static_cast<size_t>(st.st_size));
+    if (!raw.empty() && pread(indexFd_, raw.data(), raw.size(), 0) != static_cast<ssize_t>(raw.size())) {
+        LOG_ERROR(STORAGE, "Can't read block index").kv("path", indexPath).kv("error", std::strerror(errno));
+        return false;
+    }
+
+    // Сегменты до первого сохранившегося удалены обрезкой
+    uint32_t first = UINT32_MAX;
+    for (const auto& file : std::filesystem::directory_iterator(dir_, ec)) {
+        unsigned number;
+        if (std::sscanf(file.path().filename().c_str(), "blk%u.dat", &number) == 1) {
+            first = std::min(first, static_cast<uint32_t>(number));
+        }
+    }
+    if (first == UINT32_MAX) first = 0;
+    segments_.resize(first);
+    for (auto& segment : segments_) segment.pruned = true;
+    for (uint32_t n = first; std::filesystem::exists(segmentPath(n)); ++n) {
+        if (!openSegment(n, false)) return false;
+    }
+
+    // Индекс принимается, пока записи идут подряд и указывают на данные,
+    // которые действительно есть в сегментах; остальное — недописанный хвост
+    size_t entries = raw.size() / INDEX_ENTRY_SIZE;
+    index_.reserve(entries);
+    for (size_t i = 0; i < entries; ++i) {
+        const unsigned char* p = raw.data() + i * INDEX_ENTRY_SIZE;
+        IndexEntry entry{static_cast<uint32_t>(get_le(p, 4)), static_cast<uint32_t>(get_le(p + 4, 4)), get_le(p + 8, 8)};
+        uint64_t expected = 0;
+        uint32_t expectedSegment = 0;
+        if (!index_.empty()) {
+            const IndexEntry& prev = index_.back();
+            expectedSegment = prev.segment;
+            expected = prev.offset + prev.size;
+            if (entry.segment == prev.segment + 1) {
+                expectedSegment = entry.segment;
+                expected = 0;
+            }
+        }
+        if (entry.segment != expectedSegment || entry.offset != expected || entry.segment >= segments_.size() ||
+            (!segments_[entry.segment].pruned && entry.offset + entry.size > segments_[entry.segment].size)) {
+            LOG_WARN(STORAGE, "Dropping unfinished block index tail").kv("height", i).kv("entries", entries);
+            break;
+        }
+        index_.push_back(entry);
+    }
+
+    // Обрезаем всё, что лежит за последним принятым блоком
+    uint32_t lastSegment = index_.empty() ? 0 : index_.back().segment;
+    uint64_t lastEnd = index_.empty() ? 0 : index_.back().offset + index_.back().size;
+    while (segments_.size() > lastSegment + 1) {
+        closeSegment(segments_.back());
+        segments_.pop_back();
+        std::filesystem::remove(segmentPath(static_cast<uint32_t>(segments_.size())), ec);
+    }
+    if (!segments_.empty() && !segments_.back().pruned && segments_.back().size > lastEnd) {
+        if (ftruncate(segments_.back().fd, static_cast<off_t>(lastEnd)) != 0) return false;
+        segments_.back().size = lastEnd;
+    }
+    if (ftruncate(indexFd_, static_cast<off_t>(index_.size() * INDEX_ENTRY_SIZE)) != 0) return false;
+
+    LOG_INFO(STORAGE, "Block file store opened")
+        .kv("path", dir_).kv("blocks", index_.size()).kv("segments", segments_.size());
+    return true;
+}
+
+bool BlockFileStore::append(int height, std::string_view body) {
+    if (!ok_ || height != count()) return false;
+    if (body.size() > segmentLimit_ || body.size() > UINT32_MAX) {
+        LOG_ERROR(STORAGE, "Block does not fit into a segment").kv("height", height).kv("size", body.size());
+        return false;
+    }
+
+    if (segments_.empty() ||
+        (segments_.back().size > 0 && segments_.back().size + body.size() > segmentLimit_)) {
+        if (!openSegment(static_cast<uint32_t>(segments_.size()), true)) return false;
+    }
+    uint32_t number = static_cast<uint32_t>(segments_.size() - 1);
+    Segment& segment = segments_.back();
+
+    IndexEntry entry{number, static_cast<uint32_t>(body.size()), segment.size};
+    unsigned char raw[INDEX_ENTRY_SIZE];
+    put_le(raw, entry.segment, 4);
+    put_le(raw + 4, entry.size, 4);
+    put_le(raw + 8, entry.offset, 8);
+
+    // Сначала тело, потом индекс: запись индекса без данных не появится
+    if (!writeAll(segment.fd, body.data(), body.size(), entry.offset) ||
+        !writeAll(indexFd_, reinterpret_cast<const char*>(raw), INDEX_ENTRY_SIZE,
+                  static_cast<uint64_t>(height) * INDEX_ENTRY_SIZE)) {
+        LOG_ERROR(STORAGE, "Block append failed").kv("height", height).kv("error", std::strerror(errno));
+        if (ftruncate(segment.fd, static_cast<off_t>(entry.offset)) != 0) ok_ = false;
+        return false;
+    }
+
+    segment.size += body.size();
+    index_.push_back(entry);
+    return true;
+}
+
+std::optional<std::string_view> BlockFileStore::read(int height) const {
+    if (height < prunedBelow_ || height >= count()) return std::nullopt;
+    const IndexEntry& entry = index_[height];
+    return std::string_view(segments_[entry.segment].map + entry.offset, entry.size);
+}
+
+bool BlockFileStore::truncate(int height) {
+    if (!ok_) return false;
+    if (height < 0) height = 0;
+    if (height >= count()) return true;
+    if (height < prunedBelow_) {
+        LOG_ERROR(STORAGE, "Can't truncate pruned blocks").kv("height", height).kv("pruned", prunedBelow_);
+        return false;
+    }
+
+    const IndexEntry first = index_[height];
+    std::error_code ec;
+    while (segments_.size() > first.segment + 1) {
+        closeSegment(segments_.back());
+        segments_.pop_back();
+        std::filesystem::remove(segmentPath(static_cast<uint32_t>(segments_.size())), ec);
+    }
+    index_.resize(height);
+    if (ftruncate(indexFd_, static_cast<off_t>(index_.size() * INDEX_ENTRY_SIZE)) != 0 ||
+        ftruncate(segments_.back().fd, static_cast<off_t>(first.offset)) != 0) {
+        LOG_ERROR(STORAGE, "Block truncate failed").kv("height", height).kv("error", std::strerror(errno));
+        ok_ = false;
+        return false;
+    }
+    segments_.back().size = first.offset;
+    return true;
+}
+
+void BlockFileStore::prune(int height) {
+    height = std::min(height, count() - 1);
+    if (!ok_ || height <= prunedBelow_) return;
+
+    const IndexEntry& boundary = index_[height];
+    std::error_code ec;
+    for (uint32_t n = 0; n < boundary.segment; ++n) {
+        Segment& segment = segments_[n];
+        if (segment.pruned) continue;
+        closeSegment(segment);
+        segment.pruned = true;
+        std::filesystem::remove(segmentPath(n), ec);
+    }
+    // Размер файла не меняется, блоки диска под дырой освобождаются. Без
+    // поддержки в ФС место в этом сегменте вернётся, когда он уйдёт целиком
+    if (boundary.offset > 0 &&
+        fallocate(segments_[boundary.segment].fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, 0,
+                  static_cast<off_t>(boundary.offset)) != 0 && errno != EOPNOTSUPP) {
+        LOG_WARN(STORAGE, "Can't punch hole in block segment")
+            .kv("segment", boundary.segment).kv("error", std::strerror(errno));
+    }
+    prunedBelow_ = height;
+}
@@ -0,0 +1,76 @@
+// src/storage/block_file_store.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <cstdint>
+
+// Append-only хранилище тел блоков (формат тела задаёт вызывающий, см.
+// block_codec.h). Блоки пишутся подряд в файлы-сегменты blk00000.dat,
+// blk00001.dat, ... (новый сегмент начинается, когда текущий превысил бы
+// segmentLimit), а index.dat хранит по записи на высоту: u32 сегмент, u32 длина, u64 смещение (little-endian, 16 байт), так что
+// позиция блока находится без поиска. Сегменты отображаются в память
+// целиком на segmentLimit байт, чтение тела — string_view прямо в
+// отображение, без копирования и без системных вызовов.
+//
+// fsync не делается: после сбоя хвост, на который не успел лечь индекс
+// или данные, отбрасывается при открытии. Высоты идут подряд с нуля.
+//
+// Обрезка (prune) освобождает тела ниже границы: сегменты целиком ниже
+// неё удаляются, в сегменте с границей начало выбивается дырой
+// (FALLOC_FL_PUNCH_HOLE), а записи индекса остаются, так что номера
+// сегментов и смещения не сдвигаются. Границу хранит вызывающий и
+// передаёт заново после открытия.
+class BlockFileStore {
+public:
+    static constexpr uint64_t DEFAULT_SEGMENT_LIMIT = 128ull << 20;
+
+    explicit BlockFileStore(const std::string& dir, uint64_t segmentLimit = DEFAULT_SEGMENT_LIMIT);
+    ~BlockFileStore();
+
+    BlockFileStore(const BlockFileStore&) = delete;
+    BlockFileStore& operator=(const BlockFileStore&) = delete;
+
+    // Каталог открыт, индекс прочитан
+    bool ok() const { return ok_; }
+    // Число блоков: хранятся высоты 0 .. count() - 1
+    int count() const { return static_cast<int>(index_.size()); }
+
+    // Дописать тело блока; height должна быть равна count()
+    bool append(int height, std::string_view body);
+    // Тело блока. View действителен до truncate() или уничтожения хранилища
+    std::optional<std::string_view> read(int height) const;
+    // Отбросить блоки с высоты height и выше; обрезанные не отбрасываются
+    bool truncate(int height);
+    // Освободить тела блоков ниже height (тело вершины остаётся всегда)
+    void prune(int height);
+
+private:
+    struct IndexEntry {
+        uint32_t segment;
+        uint32_t size;
+        uint64_t offset;
+    };
+
+    struct Segment {
+        int fd = -1;
+        uint64_t size = 0;          // Записано байт
+        const char* map = nullptr;
+        uint64_t mapped = 0;        // Длина отображения, не меньше segmentLimit
+        bool pruned = false;        // Файл удалён обрезкой
+    };
+
+    bool load();
+    bool openSegment(uint32_t number, bool create);
+    void closeSegment(Segment& segment);
+    std::string segmentPath(uint32_t number) const;
+
+    std::string dir_;
+    uint64_t segmentLimit_;
+    int indexFd_ = -1;
+    std::vector<IndexEntry> index_;
+    std::vector<Segment> segments_;
+    int prunedBelow_ = 0;
+    bool ok_ = false;
+};
@@ -1,17 +1,45 @@
 // src/storage/ledger_db.cpp
 #include "ledger_db.h"
-#include <iostream>
+#include "block_codec.h"
+#include "../blockchain/block_executor.h"
+#include "../logging/logger.h"
+#include <algorithm>
+#include <cstdint>
 #include <fstream>
 #include <sstream>
 
+namespace {
+
+std::string keyFromWallet(const char* stored) {
+    std::string key(stored);
+    return key.rfind("generated_", 0) == 0 ? std::string() : key;
+}
+
+// user_version базы: 0 — суммы в монетах (REAL), 1 — в минимальных единицах,
+// 2 — у транзакций хранится nonce
+constexpr int SCHEMA_VERSION = 2;
+
+int queryInt(sqlite3* db, const char* sql) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return 0;
+    int value = sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : 0;
+    sqlite3_finalize(stmt);
+    return value;
+}
+
+} // namespace
+
 LedgerDB::LedgerDB(const std::string& path) {
     int rc = sqlite3_open(path.c_str(), &db);
     if (rc) {
-        std::cerr << "Can't open database: " << sqlite3_errmsg(db) << std::endl;
+        LOG_ERROR(STORAGE, "Can't open database").kv("path", path).kv("error", sqlite3_errmsg(db));
         throw std::runtime_error("Can't open database");
     }
     
     execute("PRAGMA foreign_keys = ON;");
+    // Версию смотрим до схемы: она создаёт таблицы новой базы уже в новых единицах
+    bool existing = queryInt(db, "SELECT count(*) FROM sqlite_master WHERE type = 'table' AND name = 'transactions';") > 0;
+    int version = queryInt(db, "PRAGMA user_version;");
     
     std::ifstream file("schema.sql");
     if (file.is_open()) {
@@ -26,6 +54,27 @@ LedgerDB::LedgerDB(const std::string& path) {
             execute(ss.str());
         }
     }
+
+    if (version < SCHEMA_VERSION) {
+        std::string sql = "PRAGMA user_version = " + std::to_string(SCHEMA_VERSION) + ";";
+        // У старых транзакций nonce не было и в хэш он не входил: хватает 0
+        if (existing) sql = "ALTER TABLE transactions ADD COLUMN nonce INTEGER NOT NULL DEFAULT 0;" + sql;
+        if (existing && version < 1) {
+            // Суммы из монет в минимальные единицы. Тип столбцов старой базы
+            // остаётся REAL, но значения в них целые и точные до 2^53 единиц;
+            // undo-записи и mempool читаются по своей версии и не переписываются
+            LOG_INFO(STORAGE, "Converting amounts to minor units").kv("path", path);
+            std::string scale = std::to_string(COIN);
+            sql = "BEGIN;"
+                  "UPDATE transactions SET amount = CAST(ROUND(amount * " + scale + ") AS INTEGER), "
+                  "fee = CAST(ROUND(fee * " + scale + ") AS INTEGER);"
+                  "UPDATE account_state SET balance = CAST(ROUND(balance * " + scale + ") AS INTEGER);" +
+                  sql + "COMMIT;";
+        }
+        execute(sql);
+    }
+    loadSnapshotBase();
+    loadPrunedHeight();
 }
 
 LedgerDB::~LedgerDB() {
@@ -36,7 +85,7 @@ bool LedgerDB::execute(const std::string& sql) {
     char* errMsg = nullptr;
     int rc = sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg);
     if (rc != SQLITE_OK) {
-        std::cerr << "SQL error: " << errMsg << std::endl;
+        LOG_ERROR(STORAGE, "SQL error").kv("error", errMsg);
         sqlite3_free(errMsg);
         return false;
     }
@@ -44,6 +93,7 @@ bool LedgerDB::execute(const std::string& sql) {
 }
 
 bool LedgerDB::ensureWalletExists(const std::string& address) {
+    nexus::ScopedTimer timer(queryObserver_, "wallet");
     const char* check_sql = "SELECT address FROM wallets WHERE address = ?;";
     sqlite3_stmt* stmt;
     
@@ -89,11 +139,26 @@ bool LedgerDB::rollbackTransaction() {
 }
 
 bool LedgerDB::addBlock(const Block& block) {
-    const char* sql = "INSERT INTO blocks (height, hash, prev_hash, merkle_root, timestamp, nonce, difficulty, mined_by, tx_count) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    nexus::ScopedTimer timer(queryObserver_, "add_block");
+    // Блок пишется целиком или никак. SAVEPOINT вкладывается и в открытую
+    // beginTransaction (реорганизация), и работает сам по себе
+    if (!execute("SAVEPOINT add_block;")) return false;
+    bool ok = insertBlockRow(block, static_cast<int>(block.transactions.size())) &&
+              addBlockTransactions(block);
+    if (!ok) {
+        LOG_ERROR(STORAGE, "Block not stored").kv("height", block.height);
+        execute("ROLLBACK TO add_block;");
+    }
+    execute("RELEASE add_block;");
+    return ok;
+}
+
+bool LedgerDB::insertBlockRow(const Block& block, int txCount) {
+    const char* sql = "INSERT INTO blocks (height, hash, prev_hash, merkle_root, timestamp, nonce, difficulty, mined_by, tx_count, block_size) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
     
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Failed to prepare statement: " << sqlite3_errmsg(db) << std::endl;
+        LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
         return false;
     }
     
@@ -105,21 +170,169 @@ bool LedgerDB::addBlock(const Block& block) {
     sqlite3_bind_int(stmt, 6, block.nonce);
     sqlite3_bind_double(stmt, 7, block.difficulty);
     sqlite3_bind_text(stmt, 8, block.minedBy.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int(stmt, 9, block.transactions.size());
+    sqlite3_bind_int(stmt, 9, txCount);
+    sqlite3_bind_int64(stmt, 10, static_cast<int64_t>(encodedBlockSize(block)));
     
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
-    
-    if (rc == SQLITE_DONE) {
-        for (const auto& tx : block.transactions) {
-            addTransaction(tx, block.height);
+    return rc == SQLITE_DONE;
+}
+
+bool LedgerDB::addBlockTransactions(const Block& block) {
+    bool ok = true;
+    for (size_t i = 0; i < block.transactions.size(); ++i) {
+        ok = addTransaction(block.transactions[i], block.height, static_cast<int>(i)) && ok;
+    }
+    if (!ok || !addAddressHistory(block)) {
+        LOG_ERROR(STORAGE, "Can't store block transactions").kv("height", block.height);
+        return false;
+    }
+
+    // Балансы не читаются: изменения суммируются в пуле и прибавляются в SQL
+    BlockExecution execution = BlockExecutor(executionPool_).execute(block.transactions, nullptr,
+        [](size_t, const Transaction&) { return true; });
+    if (execution.overflow) {
+        LOG_ERROR(STORAGE, "Balance overflow in block").kv("height", block.height);
+        return false;
+    }
+    BlockUndo undo;
+    undo.height = block.height;
+    undo.hash = block.hash;
+    undo.balanceDeltas.assign(execution.balanceDeltas.begin(), execution.balanceDeltas.end());
+    if (!applyBalanceDeltas(undo, +1) || !raiseSenderNonces(block, undo)) {
+        LOG_ERROR(STORAGE, "Can't apply block to account state").kv("height", block.height);
+        return false;
+    }
+    const char* sql = "INSERT OR REPLACE INTO block_undo (height, hash, data) VALUES (?, ?, ?);";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
+        return false;
+    }
+    std::string data = encodeBlockUndo(undo);
+    sqlite3_bind_int(stmt, 1, block.height);
+    sqlite3_bind_text(stmt, 2, block.hash.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_blob(stmt, 3, data.data(), static_cast<int>(data.size()), SQLITE_STATIC);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) {
+        LOG_ERROR(STORAGE, "Can't store block undo").kv("height", block.height).kv("error", sqlite3_errmsg(db));
+        return false;
+    }
+    return true;
+}
+
+bool LedgerDB::removeBlockTransactions(int height) {
+    // Блоки из баз без block_undo откатываются по строкам их транзакций
+    auto undo = LedgerDB::getBlockUndo(height);
+    if (!undo) {
+        auto block = getBlockHeader(height);
+        if (!block) return false;
+        block->transactions = LedgerDB::getTransactionsByBlock(height);
+        undo.emplace();
+        if (!makeBlockUndo(*block, *undo)) return false;
+    }
+    bool ok = applyBalanceDeltas(*undo, -1);
+    for (const auto& [address, nonce] : undo->previousNonces) ok = updateNonce(address, nonce) && ok;
+    return ok &&
+           executeForHeight("DELETE FROM block_undo WHERE height = ?;", height) &&
+           executeForHeight("DELETE FROM address_history WHERE height = ?;", height) &&
+           executeForHeight("DELETE FROM transactions WHERE block_height = ?;", height);
+}
+
+bool LedgerDB::applyBalanceDeltas(const BlockUndo& undo, int sign) {
+    const char* sql =
+        "INSERT INTO account_state (address, balance) VALUES (?, ?) "
+        "ON CONFLICT(address) DO UPDATE SET balance = balance + excluded.balance;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
+        return false;
+    }
+    bool ok = true;
+    for (const auto& [address, delta] : undo.balanceDeltas) {
+        sqlite3_bind_text(stmt, 1, address.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, sign * delta);
+        ok = sqlite3_step(stmt) == SQLITE_DONE && ok;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool LedgerDB::raiseSenderNonces(const Block& block, BlockUndo& undo) {
+    for (const auto& [address, nonce] : blockSenderNonces(block)) {
+        // getNextNonce — хранимый nonce + 1
+        uint64_t current = getNextNonce(address) - 1;
+        if (nonce <= current) continue;
+        if (!ensureWalletExists(address) || !updateNonce(address, nonce)) return false;
+        undo.previousNonces.emplace_back(address, current);
+    }
+    return true;
+}
+
+bool LedgerDB::executeForHeight(const char* sql, int height) {
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
+        return false;
+    }
+    sqlite3_bind_int(stmt, 1, height);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+std::optional<BlockUndo> LedgerDB::getBlockUndo(int height) {
+    const char* sql = "SELECT data FROM block_undo WHERE height = ?;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return std::nullopt;
+    }
+    sqlite3_bind_int(stmt, 1, height);
+    std::optional<BlockUndo> undo;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        std::string_view data(static_cast<const char*>(sqlite3_column_blob(stmt, 0)),
+                              static_cast<size_t>(sqlite3_column_bytes(stmt, 0)));
+        BlockUndo decoded;
+        if (decodeBlockUndo(data, decoded)) undo = std::move(decoded);
+    }
+    sqlite3_finalize(stmt);
+    return undo;
+}
+
+bool LedgerDB::addAddressHistory(const Block& block) {
+    // Перевод самому себе даёт одну строку: ключ (адрес, высота, позиция)
+    const char* sql =
+        "INSERT OR IGNORE INTO address_history (address, height, tx_index, tx_hash) VALUES (?, ?, ?, ?);";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    bool ok = true;
+    for (size_t i = 0; i < block.transactions.size(); ++i) {
+        const Transaction& tx = block.transactions[i];
+        for (const std::string* address : {&tx.fromAddress, &tx.toAddress}) {
+            sqlite3_bind_text(stmt, 1, address->c_str(), -1, SQLITE_STATIC);
+            sqlite3_bind_int(stmt, 2, block.height);
+            sqlite3_bind_int(stmt, 3, static_cast<int>(i));
+            sqlite3_bind_text(stmt, 4, tx.txHash.c_str(), -1, SQLITE_STATIC);
+            ok = sqlite3_step(stmt) == SQLITE_DONE && ok;
+            sqlite3_reset(stmt);
         }
-        return true;
     }
-    return false;
+    sqlite3_finalize(stmt);
+    return ok;
 }
 
 std::optional<Block> LedgerDB::getBlockByHeight(int height) {
+    nexus::ScopedTimer timer(queryObserver_, "get_block");
+    auto block = getBlockHeader(height);
+    if (block) block->transactions = getTransactionsByBlock(height);
+    return block;
+}
+
+std::optional<Block> LedgerDB::getBlockHeader(int height) {
     const char* sql = "SELECT * FROM blocks WHERE height = ?;";
     sqlite3_stmt* stmt;
     
@@ -150,8 +363,6 @@ std::optional<Block> LedgerDB::getBlockByHeight(int height) {
         if (miner_str) block.minedBy = miner_str;
         
         sqlite3_finalize(stmt);
-        
-        block.transactions = getTransactionsByBlock(height);
         return block;
     }
     
@@ -160,26 +371,242 @@ std::optional<Block> LedgerDB::getBlockByHeight(int height) {
 }
 
 std::optional<Block> LedgerDB::getBlockByHash(const std::string& hash) {
+    int height = getBlockHeight(hash);
+    if (height < 0) return std::nullopt;
+    return getBlockByHeight(height);
+}
+
+int LedgerDB::getBlockHeight(const std::string& hash) {
+    nexus::ScopedTimer timer(queryObserver_, "get_block_by_hash");
     const char* sql = "SELECT height FROM blocks WHERE hash = ?;";
     sqlite3_stmt* stmt;
     
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        return std::nullopt;
+        return -1;
     }
     
     sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_STATIC);
     
+    int height = -1;
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-        int height = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
-        return getBlockByHeight(height);
+        height = sqlite3_column_int(stmt, 0);
     }
     
     sqlite3_finalize(stmt);
-    return std::nullopt;
+    return height;
+}
+
+int LedgerDB::getBlockTxCount(int height) {
+    const char* sql = "SELECT tx_count FROM blocks WHERE height = ?;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, height);
+    int count = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        count = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return count;
+}
+
+bool LedgerDB::removeBlock(int height) {
+    nexus::ScopedTimer timer(queryObserver_, "remove_block");
+    // Ниже базы снимка и обрезанной истории нет ни undo-записей, ни транзакций
+    if (height <= snapshotBase_.height) {
+        LOG_WARN(STORAGE, "Can't remove block below snapshot base")
+            .kv("height", height).kv("base", snapshotBase_.height);
+        return false;
+    }
+    if (height <= prunedHeight_) {
+        LOG_WARN(STORAGE, "Can't remove pruned block").kv("height", height).kv("pruned", prunedHeight_);
+        return false;
+    }
+    // Транзакции блока удаляются целиком: при добавлении нового блока
+    // они будут пересозданы
+    if (!removeBlockTransactions(height)) return false;
+    return executeForHeight("DELETE FROM blocks WHERE height = ?;", height);
+}
+
+bool LedgerDB::scanBalances(const std::function<void(const std::string&, Amount)>& visit) {
+    nexus::ScopedTimer timer(queryObserver_, "scan_balances");
+    const char* sql = "SELECT address, balance FROM account_state WHERE balance != 0 ORDER BY address;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
+        return false;
+    }
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        visit(reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)), sqlite3_column_int64(stmt, 1));
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE;
+}
+
+bool LedgerDB::importSnapshot(const SnapshotBase& base, const std::vector<Block>& headers,
+                              const std::vector<SnapshotAccount>& accounts) {
+    nexus::ScopedTimer timer(queryObserver_, "import_snapshot");
+    int height = getLatestHeight();
+    if (height != 0 || snapshotBase_.height >= 0) {
+        LOG_ERROR(STORAGE, "Snapshot needs a database with only the genesis block").kv("height", height);
+        return false;
+    }
+    if (!beginTransaction()) return false;
+    bool ok = true;
+    for (const auto& header : headers) {
+        if (!(ok = insertBlockRow(header, 0))) break;
+    }
+    ok = ok && importSnapshotState(base, accounts);
+
+    const char* sql = "INSERT INTO snapshot_base (id, height, hash, commitment, verified, loaded_at) "
+                      "VALUES (1, ?, ?, ?, 0, ?);";
+    sqlite3_stmt* stmt;
+    if (ok && sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, base.height);
+        sqlite3_bind_text(stmt, 2, base.hash.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 3, base.commitment.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 4, time(nullptr));
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_finalize(stmt);
+    } else {
+        ok = false;
+    }
+    if (!ok || !commitTransaction()) {
+        LOG_ERROR(STORAGE, "Can't import snapshot").kv("height", base.height).kv("error", sqlite3_errmsg(db));
+        rollbackTransaction();
+        return false;
+    }
+    snapshotBase_ = base;
+    snapshotBase_.verified = false;
+    return true;
+}
+
+bool LedgerDB::importSnapshotState(const SnapshotBase&, const std::vector<SnapshotAccount>& accounts) {
+    if (!execute("DELETE FROM account_state;")) return false;
+    const char* sql = "INSERT INTO account_state (address, balance) VALUES (?, ?);";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
+        return false;
+    }
+    bool ok = true;
+    for (const auto& account : accounts) {
+        sqlite3_bind_text(stmt, 1, account.address.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, account.balance);
+        ok = sqlite3_step(stmt) == SQLITE_DONE && ok;
+        sqlite3_reset(stmt);
+    }
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+void LedgerDB::loadSnapshotBase() {
+    const char* sql = "SELECT height, hash, commitment, verified FROM snapshot_base WHERE id = 1;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) return;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        snapshotBase_.height = sqlite3_column_int(stmt, 0);
+        snapshotBase_.hash = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+        snapshotBase_.commitment = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        int verified = sqlite3_column_int(stmt, 3);
+        snapshotBase_.verified = verified > 0;
+        snapshotBase_.historyMismatch = verified < 0;
+    }
+    sqlite3_finalize(stmt);
+}
+
+bool LedgerDB::setSnapshotVerified(bool matched) {
+    if (!execute(matched ? "UPDATE snapshot_base SET verified = 1;" : "UPDATE snapshot_base SET verified = -1;")) {
+        return false;
+    }
+    snapshotBase_.verified = matched;
+    snapshotBase_.historyMismatch = !matched;
+    return true;
+}
+
+void LedgerDB::loadPrunedHeight() {
+    prunedHeight_ = queryInt(db, "SELECT COALESCE(MAX(height), 0) FROM prune_state;");
+}
+
+int LedgerDB::pruneBlocks(int height, int maxBlocks) {
+    // Ниже базы снимка тел нет с самого начала
+    int from = std::max(prunedHeight_, snapshotBase_.height) + 1;
+    int to = std::min({height, from + maxBlocks - 1, getLatestHeight()});
+    if (to < from) return prunedHeight_;
+
+    nexus::ScopedTimer timer(queryObserver_, "prune_blocks");
+    if (!beginTransaction()) return -1;
+    bool ok = pruneBlockTransactions(from, to);
+    const char* sql = "INSERT OR REPLACE INTO prune_state (id, height, updated_at) VALUES (1, ?, ?);";
+    sqlite3_stmt* stmt;
+    if (ok && sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, to);
+        sqlite3_bind_int64(stmt, 2, time(nullptr));
+        ok = sqlite3_step(stmt) == SQLITE_DONE;
+        sqlite3_finalize(stmt);
+    } else {
+        ok = false;
+    }
+    if (!ok || !commitTransaction()) {
+        LOG_ERROR(STORAGE, "Can't prune blocks").kv("from", from).kv("to", to).kv("error", sqlite3_errmsg(db));
+        rollbackTransaction();
+        return -1;
+    }
+    prunedHeight_ = to;
+    // Страницы удалённых строк — обратно файлу; их столько, сколько
+    // освободила эта пачка, поэтому шаг короткий
+    execute("PRAGMA incremental_vacuum;");
+    return prunedHeight_;
+}
+
+bool LedgerDB::pruneBlockTransactions(int from, int to) {
+    const char* statements[] = {
+        "DELETE FROM transactions WHERE block_height BETWEEN ? AND ?;",
+        "DELETE FROM address_history WHERE height BETWEEN ? AND ?;",
+        "DELETE FROM block_undo WHERE height BETWEEN ? AND ?;",
+    };
+    for (const char* sql : statements) {
+        sqlite3_stmt* stmt;
+        if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+            LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
+            return false;
+        }
+        sqlite3_bind_int(stmt, 1, from);
+        sqlite3_bind_int(stmt, 2, to);
+        int rc = sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+        if (rc != SQLITE_DONE) return false;
+    }
+    return true;
+}
+
+int LedgerDB::lowestHeightWithin(uint64_t bytes) {
+    // Строки баз, созданных до block_size, считаются по 200 байт на транзакцию
+    const char* sql =
+        "SELECT MIN(height) FROM ("
+        "SELECT height, SUM(COALESCE(block_size, 200 * (tx_count + 1))) "
+        "OVER (ORDER BY height DESC ROWS UNBOUNDED PRECEDING) AS total FROM blocks WHERE height > ?"
+        ") WHERE total <= ?;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
+        return -1;
+    }
+    sqlite3_bind_int(stmt, 1, std::max(prunedHeight_, snapshotBase_.height));
+    sqlite3_bind_int64(stmt, 2, static_cast<int64_t>(std::min<uint64_t>(bytes, INT64_MAX)));
+    int height = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        // NULL — не умещается даже вершина
+        height = sqlite3_column_type(stmt, 0) == SQLITE_NULL ? getLatestHeight() + 1 : sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return height;
 }
 
 int LedgerDB::getLatestHeight() {
+    nexus::ScopedTimer timer(queryObserver_, "latest_height");
     const char* sql = "SELECT MAX(height) FROM blocks;";
     sqlite3_stmt* stmt;
     
@@ -196,32 +623,132 @@ int LedgerDB::getLatestHeight() {
     return height;
 }
 
-bool LedgerDB::addTransaction(const Transaction& tx, int blockHeight) {
-    const char* sql = "INSERT INTO transactions (tx_hash, block_height, from_address, to_address, amount, fee, signature, timestamp, data, status) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+bool LedgerDB::addTransaction(const Transaction& tx, int blockHeight, int txIndex) {
+    nexus::ScopedTimer timer(queryObserver_, "add_tx");
+    // Транзакция блока обычно уже лежит в таблице как pending (попала туда из
+    // mempool): тогда она только подтверждается. Повторная pending-вставка
+    // существующую запись не трогает.
+    const char* sql =
+        "INSERT INTO transactions (tx_hash, block_height, tx_index, from_address, to_address, amount, fee, "
+        "signature, timestamp, data, status, nonce) VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?) "
+        "ON CONFLICT(tx_hash) DO UPDATE SET block_height = excluded.block_height, "
+        "tx_index = excluded.tx_index, status = excluded.status "
+        "WHERE excluded.block_height IS NOT NULL;";
     
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
         return false;
     }
     
+    bool confirmed = blockHeight >= 0;
     sqlite3_bind_text(stmt, 1, tx.txHash.c_str(), -1, SQLITE_STATIC);
-    if (blockHeight >= 0) sqlite3_bind_int(stmt, 2, blockHeight);
+    if (confirmed) sqlite3_bind_int(stmt, 2, blockHeight);
     else sqlite3_bind_null(stmt, 2);
-    sqlite3_bind_text(stmt, 3, tx.fromAddress.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 4, tx.toAddress.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_double(stmt, 5, tx.amount);
-    sqlite3_bind_double(stmt, 6, tx.fee);
-    sqlite3_bind_text(stmt, 7, tx.signature.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_int64(stmt, 8, tx.timestamp);
-    sqlite3_bind_text(stmt, 9, tx.data.c_str(), -1, SQLITE_STATIC);
-    sqlite3_bind_text(stmt, 10, tx.status.c_str(), -1, SQLITE_STATIC);
+    if (confirmed && txIndex >= 0) sqlite3_bind_int(stmt, 3, txIndex);
+    else sqlite3_bind_null(stmt, 3);
+    sqlite3_bind_text(stmt, 4, tx.fromAddress.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 5, tx.toAddress.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 6, tx.amount);
+    sqlite3_bind_int64(stmt, 7, tx.fee);
+    sqlite3_bind_text(stmt, 8, tx.signature.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 9, tx.timestamp);
+    sqlite3_bind_text(stmt, 10, tx.data.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 11, confirmed ? "confirmed" : tx.status.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 12, static_cast<sqlite3_int64>(tx.nonce));
     
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE) return false;
+    return tx.publicKey.empty() || storePublicKey(tx.fromAddress, tx.publicKey);
+}
+
+// Ключ адреса один и выводится в сам адрес, поэтому колонки в transactions
+// для него нет: он хранится в wallets.public_key, где у адресов без ключа
+// записана заглушка "generated_<адрес>"
+bool LedgerDB::storePublicKey(const std::string& address, const std::string& publicKey) {
+    const char* sql =
+        "INSERT INTO wallets (address, public_key, created_at) VALUES (?, ?, ?) "
+        "ON CONFLICT(address) DO UPDATE SET public_key = excluded.public_key "
+        "WHERE wallets.public_key <> excluded.public_key;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, address.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 2, publicKey.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 3, time(nullptr));
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
     return rc == SQLITE_DONE;
 }
 
+int LedgerDB::getTransactionHeight(const std::string& hash) {
+    nexus::ScopedTimer timer(queryObserver_, "get_tx");
+    const char* sql = "SELECT block_height FROM transactions WHERE tx_hash = ? AND block_height IS NOT NULL;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return -1;
+    }
+    sqlite3_bind_text(stmt, 1, hash.c_str(), -1, SQLITE_STATIC);
+    int height = -1;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        height = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return height;
+}
+
+bool LedgerDB::getAddressHistory(const std::string& address, const std::string& cursor, int limit,
+                                 AddressHistoryPage& page) {
+    nexus::ScopedTimer timer(queryObserver_, "address_history");
+    if (limit <= 0) return false;
+    // Без курсора начинаем выше любой позиции. Страница — спуск по первичному
+    // ключу от курсора, без OFFSET: цена не зависит от номера страницы
+    int height = INT32_MAX;
+    int txIndex = INT32_MAX;
+    if (!cursor.empty() && !decodeHistoryCursor(cursor, height, txIndex)) return false;
+    const char* sql =
+        "SELECT height, tx_index, tx_hash FROM address_history "
+        "WHERE address = ? AND (height, tx_index) < (?, ?) "
+        "ORDER BY height DESC, tx_index DESC LIMIT ?;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare statement").kv("error", sqlite3_errmsg(db));
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, address.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, height);
+    sqlite3_bind_int(stmt, 3, txIndex);
+    // Лишняя строка показывает, есть ли следующая страница
+    sqlite3_bind_int(stmt, 4, limit + 1);
+
+    std::vector<std::pair<AddressHistoryEntry, std::string>> rows;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        AddressHistoryEntry entry;
+        entry.height = sqlite3_column_int(stmt, 0);
+        entry.txIndex = sqlite3_column_int(stmt, 1);
+        rows.emplace_back(std::move(entry), reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2)));
+    }
+    sqlite3_finalize(stmt);
+
+    page.entries.clear();
+    page.nextCursor.clear();
+    for (auto& [entry, hash] : rows) {
+        if (static_cast<int>(page.entries.size()) == limit) {
+            const auto& last = page.entries.back();
+            page.nextCursor = encodeHistoryCursor(last.height, last.txIndex);
+            break;
+        }
+        auto tx = getTransactionByHash(hash);
+        if (!tx) continue;
+        entry.tx = std::move(*tx);
+        page.entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
 bool LedgerDB::updateTransactionStatus(const std::string& txHash, const std::string& status) {
+    nexus::ScopedTimer timer(queryObserver_, "update_tx");
     const char* sql = "UPDATE transactions SET status = ? WHERE tx_hash = ?;";
     
     sqlite3_stmt* stmt;
@@ -239,8 +766,13 @@ bool LedgerDB::updateTransactionStatus(const std::string& txHash, const std::str
 }
 
 std::vector<Transaction> LedgerDB::getTransactionsByBlock(int height) {
+    nexus::ScopedTimer timer(queryObserver_, "block_txs");
     std::vector<Transaction> txs;
-    const char* sql = "SELECT * FROM transactions WHERE block_height = ?;";
+    // Колонки перечислены явно: индексы ниже не должны зависеть от порядка в схеме
+    const char* sql =
+        "SELECT t.id, t.tx_hash, t.block_height, t.from_address, t.to_address, t.amount, t.fee, t.signature, "
+        "t.timestamp, t.data, t.status, w.public_key, t.nonce FROM transactions t "
+        "LEFT JOIN wallets w ON w.address = t.from_address WHERE t.block_height = ? ORDER BY t.tx_index, t.id;";
     
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
@@ -261,8 +793,8 @@ std::vector<Transaction> LedgerDB::getTransactionsByBlock(int height) {
         const char* to_str = (const char*)sqlite3_column_text(stmt, 4);
         if (to_str) tx.toAddress = to_str;
         
-        tx.amount = sqlite3_column_double(stmt, 5);
-        tx.fee = sqlite3_column_double(stmt, 6);
+        tx.amount = sqlite3_column_int64(stmt, 5);
+        tx.fee = sqlite3_column_int64(stmt, 6);
         
         const char* sig_str = (const char*)sqlite3_column_text(stmt, 7);
         if (sig_str) tx.signature = sig_str;
@@ -274,6 +806,10 @@ std::vector<Transaction> LedgerDB::getTransactionsByBlock(int height) {
         
         const char* status_str = (const char*)sqlite3_column_text(stmt, 10);
         if (status_str) tx.status = status_str;
+
+        const char* key_str = (const char*)sqlite3_column_text(stmt, 11);
+        if (key_str && Crypto::isKeyAddress(tx.fromAddress)) tx.publicKey = keyFromWallet(key_str);
+        tx.nonce = static_cast<uint64_t>(sqlite3_column_int64(stmt, 12));
         
         txs.push_back(tx);
     }
@@ -283,7 +819,11 @@ std::vector<Transaction> LedgerDB::getTransactionsByBlock(int height) {
 }
 
 std::optional<Transaction> LedgerDB::getTransactionByHash(const std::string& hash) {
-    const char* sql = "SELECT * FROM transactions WHERE tx_hash = ?;";
+    nexus::ScopedTimer timer(queryObserver_, "get_tx");
+    const char* sql =
+        "SELECT t.id, t.tx_hash, t.block_height, t.from_address, t.to_address, t.amount, t.fee, t.signature, "
+        "t.timestamp, t.data, t.status, w.public_key, t.nonce FROM transactions t "
+        "LEFT JOIN wallets w ON w.address = t.from_address WHERE t.tx_hash = ?;";
     sqlite3_stmt* stmt;
     
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
@@ -304,8 +844,8 @@ std::optional<Transaction> LedgerDB::getTransactionByHash(const std::string& has
         const char* to_str = (const char*)sqlite3_column_text(stmt, 4);
         if (to_str) tx.toAddress = to_str;
         
-        tx.amount = sqlite3_column_double(stmt, 5);
-        tx.fee = sqlite3_column_double(stmt, 6);
+        tx.amount = sqlite3_column_int64(stmt, 5);
+        tx.fee = sqlite3_column_int64(stmt, 6);
         
         const char* sig_str = (const char*)sqlite3_column_text(stmt, 7);
         if (sig_str) tx.signature = sig_str;
@@ -317,6 +857,10 @@ std::optional<Transaction> LedgerDB::getTransactionByHash(const std::string& has
         
         const char* status_str = (const char*)sqlite3_column_text(stmt, 10);
         if (status_str) tx.status = status_str;
+
+        const char* key_str = (const char*)sqlite3_column_text(stmt, 11);
+        if (key_str && Crypto::isKeyAddress(tx.fromAddress)) tx.publicKey = keyFromWallet(key_str);
+        tx.nonce = static_cast<uint64_t>(sqlite3_column_int64(stmt, 12));
         
         sqlite3_finalize(stmt);
         return tx;
@@ -326,10 +870,13 @@ std::optional<Transaction> LedgerDB::getTransactionByHash(const std::string& has
     return std::nullopt;
 }
 
-double LedgerDB::getBalance(const std::string& address) {
+Amount LedgerDB::getBalance(const std::string& address) {
+    nexus::ScopedTimer timer(queryObserver_, "balance");
     ensureWalletExists(address);
     
-    const char* sql = "SELECT balance FROM wallet_balance WHERE address = ?;";
+    // Готовый баланс из account_state: представление wallet_balance
+    // суммировало бы всю историю адреса
+    const char* sql = "SELECT balance FROM account_state WHERE address = ?;";
     sqlite3_stmt* stmt;
     
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
@@ -338,9 +885,9 @@ double LedgerDB::getBalance(const std::string& address) {
     
     sqlite3_bind_text(stmt, 1, address.c_str(), -1, SQLITE_STATIC);
     
-    double balance = 0;
+    Amount balance = 0;
     if (sqlite3_step(stmt) == SQLITE_ROW) {
-        balance = sqlite3_column_double(stmt, 0);
+        balance = sqlite3_column_int64(stmt, 0);
     }
     
     sqlite3_finalize(stmt);
@@ -348,6 +895,7 @@ double LedgerDB::getBalance(const std::string& address) {
 }
 
 bool LedgerDB::addToMempool(const Transaction& tx) {
+    nexus::ScopedTimer timer(queryObserver_, "mempool_add");
     const char* sql = "INSERT INTO mempool (tx_hash, tx_data, received_at) VALUES (?, ?, ?);";
     
     sqlite3_stmt* stmt;
@@ -365,6 +913,7 @@ bool LedgerDB::addToMempool(const Transaction& tx) {
 }
 
 std::vector<Transaction> LedgerDB::getMempool() {
+    nexus::ScopedTimer timer(queryObserver_, "mempool_read");
     std::vector<Transaction> txs;
     const char* sql = "SELECT tx_hash FROM mempool ORDER BY received_at;";
     
@@ -391,6 +940,7 @@ void LedgerDB::clearMempool() {
 }
 
 uint64_t LedgerDB::getNextNonce(const std::string& address) {
+    nexus::ScopedTimer timer(queryObserver_, "nonce");
     const char* sql = "SELECT nonce FROM wallets WHERE address = ?;";
     sqlite3_stmt* stmt;
     sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr);
@@ -408,12 +958,14 @@ bool LedgerDB::addPeer(const std::string& ip, int port, const std::string& node_
     const char* sql = "INSERT OR IGNORE INTO peers (ip_address, port, node_id, last_seen, failed_attempts) VALUES (?, ?, ?, ?, 0);";
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Failed to prepare addPeer: " << sqlite3_errmsg(db) << std::endl;
+        LOG_ERROR(STORAGE, "Failed to prepare addPeer").kv("error", sqlite3_errmsg(db));
         return false;
     }
     sqlite3_bind_text(stmt, 1, ip.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int(stmt, 2, port);
-    sqlite3_bind_text(stmt, 3, node_id.c_str(), -1, SQLITE_STATIC);
+    // node_id уникален: неизвестный id пишем как NULL, иначе сохранится только первый такой пир
+    if (node_id.empty()) sqlite3_bind_null(stmt, 3);
+    else sqlite3_bind_text(stmt, 3, node_id.c_str(), -1, SQLITE_STATIC);
     sqlite3_bind_int64(stmt, 4, time(nullptr));
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
@@ -430,7 +982,7 @@ std::vector<std::pair<std::string, int>> LedgerDB::getPeers(int max_count) {
     const char* sql = "SELECT ip_address, port FROM peers ORDER BY last_seen DESC LIMIT ?;";
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Failed to prepare getPeers: " << sqlite3_errmsg(db) << std::endl;
+        LOG_ERROR(STORAGE, "Failed to prepare getPeers").kv("error", sqlite3_errmsg(db));
         return result;
     }
     sqlite3_bind_int(stmt, 1, max_count);
@@ -446,6 +998,7 @@ std::vector<std::pair<std::string, int>> LedgerDB::getPeers(int max_count) {
 }
 
 void LedgerDB::updatePeerSeen(const std::string& ip, int port) {
+    nexus::ScopedTimer timer(queryObserver_, "peers");
     const char* sql = "UPDATE peers SET last_seen = ? WHERE ip_address = ? AND port = ?;";
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
@@ -457,11 +1010,109 @@ void LedgerDB::updatePeerSeen(const std::string& ip, int port) {
     }
 }
 
+int LedgerDB::getPeerFailedAttempts(const std::string& ip, int port) {
+    const char* sql = "SELECT failed_attempts FROM peers WHERE ip_address = ? AND port = ?;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        return 0;
+    }
+    sqlite3_bind_text(stmt, 1, ip.c_str(), -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, port);
+    int attempts = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        attempts = sqlite3_column_int(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return attempts;
+}
+
+void LedgerDB::setPeerFailedAttempts(const std::string& ip, int port, int attempts) {
+    // Seed-узлы могут ещё отсутствовать в таблице
+    addPeer(ip, port);
+    const char* sql = "UPDATE peers SET failed_attempts = ? WHERE ip_address = ? AND port = ?;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        sqlite3_bind_int(stmt, 1, attempts);
+        sqlite3_bind_text(stmt, 2, ip.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 3, port);
+        sqlite3_step(stmt);
+        sqlite3_finalize(stmt);
+    }
+}
+
+std::vector<PeerAddressRecord> LedgerDB::loadAddressBook(int max_count) {
+    nexus::ScopedTimer timer(queryObserver_, "peers");
+    std::vector<PeerAddressRecord> result;
+    const char* sql =
+        "SELECT p.ip_address, p.port, s.source_group, COALESCE(s.tried, 0), COALESCE(s.score, 0), "
+        "COALESCE(p.last_seen, 0), COALESCE(s.last_success, 0), COALESCE(p.failed_attempts, 0) "
+        "FROM peers p LEFT JOIN peer_scores s ON s.ip_address = p.ip_address AND s.port = p.port "
+        "ORDER BY COALESCE(s.tried, 0) DESC, COALESCE(s.score, 0) DESC, p.last_seen DESC LIMIT ?;";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare loadAddressBook").kv("error", sqlite3_errmsg(db));
+        return result;
+    }
+    sqlite3_bind_int(stmt, 1, max_count);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* ip = (const char*)sqlite3_column_text(stmt, 0);
+        if (!ip) continue;
+        PeerAddressRecord record;
+        record.ip = ip;
+        record.port = sqlite3_column_int(stmt, 1);
+        const char* group = (const char*)sqlite3_column_text(stmt, 2);
+        record.source_group = group ? group : "";
+        record.tried = sqlite3_column_int(stmt, 3) != 0;
+        record.score = sqlite3_column_double(stmt, 4);
+        record.last_seen = sqlite3_column_int64(stmt, 5);
+        record.last_success = sqlite3_column_int64(stmt, 6);
+        record.failed_attempts = sqlite3_column_int(stmt, 7);
+        result.push_back(record);
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+bool LedgerDB::saveAddressBook(const std::vector<PeerAddressRecord>& records) {
+    nexus::ScopedTimer timer(queryObserver_, "peers");
+    const char* sql =
+        "INSERT OR REPLACE INTO peer_scores (ip_address, port, source_group, tried, score, last_success, updated_at) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?);";
+    sqlite3_stmt* stmt;
+    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        LOG_ERROR(STORAGE, "Failed to prepare saveAddressBook").kv("error", sqlite3_errmsg(db));
+        return false;
+    }
+    beginTransaction();
+    time_t now = time(nullptr);
+    for (const auto& record : records) {
+        addPeer(record.ip, record.port);
+        sqlite3_reset(stmt);
+        sqlite3_bind_text(stmt, 1, record.ip.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, record.port);
+        sqlite3_bind_text(stmt, 3, record.source_group.c_str(), -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 4, record.tried ? 1 : 0);
+        sqlite3_bind_double(stmt, 5, record.score);
+        sqlite3_bind_int64(stmt, 6, record.last_success);
+        sqlite3_bind_int64(stmt, 7, now);
+        if (sqlite3_step(stmt) != SQLITE_DONE) {
+            LOG_ERROR(STORAGE, "Failed to save address")
+                .kv("ip", record.ip).kv("port", record.port).kv("error", sqlite3_errmsg(db));
+            sqlite3_finalize(stmt);
+            rollbackTransaction();
+            return false;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return commitTransaction();
+}
+
 bool LedgerDB::updateNonce(const std::string& address, uint64_t nonce) {
+    nexus::ScopedTimer timer(queryObserver_, "nonce");
     const char* sql = "UPDATE wallets SET nonce = ? WHERE address = ?;";
     sqlite3_stmt* stmt;
     if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Failed to prepare updateNonce: " << sqlite3_errmsg(db) << std::endl;
+        LOG_ERROR(STORAGE, "Failed to prepare updateNonce").kv("error", sqlite3_errmsg(db));
         return false;
     }
     sqlite3_bind_int64(stmt, 1, static_cast<sqlite3_int64>(nonce));
@@ -4,46 +4,106 @@
 #include <string>
 #include <vector>
 #include <optional>
-#include "../blockchain/block.h"
-#include "../blockchain/transaction.h"
+#include <functional>
+#include "ledger_storage.h"
 
-class LedgerDB {
+// Реализация хранилища на SQLite: блоки, транзакции, состояние и пиры в одной базе
+class LedgerDB : public LedgerStorage {
 private:
     sqlite3* db;
+    QueryObserver queryObserver_;
+    nexus::ThreadPool* executionPool_ = nullptr;
+    SnapshotBase snapshotBase_;
+    int prunedHeight_ = 0;
+
+    bool insertBlockRow(const Block& block, int txCount);
+    void loadSnapshotBase();
+    void loadPrunedHeight();
+
+protected:
+    const QueryObserver& queryObserver() const { return queryObserver_; }
+    nexus::ThreadPool* executionPool() const { return executionPool_; }
+    // Запись транзакций и состояния счетов блока после строки заголовка и
+    // их откат перед её удалением; наследник может держать их в другом
+    // хранилище. false — блок записан не целиком, addBlock его откатывает
+    virtual bool addBlockTransactions(const Block& block);
+    virtual bool removeBlockTransactions(int height);
+    // Строки address_history для транзакций блока
+    bool addAddressHistory(const Block& block);
+    // account_state += sign * изменения из undo-записи
+    bool applyBalanceDeltas(const BlockUndo& undo, int sign);
+    // Поднять nonce отправителей блока (blockSenderNonces), прежние — в undo
+    bool raiseSenderNonces(const Block& block, BlockUndo& undo);
+    // Запрос с единственным параметром — высотой
+    bool executeForHeight(const char* sql, int height);
+    // Открытый ключ адреса в wallets (вместо заглушки)
+    bool storePublicKey(const std::string& address, const std::string& publicKey);
+    // Балансы из снимка вместо account_state; вызывается внутри транзакции
+    // importSnapshot
+    virtual bool importSnapshotState(const SnapshotBase& base, const std::vector<SnapshotAccount>& accounts);
+    // Удалить тела блоков from..to; вызывается внутри транзакции pruneBlocks
+    virtual bool pruneBlockTransactions(int from, int to);
         
 public:
     LedgerDB(const std::string& path);
-    ~LedgerDB();
+    ~LedgerDB() override;
+
+    void setQueryObserver(QueryObserver observer) override { queryObserver_ = std::move(observer); }
+    void setExecutionPool(nexus::ThreadPool* pool) override { executionPool_ = pool; }
     
-    bool ensureWalletExists(const std::string& address);
+    bool ensureWalletExists(const std::string& address) override;
     
-    bool addBlock(const Block& block);
-    std::optional<Block> getBlockByHeight(int height);
-    std::optional<Block> getBlockByHash(const std::string& hash);
-    int getLatestHeight();
+    bool addBlock(const Block& block) override;
+    std::optional<Block> getBlockByHeight(int height) override;
+    std::optional<Block> getBlockByHash(const std::string& hash) override;
+    int getLatestHeight() override;
+    bool removeBlock(int height) override;
+    // Высота блока с данным хэшем или -1
+    int getBlockHeight(const std::string& hash);
+    std::optional<Block> getBlockHeader(int height) override;
+    std::optional<BlockUndo> getBlockUndo(int height) override;
+    // tx_count из строки заголовка, -1 — блока нет
+    int getBlockTxCount(int height);
 
     bool execute(const std::string& sql);
+
+    bool scanBalances(const std::function<void(const std::string&, Amount)>& visit) override;
+    bool importSnapshot(const SnapshotBase& base, const std::vector<Block>& headers,
+                        const std::vector<SnapshotAccount>& accounts) override;
+    SnapshotBase getSnapshotBase() override { return snapshotBase_; }
+    bool setSnapshotVerified(bool matched) override;
+
+    int pruneBlocks(int height, int maxBlocks) override;
+    int getPrunedHeight() override { return prunedHeight_; }
+    int lowestHeightWithin(uint64_t bytes) override;
     
-    bool addTransaction(const Transaction& tx, int blockHeight = -1);
-    bool updateTransactionStatus(const std::string& txHash, const std::string& status);
-    std::vector<Transaction> getTransactionsByBlock(int height);
-    std::optional<Transaction> getTransactionByHash(const std::string& hash);
+    bool addTransaction(const Transaction& tx, int blockHeight = -1, int txIndex = -1) override;
+    bool updateTransactionStatus(const std::string& txHash, const std::string& status) override;
+    std::vector<Transaction> getTransactionsByBlock(int height) override;
+    std::optional<Transaction> getTransactionByHash(const std::string& hash) override;
+    int getTransactionHeight(const std::string& hash) override;
+    bool getAddressHistory(const std::string& address, const std::string& cursor, int limit,
+                           AddressHistoryPage& page) override;
     
-    double getBalance(const std::string& address);
+    Amount getBalance(const std::string& address) override;
     
-    bool addToMempool(const Transaction& tx);
-    std::vector<Transaction> getMempool();
-    void clearMempool();
+    bool addToMempool(const Transaction& tx) override;
+    std::vector<Transaction> getMempool() override;
+    void clearMempool() override;
     
-    bool beginTransaction();
-    bool commitTransaction();
-    bool rollbackTransaction();
-
-    uint64_t getNextNonce(const std::string& address);
-    bool updateNonce(const std::string& address, uint64_t nonce);
-
-    bool addPeer(const std::string& ip, int port, const std::string& node_id = "");
-    bool removePeer(const std::string& ip, int port);
-    std::vector<std::pair<std::string, int>> getPeers(int max_count = 50);
-    void updatePeerSeen(const std::string& ip, int port);
-};
\ No newline at end of file
+    bool beginTransaction() override;
+    bool commitTransaction() override;
+    bool rollbackTransaction() override;
+
+    uint64_t getNextNonce(const std::string& address) override;
+    bool updateNonce(const std::string& address, uint64_t nonce) override;
+
+    bool addPeer(const std::string& ip, int port, const std::string& node_id = "") override;
+    bool removePeer(const std::string& ip, int port) override;
+    std::vector<std::pair<std::string, int>> getPeers(int max_count = 50) override;
+    void updatePeerSeen(const std::string& ip, int port) override;
+    int getPeerFailedAttempts(const std::string& ip, int port) override;
+    void setPeerFailedAttempts(const std::string& ip, int port, int attempts) override;
+    std::vector<PeerAddressRecord> loadAddressBook(int max_count) override;
+    bool saveAddressBook(const std::vector<PeerAddressRecord>& records) override;
+};
@@ -0,0 +1,105 @@
+// src/storage/ledger_storage.cpp
+#include "ledger_storage.h"
+#include "ledger_db.h"
+#include "block_file_ledger.h"
+#include "lsm_ledger.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <map>
+
+bool makeBlockUndo(const Block& block, BlockUndo& undo) {
+    std::map<std::string, Amount> deltas;
+    for (const auto& tx : block.transactions) {
+        Amount spend;
+        if (!addAmount(deltas[tx.toAddress], tx.amount, deltas[tx.toAddress]) ||
+            !addAmount(tx.amount, tx.fee, spend) ||
+            !subAmount(deltas[tx.fromAddress], spend, deltas[tx.fromAddress])) {
+            return false;
+        }
+    }
+    undo.height = block.height;
+    undo.hash = block.hash;
+    undo.balanceDeltas.assign(deltas.begin(), deltas.end());
+    return true;
+}
+
+std::map<std::string, uint64_t> blockSenderNonces(const Block& block) {
+    std::map<std::string, uint64_t> nonces;
+    for (const auto& tx : block.transactions) {
+        if (tx.fromAddress == "SYSTEM") continue;
+        uint64_t& nonce = nonces[tx.fromAddress];
+        nonce = std::max(nonce, tx.nonce + 1);
+    }
+    return nonces;
+}
+
+// Курсор — 16 hex-символов: высота и позиция по u32, старшими вперёд
+std::string encodeHistoryCursor(int height, int txIndex) {
+    static const char* HEX = "0123456789abcdef";
+    uint64_t packed = (static_cast<uint64_t>(static_cast<uint32_t>(height)) << 32) | static_cast<uint32_t>(txIndex);
+    std::string cursor(16, '0');
+    for (int i = 15; i >= 0; --i, packed >>= 4) cursor[i] = HEX[packed & 0xf];
+    return cursor;
+}
+
+bool decodeHistoryCursor(const std::string& cursor, int& height, int& txIndex) {
+    if (cursor.size() != 16) return false;
+    uint64_t packed = 0;
+    for (char c : cursor) {
+        int digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else return false;
+        packed = (packed << 4) | static_cast<uint64_t>(digit);
+    }
+    height = static_cast<int>(static_cast<uint32_t>(packed >> 32));
+    txIndex = static_cast<int>(static_cast<uint32_t>(packed));
+    return height >= 0 && txIndex >= 0;
+}
+
+bool parseStorageBackend(const std::string& name, StorageBackend& backend) {
+    if (name == "sqlite") {
+        backend = StorageBackend::SQLITE;
+        return true;
+    }
+    if (name == "blockfile") {
+        backend = StorageBackend::BLOCK_FILES;
+        return true;
+    }
+    if (name == "lsm") {
+        backend = StorageBackend::LSM;
+        return true;
+    }
+    return false;
+}
+
+bool parsePruneTarget(const std::string& text, PruneTarget& target) {
+    size_t digits = 0;
+    while (digits < text.size() && std::isdigit(static_cast<unsigned char>(text[digits]))) digits++;
+    if (digits == 0 || digits > 12) return false;
+    uint64_t value = std::stoull(text.substr(0, digits));
+    std::string unit = text.substr(digits);
+    target = PruneTarget{};
+    if (unit.empty()) {
+        if (value > INT32_MAX) return false;
+        target.blocks = static_cast<int>(value);
+    } else if (unit == "MB") {
+        target.bytes = value << 20;
+    } else if (unit == "GB") {
+        target.bytes = value << 30;
+    } else {
+        return false;
+    }
+    return target.enabled();
+}
+
+std::unique_ptr<LedgerStorage> openLedgerStorage(const std::string& path, StorageBackend backend) {
+    if (backend == StorageBackend::LSM && path != ":memory:") {
+        return std::make_unique<LsmLedger>(path, path + ".blocks", path + ".state");
+    }
+    if (backend == StorageBackend::BLOCK_FILES && path != ":memory:") {
+        return std::make_unique<BlockFileLedger>(path, path + ".blocks");
+    }
+    return std::make_unique<LedgerDB>(path);
+}
@@ -0,0 +1,194 @@
+// src/storage/ledger_storage.h
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <functional>
+#include "../blockchain/block.h"
+#include "../blockchain/transaction.h"
+#include "../metrics/scoped_timer.h"
+
+namespace nexus { class ThreadPool; }
+
+// Запись адресной книги: строка peers вместе с peer_scores
+struct PeerAddressRecord {
+    std::string ip;
+    int port = 0;
+    std::string source_group;
+    bool tried = false;
+    double score = 0;
+    time_t last_seen = 0;
+    time_t last_success = 0;
+    int failed_attempts = 0;
+};
+
+// Транзакция из истории адреса: позиция в цепочке и сама транзакция
+struct AddressHistoryEntry {
+    int height = -1;
+    int txIndex = -1;
+    Transaction tx;
+};
+
+// Страница истории адреса, от новых транзакций к старым. nextCursor —
+// непрозрачная позиция для следующей страницы, пустой — страниц больше нет
+struct AddressHistoryPage {
+    std::vector<AddressHistoryEntry> entries;
+    std::string nextCursor;
+};
+
+// Изменения состояния счетов от одного блока — всё, что нужно, чтобы его
+// отключить, не перечитывая историю. Nonce не суммируется, а только
+// растёт (blockSenderNonces), поэтому для него хранится прежнее значение
+struct BlockUndo {
+    int height = -1;
+    std::string hash;
+    std::vector<std::pair<std::string, Amount>> balanceDeltas;  // Адрес -> изменение, по адресу
+    std::vector<std::pair<std::string, uint64_t>> previousNonces;  // Отправитель -> nonce до блока, если блок его поднял
+};
+
+// Счёт в снимке состояния (state_snapshot.h)
+struct SnapshotAccount {
+    std::string address;
+    Amount balance = 0;
+};
+
+// Снимок, из которого загружена база: блоки 1..height есть только
+// заголовками, состояние на height взято из снимка. verified — история
+// до height проверена и дала то же состояние
+struct SnapshotBase {
+    int height = -1;          // -1 — база полная, от генезиса
+    std::string hash;
+    std::string commitment;
+    bool verified = false;
+    bool historyMismatch = false;  // История под снимком дала другой commitment: балансам верить нельзя
+};
+
+// Изменения балансов от транзакций блока: получатель +amount,
+// отправитель -(amount + fee). false — изменение не умещается в Amount
+bool makeBlockUndo(const Block& block, BlockUndo& undo);
+
+// Nonce, до которых блок поднимает отправителей: tx.nonce + 1 их старшей
+// транзакции — то же, что ставит приём в mempool (SYSTEM не считается).
+// Хранилище ставит его, только если хранимый nonce меньше
+std::map<std::string, uint64_t> blockSenderNonces(const Block& block);
+
+// Курсор истории: позиция последней отданной записи
+std::string encodeHistoryCursor(int height, int txIndex);
+bool decodeHistoryCursor(const std::string& cursor, int& height, int& txIndex);
+
+// Хранилище узла: блоки, транзакции, состояние счетов и пиры. Blockchain и
+// Node работают только через этот интерфейс, реализации выбираются при
+// открытии (openLedgerStorage)
+class LedgerStorage {
+public:
+    // Длительность операции хранилища по виду запроса ("add_block", "balance", ...)
+    using QueryObserver = nexus::ScopedTimer::LabelledObserver;
+
+    virtual ~LedgerStorage() = default;
+
+    virtual void setQueryObserver(QueryObserver observer) = 0;
+    // Пул для исполнения транзакций блока (BlockExecutor)
+    virtual void setExecutionPool(nexus::ThreadPool*) {}
+
+    // Блоки
+    virtual bool addBlock(const Block& block) = 0;
+    virtual std::optional<Block> getBlockByHeight(int height) = 0;
+    virtual std::optional<Block> getBlockByHash(const std::string& hash) = 0;
+    virtual int getLatestHeight() = 0;
+    // Заголовок без транзакций: сравнение цепочек по хэшам не читает тела
+    virtual std::optional<Block> getBlockHeader(int height) = 0;
+    // Отключить блок вершины: откатить балансы по его undo-записи и удалить
+    // блок вместе с транзакциями
+    virtual bool removeBlock(int height) = 0;
+    // Undo-запись подключённого блока (пишется в addBlock)
+    virtual std::optional<BlockUndo> getBlockUndo(int height) = 0;
+
+    // Снимок состояния. Балансы всех ненулевых счетов по возрастанию адреса
+    virtual bool scanBalances(const std::function<void(const std::string&, Amount)>& visit) = 0;
+    // Загрузить снимок в базу, где есть только генезис: заголовки 1..height
+    // (headers) без тел и балансы accounts вместо текущих. Блоки до base.height
+    // потом нельзя отключить; тел у них нет
+    virtual bool importSnapshot(const SnapshotBase& base, const std::vector<Block>& headers,
+                                const std::vector<SnapshotAccount>& accounts) = 0;
+    virtual SnapshotBase getSnapshotBase() = 0;
+    // Итог сверки снимка с историей; расхождение сохраняется и переживает перезапуск
+    virtual bool setSnapshotVerified(bool matched) = 0;
+
+    // Обрезка истории. У блоков 1..height удаляются тела — транзакции,
+    // история адресов, undo-записи, — а заголовки и балансы остаются; такие
+    // блоки нельзя отключить и отдать пирам. За вызов обрезается не больше
+    // maxBlocks блоков от текущей границы, место освобождается сразу же
+    // понемногу. Возвращает новую границу, -1 — ошибка
+    virtual int pruneBlocks(int height, int maxBlocks) = 0;
+    // Последняя обрезанная высота, 0 — тела всех блоков на месте
+    virtual int getPrunedHeight() = 0;
+    // Самая низкая высота, начиная с которой тела необрезанных блоков до
+    // вершины занимают не больше bytes (в записи block_codec)
+    virtual int lowestHeightWithin(uint64_t bytes) = 0;
+
+    // Транзакции. blockHeight >= 0 — транзакция подтверждена блоком (txIndex — позиция в нём)
+    virtual bool addTransaction(const Transaction& tx, int blockHeight = -1, int txIndex = -1) = 0;
+    virtual bool updateTransactionStatus(const std::string& txHash, const std::string& status) = 0;
+    virtual std::vector<Transaction> getTransactionsByBlock(int height) = 0;
+    virtual std::optional<Transaction> getTransactionByHash(const std::string& hash) = 0;
+    virtual int getTransactionHeight(const std::string& hash) = 0;  // -1 — не подтверждена или не найдена
+
+    // История адреса (отправитель или получатель) по индексу (адрес, высота,
+    // позиция), который ведётся при подключении и отключении блоков. Пустой
+    // cursor — первая страница; false — курсор не разобран
+    virtual bool getAddressHistory(const std::string& address, const std::string& cursor, int limit,
+                                   AddressHistoryPage& page) = 0;
+
+    // Состояние счетов
+    virtual bool ensureWalletExists(const std::string& address) = 0;
+    virtual Amount getBalance(const std::string& address) = 0;
+    virtual uint64_t getNextNonce(const std::string& address) = 0;
+    virtual bool updateNonce(const std::string& address, uint64_t nonce) = 0;
+
+    virtual bool addToMempool(const Transaction& tx) = 0;
+    virtual std::vector<Transaction> getMempool() = 0;
+    virtual void clearMempool() = 0;
+
+    // Пакетная запись: всё между begin и commit применяется целиком
+    virtual bool beginTransaction() = 0;
+    virtual bool commitTransaction() = 0;
+    virtual bool rollbackTransaction() = 0;
+
+    // Пиры
+    virtual bool addPeer(const std::string& ip, int port, const std::string& node_id = "") = 0;
+    virtual bool removePeer(const std::string& ip, int port) = 0;
+    virtual std::vector<std::pair<std::string, int>> getPeers(int max_count = 50) = 0;
+    virtual void updatePeerSeen(const std::string& ip, int port) = 0;
+    virtual int getPeerFailedAttempts(const std::string& ip, int port) = 0;
+    virtual void setPeerFailedAttempts(const std::string& ip, int port, int attempts) = 0;
+    virtual std::vector<PeerAddressRecord> loadAddressBook(int max_count) = 0;
+    virtual bool saveAddressBook(const std::vector<PeerAddressRecord>& records) = 0;
+};
+
+enum class StorageBackend {
+    SQLITE,         // Всё в одной базе SQLite (LedgerDB)
+    BLOCK_FILES,    // Тела блоков в файлах-сегментах, индексы и пиры в SQLite (BlockFileLedger)
+    LSM             // Как BLOCK_FILES, но счета и индекс транзакций в LsmStore (LsmLedger)
+};
+
+// "sqlite" | "blockfile" | "lsm"; false — неизвестное имя
+bool parseStorageBackend(const std::string& name, StorageBackend& backend);
+
+// Сколько истории держит узел с обрезкой: тела последних blocks блоков или
+// столько последних, сколько умещается в bytes. Оба заданы — действует
+// более жёсткое; оба нулевые — обрезки нет
+struct PruneTarget {
+    int blocks = 0;
+    uint64_t bytes = 0;
+    bool enabled() const { return blocks > 0 || bytes > 0; }
+};
+
+// "5000" — блоков, "500MB" / "2GB" — объём тел; false — не разобрано
+bool parsePruneTarget(const std::string& text, PruneTarget& target);
+
+// Открыть хранилище по пути базы. Для BLOCK_FILES сегменты лежат в каталоге
+// "<path>.blocks", для LSM состояние — в "<path>.state"; база ":memory:"
+// всегда открывается как SQLITE
+std::unique_ptr<LedgerStorage> openLedgerStorage(const std::string& path, StorageBackend backend);
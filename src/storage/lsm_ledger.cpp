@@ -0,0 +1,564 @@
+// src/storage/lsm_ledger.cpp
+#include "lsm_ledger.h"
+#include "block_codec.h"
+#include "../logging/logger.h"
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const char* TIP_KEY = "m:tip";
+const char* FORMAT_KEY = "m:format";
+// Формат записей счетов: 1 — i64 минимальных единиц; без ключа — f64 монет
+constexpr uint64_t STATE_FORMAT = 1;
+
+void put_le(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+uint64_t get_le(const char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+std::string accountKey(const std::string& address) { return "a" + address; }
+std::string txKey(const std::string& hash) { return "t" + hash; }
+
+// Высота big-endian: ключи блоков идут в порядке высот
+std::string heightKey(char prefix, int height) {
+    std::string key(1, prefix);
+    for (int shift = 24; shift >= 0; shift -= 8) key.push_back(static_cast<char>(static_cast<uint32_t>(height) >> shift));
+    return key;
+}
+
+std::string blockKey(int height) { return heightKey('b', height); }
+std::string undoKey(int height) { return heightKey('u', height); }
+
+// Префикс истории адреса и ключ позиции в ней
+std::string historyPrefix(const std::string& address) {
+    std::string key = "h" + address;
+    key.push_back('\0');
+    return key;
+}
+
+std::string historyKey(const std::string& address, int height, int index) {
+    std::string key = historyPrefix(address);
+    for (uint32_t value : {~static_cast<uint32_t>(height), ~static_cast<uint32_t>(index)}) {
+        for (int shift = 24; shift >= 0; shift -= 8) key.push_back(static_cast<char>(value >> shift));
+    }
+    return key;
+}
+
+uint32_t get_be32(const char* in) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) value = (value << 8) | static_cast<unsigned char>(in[i]);
+    return value;
+}
+
+std::string encodeHeight(int height) {
+    std::string out;
+    put_le(out, static_cast<uint64_t>(static_cast<int64_t>(height)), 8);
+    return out;
+}
+
+// Хэш блока и хэши его транзакций: строки с префиксом длины u32
+std::string encodeStrings(const std::vector<std::string>& items) {
+    std::string out;
+    for (const auto& item : items) {
+        put_le(out, item.size(), 4);
+        out.append(item);
+    }
+    return out;
+}
+
+std::vector<std::string> decodeStrings(std::string_view data) {
+    std::vector<std::string> items;
+    size_t pos = 0;
+    while (pos + 4 <= data.size()) {
+        size_t size = get_le(data.data() + pos, 4);
+        if (pos + 4 + size > data.size()) break;
+        items.emplace_back(data.substr(pos + 4, size));
+        pos += 4 + size;
+    }
+    return items;
+}
+
+// Запись счёта: i64 баланс в минимальных единицах, u64 nonce
+std::string encodeAccount(Amount balance, uint64_t nonce) {
+    std::string value;
+    put_le(value, static_cast<uint64_t>(balance), 8);
+    put_le(value, nonce, 8);
+    return value;
+}
+
+bool countsInBalance(int height, const Transaction& tx) {
+    return height >= 0 && tx.status == "confirmed";
+}
+
+} // namespace
+
+LsmLedger::LsmLedger(const std::string& path, const std::string& blockDir, const std::string& stateDir,
+                     LsmOptions options)
+    : BlockFileLedger(path, blockDir, true), state_(stateDir, options) {
+    if (!state_.ok()) {
+        LOG_ERROR(STORAGE, "Can't open LSM state store").kv("path", stateDir);
+        throw std::runtime_error("Can't open LSM state store");
+    }
+    upgradeState();
+    reconcileState();
+    reconcile();
+}
+
+void LsmLedger::upgradeState() {
+    std::string value;
+    if (state_.get(FORMAT_KEY, value) && value.size() >= 8 && get_le(value.data(), 8) >= STATE_FORMAT) return;
+
+    // Состояние прежнего формата: балансы из f64 монет в единицы, одним батчем
+    LsmWriteBatch batch;
+    size_t converted = state_.scan("a", "b", SIZE_MAX, [&batch](std::string_view key, std::string_view record) {
+        if (record.size() < 16) return;
+        uint64_t bits = get_le(record.data(), 8);
+        double coins;
+        std::memcpy(&coins, &bits, sizeof(coins));
+        Amount balance = 0;
+        amountFromCoins(coins, balance);
+        batch.put(std::string(key), encodeAccount(balance, get_le(record.data() + 8, 8)));
+    });
+    std::string format;
+    put_le(format, STATE_FORMAT, 8);
+    batch.put(FORMAT_KEY, std::move(format));
+    if (!state_.write(batch)) {
+        LOG_ERROR(STORAGE, "Can't upgrade account state");
+        throw std::runtime_error("Can't upgrade account state");
+    }
+    if (converted > 0) {
+        LOG_INFO(STORAGE, "Account balances converted to minor units").kv("accounts", converted);
+    }
+}
+
+LsmLedger::Account& LsmLedger::AccountCache::at(const std::string& address) {
+    auto it = accounts_.find(address);
+    if (it == accounts_.end()) {
+        it = accounts_.emplace(address, ledger_.loadAccount(address).value_or(Account{})).first;
+    }
+    return it->second;
+}
+
+void LsmLedger::AccountCache::addBalance(const std::string& address, Amount delta) {
+    Amount& balance = at(address).balance;
+    Amount& total = deltas_[address];
+    if (!addAmount(balance, delta, balance) || !addAmount(total, delta, total)) overflow_ = true;
+}
+
+BlockUndo LsmLedger::AccountCache::undo(int height, const std::string& hash) const {
+    BlockUndo undo;
+    undo.height = height;
+    undo.hash = hash;
+    undo.balanceDeltas.assign(deltas_.begin(), deltas_.end());
+    return undo;
+}
+
+bool LsmLedger::AccountCache::writeTo(LsmWriteBatch& batch) const {
+    if (overflow_) {
+        LOG_ERROR(STORAGE, "Account balance overflow");
+        return false;
+    }
+    for (const auto& [address, account] : accounts_) {
+        batch.put(accountKey(address), encodeAccount(account.balance, account.nonce));
+    }
+    return true;
+}
+
+std::optional<LsmLedger::Account> LsmLedger::loadAccount(const std::string& address) {
+    std::string value;
+    if (!state_.get(accountKey(address), value) || value.size() < 16) return std::nullopt;
+    Account account;
+    account.balance = static_cast<Amount>(get_le(value.data(), 8));
+    account.nonce = get_le(value.data() + 8, 8);
+    return account;
+}
+
+// Запись транзакции: i64 высота, i32 позиция, u8 длина статуса, статус, тело
+std::optional<LsmLedger::TxRecord> LsmLedger::loadTx(const std::string& hash) {
+    std::string value;
+    if (!state_.get(txKey(hash), value) || value.size() < 13) return std::nullopt;
+    TxRecord record;
+    record.height = static_cast<int>(static_cast<int64_t>(get_le(value.data(), 8)));
+    record.index = static_cast<int>(static_cast<int32_t>(get_le(value.data() + 8, 4)));
+    size_t statusSize = static_cast<unsigned char>(value[12]);
+    if (13 + statusSize > value.size()) return std::nullopt;
+    if (!decodeTransaction(std::string_view(value).substr(13 + statusSize), record.tx)) return std::nullopt;
+    record.tx.status = value.substr(13, statusSize);
+    return record;
+}
+
+namespace {
+
+std::string encodeTxRecord(int height, int index, const Transaction& tx) {
+    std::string value;
+    put_le(value, static_cast<uint64_t>(static_cast<int64_t>(height)), 8);
+    put_le(value, static_cast<uint32_t>(index), 4);
+    value.push_back(static_cast<char>(std::min<size_t>(tx.status.size(), 255)));
+    value.append(tx.status, 0, 255);
+    value.append(encodeTransaction(tx));
+    return value;
+}
+
+} // namespace
+
+int LsmLedger::stateTip() {
+    std::string value;
+    if (!state_.get(TIP_KEY, value) || value.size() < 8) return -1;
+    return static_cast<int>(static_cast<int64_t>(get_le(value.data(), 8)));
+}
+
+void LsmLedger::applyTx(AccountCache& accounts, const Transaction& tx, int sign) {
+    Amount spend;
+    if (!addAmount(tx.amount, tx.fee, spend)) {
+        accounts.markOverflow();
+        return;
+    }
+    accounts.addBalance(tx.toAddress, sign * tx.amount);
+    accounts.addBalance(tx.fromAddress, -sign * spend);
+}
+
+bool LsmLedger::connectState(const Block& block) {
+    const auto& txs = block.transactions;
+    // Чтение записей транзакций и счетов и кодирование — в пуле; батч
+    // собирается по порядку, как при последовательном проходе
+    std::vector<std::string> records(txs.size());
+    BlockExecution execution = BlockExecutor(executionPool()).execute(txs,
+        [this](const std::string& address) {
+            auto account = loadAccount(address);
+            return account ? AccountState{account->balance, account->nonce} : AccountState{};
+        },
+        [&](size_t i, const Transaction& tx) {
+            Transaction confirmed = tx;
+            confirmed.status = "confirmed";
+            records[i] = encodeTxRecord(block.height, static_cast<int>(i), confirmed);
+            // Транзакция могла уже быть учтена (повтор в другом блоке)
+            auto existing = loadTx(tx.txHash);
+            return !existing || !countsInBalance(existing->height, existing->tx);
+        });
+
+    if (execution.overflow) {
+        LOG_ERROR(STORAGE, "Balance overflow in block").kv("height", block.height);
+        return false;
+    }
+
+    LsmWriteBatch batch;
+    std::vector<std::string> list{block.hash};
+    for (size_t i = 0; i < txs.size(); ++i) {
+        const Transaction& tx = txs[i];
+        batch.put(txKey(tx.txHash), std::move(records[i]));
+        batch.put(historyKey(tx.fromAddress, block.height, static_cast<int>(i)), tx.txHash);
+        batch.put(historyKey(tx.toAddress, block.height, static_cast<int>(i)), tx.txHash);
+        list.push_back(tx.txHash);
+    }
+    for (const auto& [address, account] : execution.accounts) {
+        batch.put(accountKey(address), encodeAccount(account.balance, account.nonce));
+    }
+    BlockUndo undo;
+    undo.height = block.height;
+    undo.hash = block.hash;
+    undo.balanceDeltas.assign(execution.balanceDeltas.begin(), execution.balanceDeltas.end());
+    for (const auto& [address, nonce] : blockSenderNonces(block)) {
+        auto it = execution.accounts.find(address);
+        AccountState account = it != execution.accounts.end() ? it->second : AccountState{};
+        if (it == execution.accounts.end()) {
+            if (auto stored = loadAccount(address)) account = AccountState{stored->balance, stored->nonce};
+        }
+        if (nonce <= account.nonce) continue;
+        undo.previousNonces.emplace_back(address, account.nonce);
+        account.nonce = nonce;
+        batch.put(accountKey(address), encodeAccount(account.balance, account.nonce));
+    }
+    batch.put(undoKey(block.height), encodeBlockUndo(undo));
+    batch.put(blockKey(block.height), encodeStrings(list));
+    batch.put(TIP_KEY, encodeHeight(block.height));
+    return state_.write(batch);
+}
+
+bool LsmLedger::disconnectState(int height) {
+    if (height != stateTip()) return true;
+    LsmWriteBatch batch;
+    AccountCache accounts(*this);
+    auto undo = getBlockUndo(height);
+    if (undo) {
+        for (const auto& [address, delta] : undo->balanceDeltas) accounts.addBalance(address, -delta);
+        for (const auto& [address, nonce] : undo->previousNonces) accounts.at(address).nonce = nonce;
+        batch.erase(undoKey(height));
+    }
+    std::string value;
+    if (state_.get(blockKey(height), value)) {
+        auto list = decodeStrings(value);
+        for (size_t i = 1; i < list.size(); ++i) {
+            auto record = loadTx(list[i]);
+            if (!record || record->height != height) continue;
+            // Без undo-записи балансы откатываются по самим транзакциям
+            if (!undo && countsInBalance(record->height, record->tx)) applyTx(accounts, record->tx, -1);
+            // Как и в SQLite, транзакции отключённого блока удаляются:
+            // в mempool их возвращает Blockchain
+            batch.erase(txKey(list[i]));
+            batch.erase(historyKey(record->tx.fromAddress, height, record->index));
+            batch.erase(historyKey(record->tx.toAddress, height, record->index));
+        }
+        batch.erase(blockKey(height));
+    }
+    if (!accounts.writeTo(batch)) return false;
+    batch.put(TIP_KEY, encodeHeight(height - 1));
+    return state_.write(batch);
+}
+
+void LsmLedger::reconcileState() {
+    int height = getLatestHeight();
+    int tip = stateTip();
+
+    // Откатываем блоки, которых нет в базе или которые там заменены
+    while (tip >= 0) {
+        std::string value;
+        auto header = tip <= height ? getBlockHeader(tip) : std::nullopt;
+        if (header && state_.get(blockKey(tip), value)) {
+            auto list = decodeStrings(value);
+            if (!list.empty() && list.front() == header->hash) break;
+        }
+        disconnectState(tip);
+        tip--;
+    }
+
+    // Догоняем: тело из файлов, иначе из строк SQLite (база, которая
+    // раньше работала с бэкендом SQLITE)
+    int from = tip + 1;
+    for (int h = from; h <= height; ++h) {
+        auto header = getBlockHeader(h);
+        if (!header) break;
+        auto block = storedBlock(h, header->hash);
+        if (!block) {
+            block = header;
+            block->transactions = LedgerDB::getTransactionsByBlock(h);
+            if (static_cast<int>(block->transactions.size()) != getBlockTxCount(h)) {
+                // Тело потеряно: заголовки выше применённого состояния
+                // убираем, узел догрузит блоки у пиров
+                LOG_WARN(STORAGE, "Block body lost, trimming chain").kv("height", h).kv("was", height);
+                for (int top = height; top >= h; --top) BlockFileLedger::removeBlock(top);
+                break;
+            }
+        }
+        if (!connectState(*block)) {
+            LOG_ERROR(STORAGE, "Can't rebuild account state").kv("height", h);
+            break;
+        }
+    }
+    if (from <= height) {
+        LOG_INFO(STORAGE, "Account state rebuilt").kv("from", from).kv("to", stateTip());
+    }
+}
+
+bool LsmLedger::addBlockTransactions(const Block& block) {
+    if (!connectState(block)) {
+        LOG_ERROR(STORAGE, "Can't apply block to account state").kv("height", block.height);
+        return false;
+    }
+    return true;
+}
+
+bool LsmLedger::removeBlockTransactions(int height) {
+    return disconnectState(height);
+}
+
+bool LsmLedger::pruneBlockTransactions(int from, int to) {
+    if (!LedgerDB::pruneBlockTransactions(from, to)) return false;
+    LsmWriteBatch batch;
+    for (int height = from; height <= to; ++height) {
+        std::string value;
+        if (!state_.get(blockKey(height), value)) continue;
+        auto list = decodeStrings(value);
+        if (list.empty()) continue;
+        for (size_t i = 1; i < list.size(); ++i) {
+            auto record = loadTx(list[i]);
+            if (!record || record->height != height) continue;
+            batch.erase(txKey(list[i]));
+            batch.erase(historyKey(record->tx.fromAddress, height, record->index));
+            batch.erase(historyKey(record->tx.toAddress, height, record->index));
+        }
+        batch.erase(undoKey(height));
+        batch.put(blockKey(height), encodeStrings({list[0]}));
+    }
+    return state_.write(batch);
+}
+
+std::optional<BlockUndo> LsmLedger::getBlockUndo(int height) {
+    std::string value;
+    BlockUndo undo;
+    if (!state_.get(undoKey(height), value) || !decodeBlockUndo(value, undo)) return std::nullopt;
+    return undo;
+}
+
+bool LsmLedger::rollbackTransaction() {
+    bool ok = BlockFileLedger::rollbackTransaction();
+    // Состояние пишется сразу, отменённые блоки отключаем явно
+    int height = getLatestHeight();
+    for (int tip = stateTip(); tip > height; --tip) disconnectState(tip);
+    return ok;
+}
+
+bool LsmLedger::addTransaction(const Transaction& tx, int blockHeight, int txIndex) {
+    nexus::ScopedTimer timer(queryObserver(), "add_tx");
+    auto existing = loadTx(tx.txHash);
+    LsmWriteBatch batch;
+    if (blockHeight < 0) {
+        // Повторная pending-вставка существующую запись не трогает
+        if (existing) return true;
+        batch.put(txKey(tx.txHash), encodeTxRecord(-1, -1, tx));
+        return state_.write(batch);
+    }
+
+    Transaction confirmed = tx;
+    confirmed.status = "confirmed";
+    AccountCache accounts(*this);
+    if (!existing || !countsInBalance(existing->height, existing->tx)) applyTx(accounts, confirmed, +1);
+    if (!accounts.writeTo(batch)) return false;
+    batch.put(txKey(tx.txHash), encodeTxRecord(blockHeight, txIndex, confirmed));
+    return state_.write(batch);
+}
+
+bool LsmLedger::updateTransactionStatus(const std::string& txHash, const std::string& status) {
+    nexus::ScopedTimer timer(queryObserver(), "update_tx");
+    auto record = loadTx(txHash);
+    if (!record) return true;
+    LsmWriteBatch batch;
+    AccountCache accounts(*this);
+    bool counted = countsInBalance(record->height, record->tx);
+    record->tx.status = status;
+    bool counts = countsInBalance(record->height, record->tx);
+    if (counted != counts) applyTx(accounts, record->tx, counts ? +1 : -1);
+    if (!accounts.writeTo(batch)) return false;
+    batch.put(txKey(txHash), encodeTxRecord(record->height, record->index, record->tx));
+    return state_.write(batch);
+}
+
+std::vector<Transaction> LsmLedger::getTransactionsByBlock(int height) {
+    nexus::ScopedTimer timer(queryObserver(), "block_txs");
+    std::vector<Transaction> txs;
+    std::string value;
+    if (!state_.get(blockKey(height), value)) return txs;
+    auto list = decodeStrings(value);
+    for (size_t i = 1; i < list.size(); ++i) {
+        if (auto record = loadTx(list[i])) txs.push_back(std::move(record->tx));
+    }
+    return txs;
+}
+
+std::optional<Transaction> LsmLedger::getTransactionByHash(const std::string& hash) {
+    nexus::ScopedTimer timer(queryObserver(), "get_tx");
+    auto record = loadTx(hash);
+    if (!record) return std::nullopt;
+    return std::move(record->tx);
+}
+
+int LsmLedger::getTransactionHeight(const std::string& hash) {
+    nexus::ScopedTimer timer(queryObserver(), "get_tx");
+    auto record = loadTx(hash);
+    return record && record->height >= 0 ? record->height : -1;
+}
+
+bool LsmLedger::getAddressHistory(const std::string& address, const std::string& cursor, int limit,
+                                  AddressHistoryPage& page) {
+    nexus::ScopedTimer timer(queryObserver(), "address_history");
+    if (limit <= 0) return false;
+    std::string prefix = historyPrefix(address);
+    std::string start = prefix;
+    if (!cursor.empty()) {
+        int height, txIndex;
+        if (!decodeHistoryCursor(cursor, height, txIndex)) return false;
+        // Сразу за ключом курсора
+        start = historyKey(address, height, txIndex);
+        start.push_back('\0');
+    }
+    std::string end = prefix;
+    end.back() = '\1';
+
+    std::vector<std::pair<AddressHistoryEntry, std::string>> rows;
+    state_.scan(start, end, static_cast<size_t>(limit) + 1, [&](std::string_view key, std::string_view value) {
+        AddressHistoryEntry entry;
+        entry.height = static_cast<int>(~get_be32(key.data() + prefix.size()));
+        entry.txIndex = static_cast<int>(~get_be32(key.data() + prefix.size() + 4));
+        rows.emplace_back(std::move(entry), std::string(value));
+    });
+
+    page.entries.clear();
+    page.nextCursor.clear();
+    for (auto& [entry, hash] : rows) {
+        if (static_cast<int>(page.entries.size()) == limit) {
+            const auto& last = page.entries.back();
+            page.nextCursor = encodeHistoryCursor(last.height, last.txIndex);
+            break;
+        }
+        auto record = loadTx(hash);
+        if (!record) continue;
+        entry.tx = std::move(record->tx);
+        page.entries.push_back(std::move(entry));
+    }
+    return true;
+}
+
+bool LsmLedger::ensureWalletExists(const std::string& address) {
+    nexus::ScopedTimer timer(queryObserver(), "wallet");
+    if (loadAccount(address)) return true;
+    LsmWriteBatch batch;
+    AccountCache accounts(*this);
+    accounts.at(address);
+    accounts.writeTo(batch);
+    return state_.write(batch);
+}
+
+Amount LsmLedger::getBalance(const std::string& address) {
+    nexus::ScopedTimer timer(queryObserver(), "balance");
+    auto account = loadAccount(address);
+    return account ? account->balance : 0;
+}
+
+uint64_t LsmLedger::getNextNonce(const std::string& address) {
+    nexus::ScopedTimer timer(queryObserver(), "nonce");
+    auto account = loadAccount(address);
+    return (account ? account->nonce : 0) + 1;
+}
+
+bool LsmLedger::updateNonce(const std::string& address, uint64_t nonce) {
+    nexus::ScopedTimer timer(queryObserver(), "nonce");
+    LsmWriteBatch batch;
+    AccountCache accounts(*this);
+    accounts.at(address).nonce = nonce;
+    accounts.writeTo(batch);
+    return state_.write(batch);
+}
+
+bool LsmLedger::scanBalances(const std::function<void(const std::string&, Amount)>& visit) {
+    nexus::ScopedTimer timer(queryObserver(), "scan_balances");
+    state_.scan("a", "b", SIZE_MAX, [&visit](std::string_view key, std::string_view record) {
+        if (record.size() < 16) return;
+        Amount balance = static_cast<Amount>(get_le(record.data(), 8));
+        if (balance != 0) visit(std::string(key.substr(1)), balance);
+    });
+    return true;
+}
+
+bool LsmLedger::importSnapshotState(const SnapshotBase& base, const std::vector<SnapshotAccount>& accounts) {
+    // Балансы генезиса заменяются снимком; nonce в снимок не входят и остаются прежними
+    std::map<std::string, uint64_t> nonces;
+    state_.scan("a", "b", SIZE_MAX, [&nonces](std::string_view key, std::string_view record) {
+        if (record.size() >= 16) nonces[std::string(key.substr(1))] = get_le(record.data() + 8, 8);
+    });
+    LsmWriteBatch batch;
+    for (const auto& [address, nonce] : nonces) batch.put(accountKey(address), encodeAccount(0, nonce));
+    for (const auto& account : accounts) {
+        auto it = nonces.find(account.address);
+        batch.put(accountKey(account.address), encodeAccount(account.balance, it == nonces.end() ? 0 : it->second));
+    }
+    // Сверка с SQLite при открытии находит на вершине блок снимка и ничего не перестраивает
+    batch.put(blockKey(base.height), encodeStrings({base.hash}));
+    batch.put(TIP_KEY, encodeHeight(base.height));
+    return state_.write(batch);
+}
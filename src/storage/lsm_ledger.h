@@ -0,0 +1,108 @@
+// src/storage/lsm_ledger.h
+#pragma once
+#include <map>
+#include "block_file_ledger.h"
+#include "lsm_store.h"
+#include "../blockchain/block_executor.h"
+
+// Хранилище с состоянием счетов и индексом транзакций в LsmStore. Тела
+// блоков — в файлах (BlockFileLedger), в SQLite остаются заголовки блоков,
+// mempool и пиры. Баланс не суммируется по истории, а хранится готовым в
+// записи счёта и меняется при подключении и отключении блока одним
+// атомарным батчем вместе с индексом транзакций блока.
+//
+// Ключи LSM:
+//   "a" + адрес              -> i64 баланс (минимальные единицы), u64 nonce
+//   "t" + хэш транзакции      -> i64 высота (-1 — не подтверждена), i32 позиция,
+//                               статус, транзакция (block_codec)
+//   "b" + высота (u32 BE)     -> хэш блока и хэши его транзакций по порядку
+//   "h" + адрес + '\0' + ~высота (u32 BE) + ~позиция (u32 BE)
+//                             -> хэш транзакции; инверсия даёт порядок
+//                               от новых к старым при прямом обходе
+//   "u" + высота (u32 BE)     -> undo-запись блока (block_codec): ровно те
+//                               изменения балансов, что внёс connectState
+//   "m:tip"                   -> i64 высота последнего применённого блока
+//   "m:format"                -> u64 формат записей счетов (STATE_FORMAT)
+class LsmLedger : public BlockFileLedger {
+public:
+    LsmLedger(const std::string& path, const std::string& blockDir, const std::string& stateDir,
+              LsmOptions options = {});
+
+    bool rollbackTransaction() override;
+    std::optional<BlockUndo> getBlockUndo(int height) override;
+
+    bool addTransaction(const Transaction& tx, int blockHeight = -1, int txIndex = -1) override;
+    bool updateTransactionStatus(const std::string& txHash, const std::string& status) override;
+    std::vector<Transaction> getTransactionsByBlock(int height) override;
+    std::optional<Transaction> getTransactionByHash(const std::string& hash) override;
+    int getTransactionHeight(const std::string& hash) override;
+    bool getAddressHistory(const std::string& address, const std::string& cursor, int limit,
+                           AddressHistoryPage& page) override;
+
+    bool ensureWalletExists(const std::string& address) override;
+    Amount getBalance(const std::string& address) override;
+    uint64_t getNextNonce(const std::string& address) override;
+    bool updateNonce(const std::string& address, uint64_t nonce) override;
+    bool scanBalances(const std::function<void(const std::string&, Amount)>& visit) override;
+
+    LsmStats stateStats() const { return state_.stats(); }
+    // Дождаться фонового сброса и слияний состояния
+    void flushState() { state_.flush(); }
+
+protected:
+    bool addBlockTransactions(const Block& block) override;
+    bool removeBlockTransactions(int height) override;
+    // Счета из снимка, вершина состояния — блок снимка
+    bool importSnapshotState(const SnapshotBase& base, const std::vector<SnapshotAccount>& accounts) override;
+    // Записи транзакций, история и undo обрезанных блоков удаляются одним
+    // батчем, от списка блока остаётся хэш; место вернут слияния
+    bool pruneBlockTransactions(int from, int to) override;
+
+private:
+    struct Account {
+        Amount balance = 0;
+        uint64_t nonce = 0;
+    };
+
+    struct TxRecord {
+        int height = -1;
+        int index = -1;
+        Transaction tx;
+    };
+
+    // Изменения счетов в пределах одного батча
+    class AccountCache {
+    public:
+        explicit AccountCache(LsmLedger& ledger) : ledger_(ledger) {}
+        Account& at(const std::string& address);
+        // Изменение баланса с учётом в undo-записи
+        void addBalance(const std::string& address, Amount delta);
+        void markOverflow() { overflow_ = true; }
+        BlockUndo undo(int height, const std::string& hash) const;
+        // false — баланс вышел за Amount, в батч ничего не записано
+        bool writeTo(LsmWriteBatch& batch) const;
+
+    private:
+        LsmLedger& ledger_;
+        std::map<std::string, Account> accounts_;
+        std::map<std::string, Amount> deltas_;
+        bool overflow_ = false;
+    };
+
+    std::optional<Account> loadAccount(const std::string& address);
+    std::optional<TxRecord> loadTx(const std::string& hash);
+    // Применённая высота состояния, -1 — состояние пустое
+    int stateTip();
+    // Записи счетов прежнего формата (f64 монет) — в текущий
+    void upgradeState();
+    static void applyTx(AccountCache& accounts, const Transaction& tx, int sign);
+
+    // Подключить / отключить блок в состоянии одним батчем. Отключается
+    // только блок вершины состояния, для остальных высот — ничего не делает
+    bool connectState(const Block& block);
+    bool disconnectState(int height);
+    // Догнать или откатить состояние до заголовков в SQLite
+    void reconcileState();
+
+    LsmStore state_;
+};
@@ -0,0 +1,237 @@
+// src/storage/lsm_run.cpp
+#include "lsm_run.h"
+#include "../logging/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const size_t ENTRY_HEADER = 1 + 4 + 4;
+const size_t FOOTER_SIZE = 5 * 8;
+
+void put_le(unsigned char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+uint64_t get_le(const char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+uint64_t mix(uint64_t z) {
+    z += 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+uint64_t LsmBloom::hash(std::string_view key) {
+    uint64_t h = 14695981039346656037ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return mix(h);
+}
+
+// Формат: [u8 число хэш-функций][биты]. Пустой фильтр пропускает всё
+std::string LsmBloom::build(const std::vector<uint64_t>& hashes, int bitsPerKey) {
+    size_t bits = std::max<size_t>(64, hashes.size() * static_cast<size_t>(bitsPerKey));
+    bits = (bits + 7) / 8 * 8;
+    int hashCount = std::clamp(static_cast<int>(std::lround(bitsPerKey * 0.69)), 1, 30);
+
+    std::string out(1 + bits / 8, '\0');
+    out[0] = static_cast<char>(hashCount);
+    for (uint64_t h : hashes) {
+        uint64_t delta = (h >> 33) | (h << 31) | 1;
+        for (int i = 0; i < hashCount; ++i, h += delta) {
+            uint64_t bit = h % bits;
+            out[1 + bit / 8] |= static_cast<char>(1 << (bit % 8));
+        }
+    }
+    return out;
+}
+
+bool LsmBloom::mayContain(std::string_view filter, uint64_t h) {
+    if (filter.size() < 2) return true;
+    int hashCount = static_cast<unsigned char>(filter[0]);
+    uint64_t bits = (filter.size() - 1) * 8;
+    uint64_t delta = (h >> 33) | (h << 31) | 1;
+    for (int i = 0; i < hashCount; ++i, h += delta) {
+        uint64_t bit = h % bits;
+        if ((filter[1 + bit / 8] & (1 << (bit % 8))) == 0) return false;
+    }
+    return true;
+}
+
+std::shared_ptr<LsmRun> LsmRun::open(const std::string& path, uint64_t number, int tier) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || static_cast<uint64_t>(st.st_size) < FOOTER_SIZE) {
+        LOG_ERROR(STORAGE, "Can't open LSM run").kv("path", path).kv("error", std::strerror(errno));
+        if (fd >= 0) close(fd);
+        return nullptr;
+    }
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        LOG_ERROR(STORAGE, "Can't map LSM run").kv("path", path).kv("error", std::strerror(errno));
+        close(fd);
+        return nullptr;
+    }
+
+    std::shared_ptr<LsmRun> run(new LsmRun());
+    run->path_ = path;
+    run->number_ = number;
+    run->tier_ = tier;
+    run->fd_ = fd;
+    run->map_ = static_cast<const char*>(map);
+    run->size_ = size;
+
+    const char* footer = run->map_ + size - FOOTER_SIZE;
+    uint64_t indexOffset = get_le(footer, 8);
+    uint64_t bloomOffset = get_le(footer + 8, 8);
+    run->entries_ = get_le(footer + 16, 8);
+    uint64_t indexEntries = get_le(footer + 24, 8);
+    if (get_le(footer + 32, 8) != MAGIC || indexOffset > bloomOffset || bloomOffset > size - FOOTER_SIZE) {
+        LOG_ERROR(STORAGE, "Corrupted LSM run").kv("path", path);
+        return nullptr;
+    }
+    run->dataEnd_ = indexOffset;
+    run->bloom_ = std::string_view(run->map_ + bloomOffset, size - FOOTER_SIZE - bloomOffset);
+
+    run->index_.reserve(indexEntries);
+    uint64_t pos = indexOffset;
+    for (uint64_t i = 0; i < indexEntries; ++i) {
+        if (pos + 4 > bloomOffset) return nullptr;
+        uint64_t keySize = get_le(run->map_ + pos, 4);
+        if (pos + 4 + keySize + 8 > bloomOffset) return nullptr;
+        std::string_view key(run->map_ + pos + 4, keySize);
+        run->index_.emplace_back(key, get_le(run->map_ + pos + 4 + keySize, 8));
+        pos += 4 + keySize + 8;
+    }
+    return run;
+}
+
+LsmRun::~LsmRun() {
+    if (map_) munmap(const_cast<char*>(map_), size_);
+    if (fd_ >= 0) close(fd_);
+    if (obsolete_) unlink(path_.c_str());
+}
+
+LsmLookup LsmRun::get(std::string_view key, std::string& value) const {
+    if (!LsmBloom::mayContain(bloom_, LsmBloom::hash(key))) return LsmLookup::MISSING;
+    Iterator it(*this);
+    it.seek(key);
+    if (!it.valid() || it.key() != key) return LsmLookup::MISSING;
+    if (it.type() == LsmEntryType::DELETED) return LsmLookup::DELETED;
+    value.assign(it.value());
+    return LsmLookup::FOUND;
+}
+
+void LsmRun::Iterator::decode() {
+    if (offset_ >= run_.dataEnd_) return;
+    const char* p = run_.map_ + offset_;
+    type_ = static_cast<LsmEntryType>(p[0]);
+    uint64_t keySize = get_le(p + 1, 4);
+    uint64_t valueSize = get_le(p + 5, 4);
+    key_ = std::string_view(p + ENTRY_HEADER, keySize);
+    value_ = std::string_view(p + ENTRY_HEADER + keySize, valueSize);
+    nextOffset_ = offset_ + ENTRY_HEADER + keySize + valueSize;
+}
+
+void LsmRun::Iterator::seekToFirst() {
+    offset_ = 0;
+    decode();
+}
+
+void LsmRun::Iterator::seek(std::string_view key) {
+    // Последняя опорная запись индекса с ключом <= key, дальше линейно
+    const auto& index = run_.index_;
+    auto it = std::upper_bound(index.begin(), index.end(), key,
+        [](std::string_view k, const std::pair<std::string_view, uint64_t>& entry) { return k < entry.first; });
+    offset_ = it == index.begin() ? 0 : std::prev(it)->second;
+    for (decode(); valid() && key_ < key; next()) {
+    }
+}
+
+void LsmRun::Iterator::next() {
+    offset_ = nextOffset_;
+    decode();
+}
+
+LsmRunWriter::LsmRunWriter(const std::string& path, int bitsPerKey)
+    : path_(path), bitsPerKey_(bitsPerKey) {
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) {
+        LOG_ERROR(STORAGE, "Can't create LSM run").kv("path", path).kv("error", std::strerror(errno));
+        return;
+    }
+    std::setvbuf(file_, nullptr, _IOFBF, 1 << 20);
+}
+
+LsmRunWriter::~LsmRunWriter() {
+    if (file_) std::fclose(file_);
+}
+
+void LsmRunWriter::write(const void* data, size_t size) {
+    if (size > 0 && std::fwrite(data, 1, size, file_) != size) failed_ = true;
+    offset_ += size;
+}
+
+void LsmRunWriter::add(std::string_view key, LsmEntryType type, std::string_view value) {
+    if (entries_ % LsmRun::INDEX_INTERVAL == 0) {
+        unsigned char raw[8];
+        put_le(raw, key.size(), 4);
+        index_.append(reinterpret_cast<const char*>(raw), 4);
+        index_.append(key);
+        put_le(raw, offset_, 8);
+        index_.append(reinterpret_cast<const char*>(raw), 8);
+        indexEntries_++;
+    }
+    unsigned char header[ENTRY_HEADER];
+    header[0] = static_cast<unsigned char>(type);
+    put_le(header + 1, key.size(), 4);
+    put_le(header + 5, value.size(), 4);
+    write(header, ENTRY_HEADER);
+    write(key.data(), key.size());
+    write(value.data(), value.size());
+    hashes_.push_back(LsmBloom::hash(key));
+    entries_++;
+}
+
+bool LsmRunWriter::finish() {
+    if (!file_) return false;
+    uint64_t indexOffset = offset_;
+    write(index_.data(), index_.size());
+    uint64_t bloomOffset = offset_;
+    std::string bloom = LsmBloom::build(hashes_, bitsPerKey_);
+    write(bloom.data(), bloom.size());
+
+    unsigned char footer[FOOTER_SIZE];
+    put_le(footer, indexOffset, 8);
+    put_le(footer + 8, bloomOffset, 8);
+    put_le(footer + 16, entries_, 8);
+    put_le(footer + 24, indexEntries_, 8);
+    put_le(footer + 32, LsmRun::MAGIC, 8);
+    write(footer, FOOTER_SIZE);
+
+    // Прогон попадает в манифест только после того, как целиком лёг на диск
+    if (std::fflush(file_) != 0 || fsync(fileno(file_)) != 0) failed_ = true;
+    std::fclose(file_);
+    file_ = nullptr;
+    if (failed_) {
+        LOG_ERROR(STORAGE, "LSM run write failed").kv("path", path_);
+        unlink(path_.c_str());
+    }
+    return !failed_;
+}
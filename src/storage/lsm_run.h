@@ -0,0 +1,125 @@
+// src/storage/lsm_run.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+
+enum class LsmEntryType : uint8_t {
+    DELETED = 0,    // Надгробие: ключ удалён, более старые версии не видны
+    VALUE = 1
+};
+
+enum class LsmLookup {
+    FOUND,
+    DELETED,
+    MISSING         // В этом источнике ключа нет — искать в более старых
+};
+
+// Bloom-фильтр прогона: строится один раз при записи по 64-битным хэшам
+// ключей, дальше только читается прямо из отображения файла
+class LsmBloom {
+public:
+    static uint64_t hash(std::string_view key);
+    static std::string build(const std::vector<uint64_t>& hashes, int bitsPerKey);
+    static bool mayContain(std::string_view filter, uint64_t hash);
+};
+
+// Отсортированный неизменяемый прогон (sorted run) на диске. Формат файла:
+//   данные:   записи [u8 тип][u32 длина ключа][u32 длина значения][ключ][значение]
+//   индекс:   для каждой INDEX_INTERVAL-й записи [u32 длина ключа][ключ][u64 смещение]
+//   фильтр:   Bloom-фильтр всех ключей прогона
+//   подвал:   u64 смещение индекса, u64 смещение фильтра, u64 число записей,
+//             u64 число записей индекса, u64 MAGIC (всё little-endian)
+// Файл отображается в память целиком; индекс держится в памяти как
+// массив string_view в отображение.
+class LsmRun {
+public:
+    static constexpr int INDEX_INTERVAL = 16;
+    static constexpr uint64_t MAGIC = 0x314e55524d534c4eULL;  // "NLSMRUN1"
+
+    // Курсор по записям прогона в порядке ключей
+    class Iterator {
+    public:
+        explicit Iterator(const LsmRun& run) : run_(run) {}
+        bool valid() const { return offset_ < run_.dataEnd_; }
+        // Первая запись с ключом >= key
+        void seek(std::string_view key);
+        void seekToFirst();
+        void next();
+        std::string_view key() const { return key_; }
+        std::string_view value() const { return value_; }
+        LsmEntryType type() const { return type_; }
+
+    private:
+        void decode();
+
+        const LsmRun& run_;
+        uint64_t offset_ = UINT64_MAX;
+        uint64_t nextOffset_ = 0;
+        std::string_view key_;
+        std::string_view value_;
+        LsmEntryType type_ = LsmEntryType::VALUE;
+    };
+
+    // nullptr — файла нет или он повреждён
+    static std::shared_ptr<LsmRun> open(const std::string& path, uint64_t number, int tier);
+    ~LsmRun();
+
+    LsmRun(const LsmRun&) = delete;
+    LsmRun& operator=(const LsmRun&) = delete;
+
+    LsmLookup get(std::string_view key, std::string& value) const;
+
+    uint64_t number() const { return number_; }
+    int tier() const { return tier_; }
+    uint64_t fileSize() const { return size_; }
+    uint64_t entries() const { return entries_; }
+    // Прогон заменён при слиянии: файл удаляется, когда его отпустит последний читатель
+    void markObsolete() { obsolete_ = true; }
+
+private:
+    LsmRun() = default;
+
+    std::string path_;
+    uint64_t number_ = 0;
+    int tier_ = 0;
+    int fd_ = -1;
+    const char* map_ = nullptr;
+    uint64_t size_ = 0;
+    uint64_t dataEnd_ = 0;
+    uint64_t entries_ = 0;
+    std::vector<std::pair<std::string_view, uint64_t>> index_;
+    std::string_view bloom_;
+    std::atomic<bool> obsolete_{false};
+};
+
+// Последовательная запись прогона; ключи подаются строго по возрастанию
+class LsmRunWriter {
+public:
+    LsmRunWriter(const std::string& path, int bitsPerKey);
+    ~LsmRunWriter();
+
+    bool ok() const { return file_ != nullptr; }
+    void add(std::string_view key, LsmEntryType type, std::string_view value);
+    // Дописать индекс, фильтр и подвал, сбросить на диск; false — ошибка записи
+    bool finish();
+    uint64_t bytesWritten() const { return offset_; }
+    uint64_t entries() const { return entries_; }
+
+private:
+    void write(const void* data, size_t size);
+
+    std::string path_;
+    int bitsPerKey_;
+    FILE* file_ = nullptr;
+    uint64_t offset_ = 0;
+    uint64_t entries_ = 0;
+    std::vector<uint64_t> hashes_;
+    std::string index_;
+    uint64_t indexEntries_ = 0;
+    bool failed_ = false;
+};
@@ -0,0 +1,548 @@
+// src/storage/lsm_store.cpp
+#include "lsm_store.h"
+#include "../logging/logger.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+const size_t MEMTABLE_ENTRY_OVERHEAD = 48;   // Узел std::map и заголовки строк
+const size_t WAL_HEADER = 4 + 4;
+
+void put_le(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) out.push_back(static_cast<char>(value >> (8 * i)));
+}
+
+uint64_t get_le(const char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) value |= static_cast<uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+uint32_t checksum(std::string_view data) {
+    uint32_t h = 2166136261u;
+    for (unsigned char c : data) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Номер из имени "<prefix><номер><suffix>", 0 — имя не подходит
+uint64_t fileNumber(const std::string& name, const std::string& prefix, const std::string& suffix) {
+    if (name.size() <= prefix.size() + suffix.size() || name.rfind(prefix, 0) != 0 ||
+        name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0) {
+        return 0;
+    }
+    std::string digits = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+    if (digits.find_first_not_of("0123456789") != std::string::npos) return 0;
+    return std::stoull(digits);
+}
+
+// Курсор источника при слиянии: memtable, замороженная memtable или прогон
+class Cursor {
+public:
+    virtual ~Cursor() = default;
+    virtual bool valid() const = 0;
+    virtual std::string_view key() const = 0;
+    virtual LsmEntryType type() const = 0;
+    virtual std::string_view value() const = 0;
+    virtual void next() = 0;
+};
+
+template <typename Iterator>
+class MapCursor : public Cursor {
+public:
+    MapCursor(Iterator begin, Iterator end, std::string_view stop) : it_(begin), end_(end), stop_(stop) {}
+    bool valid() const override { return it_ != end_ && (stop_.empty() || std::string_view(it_->first) < stop_); }
+    std::string_view key() const override { return it_->first; }
+    LsmEntryType type() const override { return it_->second.type; }
+    std::string_view value() const override { return it_->second.value; }
+    void next() override { ++it_; }
+
+private:
+    Iterator it_;
+    Iterator end_;
+    std::string_view stop_;
+};
+
+class RunCursor : public Cursor {
+public:
+    RunCursor(const LsmRun& run, std::string_view start, std::string_view stop) : it_(run), stop_(stop) {
+        if (start.empty()) it_.seekToFirst();
+        else it_.seek(start);
+    }
+    bool valid() const override { return it_.valid() && (stop_.empty() || it_.key() < stop_); }
+    std::string_view key() const override { return it_.key(); }
+    LsmEntryType type() const override { return it_.type(); }
+    std::string_view value() const override { return it_.value(); }
+    void next() override { it_.next(); }
+
+private:
+    LsmRun::Iterator it_;
+    std::string_view stop_;
+};
+
+// Слияние источников, упорядоченных от новых к старым: для каждого ключа
+// берётся версия из самого нового источника. visit возвращает false — стоп
+template <typename Visit>
+void mergeCursors(std::vector<std::unique_ptr<Cursor>>& cursors, Visit visit) {
+    for (;;) {
+        int newest = -1;
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            if (!cursors[i]->valid()) continue;
+            if (newest < 0 || cursors[i]->key() < cursors[newest]->key()) newest = static_cast<int>(i);
+        }
+        if (newest < 0) return;
+
+        std::string key(cursors[newest]->key());
+        bool more = visit(key, cursors[newest]->type(), cursors[newest]->value());
+        for (auto& cursor : cursors) {
+            if (cursor->valid() && cursor->key() == key) cursor->next();
+        }
+        if (!more) return;
+    }
+}
+
+} // namespace
+
+LsmStore::LsmStore(const std::string& dir, LsmOptions options)
+    : dir_(dir), options_(options), memtable_(std::make_shared<Memtable>()) {
+    ok_ = open();
+    if (ok_) background_ = std::thread([this]() { backgroundLoop(); });
+}
+
+LsmStore::~LsmStore() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    backgroundCv_.notify_all();
+    if (background_.joinable()) background_.join();
+    if (wal_) std::fclose(wal_);
+}
+
+std::string LsmStore::walPath(uint64_t number) const {
+    return (std::filesystem::path(dir_) / ("wal_" + std::to_string(number) + ".log")).string();
+}
+
+std::string LsmStore::runPath(uint64_t number) const {
+    return (std::filesystem::path(dir_) / ("run_" + std::to_string(number) + ".sst")).string();
+}
+
+bool LsmStore::open() {
+    std::error_code ec;
+    std::filesystem::create_directories(dir_, ec);
+    if (ec) {
+        LOG_ERROR(STORAGE, "Can't create LSM directory").kv("path", dir_).kv("error", ec.message());
+        return false;
+    }
+
+    // MANIFEST: "next N", "wal N" (самый старый нужный журнал), "run N ярус" от новых к старым
+    uint64_t walMin = 0;
+    std::vector<uint64_t> liveRuns;
+    std::ifstream manifest(std::filesystem::path(dir_) / "MANIFEST");
+    for (std::string line; std::getline(manifest, line);) {
+        std::istringstream in(line);
+        std::string kind;
+        uint64_t number = 0;
+        in >> kind >> number;
+        if (kind == "next") {
+            nextNumber_ = std::max(nextNumber_, number);
+        } else if (kind == "wal") {
+            walMin = number;
+        } else if (kind == "run") {
+            int tier = 0;
+            in >> tier;
+            auto run = LsmRun::open(runPath(number), number, tier);
+            if (!run) return false;
+            runs_.push_back(run);
+            liveRuns.push_back(number);
+        }
+    }
+
+    // Прогоны вне манифеста — остатки прерванных сбросов и слияний
+    std::vector<uint64_t> wals;
+    for (const auto& entry : std::filesystem::directory_iterator(dir_, ec)) {
+        std::string name = entry.path().filename().string();
+        if (uint64_t run = fileNumber(name, "run_", ".sst")) {
+            nextNumber_ = std::max(nextNumber_, run + 1);
+            if (std::find(liveRuns.begin(), liveRuns.end(), run) == liveRuns.end()) {
+                std::filesystem::remove(entry.path(), ec);
+            }
+        } else if (uint64_t wal = fileNumber(name, "wal_", ".log")) {
+            nextNumber_ = std::max(nextNumber_, wal + 1);
+            if (wal >= walMin) wals.push_back(wal);
+            else std::filesystem::remove(entry.path(), ec);
+        }
+    }
+    std::sort(wals.begin(), wals.end());
+    for (uint64_t wal : wals) {
+        if (!replayWal(wal)) return false;
+    }
+
+    if (!openWal()) return false;
+    // Восстановленные записи сразу уходят в прогон: старые журналы больше не нужны
+    if (!memtable_->empty()) {
+        immutable_ = memtable_;
+        immutableWalNumber_ = wals.back();
+        memtable_ = std::make_shared<Memtable>();
+        memtableBytes_ = 0;
+        if (!flushImmutable()) return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!writeManifest()) return false;
+    }
+    for (uint64_t wal : wals) std::filesystem::remove(walPath(wal), ec);
+
+    LOG_INFO(STORAGE, "LSM store opened")
+        .kv("path", dir_).kv("runs", runs_.size()).kv("replayed_wals", wals.size());
+    return true;
+}
+
+bool LsmStore::replayWal(uint64_t number) {
+    FILE* file = std::fopen(walPath(number).c_str(), "rb");
+    if (!file) return false;
+    std::string payload;
+    uint64_t records = 0;
+    for (;;) {
+        char header[WAL_HEADER];
+        if (std::fread(header, 1, WAL_HEADER, file) != WAL_HEADER) break;
+        payload.resize(get_le(header, 4));
+        if (std::fread(payload.data(), 1, payload.size(), file) != payload.size() ||
+            checksum(payload) != get_le(header + 4, 4)) {
+            // Недописанная последняя запись: батч не был подтверждён
+            LOG_WARN(STORAGE, "Dropping torn LSM journal tail").kv("wal", number).kv("records", records);
+            break;
+        }
+        const char* p = payload.data();
+        const char* end = p + payload.size();
+        uint64_t count = get_le(p, 4);
+        p += 4;
+        for (uint64_t i = 0; i < count && p + 9 <= end; ++i) {
+            auto type = static_cast<LsmEntryType>(p[0]);
+            uint64_t keySize = get_le(p + 1, 4);
+            uint64_t valueSize = get_le(p + 5, 4);
+            p += 9;
+            if (p + keySize + valueSize > end) break;
+            std::string key(p, keySize);
+            memtableBytes_ += keySize + valueSize + MEMTABLE_ENTRY_OVERHEAD;
+            (*memtable_)[std::move(key)] = MemEntry{type, std::string(p + keySize, valueSize)};
+            p += keySize + valueSize;
+        }
+        records++;
+    }
+    std::fclose(file);
+    return true;
+}
+
+bool LsmStore::openWal() {
+    walNumber_ = nextNumber_++;
+    wal_ = std::fopen(walPath(walNumber_).c_str(), "ab");
+    if (!wal_) {
+        LOG_ERROR(STORAGE, "Can't open LSM journal").kv("path", walPath(walNumber_)).kv("error", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool LsmStore::writeManifest() {
+    std::filesystem::path path = std::filesystem::path(dir_) / "MANIFEST";
+    std::filesystem::path tmp = std::filesystem::path(dir_) / "MANIFEST.tmp";
+    FILE* file = std::fopen(tmp.c_str(), "w");
+    if (!file) return false;
+    std::fprintf(file, "next %llu\n", static_cast<unsigned long long>(nextNumber_));
+    std::fprintf(file, "wal %llu\n", static_cast<unsigned long long>(immutable_ ? immutableWalNumber_ : walNumber_));
+    for (const auto& run : runs_) {
+        std::fprintf(file, "run %llu %d\n", static_cast<unsigned long long>(run->number()), run->tier());
+    }
+    bool ok = std::fflush(file) == 0 && fsync(fileno(file)) == 0;
+    std::fclose(file);
+    std::error_code ec;
+    if (ok) std::filesystem::rename(tmp, path, ec);
+    if (!ok || ec) {
+        LOG_ERROR(STORAGE, "Can't write LSM manifest").kv("path", path.string());
+        return false;
+    }
+    return true;
+}
+
+bool LsmStore::write(const LsmWriteBatch& batch) {
+    if (batch.empty()) return true;
+
+    std::string payload;
+    payload.reserve(4 + batch.bytes() + batch.ops().size() * 9);
+    put_le(payload, batch.ops().size(), 4);
+    for (const auto& op : batch.ops()) {
+        payload.push_back(static_cast<char>(op.type));
+        put_le(payload, op.key.size(), 4);
+        put_le(payload, op.value.size(), 4);
+        payload.append(op.key);
+        payload.append(op.value);
+    }
+    std::string header;
+    put_le(header, payload.size(), 4);
+    put_le(header, checksum(payload), 4);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!ok_) return false;
+    if (memtableBytes_ >= options_.memtableBytes && !rotateMemtable(lock)) return false;
+
+    // Журнал сбрасывается в ядро на каждый батч: падение процесса его не теряет
+    bool written = std::fwrite(header.data(), 1, header.size(), wal_) == header.size() &&
+                   std::fwrite(payload.data(), 1, payload.size(), wal_) == payload.size() &&
+                   std::fflush(wal_) == 0;
+    if (written && options_.syncWal) written = fdatasync(fileno(wal_)) == 0;
+    if (!written) {
+        LOG_ERROR(STORAGE, "LSM journal write failed").kv("error", std::strerror(errno));
+        return false;
+    }
+
+    for (const auto& op : batch.ops()) {
+        memtableBytes_ += op.key.size() + op.value.size() + MEMTABLE_ENTRY_OVERHEAD;
+        (*memtable_)[op.key] = MemEntry{op.type, op.value};
+    }
+    stats_.userBytes += batch.bytes();
+    stats_.walBytes += header.size() + payload.size();
+    return true;
+}
+
+bool LsmStore::put(std::string key, std::string value) {
+    LsmWriteBatch batch;
+    batch.put(std::move(key), std::move(value));
+    return write(batch);
+}
+
+bool LsmStore::erase(std::string key) {
+    LsmWriteBatch batch;
+    batch.erase(std::move(key));
+    return write(batch);
+}
+
+bool LsmStore::get(std::string_view key, std::string& value) {
+    RunList runs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const Memtable* table : {static_cast<const Memtable*>(memtable_.get()), immutable_.get()}) {
+            if (!table) continue;
+            auto it = table->find(key);
+            if (it == table->end()) continue;
+            if (it->second.type == LsmEntryType::DELETED) return false;
+            value = it->second.value;
+            return true;
+        }
+        runs = runs_;
+    }
+    for (const auto& run : runs) {
+        switch (run->get(key, value)) {
+            case LsmLookup::FOUND: return true;
+            case LsmLookup::DELETED: return false;
+            case LsmLookup::MISSING: break;
+        }
+    }
+    return false;
+}
+
+size_t LsmStore::scan(std::string_view start, std::string_view end, size_t limit, const ScanCallback& callback) {
+    if (limit == 0) return 0;
+    // Из активной memtable копируется только начало диапазона: её первые
+    // limit живых ключей уже ограничивают ответ сверху
+    Memtable head;
+    std::shared_ptr<const Memtable> immutable;
+    RunList runs;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        size_t live = 0;
+        for (auto it = memtable_->lower_bound(start);
+             it != memtable_->end() && (end.empty() || std::string_view(it->first) < end) && live < limit; ++it) {
+            head.emplace(it->first, it->second);
+            if (it->second.type == LsmEntryType::VALUE) live++;
+        }
+        immutable = immutable_;
+        runs = runs_;
+    }
+
+    std::vector<std::unique_ptr<Cursor>> cursors;
+    cursors.push_back(std::make_unique<MapCursor<Memtable::const_iterator>>(head.cbegin(), head.cend(), end));
+    if (immutable) {
+        cursors.push_back(std::make_unique<MapCursor<Memtable::const_iterator>>(
+            immutable->lower_bound(start), immutable->cend(), end));
+    }
+    for (const auto& run : runs) cursors.push_back(std::make_unique<RunCursor>(*run, start, end));
+
+    size_t emitted = 0;
+    mergeCursors(cursors, [&](std::string_view key, LsmEntryType type, std::string_view value) {
+        if (type == LsmEntryType::VALUE) {
+            callback(key, value);
+            emitted++;
+        }
+        return emitted < limit;
+    });
+    return emitted;
+}
+
+bool LsmStore::rotateMemtable(std::unique_lock<std::mutex>& lock) {
+    // Предыдущая memtable ещё сбрасывается — писатель ждёт (обратное давление)
+    idleCv_.wait(lock, [this]() { return !immutable_ || !ok_; });
+    if (!ok_) return false;
+    FILE* previous = wal_;
+    uint64_t previousNumber = walNumber_;
+    if (!openWal()) {
+        wal_ = previous;
+        walNumber_ = previousNumber;
+        return false;
+    }
+    std::fclose(previous);
+    immutable_ = memtable_;
+    immutableWalNumber_ = previousNumber;
+    memtable_ = std::make_shared<Memtable>();
+    memtableBytes_ = 0;
+    backgroundCv_.notify_one();
+    return true;
+}
+
+void LsmStore::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!ok_) return;
+    if (!memtable_->empty() && !rotateMemtable(lock)) return;
+    idleCv_.wait(lock, [this]() {
+        return !ok_ || (!immutable_ && !backgroundBusy_ && compactionTier() < 0);
+    });
+}
+
+LsmStats LsmStore::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    LsmStats stats = stats_;
+    stats.runs = runs_.size();
+    return stats;
+}
+
+int LsmStore::compactionTier() const {
+    std::map<int, int> tiers;
+    for (const auto& run : runs_) tiers[run->tier()]++;
+    for (const auto& [tier, count] : tiers) {
+        if (count >= options_.tierFanout) return tier;
+    }
+    return -1;
+}
+
+void LsmStore::backgroundLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        backgroundCv_.wait(lock, [this]() {
+            return stopping_ || !ok_ || immutable_ || compactionTier() >= 0;
+        });
+        if (!ok_) break;
+        // Сначала сброс: он освобождает писателя. Недоделанные слияния
+        // при остановке продолжатся после следующего открытия
+        bool flushing = immutable_ != nullptr;
+        if (!flushing && stopping_) break;
+
+        backgroundBusy_ = true;
+        lock.unlock();
+        bool ok = flushing ? flushImmutable() : compactTier();
+        lock.lock();
+        backgroundBusy_ = false;
+        if (!ok) ok_ = false;
+        idleCv_.notify_all();
+    }
+    idleCv_.notify_all();
+}
+
+bool LsmStore::flushImmutable() {
+    std::shared_ptr<const Memtable> table;
+    uint64_t number;
+    bool hasOlder;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        table = immutable_;
+        number = nextNumber_++;
+        hasOlder = !runs_.empty();
+    }
+    if (!table) return true;
+
+    LsmRunWriter writer(runPath(number), options_.bloomBitsPerKey);
+    if (!writer.ok()) return false;
+    for (const auto& [key, entry] : *table) {
+        // Надгробию нечего скрывать, если прогонов ещё нет
+        if (entry.type == LsmEntryType::DELETED && !hasOlder) continue;
+        writer.add(key, entry.type, entry.value);
+    }
+    if (!writer.finish()) return false;
+    auto run = LsmRun::open(runPath(number), number, 0);
+    if (!run) return false;
+
+    uint64_t obsoleteWal;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        runs_.insert(runs_.begin(), run);
+        immutable_.reset();
+        obsoleteWal = immutableWalNumber_;
+        stats_.flushBytes += writer.bytesWritten();
+        stats_.flushes++;
+        if (!writeManifest()) return false;
+    }
+    idleCv_.notify_all();
+    std::error_code ec;
+    std::filesystem::remove(walPath(obsoleteWal), ec);
+    LOG_DEBUG(STORAGE, "LSM memtable flushed").kv("run", number).kv("entries", writer.entries());
+    return true;
+}
+
+bool LsmStore::compactTier() {
+    RunList group;
+    int tier;
+    bool dropDeleted;
+    uint64_t number;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tier = compactionTier();
+        if (tier < 0) return true;
+        for (const auto& run : runs_) {
+            if (run->tier() == tier) group.push_back(run);
+        }
+        // Ярусы идут подряд, так что группа — непрерывный отрезок runs_.
+        // Если старше неё ничего нет, надгробия можно выбросить
+        dropDeleted = group.back() == runs_.back();
+        number = nextNumber_++;
+    }
+
+    std::vector<std::unique_ptr<Cursor>> cursors;
+    for (const auto& run : group) cursors.push_back(std::make_unique<RunCursor>(*run, "", ""));
+    LsmRunWriter writer(runPath(number), options_.bloomBitsPerKey);
+    if (!writer.ok()) return false;
+    mergeCursors(cursors, [&](std::string_view key, LsmEntryType type, std::string_view value) {
+        if (!(dropDeleted && type == LsmEntryType::DELETED)) writer.add(key, type, value);
+        return true;
+    });
+    bool empty = writer.entries() == 0;
+    if (!writer.finish()) return false;
+    std::shared_ptr<LsmRun> merged;
+    if (empty) {
+        unlink(runPath(number).c_str());
+    } else {
+        merged = LsmRun::open(runPath(number), number, tier + 1);
+        if (!merged) return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto first = std::find(runs_.begin(), runs_.end(), group.front());
+        auto position = runs_.erase(first, first + static_cast<std::ptrdiff_t>(group.size()));
+        if (merged) runs_.insert(position, merged);
+        stats_.compactionBytes += writer.bytesWritten();
+        stats_.compactions++;
+        if (!writeManifest()) return false;
+    }
+    // Файлы удалятся, когда их отпустят текущие читатели
+    for (const auto& run : group) run->markObsolete();
+    LOG_DEBUG(STORAGE, "LSM runs merged")
+        .kv("tier", tier).kv("runs", group.size()).kv("entries", writer.entries()).kv("bytes", writer.bytesWritten());
+    return true;
+}
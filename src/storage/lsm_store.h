@@ -0,0 +1,145 @@
+// src/storage/lsm_store.h
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include <cstdio>
+#include "lsm_run.h"
+
+struct LsmOptions {
+    size_t memtableBytes = 4 << 20;   // Порог переключения memtable
+    int tierFanout = 4;               // Столько прогонов одного яруса сливаются в один следующего
+    int bloomBitsPerKey = 10;         // ~1% ложных срабатываний
+    bool syncWal = false;             // fdatasync журнала на каждую запись
+};
+
+// Атомарный набор изменений: в журнал и memtable попадает целиком
+class LsmWriteBatch {
+public:
+    struct Op {
+        LsmEntryType type;
+        std::string key;
+        std::string value;
+    };
+
+    void put(std::string key, std::string value) {
+        bytes_ += key.size() + value.size();
+        ops_.push_back({LsmEntryType::VALUE, std::move(key), std::move(value)});
+    }
+    void erase(std::string key) {
+        bytes_ += key.size();
+        ops_.push_back({LsmEntryType::DELETED, std::move(key), {}});
+    }
+    bool empty() const { return ops_.empty(); }
+    void clear() { ops_.clear(); bytes_ = 0; }
+    const std::vector<Op>& ops() const { return ops_; }
+    size_t bytes() const { return bytes_; }
+
+private:
+    std::vector<Op> ops_;
+    size_t bytes_ = 0;
+};
+
+struct LsmStats {
+    uint64_t userBytes = 0;         // Ключи и значения, поданные в write()
+    uint64_t walBytes = 0;
+    uint64_t flushBytes = 0;        // memtable -> прогоны яруса 0
+    uint64_t compactionBytes = 0;   // Слияния прогонов
+    uint64_t flushes = 0;
+    uint64_t compactions = 0;
+    size_t runs = 0;
+
+    // Байт записано на диск на байт пользовательских данных
+    double writeAmplification() const {
+        return userBytes ? static_cast<double>(walBytes + flushBytes + compactionBytes) / userBytes : 0;
+    }
+};
+
+// Встроенное log-structured merge хранилище ключ-значение. Запись идёт в
+// журнал (wal_N.log) и в отсортированную memtable; заполненная memtable
+// замораживается и фоновым потоком сбрасывается в неизменяемый прогон
+// (run_N.sst) яруса 0. Когда на ярусе набирается tierFanout прогонов, фон
+// сливает их в один прогон следующего яруса (size-tiered), поэтому каждый
+// байт переписывается O(log(данные / memtable)) раз, а случайная запись
+// остаётся дописыванием в журнал. Чтение: memtable, замороженная memtable,
+// затем прогоны от новых к старым; лишние прогоны отсекает Bloom-фильтр.
+// Состав прогонов хранится в MANIFEST, который заменяется атомарно.
+//
+// Писатель — один поток (io-поток узла); читать можно из любого.
+class LsmStore {
+public:
+    explicit LsmStore(const std::string& dir, LsmOptions options = {});
+    // Дожидается фонового сброса и слияний
+    ~LsmStore();
+
+    LsmStore(const LsmStore&) = delete;
+    LsmStore& operator=(const LsmStore&) = delete;
+
+    bool ok() const { return ok_; }
+
+    bool write(const LsmWriteBatch& batch);
+    bool put(std::string key, std::string value);
+    bool erase(std::string key);
+    // false — ключа нет или он удалён
+    bool get(std::string_view key, std::string& value);
+
+    // Живые ключи из [start, end) по возрастанию, не больше limit штук;
+    // пустой end — до конца. Возвращает число отданных ключей
+    using ScanCallback = std::function<void(std::string_view key, std::string_view value)>;
+    size_t scan(std::string_view start, std::string_view end, size_t limit, const ScanCallback& callback);
+
+    // Сбросить memtable в прогон и дождаться фоновой работы
+    void flush();
+    LsmStats stats() const;
+
+private:
+    struct MemEntry {
+        LsmEntryType type;
+        std::string value;
+    };
+    using Memtable = std::map<std::string, MemEntry, std::less<>>;
+    using RunList = std::vector<std::shared_ptr<LsmRun>>;
+
+    bool open();
+    bool replayWal(uint64_t number);
+    bool openWal();
+    bool writeManifest();
+    std::string walPath(uint64_t number) const;
+    std::string runPath(uint64_t number) const;
+
+    // Заморозить memtable и завести новый журнал; вызывается под mutex_
+    bool rotateMemtable(std::unique_lock<std::mutex>& lock);
+    void backgroundLoop();
+    bool flushImmutable();
+    // Слить все прогоны переполненного яруса в один прогон следующего
+    bool compactTier();
+    // Младший ярус, где набралось tierFanout прогонов, или -1; под mutex_
+    int compactionTier() const;
+
+    std::string dir_;
+    LsmOptions options_;
+    bool ok_ = false;
+
+    mutable std::mutex mutex_;
+    std::condition_variable backgroundCv_;   // Есть работа для фонового потока
+    std::condition_variable idleCv_;         // Фон закончил шаг
+    std::shared_ptr<Memtable> memtable_;
+    size_t memtableBytes_ = 0;
+    std::shared_ptr<const Memtable> immutable_;
+    RunList runs_;                 // От новых к старым; ярусы не убывают
+    uint64_t nextNumber_ = 1;      // Номера журналов и прогонов
+    uint64_t walNumber_ = 0;
+    uint64_t immutableWalNumber_ = 0;
+    FILE* wal_ = nullptr;
+    bool backgroundBusy_ = false;
+    bool stopping_ = false;
+    LsmStats stats_;
+    std::thread background_;
+};
@@ -6,6 +6,11 @@
 -- Отключаем FOREIGN KEY временно для инициализации
 PRAGMA foreign_keys = OFF;
 
+-- Освобождённые страницы возвращаются файлу по PRAGMA incremental_vacuum
+-- (обрезка истории), без полного VACUUM. Действует только для новой базы:
+-- в прежних свободные страницы переиспользуются, и файл просто не растёт
+PRAGMA auto_vacuum = INCREMENTAL;
+
 -- ============================================
 -- 1. КОШЕЛЬКИ
 -- ============================================
@@ -56,12 +61,15 @@ CREATE TABLE IF NOT EXISTS transactions (
     tx_index INTEGER,
     from_address TEXT NOT NULL,
     to_address TEXT NOT NULL,
-    amount REAL NOT NULL CHECK (amount > 0),
-    fee REAL NOT NULL CHECK (fee >= 0),
+    -- Суммы в минимальных единицах: 1 монета = 10^9 (amount.h)
+    amount INTEGER NOT NULL CHECK (amount > 0),
+    fee INTEGER NOT NULL CHECK (fee >= 0),
     signature TEXT NOT NULL,
     timestamp INTEGER NOT NULL,
     data TEXT,
     status TEXT CHECK (status IN ('pending', 'confirmed', 'invalid')) DEFAULT 'pending',
+    -- Входит в хэш и подпись транзакции
+    nonce INTEGER NOT NULL DEFAULT 0,
     UNIQUE (block_height, tx_index)
 );
 
@@ -72,6 +80,52 @@ CREATE INDEX IF NOT EXISTS idx_tx_block ON transactions(block_height);
 CREATE INDEX IF NOT EXISTS idx_tx_status ON transactions(status);
 CREATE INDEX IF NOT EXISTS idx_tx_timestamp ON transactions(timestamp);
 
+-- История адреса: по строке на каждый адрес подтверждённой транзакции.
+-- Страница истории — спуск по первичному ключу от курсора (height, tx_index)
+CREATE TABLE IF NOT EXISTS address_history (
+    address TEXT NOT NULL,
+    height INTEGER NOT NULL,
+    tx_index INTEGER NOT NULL,
+    tx_hash TEXT NOT NULL,
+    PRIMARY KEY (address, height, tx_index)
+) WITHOUT ROWID;
+
+CREATE INDEX IF NOT EXISTS idx_history_height ON address_history(height);
+
+-- Балансы подключённых блоков. Меняются при подключении и отключении блока
+-- по его undo-записи (block_undo: изменения балансов, block_codec)
+CREATE TABLE IF NOT EXISTS account_state (
+    address TEXT PRIMARY KEY,
+    balance INTEGER NOT NULL DEFAULT 0
+) WITHOUT ROWID;
+
+CREATE TABLE IF NOT EXISTS block_undo (
+    height INTEGER PRIMARY KEY,
+    hash TEXT NOT NULL,
+    data BLOB NOT NULL
+);
+
+-- Снимок состояния, из которого загружена база (state_snapshot.h): блоки
+-- 1..height есть только заголовками, балансы на height взяты из снимка
+CREATE TABLE IF NOT EXISTS snapshot_base (
+    id INTEGER PRIMARY KEY CHECK (id = 1),
+    height INTEGER NOT NULL,
+    hash TEXT NOT NULL,
+    commitment TEXT NOT NULL,
+    -- 1 — сверен с историей, -1 — история не сошлась
+    verified INTEGER DEFAULT 0,
+    loaded_at INTEGER NOT NULL
+);
+
+-- Обрезка истории: у блоков 1..height удалены транзакции, история адресов
+-- и undo-записи, строки blocks остались. block_size — длина тела в записи
+-- block_codec, по ней считается объём хранимой истории
+CREATE TABLE IF NOT EXISTS prune_state (
+    id INTEGER PRIMARY KEY CHECK (id = 1),
+    height INTEGER NOT NULL,
+    updated_at INTEGER NOT NULL
+);
+
 -- ============================================
 -- 4. МЕМПУЛ
 -- ============================================
@@ -107,6 +161,18 @@ CREATE INDEX IF NOT EXISTS idx_peers_ip_port ON peers(ip_address, port);
 CREATE INDEX IF NOT EXISTS idx_peers_last_seen ON peers(last_seen);
 CREATE INDEX IF NOT EXISTS idx_peers_bootstrap ON peers(is_bootstrap);
 
+-- Адресная книга: бакет источника и оценка качества пира
+CREATE TABLE IF NOT EXISTS peer_scores (
+    ip_address TEXT NOT NULL,
+    port INTEGER NOT NULL,
+    source_group TEXT,
+    tried BOOLEAN DEFAULT 0,
+    score REAL DEFAULT 0,
+    last_success INTEGER DEFAULT 0,
+    updated_at INTEGER,
+    PRIMARY KEY (ip_address, port)
+);
+
 -- ============================================
 -- 6. КОНФИГУРАЦИЯ УЗЛА
 -- ============================================
@@ -228,15 +294,38 @@ INSERT OR IGNORE INTO transactions (
     0,
     'SYSTEM',
     'genesis_miner',
-    10000.0,
-    0.0,
+    10000000000000,
+    0,
     'genesis_signature',
     strftime('%s', 'now'),
     'Genesis block reward',
     'confirmed'
 );
 
--- 4. Конфигурация узла
+-- 4. История адресов для баз, созданных до появления address_history
+-- (для заполненной таблицы условие ложно и transactions не читается)
+INSERT OR IGNORE INTO address_history (address, height, tx_index, tx_hash)
+SELECT from_address, block_height, tx_index, tx_hash FROM transactions
+WHERE block_height IS NOT NULL AND tx_index IS NOT NULL
+AND NOT EXISTS (SELECT 1 FROM address_history)
+UNION ALL
+SELECT to_address, block_height, tx_index, tx_hash FROM transactions
+WHERE block_height IS NOT NULL AND tx_index IS NOT NULL
+AND NOT EXISTS (SELECT 1 FROM address_history);
+
+-- 5. Балансы для баз, созданных до появления account_state
+INSERT INTO account_state (address, balance)
+SELECT address, SUM(delta) FROM (
+    SELECT to_address AS address, amount AS delta FROM transactions
+    WHERE block_height IS NOT NULL AND status = 'confirmed'
+    UNION ALL
+    SELECT from_address, -amount - fee FROM transactions
+    WHERE block_height IS NOT NULL AND status = 'confirmed'
+)
+WHERE NOT EXISTS (SELECT 1 FROM account_state)
+GROUP BY address;
+
+-- 6. Конфигурация узла
 INSERT OR IGNORE INTO node_config (
     id, node_id, node_name, network, listen_port,
     last_block_height, last_block_hash, mining_enabled,
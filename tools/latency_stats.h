@@ -0,0 +1,35 @@
+// tools/latency_stats.h
+#pragma once
+#include <algorithm>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace nexus::tools {
+
+// Выборка задержек в миллисекундах и её перцентили для JSON-отчёта
+struct LatencyStats {
+    std::vector<double> samples_ms;
+
+    nlohmann::json to_json() const {
+        if (samples_ms.empty()) return {{"count", 0}};
+        std::vector<double> sorted = samples_ms;
+        std::sort(sorted.begin(), sorted.end());
+        auto pct = [&](double p) {
+            size_t idx = static_cast<size_t>(p / 100.0 * static_cast<double>(sorted.size() - 1) + 0.5);
+            return sorted[std::min(idx, sorted.size() - 1)];
+        };
+        double sum = 0;
+        for (double v : sorted) sum += v;
+        return {
+            {"count", sorted.size()},
+            {"mean_ms", sum / static_cast<double>(sorted.size())},
+            {"p50_ms", pct(50)},
+            {"p90_ms", pct(90)},
+            {"p99_ms", pct(99)},
+            {"p999_ms", pct(99.9)},
+            {"max_ms", sorted.back()}
+        };
+    }
+};
+
+} // namespace nexus::tools
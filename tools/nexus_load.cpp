@@ -0,0 +1,593 @@
+// tools/nexus_load.cpp
+// Генератор нагрузки: много отправителей с собственными nonce, отправка через
+// HTTP API или P2P, замкнутый (N одновременных запросов) и открытый
+// (фиксированная частота прихода) режимы. Задержки считаются от отправки до
+// попадания в mempool и до включения в блок; включение отслеживается по блокам,
+// которые узел отдаёт по P2P.
+//
+//   ./nexus-load --node 127.0.0.1:8000 --senders 64 --mode closed --concurrency 32 --duration 60
+//   ./nexus-load --node 127.0.0.1:8000 --mode open --rate 200 --via p2p --out load.json
+//   ./nexus-load --node 127.0.0.1:8000 --signed --concurrency 8 --duration 30
+#include "blockchain/transaction.h"
+#include "network/message.h"
+#include "latency_stats.h"
+#include <boost/asio.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <unistd.h>
+
+using boost::asio::ip::tcp;
+using Clock = std::chrono::steady_clock;
+using nexus::tools::LatencyStats;
+
+namespace {
+
+constexpr Amount FEE = COIN / 1000;
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int p2p_port = 8000;
+    int http_port = 9000;          // По умолчанию P2P-порт + 1000, как у узла
+    std::string via = "http";      // http | p2p
+    std::string mode = "closed";   // closed | open
+    int concurrency = 16;
+    double rate = 100;             // Транзакций в секунду в открытом режиме
+    int duration_s = 30;
+    int drain_s = 60;              // Сколько ждать включения в блоки после нагрузки
+    int senders = 32;
+    Amount fund = 10 * COIN;       // Начальный баланс каждого отправителя
+    int fund_timeout_s = 300;
+    bool skip_funding = false;
+    bool signed_txs = false;       // Отправители — адреса ключей Ed25519, транзакции подписаны
+    std::string out_path;
+};
+
+double ms_since(Clock::time_point from, Clock::time_point to = Clock::now()) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+// ------------------------------------------------------------
+// HTTP: одно соединение на запрос — так работает сервер узла
+// ------------------------------------------------------------
+
+struct HttpResponse {
+    int status{0};
+    std::string body;
+};
+
+std::optional<HttpResponse> http_request(const std::string& host, int port, const std::string& method,
+                                         const std::string& path, const std::string& body = "") {
+    try {
+        boost::asio::io_context io;
+        tcp::socket socket(io);
+        socket.connect(tcp::endpoint(boost::asio::ip::make_address(host), static_cast<unsigned short>(port)));
+
+        std::string request = method + " " + path + " HTTP/1.1\r\nHost: " + host +
+                              "\r\nContent-Type: application/json\r\nContent-Length: " +
+                              std::to_string(body.size()) + "\r\nConnection: close\r\n\r\n" + body;
+        boost::asio::write(socket, boost::asio::buffer(request));
+
+        std::string raw;
+        boost::system::error_code ec;
+        char chunk[4096];
+        for (;;) {
+            size_t n = socket.read_some(boost::asio::buffer(chunk), ec);
+            raw.append(chunk, n);
+            if (ec) break;
+        }
+        if (raw.rfind("HTTP/1.1 ", 0) != 0) return std::nullopt;
+
+        HttpResponse response;
+        response.status = std::atoi(raw.c_str() + 9);
+        size_t body_pos = raw.find("\r\n\r\n");
+        if (body_pos != std::string::npos) response.body = raw.substr(body_pos + 4);
+        return response;
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
+}
+
+// ------------------------------------------------------------
+// Учёт отправленных транзакций и задержек
+// ------------------------------------------------------------
+
+class Tracker {
+public:
+    void submitted(const std::string& hash, Clock::time_point at) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_[hash] = Entry{at, false};
+    }
+
+    void admitted(const std::string& hash, Clock::time_point at) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pending_.find(hash);
+        if (it == pending_.end() || it->second.admitted) return;
+        it->second.admitted = true;
+        admission_.samples_ms.push_back(ms_since(it->second.submitted_at, at));
+    }
+
+    void included(const std::string& hash, Clock::time_point at) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = pending_.find(hash);
+        if (it == pending_.end()) return;
+        inclusion_.samples_ms.push_back(ms_since(it->second.submitted_at, at));
+        pending_.erase(it);
+    }
+
+    // Хэши, ещё не подтверждённые как попавшие в mempool (для режима P2P)
+    std::vector<std::string> unadmitted(size_t limit) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::vector<std::string> result;
+        for (const auto& [hash, entry] : pending_) {
+            if (!entry.admitted) result.push_back(hash);
+            if (result.size() >= limit) break;
+        }
+        return result;
+    }
+
+    size_t outstanding() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pending_.size();
+    }
+
+    nlohmann::json admission_json() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return admission_.to_json();
+    }
+
+    nlohmann::json inclusion_json() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return inclusion_.to_json();
+    }
+
+private:
+    struct Entry {
+        Clock::time_point submitted_at;
+        bool admitted;
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<std::string, Entry> pending_;
+    LatencyStats admission_;
+    LatencyStats inclusion_;
+};
+
+// ------------------------------------------------------------
+// P2P: одно входящее соединение к узлу. Через него видны новые блоки
+// (NEW_BLOCK, затем GET_BLOCKS за транзакциями) и, в режиме --via p2p,
+// отправляются транзакции
+// ------------------------------------------------------------
+
+class P2PLink {
+public:
+    P2PLink(const std::string& host, int port, Tracker& tracker)
+        : socket_(io_), tracker_(tracker) {
+        socket_.connect(tcp::endpoint(boost::asio::ip::make_address(host), static_cast<unsigned short>(port)));
+        node_id_ = "loadgen_" + std::to_string(getpid());
+        send(nexus::Message::create_handshake(node_id_, 0));
+        reader_ = std::thread([this]() { read_loop(); });
+        poller_ = std::thread([this]() { poll_loop(); });
+    }
+
+    ~P2PLink() {
+        stopping_ = true;
+        boost::system::error_code ec;
+        socket_.shutdown(tcp::socket::shutdown_both, ec);
+        socket_.close(ec);
+        if (reader_.joinable()) reader_.join();
+        if (poller_.joinable()) poller_.join();
+    }
+
+    void send(const nexus::Message& msg) {
+        std::string wire = msg.serialize() + "\n";
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        boost::system::error_code ec;
+        boost::asio::write(socket_, boost::asio::buffer(wire), ec);
+    }
+
+    void send_transaction(const Transaction& tx) {
+        send(nexus::Message::create_new_transaction(node_id_, tx.toJsonObject()));
+    }
+
+    int height() const { return height_.load(); }
+    uint64_t blocks_seen() const { return blocks_seen_.load(); }
+
+private:
+    void read_loop() {
+        boost::asio::streambuf buffer;
+        boost::system::error_code ec;
+        while (!stopping_) {
+            boost::asio::read_until(socket_, buffer, '\n', ec);
+            if (ec) break;
+            std::istream stream(&buffer);
+            std::string line;
+            std::getline(stream, line);
+            try {
+                handle(nexus::Message::deserialize(line));
+            } catch (const std::exception&) {
+                // Чужие форматы сообщений генератору не интересны
+            }
+        }
+    }
+
+    void handle(const nexus::Message& msg) {
+        switch (msg.type) {
+            case nexus::MessageType::GET_BLOCKS: {
+                // Узел просит блоки начиная со своей высоты + 1: так мы узнаём его высоту
+                int from = msg.payload.value("from_height", 0);
+                int expected = -1;
+                height_.compare_exchange_strong(expected, from - 1);
+                break;
+            }
+            case nexus::MessageType::NEW_BLOCK:
+                request_blocks();
+                break;
+            case nexus::MessageType::BLOCKS_RESPONSE: {
+                auto now = Clock::now();
+                if (!msg.payload.is_array()) break;
+                for (const auto& block : msg.payload) {
+                    int h = block.value("height", 0);
+                    if (h <= height_.load()) continue;
+                    height_ = h;
+                    blocks_seen_++;
+                    for (const auto& tx : block.value("transactions", nlohmann::json::array())) {
+                        tracker_.included(tx.value("txHash", ""), now);
+                    }
+                }
+                break;
+            }
+            case nexus::MessageType::PING:
+                send(nexus::Message::create_pong(node_id_, msg.payload.value("nonce", uint64_t(0))));
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Пока высота узла неизвестна (его GET_BLOCKS ещё не пришёл), берём цепочку целиком
+    void request_blocks() {
+        send(nexus::Message::create_get_blocks(node_id_, height_.load() + 1));
+    }
+
+    // NEW_BLOCK может потеряться или прийти раньше, чем блок станет виден
+    // в БД узла, поэтому блоки дополнительно запрашиваются раз в секунду
+    void poll_loop() {
+        while (!stopping_) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            request_blocks();
+        }
+    }
+
+    boost::asio::io_context io_;
+    tcp::socket socket_;
+    Tracker& tracker_;
+    std::string node_id_;
+    std::mutex write_mutex_;
+    std::atomic<bool> stopping_{false};
+    std::atomic<int> height_{-1};
+    std::atomic<uint64_t> blocks_seen_{0};
+    std::thread reader_;
+    std::thread poller_;
+};
+
+// ------------------------------------------------------------
+// Генерация и отправка транзакций
+// ------------------------------------------------------------
+
+struct Sender {
+    std::string address;
+    std::string private_key;       // Только с --signed
+    std::atomic<uint64_t> nonce{0};
+};
+
+struct Counters {
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> accepted{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> errors{0};
+};
+
+class LoadGenerator {
+public:
+    LoadGenerator(const Options& options, Tracker& tracker, P2PLink& link)
+        : options_(options), tracker_(tracker), link_(link) {
+        std::string prefix = "load_" + std::to_string(getpid()) + "_";
+        senders_.reserve(options.senders);
+        for (int i = 0; i < options.senders; ++i) {
+            senders_.push_back(std::make_unique<Sender>());
+            Sender& sender = *senders_.back();
+            if (options.signed_txs) {
+                auto keys = Crypto::generateKeyPair();
+                sender.private_key = keys.privateKey;
+                sender.address = Crypto::addressFromPublicKey(keys.publicKey);
+            } else {
+                sender.address = prefix + std::to_string(i);
+            }
+        }
+    }
+
+    // Пополнение отправителей с genesis_miner; ждём, пока пополнения попадут
+    // в блоки: баланс считается только по подтверждённым транзакциям
+    bool fund() {
+        std::vector<std::string> hashes;
+        for (const auto& sender : senders_) {
+            nlohmann::json body = {{"from", "genesis_miner"}, {"to", sender->address},
+                                   {"amount", amountToJson(options_.fund)}, {"fee", amountToJson(FEE)}};
+            auto response = http_request(options_.host, options_.http_port, "POST", "/transaction", body.dump());
+            if (!response || response->status != 200) {
+                std::cerr << "Funding " << sender->address << " failed: "
+                          << (response ? response->body : "no response") << std::endl;
+                return false;
+            }
+            hashes.push_back(nlohmann::json::parse(response->body).value("tx_hash", ""));
+        }
+
+        std::cerr << "Funded " << hashes.size() << " senders, waiting for confirmation..." << std::endl;
+        auto deadline = Clock::now() + std::chrono::seconds(options_.fund_timeout_s);
+        while (!hashes.empty() && Clock::now() < deadline) {
+            auto response = http_request(options_.host, options_.http_port, "GET", "/tx/" + hashes.back());
+            if (response && response->status == 200 &&
+                nlohmann::json::parse(response->body).value("status", "") == "confirmed") {
+                hashes.pop_back();
+                continue;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+        if (!hashes.empty()) {
+            std::cerr << hashes.size() << " funding transactions not confirmed in time" << std::endl;
+            return false;
+        }
+        return true;
+    }
+
+    void run() {
+        started_ = Clock::now();
+        auto deadline = started_ + std::chrono::seconds(options_.duration_s);
+        std::vector<std::thread> workers;
+
+        if (options_.via == "p2p") {
+            workers.emplace_back([this, deadline]() { admission_poll_loop(deadline); });
+        }
+
+        if (options_.mode == "open") {
+            // Открытая модель: i-я транзакция запланирована на started + i/rate,
+            // задержка считается от плана, а не от фактической отправки, чтобы
+            // отставание генератора не прятало задержки узла
+            auto interval = std::chrono::duration<double>(1.0 / options_.rate);
+            for (int w = 0; w < options_.concurrency; ++w) {
+                workers.emplace_back([this, deadline, interval]() {
+                    for (;;) {
+                        uint64_t i = next_arrival_++;
+                        auto scheduled = started_ + std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(i));
+                        if (scheduled >= deadline) break;
+                        std::this_thread::sleep_until(scheduled);
+                        submit(*senders_[i % senders_.size()], scheduled);
+                    }
+                });
+            }
+        } else {
+            // Замкнутая модель: каждый из concurrency воркеров ждёт ответа
+            // перед следующей отправкой и использует только своих отправителей
+            for (int w = 0; w < options_.concurrency; ++w) {
+                workers.emplace_back([this, deadline, w]() {
+                    size_t slot = static_cast<size_t>(w);
+                    while (Clock::now() < deadline) {
+                        submit(*senders_[slot % senders_.size()], Clock::now());
+                        slot += static_cast<size_t>(options_.concurrency);
+                    }
+                });
+            }
+        }
+
+        for (auto& worker : workers) worker.join();
+        load_seconds_ = ms_since(started_) / 1000.0;
+    }
+
+    void drain() {
+        auto deadline = Clock::now() + std::chrono::seconds(options_.drain_s);
+        while (tracker_.outstanding() > 0 && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        }
+    }
+
+    nlohmann::json report() const {
+        return {
+            {"options", {
+                {"node", options_.host + ":" + std::to_string(options_.p2p_port)},
+                {"via", options_.via},
+                {"mode", options_.mode},
+                {"concurrency", options_.concurrency},
+                {"rate", options_.mode == "open" ? nlohmann::json(options_.rate) : nlohmann::json(nullptr)},
+                {"duration_s", options_.duration_s},
+                {"senders", options_.senders},
+                {"signed", options_.signed_txs}
+            }},
+            {"submitted", counters_.submitted.load()},
+            {"accepted", counters_.accepted.load()},
+            {"rejected", counters_.rejected.load()},
+            {"errors", counters_.errors.load()},
+            {"load_seconds", load_seconds_},
+            {"submitted_per_sec", load_seconds_ > 0 ? counters_.submitted.load() / load_seconds_ : 0},
+            {"accepted_per_sec", load_seconds_ > 0 ? counters_.accepted.load() / load_seconds_ : 0},
+            {"admission_latency", tracker_.admission_json()},
+            {"inclusion_latency", tracker_.inclusion_json()},
+            {"not_included", tracker_.outstanding()},
+            {"blocks_seen", link_.blocks_seen()}
+        };
+    }
+
+private:
+    Transaction make_tx(Sender& sender) {
+        uint64_t nonce = sender.nonce++;
+        Transaction tx;
+        tx.fromAddress = sender.address;
+        tx.toAddress = senders_[(nonce * 7 + 1) % senders_.size()]->address;
+        // Сумма разная у соседних nonce: так транзакции различимы и в логах узла
+        tx.amount = static_cast<Amount>(100000 + nonce % 900000);
+        tx.fee = FEE;
+        tx.timestamp = time(nullptr);
+        tx.nonce = nonce;
+        if (options_.signed_txs) {
+            tx.sign(sender.private_key);
+        } else {
+            tx.signature = "load_sig";
+            tx.txHash = tx.calculateHash();
+        }
+        return tx;
+    }
+
+    void submit(Sender& sender, Clock::time_point scheduled) {
+        Transaction tx = make_tx(sender);
+        counters_.submitted++;
+
+        if (options_.via == "p2p") {
+            tracker_.submitted(tx.txHash, scheduled);
+            link_.send_transaction(tx);
+            counters_.accepted++;
+            return;
+        }
+
+        nlohmann::json body = {{"from", tx.fromAddress}, {"to", tx.toAddress}, {"amount", amountToJson(tx.amount)},
+                               {"fee", amountToJson(tx.fee)}, {"nonce", tx.nonce}};
+        if (options_.signed_txs) {
+            body["timestamp"] = tx.timestamp;
+            body["signature"] = tx.signature;
+            body["public_key"] = tx.publicKey;
+        }
+        auto response = http_request(options_.host, options_.http_port, "POST", "/transaction", body.dump());
+        auto now = Clock::now();
+        if (!response) {
+            counters_.errors++;
+            return;
+        }
+        if (response->status != 200) {
+            counters_.rejected++;
+            return;
+        }
+        counters_.accepted++;
+        // Узел сам считает хэш (со своей меткой времени) и возвращает его
+        std::string hash = nlohmann::json::parse(response->body).value("tx_hash", tx.txHash);
+        tracker_.submitted(hash, scheduled);
+        tracker_.admitted(hash, now);
+    }
+
+    // В режиме P2P узел не подтверждает приём, поэтому попадание в mempool
+    // проверяется опросом GET /tx/<hash>; точность ограничена скоростью опроса
+    void admission_poll_loop(Clock::time_point deadline) {
+        while (Clock::now() < deadline + std::chrono::seconds(5)) {
+            auto hashes = tracker_.unadmitted(64);
+            if (hashes.empty()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                continue;
+            }
+            for (const auto& hash : hashes) {
+                auto response = http_request(options_.host, options_.http_port, "GET", "/tx/" + hash);
+                if (response && response->status == 200) tracker_.admitted(hash, Clock::now());
+            }
+        }
+    }
+
+    const Options& options_;
+    Tracker& tracker_;
+    P2PLink& link_;
+    std::vector<std::unique_ptr<Sender>> senders_;
+    Counters counters_;
+    std::atomic<uint64_t> next_arrival_{0};
+    Clock::time_point started_;
+    double load_seconds_{0};
+};
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]" << std::endl
+              << "  --node <ip:p2p_port>   Target node (default 127.0.0.1:8000, HTTP on p2p_port+1000)" << std::endl
+              << "  --http-port <port>     Override HTTP API port" << std::endl
+              << "  --via <http|p2p>       Submission interface (default http)" << std::endl
+              << "  --mode <closed|open>   Closed loop or fixed arrival rate (default closed)" << std::endl
+              << "  --concurrency <n>      Workers / in-flight requests (default 16)" << std::endl
+              << "  --rate <tx/s>          Arrival rate for open mode (default 100)" << std::endl
+              << "  --duration <s>         Load duration (default 30)" << std::endl
+              << "  --drain <s>            Wait for block inclusion afterwards (default 60)" << std::endl
+              << "  --senders <n>          Funded sender accounts (default 32)" << std::endl
+              << "  --fund <amount>        Initial balance per sender (default 10)" << std::endl
+              << "  --fund-timeout <s>     Wait for funding confirmation (default 300)" << std::endl
+              << "  --skip-funding         Senders are already funded" << std::endl
+              << "  --signed               Fresh Ed25519 key senders, signed transactions (needs funding)" << std::endl
+              << "  --out <file>           Write JSON report to file instead of stdout" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    bool http_port_set = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--node" && has_value) {
+            std::string node = argv[++i];
+            size_t colon = node.find(':');
+            options.host = node.substr(0, colon);
+            if (colon != std::string::npos) options.p2p_port = std::stoi(node.substr(colon + 1));
+        }
+        else if (arg == "--http-port" && has_value) { options.http_port = std::stoi(argv[++i]); http_port_set = true; }
+        else if (arg == "--via" && has_value) options.via = argv[++i];
+        else if (arg == "--mode" && has_value) options.mode = argv[++i];
+        else if (arg == "--concurrency" && has_value) options.concurrency = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--rate" && has_value) options.rate = std::stod(argv[++i]);
+        else if (arg == "--duration" && has_value) options.duration_s = std::stoi(argv[++i]);
+        else if (arg == "--drain" && has_value) options.drain_s = std::stoi(argv[++i]);
+        else if (arg == "--senders" && has_value) options.senders = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--fund" && has_value && parseAmount(argv[i + 1], options.fund)) ++i;
+        else if (arg == "--fund-timeout" && has_value) options.fund_timeout_s = std::stoi(argv[++i]);
+        else if (arg == "--skip-funding") options.skip_funding = true;
+        else if (arg == "--signed") options.signed_txs = true;
+        else if (arg == "--out" && has_value) options.out_path = argv[++i];
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!http_port_set) options.http_port = options.p2p_port + 1000;
+    if ((options.via != "http" && options.via != "p2p") || (options.mode != "closed" && options.mode != "open") ||
+        options.rate <= 0 || options.fund <= 0 || (options.signed_txs && options.skip_funding)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    Tracker tracker;
+    std::unique_ptr<P2PLink> link;
+    try {
+        link = std::make_unique<P2PLink>(options.host, options.p2p_port, tracker);
+    } catch (const std::exception& e) {
+        std::cerr << "Can't connect to " << options.host << ":" << options.p2p_port << ": " << e.what() << std::endl;
+        return 1;
+    }
+
+    LoadGenerator generator(options, tracker, *link);
+    if (!options.skip_funding && !generator.fund()) return 1;
+
+    std::cerr << "Running " << options.mode << "-loop load via " << options.via << " for "
+              << options.duration_s << "s..." << std::endl;
+    generator.run();
+    std::cerr << "Load finished, waiting up to " << options.drain_s << "s for block inclusion..." << std::endl;
+    generator.drain();
+
+    nlohmann::json report = generator.report();
+    link.reset();
+
+    if (options.out_path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(options.out_path);
+        out << report.dump(2) << std::endl;
+    }
+    return 0;
+}
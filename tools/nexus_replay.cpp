@@ -0,0 +1,266 @@
+// tools/nexus_replay.cpp
+// Воспроизведение захвата входящего трафика (узел с NEXUS_CAPTURE=файл) на
+// свежем узле без сети и майнинга. Сообщения P2P подаются в io-поток узла,
+// HTTP-запросы — в обработчик API по одному, как у настоящего HTTP-сервера.
+// Время между записями сохраняется (--speed 1), сжимается (--speed 10) или
+// не выдерживается вовсе (--speed 0). Задержки считаются от момента, когда
+// запись должна была поступить, до конца её обработки.
+// Запускать из каталога сборки (рядом должен лежать schema.sql):
+//
+//   ./nexus-replay traffic.cap --speed 10 --out replay.json
+//   ./nexus-replay traffic.cap --speed 0 --source p2p
+#include "core/node.h"
+#include "network/traffic_capture.h"
+#include "storage/ledger_db.h"
+#include "logging/logger.h"
+#include "latency_stats.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+using nexus::tools::LatencyStats;
+
+namespace {
+
+struct Options {
+    std::string capture_path;
+    std::string db_path;           // Пусто — временная БД, удаляется после прогона
+    double speed = 1.0;            // 0 — без пауз между записями
+    std::string source = "all";    // all | p2p | http
+    std::string out_path;
+};
+
+double ms_between(Clock::time_point from, Clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+class Results {
+public:
+    void p2p_done(nexus::MessageType type, double ms) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        by_type_[nexus::message_type_to_string(type)].samples_ms.push_back(ms);
+        p2p_all_.samples_ms.push_back(ms);
+    }
+
+    void http_done(const std::string& status, double ms) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        http_.samples_ms.push_back(ms);
+        http_statuses_[status]++;
+    }
+
+    nlohmann::json to_json() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nlohmann::json types = nlohmann::json::object();
+        for (const auto& [name, stats] : by_type_) types[name] = stats.to_json();
+        return {
+            {"p2p_latency", p2p_all_.to_json()},
+            {"p2p_latency_by_type", types},
+            {"http_latency", http_.to_json()},
+            {"http_statuses", http_statuses_}
+        };
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::map<std::string, LatencyStats> by_type_;
+    LatencyStats p2p_all_;
+    LatencyStats http_;
+    std::map<std::string, int> http_statuses_;
+};
+
+// HTTP-запросы обслуживаются строго по одному, как в цикле accept узла,
+// и не задерживают подачу сообщений P2P
+class HttpWorker {
+public:
+    HttpWorker(nexus::Node& node, Results& results) : node_(node), results_(results) {
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~HttpWorker() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    void submit(Clock::time_point due, std::string request) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back({due, std::move(request)});
+        }
+        cv_.notify_one();
+    }
+
+private:
+    struct Job {
+        Clock::time_point due;
+        std::string request;
+    };
+
+    void run() {
+        for (;;) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            nexus::HttpResponse response = node_.handleHttpRequest(job.request);
+            results_.http_done(response.status, ms_between(job.due, Clock::now()));
+        }
+    }
+
+    nexus::Node& node_;
+    Results& results_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Job> queue_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " <capture> [options]" << std::endl
+              << "  --speed <x>         Replay speed factor, 0 = as fast as possible (default 1)" << std::endl
+              << "  --source <kind>     all | p2p | http (default all)" << std::endl
+              << "  --db <path>         Node database (default: fresh temporary DB)" << std::endl
+              << "  --out <file>        Write JSON report to file instead of stdout" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--speed" && has_value) options.speed = std::stod(argv[++i]);
+        else if (arg == "--source" && has_value) options.source = argv[++i];
+        else if (arg == "--db" && has_value) options.db_path = argv[++i];
+        else if (arg == "--out" && has_value) options.out_path = argv[++i];
+        else if (options.capture_path.empty() && arg.rfind("--", 0) != 0) options.capture_path = arg;
+        else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+    if (options.capture_path.empty() || options.speed < 0 ||
+        (options.source != "all" && options.source != "p2p" && options.source != "http")) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    nexus::CaptureReader reader(options.capture_path);
+    if (!reader.ok()) {
+        std::cerr << "Can't read capture " << options.capture_path << std::endl;
+        return 1;
+    }
+
+    nexus::Logger::instance().setLevel(nexus::LogLevel::WARN);
+    if (const char* spec = std::getenv("NEXUS_LOG")) nexus::Logger::instance().configure(spec);
+
+    bool temporary_db = options.db_path.empty();
+    if (temporary_db) {
+        options.db_path = (std::filesystem::temp_directory_path() /
+                           ("nexus-replay-" + std::to_string(getpid()) + ".db")).string();
+        std::filesystem::remove(options.db_path);
+    }
+
+    Results results;
+    std::atomic<uint64_t> p2p_injected{0};
+    std::atomic<uint64_t> p2p_completed{0};
+    uint64_t http_requests = 0;
+    uint64_t skipped = 0;
+    uint64_t capture_span_us = 0;
+    double max_lag_ms = 0;
+    auto started = Clock::now();
+
+    {
+        // Порт 0: сервер узла не запускается, но сокет под него создаётся
+        nexus::Node node(options.db_path, 0, 0, "replay");
+        node.startReplay();
+        {
+            HttpWorker http(node, results);
+            nexus::CaptureRecord record;
+            while (reader.next(record)) {
+                capture_span_us = record.offset_us;
+                // Свои блоки узла воспроизводятся вместе с P2P: без них цепочка другая
+                bool is_p2p = record.source != nexus::CaptureSource::HTTP;
+                if ((is_p2p && options.source == "http") || (!is_p2p && options.source == "p2p")) {
+                    skipped++;
+                    continue;
+                }
+
+                Clock::time_point due = Clock::now();
+                if (options.speed > 0) {
+                    due = started + std::chrono::microseconds(
+                        static_cast<int64_t>(static_cast<double>(record.offset_us) / options.speed));
+                    std::this_thread::sleep_until(due);
+                    max_lag_ms = std::max(max_lag_ms, ms_between(due, Clock::now()));
+                }
+
+                if (is_p2p) {
+                    p2p_injected++;
+                    node.injectMessage(record.peer, record.data,
+                        [&results, &p2p_completed, due](nexus::MessageType type, double) {
+                            results.p2p_done(type, ms_between(due, Clock::now()));
+                            p2p_completed++;
+                        });
+                } else {
+                    http_requests++;
+                    http.submit(due, std::move(record.data));
+                }
+            }
+
+            // Ждём, пока io-поток разберёт всё поставленное
+            auto deadline = Clock::now() + std::chrono::seconds(120);
+            while (p2p_completed < p2p_injected && Clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+        }
+        node.stop();
+    }
+    double wall_s = std::chrono::duration<double>(Clock::now() - started).count();
+
+    int final_height = -1;
+    {
+        LedgerDB db(options.db_path);
+        final_height = db.getLatestHeight();
+    }
+    if (temporary_db) std::filesystem::remove(options.db_path);
+
+    nlohmann::json report = results.to_json();
+    report["capture"] = options.capture_path;
+    report["options"] = {{"speed", options.speed}, {"source", options.source}};
+    report["p2p_messages"] = p2p_injected.load();
+    report["p2p_unfinished"] = p2p_injected.load() - p2p_completed.load();
+    report["http_requests"] = http_requests;
+    report["skipped"] = skipped;
+    report["capture_span_s"] = static_cast<double>(capture_span_us) / 1e6;
+    report["replay_wall_s"] = wall_s;
+    report["max_dispatch_lag_ms"] = max_lag_ms;
+    report["final_height"] = final_height;
+
+    if (options.out_path.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    } else {
+        std::ofstream out(options.out_path);
+        out << report.dump(2) << std::endl;
+    }
+    nexus::Logger::instance().flush();
+    return 0;
+}